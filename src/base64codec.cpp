@@ -0,0 +1,370 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <cstring>
+
+#include "base64codec.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BASE64_USE_NEON
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BASE64_USE_SSSE3
+#endif
+
+#define BASE64_INVALID 0xff
+#define BASE64_PAD     '='
+
+static const char encodeTable[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Same ranking as glib: '=' ranks as zero, everything else outside the
+// alphabet is skipped by the lenient decoder.
+static const uint8_t decodeTable[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,   62, 0xff, 0xff, 0xff,   63,
+	  52,   53,   54,   55,   56,   57,   58,   59,   60,   61, 0xff, 0xff, 0xff,    0, 0xff, 0xff,
+	0xff,    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+	  15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff,   26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+	  41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+#if defined(BASE64_USE_NEON)
+
+static inline uint8x16_t indexToAscii(uint8x16_t index)
+{
+	uint8x16_t offset = vdupq_n_u8('A');
+	offset = vbslq_u8(vcgeq_u8(index, vdupq_n_u8(26)), vdupq_n_u8('a' - 26), offset);
+	offset = vbslq_u8(vcgeq_u8(index, vdupq_n_u8(52)), vdupq_n_u8((uint8_t)('0' - 52)), offset);
+	offset = vbslq_u8(vceqq_u8(index, vdupq_n_u8(62)), vdupq_n_u8((uint8_t)('+' - 62)), offset);
+	offset = vbslq_u8(vceqq_u8(index, vdupq_n_u8(63)), vdupq_n_u8((uint8_t)('/' - 63)), offset);
+	return vaddq_u8(index, offset);
+}
+
+static inline uint8x16_t asciiToIndex(uint8x16_t ascii, uint8x16_t &invalid)
+{
+	uint8x16_t upper = vcltq_u8(vsubq_u8(ascii, vdupq_n_u8('A')), vdupq_n_u8(26));
+	uint8x16_t lower = vcltq_u8(vsubq_u8(ascii, vdupq_n_u8('a')), vdupq_n_u8(26));
+	uint8x16_t digit = vcltq_u8(vsubq_u8(ascii, vdupq_n_u8('0')), vdupq_n_u8(10));
+	uint8x16_t plus = vceqq_u8(ascii, vdupq_n_u8('+'));
+	uint8x16_t slash = vceqq_u8(ascii, vdupq_n_u8('/'));
+
+	uint8x16_t offset = vandq_u8(upper, vdupq_n_u8((uint8_t)(-'A')));
+	offset = vorrq_u8(offset, vandq_u8(lower, vdupq_n_u8((uint8_t)(26 - 'a'))));
+	offset = vorrq_u8(offset, vandq_u8(digit, vdupq_n_u8((uint8_t)(52 - '0'))));
+	offset = vorrq_u8(offset, vandq_u8(plus, vdupq_n_u8((uint8_t)(62 - '+'))));
+	offset = vorrq_u8(offset, vandq_u8(slash, vdupq_n_u8((uint8_t)(63 - '/'))));
+
+	uint8x16_t valid = vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, vorrq_u8(plus, slash)));
+	invalid = vorrq_u8(invalid, vmvnq_u8(valid));
+
+	return vaddq_u8(ascii, offset);
+}
+
+// Encodes 48 bytes into 64 characters per iteration.
+static size_t encodeBlocks(const uint8_t *src, size_t size, char *dst)
+{
+	size_t consumed = 0;
+	const uint8x16_t mask2 = vdupq_n_u8(0x03);
+	const uint8x16_t mask4 = vdupq_n_u8(0x0f);
+	const uint8x16_t mask6 = vdupq_n_u8(0x3f);
+
+	while (size - consumed >= 48)
+	{
+		uint8x16x3_t in = vld3q_u8(src + consumed);
+		uint8x16x4_t out;
+
+		out.val[0] = vshrq_n_u8(in.val[0], 2);
+		out.val[1] = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[0], mask2), 4), vshrq_n_u8(in.val[1], 4));
+		out.val[2] = vorrq_u8(vshlq_n_u8(vandq_u8(in.val[1], mask4), 2), vshrq_n_u8(in.val[2], 6));
+		out.val[3] = vandq_u8(in.val[2], mask6);
+
+		out.val[0] = indexToAscii(out.val[0]);
+		out.val[1] = indexToAscii(out.val[1]);
+		out.val[2] = indexToAscii(out.val[2]);
+		out.val[3] = indexToAscii(out.val[3]);
+
+		vst4q_u8((uint8_t *)dst + (consumed / 3) * 4, out);
+		consumed += 48;
+	}
+
+	return consumed;
+}
+
+// Decodes 64 characters into 48 bytes per iteration. Stops at the first
+// block containing anything but alphabet characters (padding included).
+static size_t decodeBlocks(const char *src, size_t length, uint8_t *dst)
+{
+	size_t consumed = 0;
+
+	while (length - consumed >= 64)
+	{
+		uint8x16x4_t in = vld4q_u8((const uint8_t *)src + consumed);
+		uint8x16_t invalid = vdupq_n_u8(0);
+
+		in.val[0] = asciiToIndex(in.val[0], invalid);
+		in.val[1] = asciiToIndex(in.val[1], invalid);
+		in.val[2] = asciiToIndex(in.val[2], invalid);
+		in.val[3] = asciiToIndex(in.val[3], invalid);
+
+		uint64x2_t invalid64 = vreinterpretq_u64_u8(invalid);
+		if (vgetq_lane_u64(invalid64, 0) | vgetq_lane_u64(invalid64, 1))
+			break;
+
+		uint8x16x3_t out;
+		out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2), vshrq_n_u8(in.val[1], 4));
+		out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4), vshrq_n_u8(in.val[2], 2));
+		out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+
+		vst3q_u8(dst + (consumed / 4) * 3, out);
+		consumed += 64;
+	}
+
+	return consumed;
+}
+
+#elif defined(BASE64_USE_SSSE3)
+
+static inline __m128i indexToAscii(__m128i index)
+{
+	__m128i offset = _mm_set1_epi8('A');
+	__m128i mask = _mm_cmpgt_epi8(index, _mm_set1_epi8(25));
+	offset = _mm_or_si128(_mm_andnot_si128(mask, offset), _mm_and_si128(mask, _mm_set1_epi8('a' - 26)));
+	mask = _mm_cmpgt_epi8(index, _mm_set1_epi8(51));
+	offset = _mm_or_si128(_mm_andnot_si128(mask, offset), _mm_and_si128(mask, _mm_set1_epi8('0' - 52)));
+	mask = _mm_cmpeq_epi8(index, _mm_set1_epi8(62));
+	offset = _mm_or_si128(_mm_andnot_si128(mask, offset), _mm_and_si128(mask, _mm_set1_epi8('+' - 62)));
+	mask = _mm_cmpeq_epi8(index, _mm_set1_epi8(63));
+	offset = _mm_or_si128(_mm_andnot_si128(mask, offset), _mm_and_si128(mask, _mm_set1_epi8('/' - 63)));
+	return _mm_add_epi8(index, offset);
+}
+
+static inline __m128i inRange(__m128i value, char low, char high)
+{
+	return _mm_and_si128(_mm_cmpgt_epi8(value, _mm_set1_epi8(low - 1)),
+	                     _mm_cmplt_epi8(value, _mm_set1_epi8(high + 1)));
+}
+
+// Encodes 12 bytes into 16 characters per iteration. Each load reads 16
+// bytes, so the loop leaves at least 4 bytes for the scalar tail.
+static size_t encodeBlocks(const uint8_t *src, size_t size, char *dst)
+{
+	size_t consumed = 0;
+	const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+	while (size - consumed >= 16)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i *)(src + consumed));
+		in = _mm_shuffle_epi8(in, shuffle);
+
+		// Each 32-bit lane now holds [b1 b0 b2 b1]; pull out the four 6-bit fields.
+		__m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+		__m128i lo = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+		__m128i index = _mm_or_si128(hi, lo);
+
+		_mm_storeu_si128((__m128i *)(dst + (consumed / 3) * 4), indexToAscii(index));
+		consumed += 12;
+	}
+
+	return consumed;
+}
+
+// Decodes 16 characters into 12 bytes per iteration. Stops at the first
+// block containing anything but alphabet characters (padding included).
+static size_t decodeBlocks(const char *src, size_t length, uint8_t *dst)
+{
+	size_t consumed = 0;
+	const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+	while (length - consumed >= 16)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i *)(src + consumed));
+
+		__m128i upper = inRange(in, 'A', 'Z');
+		__m128i lower = inRange(in, 'a', 'z');
+		__m128i digit = inRange(in, '0', '9');
+		__m128i plus = _mm_cmpeq_epi8(in, _mm_set1_epi8('+'));
+		__m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+
+		__m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+		if (_mm_movemask_epi8(valid) != 0xffff)
+			break;
+
+		__m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+		offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+		offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+		offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+		offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+		__m128i index = _mm_add_epi8(in, offset);
+
+		// Merge pairs of 6-bit fields into 12 bits, then pairs of those into 24 bits.
+		__m128i merged = _mm_maddubs_epi16(index, _mm_set1_epi32(0x01400140));
+		merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+		merged = _mm_shuffle_epi8(merged, pack);
+
+		uint8_t out[16];
+		_mm_storeu_si128((__m128i *)out, merged);
+		memcpy(dst + (consumed / 4) * 3, out, 12);
+		consumed += 16;
+	}
+
+	return consumed;
+}
+
+#else
+
+static size_t encodeBlocks(const uint8_t *, size_t, char *)
+{
+	return 0;
+}
+
+static size_t decodeBlocks(const char *, size_t, uint8_t *)
+{
+	return 0;
+}
+
+#endif
+
+// glib compatible decoding: skips characters outside the alphabet, stops at
+// NUL like the strlen() in g_base64_decode and honours '=' per quantum.
+static size_t decodeLenient(const char *src, size_t length, uint8_t *dst)
+{
+	uint8_t *out = dst;
+	uint32_t value = 0;
+	int count = 0;
+	char last[2] = { 0, 0 };
+
+	for (size_t i = 0; i < length && src[i] != '\0'; i++)
+	{
+		uint8_t rank = decodeTable[(uint8_t)src[i]];
+		if (BASE64_INVALID == rank)
+			continue;
+
+		last[1] = last[0];
+		last[0] = src[i];
+		value = (value << 6) | rank;
+
+		if (++count == 4)
+		{
+			*out++ = (uint8_t)(value >> 16);
+			if (last[1] != BASE64_PAD)
+				*out++ = (uint8_t)(value >> 8);
+			if (last[0] != BASE64_PAD)
+				*out++ = (uint8_t)value;
+			count = 0;
+		}
+	}
+
+	return out - dst;
+}
+
+size_t Base64::encode(const uint8_t *src, size_t size, char *dst)
+{
+	size_t consumed = encodeBlocks(src, size, dst);
+	char *out = dst + (consumed / 3) * 4;
+
+	for (; size - consumed >= 3; consumed += 3)
+	{
+		uint32_t value = (src[consumed] << 16) | (src[consumed + 1] << 8) | src[consumed + 2];
+		*out++ = encodeTable[(value >> 18) & 0x3f];
+		*out++ = encodeTable[(value >> 12) & 0x3f];
+		*out++ = encodeTable[(value >> 6) & 0x3f];
+		*out++ = encodeTable[value & 0x3f];
+	}
+
+	if (size - consumed == 1)
+	{
+		uint32_t value = src[consumed] << 16;
+		*out++ = encodeTable[(value >> 18) & 0x3f];
+		*out++ = encodeTable[(value >> 12) & 0x3f];
+		*out++ = BASE64_PAD;
+		*out++ = BASE64_PAD;
+	}
+	else if (size - consumed == 2)
+	{
+		uint32_t value = (src[consumed] << 16) | (src[consumed + 1] << 8);
+		*out++ = encodeTable[(value >> 18) & 0x3f];
+		*out++ = encodeTable[(value >> 12) & 0x3f];
+		*out++ = encodeTable[(value >> 6) & 0x3f];
+		*out++ = BASE64_PAD;
+	}
+
+	return out - dst;
+}
+
+size_t Base64::decode(const char *src, size_t length, uint8_t *dst)
+{
+	// The fast path only accepts canonical input: whole quanta and padding
+	// at the very end. Anything else is handed to the glib compatible decoder.
+	if (length % 4 != 0)
+		return decodeLenient(src, length, dst);
+
+	size_t consumed = decodeBlocks(src, length, dst);
+	uint8_t *out = dst + (consumed / 4) * 3;
+
+	for (; consumed < length; consumed += 4)
+	{
+		const uint8_t *in = (const uint8_t *)src + consumed;
+		bool lastQuantum = (consumed + 4 == length);
+		int padding = 0;
+
+		if (lastQuantum && in[3] == BASE64_PAD)
+			padding = (in[2] == BASE64_PAD) ? 2 : 1;
+
+		uint8_t a = decodeTable[in[0]];
+		uint8_t b = decodeTable[in[1]];
+		uint8_t c = (padding == 2) ? 0 : decodeTable[in[2]];
+		uint8_t d = (padding >= 1) ? 0 : decodeTable[in[3]];
+
+		if (BASE64_INVALID == (a | b | c | d) || in[0] == BASE64_PAD || in[1] == BASE64_PAD ||
+		        (padding < 2 && in[2] == BASE64_PAD) || (padding < 1 && in[3] == BASE64_PAD))
+			return decodeLenient(src, length, dst);
+
+		uint32_t value = (a << 18) | (b << 12) | (c << 6) | d;
+		*out++ = (uint8_t)(value >> 16);
+		if (padding < 2)
+			*out++ = (uint8_t)(value >> 8);
+		if (padding < 1)
+			*out++ = (uint8_t)value;
+	}
+
+	return out - dst;
+}
+
+void Base64::encode(const uint8_t *src, size_t size, std::string &out)
+{
+	out.resize(encodedLength(size));
+	if (size > 0)
+		encode(src, size, &out[0]);
+}
+
+void Base64::decode(const std::string &in, std::vector<uint8_t> &out)
+{
+	out.resize(maxDecodedLength(in.size()));
+	out.resize(decode(in.data(), in.size(), out.data()));
+}
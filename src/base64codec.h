@@ -0,0 +1,53 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef BASE64CODEC_H
+#define BASE64CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Base64 codec used for every binary payload carried over LS2 (SPP data).
+ *
+ * Output is byte-identical to g_base64_encode/g_base64_decode but works on
+ * caller-provided buffers, so hot paths can reuse storage instead of
+ * allocating per packet. Full blocks are processed with NEON or SSSE3 when
+ * the compiler targets them, the remainder with a scalar loop.
+ */
+namespace Base64
+{
+
+inline size_t encodedLength(size_t size) { return ((size + 2) / 3) * 4; }
+inline size_t maxDecodedLength(size_t length) { return (length / 4) * 3 + 3; }
+
+// Writes encodedLength(size) characters to dst (no terminating NUL).
+size_t encode(const uint8_t *src, size_t size, char *dst);
+
+// Writes at most maxDecodedLength(length) bytes to dst and returns the
+// number of bytes written. Like glib, characters outside the alphabet are
+// skipped and a trailing partial quantum is dropped.
+size_t decode(const char *src, size_t length, uint8_t *dst);
+
+void encode(const uint8_t *src, size_t size, std::string &out);
+void decode(const std::string &in, std::vector<uint8_t> &out);
+
+} // namespace Base64
+
+#endif // BASE64CODEC_H
@@ -277,7 +277,7 @@ bool BluetoothA2dpProfileService::startStreaming(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -352,7 +352,7 @@ bool BluetoothA2dpProfileService::stopStreaming(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -432,7 +432,7 @@ bool BluetoothA2dpProfileService::getAudioPath(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -508,7 +508,7 @@ bool BluetoothA2dpProfileService::setSbcEncoderBitpool(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string), PROP(bitpool, integer)) REQUIRED_2(address, bitpool));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string), PROP(bitpool, integer)) REQUIRED_2(address, bitpool));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -584,7 +584,7 @@ bool BluetoothA2dpProfileService::getCodecConfiguration(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
 												PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -695,7 +695,7 @@ bool BluetoothA2dpProfileService::getDelayReportingTime(LSMessage &message)
 	int parseError = 0;
 	bool subscribed = false;
 
-	const std::string schema =  STRICT_SCHEMA(
+	const char *schema =  STRICT_SCHEMA(
                                     PROPS_3(PROP(address, string), PROP(subscribe, boolean), PROP(adapterAddress, string))
                                     REQUIRED_1(address));
 
@@ -814,7 +814,7 @@ bool BluetoothA2dpProfileService::enableDelayReporting(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(
+	const char *schema =  STRICT_SCHEMA(
                                     PROPS_1(PROP(adapterAddress, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -879,7 +879,7 @@ bool BluetoothA2dpProfileService::disableDelayReporting(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(
+	const char *schema =  STRICT_SCHEMA(
                                     PROPS_1(PROP(adapterAddress, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -0,0 +1,667 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <algorithm>
+#include <vector>
+
+#include "bluetoothadvertisingscheduler.h"
+#include "mainloopwatchdog.h"
+#include "logging.h"
+
+#define MSGID_ADVERTISING_SCHEDULER "ADVERTISING_SCHEDULER"
+
+BluetoothAdvertisingScheduler::BluetoothAdvertisingScheduler(BluetoothAdapter *adapter, unsigned int maxSets, unsigned int sliceMs) :
+	mAdapter(adapter),
+	mMaxSets(maxSets),
+	mSliceMs(sliceMs ? sliceMs : 1000),
+	mPendingRegistrations(0),
+	mRotationSource(0),
+	mRotations(0),
+	mAlive(std::make_shared<bool>(true))
+{
+}
+
+BluetoothAdvertisingScheduler::~BluetoothAdvertisingScheduler()
+{
+	if (mRotationSource)
+		g_source_remove(mRotationSource);
+}
+
+uint8_t BluetoothAdvertisingScheduler::allocateId() const
+{
+	for (unsigned int id = 1; id <= UINT8_MAX; id++)
+	{
+		if (mAdvertisements.find(id) == mAdvertisements.end())
+			return id;
+	}
+
+	return 0;
+}
+
+int64_t BluetoothAdvertisingScheduler::getAirTime(const Advertisement &advertisement, int64_t now) const
+{
+	if (!advertisement.onAirSince)
+		return advertisement.airTimeUs;
+
+	return advertisement.airTimeUs + now - advertisement.onAirSince;
+}
+
+int64_t BluetoothAdvertisingScheduler::getVirtualTime(const Advertisement &advertisement, int64_t now) const
+{
+	return advertisement.virtualStart + getAirTime(advertisement, now) / advertisement.weight;
+}
+
+uint8_t BluetoothAdvertisingScheduler::findNextWaiting(int64_t now) const
+{
+	uint8_t nextId = 0;
+	int64_t nextVirtualTime = 0;
+
+	for (auto &advertisement : mAdvertisements)
+	{
+		const Advertisement &candidate = advertisement.second;
+		if (candidate.assigned || candidate.registering || candidate.removing)
+			continue;
+
+		int64_t virtualTime = getVirtualTime(candidate, now);
+		if (!nextId || virtualTime < nextVirtualTime)
+		{
+			nextId = advertisement.first;
+			nextVirtualTime = virtualTime;
+		}
+	}
+
+	return nextId;
+}
+
+bool BluetoothAdvertisingScheduler::hasWaiting() const
+{
+	for (auto &advertisement : mAdvertisements)
+	{
+		const Advertisement &candidate = advertisement.second;
+		if (!candidate.assigned && !candidate.registering && !candidate.removing)
+			return true;
+	}
+
+	return false;
+}
+
+void BluetoothAdvertisingScheduler::add(const AdvertiserInfo &info, unsigned int weight, AddCallback callback)
+{
+	uint8_t advertiserId = allocateId();
+	if (!advertiserId)
+	{
+		callback(BLUETOOTH_ERROR_NOMEM, 0);
+		return;
+	}
+
+	int64_t now = g_get_monotonic_time();
+
+	Advertisement advertisement = {};
+	advertisement.info = info;
+	advertisement.weight = weight ? weight : 1;
+	advertisement.addedTime = now;
+	advertisement.addCallback = callback;
+
+	bool first = true;
+	for (auto &other : mAdvertisements)
+	{
+		int64_t virtualTime = getVirtualTime(other.second, now);
+		if (first || virtualTime < advertisement.virtualStart)
+			advertisement.virtualStart = virtualTime;
+		first = false;
+	}
+
+	mAdvertisements[advertiserId] = advertisement;
+
+	for (auto &set : mSets)
+	{
+		if (!set.second.busy && !set.second.advertiserId)
+		{
+			putOnAir(set.first, advertiserId);
+			return;
+		}
+	}
+
+	if (!mMaxSets || mSets.size() + mPendingRegistrations < mMaxSets)
+	{
+		registerSet(advertiserId);
+		return;
+	}
+
+	BT_INFO(MSGID_ADVERTISING_SCHEDULER, 0, "Advertiser %d waits for one of %zu advertising sets",
+			advertiserId, mSets.size());
+
+	mAdvertisements[advertiserId].addCallback = nullptr;
+	updateRotation();
+	callback(BLUETOOTH_ERROR_NONE, advertiserId);
+}
+
+void BluetoothAdvertisingScheduler::remove(uint8_t advertiserId, BluetoothResultCallback callback)
+{
+	auto advertisementIter = mAdvertisements.find(advertiserId);
+	if (advertisementIter == mAdvertisements.end() || advertisementIter->second.removing)
+	{
+		callback(BLUETOOTH_ERROR_PARAM_INVALID);
+		return;
+	}
+
+	Advertisement &advertisement = advertisementIter->second;
+	if (!advertisement.assigned && !advertisement.registering)
+	{
+		mAdvertisements.erase(advertisementIter);
+		updateRotation();
+		callback(BLUETOOTH_ERROR_NONE);
+		return;
+	}
+
+	// Finished by whichever SIL call on its behalf completes next
+	advertisement.removing = true;
+	advertisement.removeCallback = callback;
+
+	if (advertisement.assigned)
+	{
+		auto setIter = mSets.find(advertisement.hardwareId);
+		if (setIter != mSets.end() && !setIter->second.busy)
+			takeOffAir(advertisement.hardwareId);
+	}
+}
+
+const AdvertiserInfo *BluetoothAdvertisingScheduler::find(uint8_t advertiserId) const
+{
+	auto advertisementIter = mAdvertisements.find(advertiserId);
+	if (advertisementIter == mAdvertisements.end())
+		return NULL;
+
+	return &advertisementIter->second.info;
+}
+
+bool BluetoothAdvertisingScheduler::isSameData(const AdvertiseData &first, const AdvertiseData &second, bool ignoreManufacturerData)
+{
+	if (first.includeTxPower != second.includeTxPower || first.includeName != second.includeName)
+		return false;
+
+	if (!ignoreManufacturerData && first.manufacturerData != second.manufacturerData)
+		return false;
+
+	if (first.services != second.services)
+		return false;
+
+	if (first.proprietaryData.size() != second.proprietaryData.size())
+		return false;
+
+	for (size_t i = 0; i < first.proprietaryData.size(); i++)
+	{
+		if (first.proprietaryData[i].type != second.proprietaryData[i].type ||
+			first.proprietaryData[i].data != second.proprietaryData[i].data)
+			return false;
+	}
+
+	return true;
+}
+
+void BluetoothAdvertisingScheduler::setData(uint8_t advertiserId, bool isScanResponse, const AdvertiseData &data, int size,
+											BluetoothResultCallback callback)
+{
+	auto advertisementIter = mAdvertisements.find(advertiserId);
+	if (advertisementIter == mAdvertisements.end())
+	{
+		callback(BLUETOOTH_ERROR_PARAM_INVALID);
+		return;
+	}
+
+	Advertisement &advertisement = advertisementIter->second;
+	AdvertiseData &current = isScanResponse ? advertisement.info.scanResponse : advertisement.info.advertiseData;
+	int &currentSize = isScanResponse ? advertisement.info.scanResponseSize : advertisement.info.advertiseDataSize;
+
+	if (isSameData(current, data, false))
+	{
+		advertisement.unchangedDataUpdates++;
+		callback(BLUETOOTH_ERROR_NONE);
+		return;
+	}
+
+	current = data;
+	currentSize = size;
+	advertisement.dataUpdates++;
+
+	// Sent along when the advertisement gets its next turn
+	if (!advertisement.assigned)
+	{
+		callback(BLUETOOTH_ERROR_NONE);
+		return;
+	}
+
+	// Sent once the pending start or stop of the set has completed, and only
+	// if the set still holds this advertisement by then
+	HardwareSet &set = mSets[advertisement.hardwareId];
+	if (set.busy || !advertisement.onAirSince)
+	{
+		if (isScanResponse)
+			advertisement.scanResponseDirty = true;
+		else
+			advertisement.advertiseDataDirty = true;
+		callback(BLUETOOTH_ERROR_NONE);
+		return;
+	}
+
+	uint8_t hardwareId = advertisement.hardwareId;
+	set.busy = true;
+
+	std::weak_ptr<bool> alive = mAlive;
+	mAdapter->setAdvertiserData(hardwareId, isScanResponse, data, [this, alive, hardwareId, callback](BluetoothError error) {
+		if (!alive.expired())
+			settle(hardwareId);
+
+		callback(error);
+	});
+}
+
+void BluetoothAdvertisingScheduler::pushDirtyData(uint8_t hardwareId)
+{
+	HardwareSet &set = mSets[hardwareId];
+	auto advertisementIter = mAdvertisements.find(set.advertiserId);
+	if (advertisementIter == mAdvertisements.end())
+		return;
+
+	Advertisement &advertisement = advertisementIter->second;
+	if (!advertisement.onAirSince || (!advertisement.advertiseDataDirty && !advertisement.scanResponseDirty))
+		return;
+
+	bool isScanResponse = !advertisement.advertiseDataDirty;
+	if (isScanResponse)
+		advertisement.scanResponseDirty = false;
+	else
+		advertisement.advertiseDataDirty = false;
+
+	uint8_t advertiserId = set.advertiserId;
+	set.busy = true;
+
+	std::weak_ptr<bool> alive = mAlive;
+	mAdapter->setAdvertiserData(hardwareId, isScanResponse,
+								isScanResponse ? advertisement.info.scanResponse : advertisement.info.advertiseData,
+								[this, alive, hardwareId, advertiserId](BluetoothError error) {
+		if (alive.expired())
+			return;
+
+		if (BLUETOOTH_ERROR_NONE != error)
+			BT_WARNING(MSGID_ADVERTISING_SCHEDULER, 0, "Failed to update data of advertiser %d on set %d: %d",
+					   advertiserId, hardwareId, error);
+
+		settle(hardwareId);
+	});
+}
+
+void BluetoothAdvertisingScheduler::registerSet(uint8_t advertiserId)
+{
+	mAdvertisements[advertiserId].registering = true;
+	mPendingRegistrations++;
+
+	std::weak_ptr<bool> alive = mAlive;
+	mAdapter->registerAdvertiser([this, alive, advertiserId](BluetoothError error, uint8_t hardwareId) {
+		if (alive.expired())
+			return;
+
+		mPendingRegistrations--;
+
+		if (BLUETOOTH_ERROR_NONE == error)
+		{
+			HardwareSet set = { 0, false };
+			mSets[hardwareId] = set;
+		}
+		else if (!mSets.empty())
+		{
+			mMaxSets = mSets.size() + mPendingRegistrations;
+			BT_WARNING(MSGID_ADVERTISING_SCHEDULER, 0, "Controller refused another advertising set, rotating over %u",
+					   mMaxSets);
+		}
+
+		auto advertisementIter = mAdvertisements.find(advertiserId);
+		if (advertisementIter == mAdvertisements.end())
+		{
+			if (BLUETOOTH_ERROR_NONE == error)
+				settle(hardwareId);
+			return;
+		}
+
+		Advertisement &advertisement = advertisementIter->second;
+		advertisement.registering = false;
+
+		AddCallback addCallback = advertisement.addCallback;
+		advertisement.addCallback = nullptr;
+
+		if (advertisement.removing || (BLUETOOTH_ERROR_NONE != error && mSets.empty()))
+		{
+			BluetoothResultCallback removeCallback = advertisement.removeCallback;
+			mAdvertisements.erase(advertisementIter);
+
+			if (BLUETOOTH_ERROR_NONE == error)
+				settle(hardwareId);
+
+			if (addCallback)
+				addCallback(error, 0);
+			if (removeCallback)
+				removeCallback(BLUETOOTH_ERROR_NONE);
+			return;
+		}
+
+		if (BLUETOOTH_ERROR_NONE != error)
+		{
+			// Takes turns on the sets we already have
+			updateRotation();
+			if (addCallback)
+				addCallback(BLUETOOTH_ERROR_NONE, advertiserId);
+			return;
+		}
+
+		advertisement.addCallback = addCallback;
+		putOnAir(hardwareId, advertiserId);
+	});
+}
+
+void BluetoothAdvertisingScheduler::putOnAir(uint8_t hardwareId, uint8_t advertiserId)
+{
+	HardwareSet &set = mSets[hardwareId];
+	set.advertiserId = advertiserId;
+	set.busy = true;
+
+	Advertisement &advertisement = mAdvertisements[advertiserId];
+	advertisement.assigned = true;
+	advertisement.hardwareId = hardwareId;
+	// Goes on air with the current data
+	advertisement.advertiseDataDirty = false;
+	advertisement.scanResponseDirty = false;
+
+	std::weak_ptr<bool> alive = mAlive;
+	mAdapter->startAdvertising(hardwareId, advertisement.info.settings, advertisement.info.advertiseData,
+							   advertisement.info.scanResponse, [this, alive, hardwareId, advertiserId](BluetoothError error) {
+		if (alive.expired())
+			return;
+
+		auto advertisementIter = mAdvertisements.find(advertiserId);
+		if (advertisementIter == mAdvertisements.end())
+		{
+			// Nothing is left to advertise, the set must not stay on air
+			if (BLUETOOTH_ERROR_NONE == error)
+			{
+				takeOffAir(hardwareId);
+				return;
+			}
+
+			HardwareSet &set = mSets[hardwareId];
+			set.advertiserId = 0;
+			set.busy = false;
+			settle(hardwareId);
+			return;
+		}
+
+		Advertisement &advertisement = advertisementIter->second;
+		AddCallback addCallback = advertisement.addCallback;
+		advertisement.addCallback = nullptr;
+
+		if (BLUETOOTH_ERROR_NONE == error)
+		{
+			advertisement.onAirSince = g_get_monotonic_time();
+			advertisement.turns++;
+
+			settle(hardwareId);
+
+			if (addCallback)
+				addCallback(BLUETOOTH_ERROR_NONE, advertiserId);
+			return;
+		}
+
+		BT_WARNING(MSGID_ADVERTISING_SCHEDULER, 0, "Failed to put advertiser %d on set %d: %d",
+				   advertiserId, hardwareId, error);
+
+		HardwareSet &set = mSets[hardwareId];
+		set.advertiserId = 0;
+		set.busy = false;
+		advertisement.assigned = false;
+
+		if (addCallback || advertisement.removing)
+		{
+			BluetoothResultCallback removeCallback = advertisement.removeCallback;
+			mAdvertisements.erase(advertiserId);
+			settle(hardwareId);
+
+			if (addCallback)
+				addCallback(error, 0);
+			if (removeCallback)
+				removeCallback(BLUETOOTH_ERROR_NONE);
+			return;
+		}
+
+		// Left idle until the next slice so a failing advertisement is not
+		// retried in a loop
+		updateRotation();
+	});
+}
+
+void BluetoothAdvertisingScheduler::takeOffAir(uint8_t hardwareId)
+{
+	HardwareSet &set = mSets[hardwareId];
+	set.busy = true;
+	uint8_t advertiserId = set.advertiserId;
+
+	std::weak_ptr<bool> alive = mAlive;
+	mAdapter->disableAdvertiser(hardwareId, [this, alive, hardwareId, advertiserId](BluetoothError error) {
+		if (alive.expired())
+			return;
+
+		if (BLUETOOTH_ERROR_NONE != error)
+			BT_WARNING(MSGID_ADVERTISING_SCHEDULER, 0, "Failed to take advertiser %d off set %d: %d",
+					   advertiserId, hardwareId, error);
+
+		mSets[hardwareId].advertiserId = 0;
+
+		auto advertisementIter = mAdvertisements.find(advertiserId);
+		if (advertisementIter == mAdvertisements.end())
+		{
+			settle(hardwareId);
+			return;
+		}
+
+		Advertisement &advertisement = advertisementIter->second;
+		advertisement.airTimeUs = getAirTime(advertisement, g_get_monotonic_time());
+		advertisement.onAirSince = 0;
+		advertisement.assigned = false;
+
+		if (!advertisement.removing)
+		{
+			settle(hardwareId);
+			return;
+		}
+
+		BluetoothResultCallback removeCallback = advertisement.removeCallback;
+		mAdvertisements.erase(advertisementIter);
+		settle(hardwareId);
+		updateRotation();
+
+		if (removeCallback)
+			removeCallback(error);
+	});
+}
+
+void BluetoothAdvertisingScheduler::settle(uint8_t hardwareId)
+{
+	auto setIter = mSets.find(hardwareId);
+	if (setIter == mSets.end())
+		return;
+
+	HardwareSet &set = setIter->second;
+	set.busy = false;
+
+	if (set.advertiserId)
+	{
+		if (mAdvertisements[set.advertiserId].removing)
+			takeOffAir(hardwareId);
+		else
+			pushDirtyData(hardwareId);
+		return;
+	}
+
+	uint8_t nextId = findNextWaiting(g_get_monotonic_time());
+	if (nextId)
+	{
+		putOnAir(hardwareId, nextId);
+		return;
+	}
+
+	releaseSet(hardwareId);
+}
+
+void BluetoothAdvertisingScheduler::releaseSet(uint8_t hardwareId)
+{
+	mSets[hardwareId].busy = true;
+
+	std::weak_ptr<bool> alive = mAlive;
+	mAdapter->unregisterAdvertiser(hardwareId, [this, alive, hardwareId](BluetoothError error) {
+		if (alive.expired())
+			return;
+
+		if (BLUETOOTH_ERROR_NONE != error)
+			BT_WARNING(MSGID_ADVERTISING_SCHEDULER, 0, "Failed to unregister advertising set %d: %d", hardwareId, error);
+
+		mSets.erase(hardwareId);
+
+		// Something may have been added while the set was released
+		uint8_t nextId = findNextWaiting(g_get_monotonic_time());
+		if (nextId)
+			registerSet(nextId);
+	});
+}
+
+void BluetoothAdvertisingScheduler::updateRotation()
+{
+	if (hasWaiting())
+	{
+		if (!mRotationSource)
+			mRotationSource = MainLoopWatchdog::addTimeout("BluetoothAdvertisingScheduler::rotate", mSliceMs,
+														   &BluetoothAdvertisingScheduler::handleRotation, this);
+	}
+	else if (mRotationSource)
+	{
+		g_source_remove(mRotationSource);
+		mRotationSource = 0;
+	}
+}
+
+gboolean BluetoothAdvertisingScheduler::handleRotation(gpointer userData)
+{
+	BluetoothAdvertisingScheduler *scheduler = static_cast<BluetoothAdvertisingScheduler*>(userData);
+
+	scheduler->rotate();
+
+	if (scheduler->hasWaiting())
+		return TRUE;
+
+	scheduler->mRotationSource = 0;
+	return FALSE;
+}
+
+void BluetoothAdvertisingScheduler::rotate()
+{
+	std::vector<uint8_t> idleSets;
+	for (auto &set : mSets)
+	{
+		if (!set.second.busy && !set.second.advertiserId)
+			idleSets.push_back(set.first);
+	}
+
+	// Sets left idle after a failed start get a waiting advertisement again
+	for (auto hardwareId : idleSets)
+		settle(hardwareId);
+
+	int64_t now = g_get_monotonic_time();
+	int64_t sliceUs = (int64_t) mSliceMs * 1000;
+
+	std::vector<std::pair<int64_t, uint8_t>> waiting;
+	for (auto &advertisement : mAdvertisements)
+	{
+		const Advertisement &candidate = advertisement.second;
+		if (!candidate.assigned && !candidate.registering && !candidate.removing)
+			waiting.push_back(std::make_pair(getVirtualTime(candidate, now), advertisement.first));
+	}
+
+	std::vector<std::pair<int64_t, uint8_t>> onAir;
+	for (auto &set : mSets)
+	{
+		if (set.second.busy || !set.second.advertiserId)
+			continue;
+
+		const Advertisement &current = mAdvertisements[set.second.advertiserId];
+		if (now - current.onAirSince >= sliceUs)
+			onAir.push_back(std::make_pair(getVirtualTime(current, now), set.first));
+	}
+
+	// The waiting ones furthest behind replace the ones on air furthest ahead
+	std::sort(waiting.begin(), waiting.end());
+	std::sort(onAir.begin(), onAir.end(), std::greater<std::pair<int64_t, uint8_t>>());
+
+	for (size_t i = 0; i < onAir.size() && i < waiting.size(); i++)
+	{
+		if (waiting[i].first >= onAir[i].first)
+			break;
+
+		mRotations++;
+		takeOffAir(onAir[i].second);
+	}
+}
+
+pbnjson::JValue BluetoothAdvertisingScheduler::getStatistics() const
+{
+	int64_t now = g_get_monotonic_time();
+
+	pbnjson::JValue advertisersObj = pbnjson::Array();
+	for (auto &advertisement : mAdvertisements)
+	{
+		const Advertisement &current = advertisement.second;
+
+		int64_t airTime = getAirTime(current, now);
+		int64_t lifetime = now - current.addedTime;
+		double dutyCycle = lifetime > 0 ? (double) airTime / lifetime : 0;
+		int32_t interval = current.info.settings.maxInterval ? current.info.settings.maxInterval :
+						   current.info.settings.minInterval;
+
+		pbnjson::JValue advertiserObj = pbnjson::Object();
+		advertiserObj.put("advertiserId", (int32_t) advertisement.first);
+		advertiserObj.put("weight", (int32_t) current.weight);
+		advertiserObj.put("onAir", current.onAirSince != 0);
+		advertiserObj.put("turns", (int64_t) current.turns);
+		advertiserObj.put("dataUpdates", (int64_t) current.dataUpdates);
+		advertiserObj.put("unchangedDataUpdates", (int64_t) current.unchangedDataUpdates);
+		advertiserObj.put("airTimeUs", airTime);
+		advertiserObj.put("dutyCycle", dutyCycle);
+		if (interval > 0)
+		{
+			advertiserObj.put("intervalMs", interval);
+			// Average gap between advertising events a scanner sees
+			if (dutyCycle > 0)
+				advertiserObj.put("effectiveIntervalMs", (int64_t) (interval / dutyCycle));
+		}
+		advertisersObj.append(advertiserObj);
+	}
+
+	pbnjson::JValue statisticsObj = pbnjson::Object();
+	statisticsObj.put("sets", (int32_t) mSets.size());
+	statisticsObj.put("maxSets", (int32_t) mMaxSets);
+	statisticsObj.put("sliceMs", (int32_t) mSliceMs);
+	statisticsObj.put("rotations", (int64_t) mRotations);
+	statisticsObj.put("advertisers", advertisersObj);
+
+	return statisticsObj;
+}
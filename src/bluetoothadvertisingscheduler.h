@@ -0,0 +1,146 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef BLUETOOTH_ADVERTISING_SCHEDULER_H
+#define BLUETOOTH_ADVERTISING_SCHEDULER_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+
+#include <glib.h>
+#include <pbnjson.hpp>
+#include <bluetooth-sil-api.h>
+
+struct AdvertiserInfo
+{
+	AdvertiseData advertiseData = {};
+	AdvertiseData scanResponse = {};
+	AdvertiseSettings settings = {};
+	// Encoded sizes of the payloads in bytes, -1 while not known
+	int advertiseDataSize = -1;
+	int scanResponseSize = -1;
+};
+
+/*
+ * Time slices more advertisements than the controller has advertising sets.
+ *
+ * Clients get a logical advertiser id. Each advertisement is put on one of
+ * the hardware sets registered with the SIL; while there are more of them
+ * than sets, the one on air that is furthest ahead of its fair share is
+ * swapped for the waiting one furthest behind every slice. The share of an
+ * advertisement is its air time divided by its weight, so a weight 2 beacon
+ * is on air twice as long as a weight 1 advertisement.
+ *
+ * The number of sets is either configured or learned: once the controller
+ * refuses to register another set the current count is taken as its limit.
+ */
+class BluetoothAdvertisingScheduler
+{
+public:
+	typedef std::function<void(BluetoothError error, uint8_t advertiserId)> AddCallback;
+
+	BluetoothAdvertisingScheduler(BluetoothAdapter *adapter, unsigned int maxSets, unsigned int sliceMs);
+	~BluetoothAdvertisingScheduler();
+
+	BluetoothAdvertisingScheduler(const BluetoothAdvertisingScheduler&) = delete;
+	BluetoothAdvertisingScheduler& operator = (const BluetoothAdvertisingScheduler&) = delete;
+
+	// The callback runs once the advertisement is on air, or right away when
+	// it has to wait for its turn
+	void add(const AdvertiserInfo &info, unsigned int weight, AddCallback callback);
+	// The callback runs once the advertisement is off air
+	void remove(uint8_t advertiserId, BluetoothResultCallback callback);
+	bool has(uint8_t advertiserId) const { return mAdvertisements.find(advertiserId) != mAdvertisements.end(); }
+	const AdvertiserInfo *find(uint8_t advertiserId) const;
+	// Kept for the next turn and applied while on air, without stopping the
+	// set. While a SIL call on the set is pending the data is only sent
+	// once it completes. Data equal to the current one is not sent again.
+	void setData(uint8_t advertiserId, bool isScanResponse, const AdvertiseData &data, int size,
+				 BluetoothResultCallback callback);
+
+	static bool isSameData(const AdvertiseData &first, const AdvertiseData &second, bool ignoreManufacturerData);
+
+	pbnjson::JValue getStatistics() const;
+
+private:
+	typedef struct
+	{
+		AdvertiserInfo info;
+		unsigned int weight;
+		uint8_t hardwareId;
+		int64_t addedTime;
+		// 0 while not advertising
+		int64_t onAirSince;
+		int64_t airTimeUs;
+		// Share a newcomer starts with, so it does not take over the air
+		int64_t virtualStart;
+		uint64_t turns;
+		uint64_t dataUpdates;
+		uint64_t unchangedDataUpdates;
+		// Changed since last sent to the hardware set it is placed on
+		bool advertiseDataDirty;
+		bool scanResponseDirty;
+		// Waiting for a hardware set registered on its behalf
+		bool registering;
+		// Placed on a hardware set, possibly still being started or stopped
+		bool assigned;
+		AddCallback addCallback;
+		bool removing;
+		BluetoothResultCallback removeCallback;
+	} Advertisement;
+
+	typedef struct
+	{
+		// Logical id on air, 0 while idle
+		uint8_t advertiserId;
+		// A SIL call on this set is pending
+		bool busy;
+	} HardwareSet;
+
+	uint8_t allocateId() const;
+	int64_t getAirTime(const Advertisement &advertisement, int64_t now) const;
+	int64_t getVirtualTime(const Advertisement &advertisement, int64_t now) const;
+	uint8_t findNextWaiting(int64_t now) const;
+	bool hasWaiting() const;
+
+	void registerSet(uint8_t advertiserId);
+	void putOnAir(uint8_t hardwareId, uint8_t advertiserId);
+	void takeOffAir(uint8_t hardwareId);
+	void pushDirtyData(uint8_t hardwareId);
+	void settle(uint8_t hardwareId);
+	void releaseSet(uint8_t hardwareId);
+
+	void updateRotation();
+	static gboolean handleRotation(gpointer userData);
+	void rotate();
+
+	BluetoothAdapter *mAdapter;
+	unsigned int mMaxSets;
+	unsigned int mSliceMs;
+	unsigned int mPendingRegistrations;
+	guint mRotationSource;
+	uint64_t mRotations;
+
+	std::map<uint8_t, Advertisement> mAdvertisements;
+	std::map<uint8_t, HardwareSet> mSets;
+	// SIL callbacks arriving after the scheduler is gone are dropped
+	std::shared_ptr<bool> mAlive;
+};
+
+#endif // BLUETOOTH_ADVERTISING_SCHEDULER_H
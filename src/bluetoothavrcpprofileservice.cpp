@@ -22,6 +22,8 @@
 #include "bluetootherrors.h"
 #include "ls2utils.h"
 #include "clientwatch.h"
+#include "responseworkerpool.h"
+#include "eventqueue.h"
 #include "logging.h"
 #include "utils.h"
 #include "bluetoothclientwatch.h"
@@ -225,6 +227,10 @@ void BluetoothAvrcpProfileService::initialize(const std::string &adapterAddress)
 
 void BluetoothAvrcpProfileService::propertiesChanged(const std::string &adapterAddress, const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothAvrcpProfileService::propertiesChanged", mAlive,
+			[=] { BluetoothAvrcpProfileService::propertiesChanged(adapterAddress, address, properties); }))
+		return;
+
 	BluetoothProfileService::propertiesChanged(adapterAddress, address, properties);
 
 	bool connected = false;
@@ -364,7 +370,7 @@ bool BluetoothAvrcpProfileService::supplyMediaMetaData(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(requestId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(requestId, string),
 		OBJECT(metaData, OBJSCHEMA_7(PROP(title, string), PROP(artist, string), PROP(album, string), PROP(genre, string),
 			PROP(mediaNumber, integer), PROP(totalMediaCount, integer), PROP(duration, integer))),
 		PROP(adapterAddress, string))
@@ -485,7 +491,7 @@ bool BluetoothAvrcpProfileService::supplyMediaPlayStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(requestId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(requestId, string),
 		OBJECT(playbackStatus, OBJSCHEMA_3(PROP(duration, integer), PROP(position, integer), PROP(status, string))),
 		PROP(adapterAddress, string))
 		REQUIRED_2(requestId, playbackStatus));
@@ -678,7 +684,7 @@ bool BluetoothAvrcpProfileService::sendPassThroughCommand(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string),
 		PROP(keyCode, string), PROP(keyStatus, string),PROP(adapterAddress, string))
 		REQUIRED_3(address, keyCode, keyStatus));
 
@@ -765,7 +771,7 @@ bool BluetoothAvrcpProfileService::getMediaMetaData(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
                                                 PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -853,7 +859,7 @@ bool BluetoothAvrcpProfileService::getPlayerApplicationSettings(LSMessage &messa
 	int parseError = 0;
 	bool subscribed = false;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
                                                 PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -985,7 +991,7 @@ bool BluetoothAvrcpProfileService::setPlayerApplicationSettings(LSMessage &messa
 	BluetoothPlayerApplicationSettingsPropertiesList propertiesToChange;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_6(
+	const char *schema =  STRICT_SCHEMA(PROPS_6(
                                     PROP(adapterAddress, string), PROP(address, string), PROP(equalizer, string),
                                     PROP(repeat, string), PROP(shuffle, string),
                                     PROP(scan, string)));
@@ -1133,7 +1139,7 @@ bool BluetoothAvrcpProfileService::setAbsoluteVolume(LSMessage &message)
 	BluetoothPlayerApplicationSettingsPropertiesList propertiesToChange;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
 		PROP(volume, integer), PROP(adapterAddress, string))
 		REQUIRED_2(address, volume));
 
@@ -1213,7 +1219,7 @@ bool BluetoothAvrcpProfileService::getRemoteVolume(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
                                                 PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1343,7 +1349,7 @@ bool BluetoothAvrcpProfileService::getMediaPlayStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
                                                 PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1422,7 +1428,7 @@ bool BluetoothAvrcpProfileService::receivePassThroughCommand(LSMessage& message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
 		PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1514,7 +1520,7 @@ bool BluetoothAvrcpProfileService::getSupportedNotificationEvents(LSMessage &mes
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
                                                 PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1592,7 +1598,7 @@ bool BluetoothAvrcpProfileService::getRemoteFeatures(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -2002,25 +2008,28 @@ void BluetoothAvrcpProfileService::mediaPlayStatusReceived(const BluetoothMediaP
 			deviceIter->second = playStatus;
 		}
 	}
+
+	// Position updates arrive every second while playing, so the payload
+	// is written once straight into a reused buffer
+	mPlayStatusWriter.reset();
+	mPlayStatusWriter.beginObject();
+	mPlayStatusWriter.put("returnValue", true);
+	mPlayStatusWriter.put("subscribed", true);
+	mPlayStatusWriter.put("address", address);
+	mPlayStatusWriter.put("adapterAddress", adapterAddress);
+	mPlayStatusWriter.beginObject("playbackStatus");
+	mPlayStatusWriter.put("duration", (int32_t)playStatus.getDuration());
+	mPlayStatusWriter.put("position", (int32_t)playStatus.getPosition());
+	mPlayStatusWriter.put("status", mediaPlayStatusToString(playStatus.getStatus()));
+	mPlayStatusWriter.endObject();
+	mPlayStatusWriter.endObject();
+
 	for (auto watch : mMediaPlayStatusWatchesForMultipleAdapters)
 	{
 		if (convertToLower(adapterAddress) == convertToLower(watch->getAdapterAddress()) &&
 			convertToLower(address) == convertToLower(watch->getDeviceAddress()))
 		{
-			pbnjson::JValue object = pbnjson::Object();
-
-			object.put("returnValue", true);
-			object.put("subscribed", true);
-			object.put("address", address);
-			object.put("adapterAddress", adapterAddress);
-
-			pbnjson::JValue playStatusObj = pbnjson::Object();
-			playStatusObj.put("duration", (int32_t)playStatus.getDuration());
-			playStatusObj.put("position", (int32_t)playStatus.getPosition());
-			playStatusObj.put("status", mediaPlayStatusToString(playStatus.getStatus()));
-
-			object.put("playbackStatus", playStatusObj);
-			LSUtils::postToClient(watch->getMessage(), object);
+			LSUtils::postToClient(watch->getMessage(), mPlayStatusWriter.getPayload());
 		}
 	}
 }
@@ -2205,7 +2214,7 @@ bool BluetoothAvrcpProfileService::prepareAwaitRequest(LS::Message &request, pbn
 {
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true),
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true),
 		PROP(adapterAddress, string)) REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -2785,7 +2794,7 @@ bool BluetoothAvrcpProfileService::getPlayerInfo(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 				PROP(address, string), PROP_WITH_VAL_1(subscribe, boolean, true))
 			REQUIRED_2(subscribe, address));
 
@@ -3007,7 +3016,7 @@ bool BluetoothAvrcpProfileService::getCurrentFolder(LSMessage &message){
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
 				PROP(subscribe, boolean))REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -3082,7 +3091,7 @@ bool BluetoothAvrcpProfileService::getNumberOfItems(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(address, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(address, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -3148,7 +3157,7 @@ bool BluetoothAvrcpProfileService::getFolderItems(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
 													 PROP(address, string), PROP(startIndex, integer),
 													 PROP(endIndex, integer)) REQUIRED_3(address, startIndex, endIndex));
 
@@ -3190,46 +3199,50 @@ bool BluetoothAvrcpProfileService::getFolderItems(LSMessage &message)
 
 	LSMessage *requestMessage = request.get();
 	LSMessageRef(requestMessage);
-	auto folderItemsCallback = [this, requestMessage, adapterAddress, deviceAddress](
+	auto folderItemsCallback = [requestMessage, adapterAddress, deviceAddress](
 								   BluetoothError error, const BluetoothFolderItemList &folderItems) {
 		if (BLUETOOTH_ERROR_NONE != error)
 		{
 			LSUtils::respondWithError(requestMessage, error);
 			return;
 		}
-		pbnjson::JValue responseObj = pbnjson::Object();
-		pbnjson::JValue itemArray = pbnjson::Array();
 
-		responseObj.put("adapterAddress", adapterAddress);
-		responseObj.put("address", deviceAddress);
-		responseObj.put("returnValue", true);
-		for (auto item : folderItems)
-		{
-			pbnjson::JValue itemObj = pbnjson::Object();
-			itemObj.put("name", item.getName());
-			itemObj.put("path", item.getPath());
-			itemObj.put("type", folderItemTypeEnumToString(item.getType()));
-			itemObj.put("playable", item.getPlayable());
-			if (BluetoothAvrcpItemType::ITEM_TYPE_FOLDER != item.getType())
+		ResponseWorkerPool::respond(requestMessage, folderItems.size(),
+									[folderItems, adapterAddress, deviceAddress]() -> std::string {
+			pbnjson::JValue responseObj = pbnjson::Object();
+			pbnjson::JValue itemArray = pbnjson::Array();
+
+			responseObj.put("adapterAddress", adapterAddress);
+			responseObj.put("address", deviceAddress);
+			responseObj.put("returnValue", true);
+			for (auto item : folderItems)
 			{
-				pbnjson::JValue metadataObj = pbnjson::Object();
-				BluetoothMediaMetaData mediaMetadata = item.getMetadata();
-
-				metadataObj.put("title", mediaMetadata.getTitle());
-				metadataObj.put("artist", mediaMetadata.getArtist());
-				metadataObj.put("album", mediaMetadata.getAlbum());
-				metadataObj.put("genre", mediaMetadata.getGenre());
-				metadataObj.put("trackNumber", (int32_t)mediaMetadata.getTrackNumber());
-				metadataObj.put("trackCount", (int32_t)mediaMetadata.getTrackCount());
-				metadataObj.put("duration", (int32_t)mediaMetadata.getDuration());
-
-				itemObj.put("metaData", metadataObj);
+				pbnjson::JValue itemObj = pbnjson::Object();
+				itemObj.put("name", item.getName());
+				itemObj.put("path", item.getPath());
+				itemObj.put("type", folderItemTypeEnumToString(item.getType()));
+				itemObj.put("playable", item.getPlayable());
+				if (BluetoothAvrcpItemType::ITEM_TYPE_FOLDER != item.getType())
+				{
+					pbnjson::JValue metadataObj = pbnjson::Object();
+					BluetoothMediaMetaData mediaMetadata = item.getMetadata();
+
+					metadataObj.put("title", mediaMetadata.getTitle());
+					metadataObj.put("artist", mediaMetadata.getArtist());
+					metadataObj.put("album", mediaMetadata.getAlbum());
+					metadataObj.put("genre", mediaMetadata.getGenre());
+					metadataObj.put("trackNumber", (int32_t)mediaMetadata.getTrackNumber());
+					metadataObj.put("trackCount", (int32_t)mediaMetadata.getTrackCount());
+					metadataObj.put("duration", (int32_t)mediaMetadata.getDuration());
+
+					itemObj.put("metaData", metadataObj);
+				}
+				itemArray.append(itemObj);
 			}
-			itemArray.append(itemObj);
-		}
-		responseObj.put("folderItems", itemArray);
+			responseObj.put("folderItems", itemArray);
 
-		LSUtils::postToClient(requestMessage, responseObj);
+			return responseObj.stringify();
+		});
 		LSMessageUnref(requestMessage);
 	};
 	impl->getFolderItems(requestObj["startIndex"].asNumber<int32_t>(),
@@ -3260,7 +3273,7 @@ bool BluetoothAvrcpProfileService::changePath(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 													 PROP(address, string), PROP(itemPath, string)) REQUIRED_2(address, itemPath));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -3321,7 +3334,7 @@ bool BluetoothAvrcpProfileService::playItem(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 													 PROP(address, string), PROP(itemPath, string))
 													 REQUIRED_2(address, itemPath));
 
@@ -3382,7 +3395,7 @@ bool BluetoothAvrcpProfileService::addToNowPlaying(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 													 PROP(address, string), PROP(itemPath, string)) REQUIRED_2(address, itemPath));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -3443,7 +3456,7 @@ bool BluetoothAvrcpProfileService::search(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 													 PROP(address, string), PROP(searchString, string)) REQUIRED_2(address, searchString));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -3514,7 +3527,7 @@ bool BluetoothAvrcpProfileService::notifyMediaPlayStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
 		OBJECT(playbackStatus, OBJSCHEMA_3(PROP(duration, integer), PROP(position, integer), PROP(status, string))),
 		PROP(adapterAddress, string))
 		REQUIRED_2(address, playbackStatus));
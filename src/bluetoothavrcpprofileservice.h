@@ -27,6 +27,7 @@
 #include <pbnjson.hpp>
 
 #include "bluetoothprofileservice.h"
+#include "jsonwriter.h"
 
 #define DELETE_OBJ(del_obj) if(del_obj) { delete del_obj; del_obj = 0; }
 
@@ -180,7 +181,7 @@ private:
 							const std::string &address);
 	void clearPlayStatus(const std::string &adapterAddress,
 						 const std::string &address);
-	std::string folderItemTypeEnumToString(BluetoothAvrcpItemType type);
+	static std::string folderItemTypeEnumToString(BluetoothAvrcpItemType type);
 	BluetoothClientWatch *getMediaRequestWatch(
 		std::list<BluetoothClientWatch *> &clientWatches, const std::string &adapterAddress);
 
@@ -218,6 +219,7 @@ private:
 	std::list<BluetoothClientWatch*> mNotificationEventsWatchesForMultipleAdapters;
 	std::list<BluetoothClientWatch*> mGetMediaMetaDataWatchesForMultipleAdapters;
 	std::list<BluetoothClientWatch*> mMediaPlayStatusWatchesForMultipleAdapters;
+	JsonWriter mPlayStatusWriter;
 	std::list<BluetoothClientWatch*> mPlayerApplicationSettingsWatchesForMultipleAdapters;
 	std::list<BluetoothClientWatch*> mReceivePassThroughCommandWatchesForMultipleAdapters;
 	std::list<BluetoothClientWatch*> mGetRemoteVolumeWatchesForMultipleAdapters;
@@ -17,6 +17,7 @@
 
 #include "bluetoothbinarysocket.h"
 #include "logging.h"
+#include "mainloopwatchdog.h"
 
 BluetoothBinarySocket::BluetoothBinarySocket() :
 	mBufferSize(0),
@@ -133,8 +134,8 @@ bool BluetoothBinarySocket::registerReceiveDataWatch(BluetoothBinarySocketReceiv
 	g_io_channel_set_flags(mServerIoChannel, G_IO_FLAG_NONBLOCK, NULL);
 	g_io_channel_set_close_on_unref(mServerIoChannel, TRUE);
 
-	g_io_add_watch(mServerIoChannel, (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL),
-					&getAcceptRequest, this);
+	MainLoopWatchdog::addIoWatch("BluetoothBinarySocket::getAcceptRequest", mServerIoChannel,
+					(GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL), &getAcceptRequest, this);
 
 	return true;
 }
@@ -191,7 +192,8 @@ void BluetoothBinarySocket::retrySendData(const uint8_t *data, const uint32_t si
 	mRetryDataSize = size;
 	mRetryCount = 0;
 
-	g_timeout_add(WRITE_RETRY_SLEEP_TIME, retrySendDataCallback, this);
+	MainLoopWatchdog::addTimeout("BluetoothBinarySocket::retrySendData", WRITE_RETRY_SLEEP_TIME,
+					retrySendDataCallback, this);
 }
 
 void BluetoothBinarySocket::storeSendDataToBuffer(const uint8_t *data, const uint32_t size)
@@ -243,8 +245,8 @@ gboolean BluetoothBinarySocket::getAcceptRequest(GIOChannel *io, GIOCondition co
 	binarySocket->mClientIoChannel = g_io_channel_unix_new(binarySocket->mClientSocketFd);
 	g_io_channel_set_flags(binarySocket->mClientIoChannel, G_IO_FLAG_NONBLOCK, NULL);
 	g_io_channel_set_close_on_unref(binarySocket->mClientIoChannel, TRUE);
-	g_io_add_watch(binarySocket->mClientIoChannel, (GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL),
-					&getReceiveRequest, userData);
+	MainLoopWatchdog::addIoWatch("BluetoothBinarySocket::getReceiveRequest", binarySocket->mClientIoChannel,
+					(GIOCondition)(G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL), &getReceiveRequest, userData);
 
 	return TRUE;
 }
@@ -0,0 +1,96 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <glib.h>
+
+#include "bluetoothconnectiontable.h"
+#include "utils.h"
+
+// Keys of packed addresses use the low 48 bits only
+#define UNPACKED_KEY_FLAG		(1ULL << 63)
+
+uint64_t BluetoothConnectionTable::packAddress(const std::string &address)
+{
+	uint64_t key = 0;
+	int digits = 0;
+
+	for (char c : address)
+	{
+		if (c == ':')
+			continue;
+
+		int value = g_ascii_xdigit_value(c);
+		if (value < 0 || ++digits > 12)
+		{
+			digits = -1;
+			break;
+		}
+
+		key = (key << 4) | value;
+	}
+
+	if (digits == 12)
+		return key;
+
+	// Not a bluetooth address (or none at all for the single adapter state),
+	// still give it a stable case insensitive key
+	return std::hash<std::string>()(convertToLower(address)) | UNPACKED_KEY_FLAG;
+}
+
+uint8_t BluetoothConnectionTable::getState(const std::string &adapterAddress, const std::string &address) const
+{
+	auto adapterIter = mAdapters.find(packAddress(adapterAddress));
+	if (adapterIter == mAdapters.end())
+		return 0;
+
+	auto deviceIter = adapterIter->second.find(packAddress(address));
+	if (deviceIter == adapterIter->second.end())
+		return 0;
+
+	return deviceIter->second;
+}
+
+void BluetoothConnectionTable::setState(const std::string &adapterAddress, const std::string &address, State state, bool enabled)
+{
+	uint64_t adapterKey = packAddress(adapterAddress);
+	uint64_t deviceKey = packAddress(address);
+
+	uint8_t previousState = 0;
+	auto adapterIter = mAdapters.find(adapterKey);
+	if (adapterIter != mAdapters.end())
+	{
+		auto deviceIter = adapterIter->second.find(deviceKey);
+		if (deviceIter != adapterIter->second.end())
+			previousState = deviceIter->second;
+	}
+
+	uint8_t newState = enabled ? (previousState | state) : (previousState & ~state);
+	if (newState == previousState)
+		return;
+
+	if (newState)
+		mAdapters[adapterKey][deviceKey] = newState;
+	else
+	{
+		adapterIter->second.erase(deviceKey);
+		if (adapterIter->second.empty())
+			mAdapters.erase(adapterIter);
+	}
+
+	if (mChangedCallback)
+		mChangedCallback(adapterAddress, address, previousState, newState);
+}
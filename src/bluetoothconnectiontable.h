@@ -0,0 +1,64 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef BLUETOOTH_CONNECTION_TABLE_H
+#define BLUETOOTH_CONNECTION_TABLE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Connection state of the devices of one profile, per adapter. Addresses are
+ * packed into integers, so lookups and updates are a hash lookup without
+ * converting or copying the address strings. The state of a device is a set
+ * of the flags below; a device without any is not stored.
+ *
+ * The changed callback is called on every transition, after the table was
+ * updated, with the addresses as given to the update.
+ */
+class BluetoothConnectionTable
+{
+public:
+	typedef enum
+	{
+		STATE_CONNECTING = 0x01,
+		STATE_CONNECTED = 0x02,
+		STATE_LOCAL_DISCONNECT = 0x04
+	} State;
+
+	typedef std::function<void(const std::string &adapterAddress, const std::string &address,
+	                           uint8_t previousState, uint8_t state)> ChangedCallback;
+
+	void setChangedCallback(ChangedCallback callback) { mChangedCallback = callback; }
+
+	uint8_t getState(const std::string &adapterAddress, const std::string &address) const;
+	bool hasState(const std::string &adapterAddress, const std::string &address, State state) const
+	{
+		return (getState(adapterAddress, address) & state) != 0;
+	}
+	void setState(const std::string &adapterAddress, const std::string &address, State state, bool enabled);
+
+private:
+	static uint64_t packAddress(const std::string &address);
+
+	std::unordered_map<uint64_t, std::unordered_map<uint64_t, uint8_t>> mAdapters;
+	ChangedCallback mChangedCallback;
+};
+
+#endif // BLUETOOTH_CONNECTION_TABLE_H
@@ -0,0 +1,101 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <cstring>
+
+#include "bluetoothdevicefields.h"
+
+typedef struct
+{
+	const char *name;
+	uint32_t field;
+} FieldName;
+
+static const FieldName fieldNames[] =
+{
+	{ "name", BluetoothDeviceFields::NAME },
+	{ "typeOfDevice", BluetoothDeviceFields::TYPE_OF_DEVICE },
+	{ "classOfDevice", BluetoothDeviceFields::CLASS_OF_DEVICE },
+	{ "paired", BluetoothDeviceFields::PAIRED },
+	{ "pairing", BluetoothDeviceFields::PAIRING },
+	{ "trusted", BluetoothDeviceFields::TRUSTED },
+	{ "blocked", BluetoothDeviceFields::BLOCKED },
+	{ "rssi", BluetoothDeviceFields::RSSI },
+	{ "adapterAddress", BluetoothDeviceFields::ADAPTER_ADDRESS },
+	{ "manufacturerData", BluetoothDeviceFields::MANUFACTURER_DATA },
+	{ "scanRecord", BluetoothDeviceFields::SCAN_RECORD },
+	{ "serviceClasses", BluetoothDeviceFields::SERVICE_CLASSES },
+	{ "connectedProfiles", BluetoothDeviceFields::CONNECTED_PROFILES },
+	{ "connectedRoles", BluetoothDeviceFields::CONNECTED_ROLES }
+};
+
+bool BluetoothDeviceFields::compile(const pbnjson::JValue &requestObj, uint32_t &fields)
+{
+	if (!requestObj.hasKey("fields"))
+	{
+		fields = ALL;
+		return true;
+	}
+
+	pbnjson::JValue fieldsObj = requestObj["fields"];
+	if (!fieldsObj.isArray())
+		return false;
+
+	fields = 0;
+	for (int i = 0; i < fieldsObj.arraySize(); i++)
+	{
+		std::string name = fieldsObj[i].asString();
+		if ("address" == name)
+			continue;
+
+		uint32_t field = 0;
+		for (auto &fieldName : fieldNames)
+		{
+			if (!strcmp(fieldName.name, name.c_str()))
+			{
+				field = fieldName.field;
+				break;
+			}
+		}
+
+		if (!field)
+			return false;
+
+		fields |= field;
+	}
+
+	return true;
+}
+
+BluetoothDeviceFieldSubscriptions::BluetoothDeviceFieldSubscriptions() :
+	mServiceHandle(0)
+{
+}
+
+void BluetoothDeviceFieldSubscriptions::subscribe(LS::Message &request, uint32_t fields)
+{
+	auto subscriptionsIter = mSubscriptions.find(fields);
+	if (subscriptionsIter == mSubscriptions.end())
+	{
+		LS::SubscriptionPoint *subscriptionPoint = new LS::SubscriptionPoint;
+		subscriptionPoint->setServiceHandle(mServiceHandle);
+		subscriptionsIter = mSubscriptions.insert(std::make_pair(fields,
+				std::unique_ptr<LS::SubscriptionPoint>(subscriptionPoint))).first;
+	}
+
+	subscriptionsIter->second->subscribe(request);
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef BLUETOOTH_DEVICE_FIELDS_H
+#define BLUETOOTH_DEVICE_FIELDS_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include <pbnjson.hpp>
+#include <luna-service2/lunaservice.hpp>
+
+/*
+ * Projection of the device objects returned by the device list methods and
+ * scan results. A client passes the members it needs in "fields", which is
+ * compiled once into a bitmask the device serializers check per member.
+ * "address" identifies the device and is always included.
+ */
+namespace BluetoothDeviceFields
+{
+
+enum : uint32_t
+{
+	NAME = 1 << 0,
+	TYPE_OF_DEVICE = 1 << 1,
+	CLASS_OF_DEVICE = 1 << 2,
+	PAIRED = 1 << 3,
+	PAIRING = 1 << 4,
+	TRUSTED = 1 << 5,
+	BLOCKED = 1 << 6,
+	RSSI = 1 << 7,
+	ADAPTER_ADDRESS = 1 << 8,
+	MANUFACTURER_DATA = 1 << 9,
+	SCAN_RECORD = 1 << 10,
+	SERVICE_CLASSES = 1 << 11,
+	CONNECTED_PROFILES = 1 << 12,
+	CONNECTED_ROLES = 1 << 13,
+	ALL = (1 << 14) - 1
+};
+
+// All fields when the request has no "fields" member, false on unknown names
+bool compile(const pbnjson::JValue &requestObj, uint32_t &fields);
+
+} // namespace BluetoothDeviceFields
+
+/*
+ * Subscribers of one device list method, grouped by their field set so each
+ * distinct projection is serialized once per notification.
+ */
+class BluetoothDeviceFieldSubscriptions
+{
+public:
+	BluetoothDeviceFieldSubscriptions();
+
+	BluetoothDeviceFieldSubscriptions(const BluetoothDeviceFieldSubscriptions&) = delete;
+	BluetoothDeviceFieldSubscriptions& operator = (const BluetoothDeviceFieldSubscriptions&) = delete;
+
+	void setServiceHandle(LS::Handle *serviceHandle) { mServiceHandle = serviceHandle; }
+	void subscribe(LS::Message &request, uint32_t fields);
+
+	template <typename Function>
+	void forEach(Function function)
+	{
+		for (auto &subscriptions : mSubscriptions)
+			function(subscriptions.first, subscriptions.second.get());
+	}
+
+private:
+	LS::Handle *mServiceHandle;
+	std::map<uint32_t, std::unique_ptr<LS::SubscriptionPoint>> mSubscriptions;
+};
+
+#endif // BLUETOOTH_DEVICE_FIELDS_H
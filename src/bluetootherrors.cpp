@@ -15,12 +15,17 @@
 // SPDX-License-Identifier: Apache-2.0
 
 
-#include <string>
-#include <map>
+#include <vector>
 
 #include "bluetootherrors.h"
 
-static std::map<BluetoothError, std::string> bluetoothSILErrorText =
+typedef struct
+{
+	int code;
+	const char *text;
+} ErrorText;
+
+static constexpr ErrorText bluetoothSILErrorTextTable[] =
 {
 	{BLUETOOTH_ERROR_NONE, "No error"},
 	{BLUETOOTH_ERROR_FAIL, "The operation failed for an unspecified or generic reason"},
@@ -72,7 +77,9 @@ static std::map<BluetoothError, std::string> bluetoothSILErrorText =
 	{BLUETOOTH_ERROR_MESH_NETKEY_UPDATE_FAILED, "Network key update failed"}
 };
 
-static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
+// Indexed by code - BT_ERR_ADAPTER_NOT_AVAILABLE, every code up to
+// LAST_ERROR_CODE needs an entry in order (checked below)
+static constexpr ErrorText bluetoothErrorTextTable[] =
 {
 	{BT_ERR_ADAPTER_NOT_AVAILABLE, "Bluetooth adapter is not available"},
 	{BT_ERR_MSG_PARSE_FAIL, "Failed to parse incoming message"},
@@ -82,7 +89,6 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_DEVICE_NOT_AVAIL, "Device with supplied address is not available"},
 	{BT_ERR_PAIRING_CANCELED, "Pairing canceled by user"},
 	{BT_ERR_NO_PAIRING, "There is no pairing in progress"},
-	{BT_ERR_NO_PAIRING_FOR_REQUESTED_ADDRESS, "There is no pairing in progress for requested address"},
 	{BT_ERR_DISCOVERY_TO_NEG_VALUE, "Invalid negative value for discoveryTimeout: "},
 	{BT_ERR_DISCOVERABLE_TO_NEG_VALUE, "Invalid negative value for discoverableTimeout: "},
 	{BT_ERR_PAIRABLE_TO_NEG_VALUE, "Invalid negative value for pairableTimeout: "},
@@ -142,7 +148,6 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_GATT_CHARACTERISTC_VALUE_PARAM_MISSING, "Required characteristic 'value' parameter is not supplied"},
 	{BT_ERR_GATT_CHARACTERISTICS_PARAM_MISSING, "Required 'characteristics' parameter is not supplied"},
 	{BT_ERR_GATT_DESCRIPTOR_INFO_PARAM_MISSING, "Required 'descriptorInfo' parameter is not supplied"},
-	{BT_ERR_GATT_DESCRIPTORS_PARAM_MISSING, "Required 'descriptors' parameter is not supplied"},
 	{BT_ERR_GATT_SERVICE_DISCOVERY_FAIL, "GATT service discovery failed"},
 	{BT_ERR_GATT_DISCOVERY_INVALID_PARAM, "GATT service discovery cannot be started, one of adapterAddress or address should be supplied"},
 	{BT_ERR_GATT_ADD_SERVICE_FAIL, "GATT add service failed"},
@@ -153,12 +158,6 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_GATT_CHARACTERISTC_INVALID_VALUE_PARAM, "Invalid value input for GATT characteristic"},
 	{BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL, "GATT monitor characteristic failed for characteristic: "},
 	{BT_ERR_GATT_INVALID_SERVICE, "Invalid GATT service"},
-	{BT_ERR_GATT_INVALID_DESCRIPTOR, "Invalid GATT descriptor"},
-	{BT_ERR_GATT_READ_DESCRIPTORS_FAIL, "Failed to read descriptors"},
-	{BT_ERR_GATT_DESCRIPTOR_PARAM_MISSING, "Missing descriptor parameter"},
-	{BT_ERR_GATT_DESCRIPTOR_VALUE_PARAM_MISSING, "Missing value parameter for descriptor"},
-	{BT_ERR_GATT_DESCRIPTOR_INVALID_VALUE_PARAM, "Invalid value input for GATT descriptor"},
-	{BT_ERR_GATT_WRITE_DESCRIPTOR_FAIL, "Failed to write GATT descriptor"},
 	{BT_ERR_A2DP_START_STREAMING_FAILED, "A2DP start streaming failed"},
 	{BT_ERR_A2DP_STOP_STREAMING_FAILED, "A2DP stop streaming failed"},
 	{BT_ERR_A2DP_DEVICE_ADDRESS_PARAM_MISSING, "Required 'address' parameter is not supplied"},
@@ -171,6 +170,14 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_AVRCP_REQUEST_NOT_ALLOWED, "Request is currently not allowed"},
 	{BT_ERR_AVRCP_REQUESTID_NOT_EXIST, "The supplied requestId does not exist"},
 	{BT_ERR_AVRCP_STATE_ERR, "Failed to retrieve state for remote device"},
+	{BT_ERR_GATT_DESCRIPTORS_PARAM_MISSING, "Required 'descriptors' parameter is not supplied"},
+	{BT_ERR_GATT_INVALID_DESCRIPTOR, "Invalid GATT descriptor"},
+	{BT_ERR_GATT_READ_DESCRIPTORS_FAIL, "Failed to read descriptors"},
+	{BT_ERR_GATT_DESCRIPTOR_PARAM_MISSING, "Missing descriptor parameter"},
+	{BT_ERR_GATT_DESCRIPTOR_VALUE_PARAM_MISSING, "Missing value parameter for descriptor"},
+	{BT_ERR_GATT_DESCRIPTOR_INVALID_VALUE_PARAM, "Invalid value input for GATT descriptor"},
+	{BT_ERR_GATT_WRITE_DESCRIPTOR_FAIL, "Failed to write GATT descriptor"},
+	{BT_ERR_NO_PAIRING_FOR_REQUESTED_ADDRESS, "There is no pairing in progress for requested address"},
 	{BT_ERR_HFP_OPEN_SCO_FAILED, "Failed to open SCO channel"},
 	{BT_ERR_HFP_CLOSE_SCO_FAILED, "Failed to close SCO channel"},
 	{BT_ERR_HFP_RESULT_CODE_PARAM_MISSING, "Required 'resultCode' parameter is not supplied"},
@@ -187,13 +194,12 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_SPP_TIMEOUT_NOT_AVAILABLE, "The supplied 'timeout' is not available"},
 	{BT_ERR_SPP_PERMISSION_DENIED, "Permission denied"},
 	{BT_ERR_BLE_ADV_CONFIG_FAIL, "Failed to configure advertisement"},
-	{BT_ERR_BLE_ADV_CONFIG_DATA_PARAM_MISSING,"Services and manufacturer data are missing, one should be supplied."},
+	{214, ""}, // not assigned
+	{BT_ERR_BLE_ADV_CONFIG_DATA_PARAM_MISSING, "Services and manufacturer data are missing, one should be supplied."},
 	{BT_ERR_BLE_ADV_CONFIG_EXCESS_DATA_PARAM, "Cannot have both services and manufacturer data, only one should be supplied."},
 	{BT_ERR_BLE_ADV_ALREADY_ADVERTISING, "Already advertising, failed to reconfigure."},
 	{BT_ERR_BLE_ADV_SERVICE_DATA_FAIL, "Cannot have more than one service with data."},
 	{BT_ERR_BLE_ADV_UUID_FAIL, "Cannot configure data without UUID."},
-	{BT_ERR_BLE_ADV_NO_MORE_ADVERTISER, "Failed to start advertising because no advertising instance is available."},
-	{BT_ERR_BLE_ADV_EXCEED_SIZE_LIMIT, "Advertise size cannot be more than 31 bytes."},
 	{BT_ERR_SPP_APPID_PARAM_MISSING, "Application id is not supplied"},
 	{BT_ERR_HFP_ALLOW_ONE_SUBSCRIBE_PER_DEVICE, "Only one subscription per device allowed"},
 	{BT_ERR_PAN_SET_TETHERING_FAILED, "Failed to set bluetooth tethering"},
@@ -231,6 +237,7 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_AVRCP_SET_ABSOLUTE_VOLUME_FAILED, "Failed to set absolute volume"},
 	{BT_ERR_WOBLE_SET_WOBLE_PARAM_MISSING, "Required 'woBleEnabled' parameter is not supplied"},
 	{BT_ERR_WOBLE_SET_WOBLE_TRIGGER_DEVICES_PARAM_MISSING, "Required 'triggerDevices' parameter is not supplied"},
+	{BT_ERR_BLE_ADV_NO_MORE_ADVERTISER, "Failed to start advertising because no advertising instance is available."},
 	{BT_ERR_A2DP_SBC_ENCODER_BITPOOL_MISSING, "Required 'bitpool' parameter is not supplied"},
 	{BT_ERR_HID_DEVICE_ADDRESS_PARAM_MISSING, "Required 'address' parameter is not supplied"},
 	{BT_ERR_HID_REPORT_ID_PARAM_MISSING, "Required 'reportId' parameter is not supplied"},
@@ -251,18 +258,20 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_CONNID_PARAM_MISSING, "Required 'connectId' parameter is not supplied"},
 	{BT_ERR_MESSAGE_OWNER_MISSING, "Required message owner is not supplied"},
 	{BT_ERR_GATT_SERVER_NAME_PARAM_MISSING, "Required 'server' uuid parameter is not supplied"},
-	{BT_ERR_GATT_SERVERID_PARAM_MISSING, "Required 'serverId' parameter is not supplied"},
+	{BT_ERR_GATT_APPLICATION_ID_PARAM_MISSING, "Required application id parameter is not supplied"},
 	{BT_ERR_GATT_REMOVE_SERVER_FAIL, "GATT remove server failed"},
 	{BT_ERR_GATT_ADVERTISERID_PARAM_MISSING, "Required 'advertiserId' parameter is not supplied"},
+	{BT_ERR_GATT_SERVERID_PARAM_MISSING, "Required 'serverId' parameter is not supplied"},
 	{BT_ERR_GATT_READ_DESCRIPTOR_FAIL, "Failed to read descriptor"},
-	{BT_ERR_GATT_INSTANCE_ID_NOT_SUPPORTED, "'instanceId' is not supported"},
 	{BT_ERR_CLIENTID_PARAM_MISSING, "Required 'clientId' parameter is not supplied"},
+	{BT_ERR_BLE_ADV_EXCEED_SIZE_LIMIT, "Advertise size cannot be more than 31 bytes."},
+	{BT_ERR_GATT_INSTANCE_ID_NOT_SUPPORTED, "'instanceId' is not supported"},
 	{BT_ERR_API_NOT_SUPPORTED_BY_STACK, "API not supported by stack"},
 	{BT_ERR_DELAY_REPORTING_ALREADY_ENABLED, "Delay reporting already enabled"},
 	{BT_ERR_DELAY_REPORTING_ALREADY_DISABLED, "Delay reporting already disabled"},
 	{BT_ERR_DELAY_REPORTING_DISABLED, "Delay reporting is  disabled, please enable it to use this api"},
-	{BT_ERR_PBAP_REPOSITORY_PARAM_MISSING, "Required 'repository' parameter is not supplied"},
 	{BT_ERR_PBAP_OBJECT_PARAM_MISSING, "Required 'object ' parameter is not supplied"},
+	{BT_ERR_PBAP_REPOSITORY_PARAM_MISSING, "Required 'repository' parameter is not supplied"},
 	{BT_ERR_NOT_NOT_SUPPORTED_BY_REMOTE_DEVICE, "feature is not supported by remote device"},
 	{BT_ERR_PBAP_VCARD_HANDLE_PARAM_MISSING, "Required 'vCardHandle' parameter is not supplied"},
 	{BT_ERR_PBAP_FILTER_PARAM_MISSING, "Required 'filter' parameter is not supplied"},
@@ -270,15 +279,15 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_MAP_INSTANCE_NOT_EXIST, "The supplied instance does not exist"},
 	{BT_ERR_MAP_SESSION_ID_NOT_EXIST, "The supplied session id does not exist"},
 	{BT_ERR_MAP_SESSION_ID_PARAM_MISSING, "Required 'sessionId' parameter is not supplied"},
-	{BT_ERR_MAP_FOLDER_PARAM_MISSING,"Required 'folder' parameter is not supplied"},
+	{BT_ERR_MAP_FOLDER_PARAM_MISSING, "Required 'folder' parameter is not supplied"},
 	{BT_ERR_AVRCP_START_INDEX_PARAM_MISSING, "Required 'startIndex' parameter is not supplied"},
 	{BT_ERR_AVRCP_END_INDEX_PARAM_MISSING, "Required 'endIndex' parameter is not supplied"},
 	{BT_ERR_AVRCP_ITEM_PATH_PARAM_MISSING, "Required 'itemPath' parameter is not supplied"},
 	{BT_ERR_AVRCP_SEARCH_STRING_PARAM_MISSING, "Required 'searchString' parameter is not supplied"},
+	{BT_ERR_MAP_HANDLE_PARAM_MISSING, "Required 'handle' parameter is not supplied"},
 	{BT_ERR_MAP_INSTANCE_ALREADY_CONNECTED, "The supplied instance already connected"},
-	{BT_ERR_MAP_STATUS_INDICATOR_PARAM_MISSING,"Required 'statusIndicator' parameter is not supplied"},
+	{BT_ERR_MAP_STATUS_INDICATOR_PARAM_MISSING, "Required 'statusIndicator' parameter is not supplied"},
 	{BT_ERR_MAP_STATUS_VALUE_PARAM_MISSING, "Required 'statusValue' parameter is not supplied"},
-	{BT_ERR_MAP_HANDLE_PARAM_MISSING, "Required 'handle' parameter is not supplied"},
 	{BT_ERR_AVRCP_PLAYBACK_STATUS_PARAM_MISSING, "Required 'playbackStatus' parameter is not supplied"},
 	{BT_ERR_MESH_NET_KEY_INDEX_PARAM_MISSING, "Required 'netKeyIndex' parameter is missing"},
 	{BT_ERR_MESH_APP_KEY_INDEX_PARAM_MISSING, "Required 'appKeyIndex' parameter missing"},
@@ -292,43 +301,87 @@ static std::map<BluetoothErrorCode, std::string> bluetoothErrorTextTable =
 	{BT_ERR_MESH_GATT_PROXY_STATE_PARAM_MISSING, "Required 'gattProxyState' parameter missing"},
 	{BT_ERR_MESH_HB_PUB_STATUS_PARAM_MISSING, "Required 'hbPubStatus' parameter missing"},
 	{BT_ERR_MESH_PUB_STATUS_PARAM_MISSING, "Required 'pubStatus' parameter missing"},
+	{BT_ERR_MESH_APP_KEY_INDEX_INVALID, "App key index doesn't belong to this app"},
 	{BT_ERR_MESH_NODE_IDENTITY_PARAM_MISSING, "Required 'nodeIdentity' parameter missing"},
 	{BT_ERR_MESH_RELAY_STATUS_PARAM_MISSING, "Required 'relayStatus' parameter missing"},
 	{BT_ERR_MESH_NUMBER_PARAM_MISSING, "Required 'number' parameter missing"},
 	{BT_ERR_MESH_OOB_DATA_PARAM_MISSING, "Required 'oobData' parameter missing"},
 	{BT_ERR_MESH_ONOFF_PARAM_MISSING, "Required 'onoff' parameter missing"},
-	{BT_ERR_MESH_APP_KEY_INDEX_INVALID, "App key index doesn't belong to this app"},
-	{BT_ERR_MESH_ADAPTER_NOT_AUTHORIZED, "Requested adapter address Not authorized to perform the action"},
 	{BT_ERR_MESH_NETWORK_NOT_CREATED, "Mesh network is not created"},
+	{BT_ERR_MESH_ADAPTER_NOT_AUTHORIZED, "Requested adapter address Not authorized to perform the action"},
 	{BT_ERR_MESH_CONFIG_PARAM_MISSING, "Required 'config' parameter missing"},
 	{BT_ERR_MESH_RELAY_PARAM_MISSING, "Required 'relay' parameter missing"},
 	{BT_ERR_MESH_RETRANSMIT_COUNT_PARAM_MISSING, "Required 'retransmitCount' parameter missing"},
 	{BT_ERR_MESH_RETRANSMIT_INTERVAL_STEPS_PARAM_MISSING, "Required 'retransmitIntervalSteps' parameter missing"},
 	{BT_ERR_MESH_NODE_ADDRESS_INVALID, "Supplied node Address does not exist or is invalid"},
 	{BT_ERR_MESH_PRIMARY_ELEMENT_ADDRESS_PARAM_MISSING, "Required 'primaryElementAddress' parameter missing"},
-	{BT_ERR_MESH_KEY_REFRESH_IN_PROGRESS, "Key refresh is already in progress"}
+	{BT_ERR_MESH_KEY_REFRESH_IN_PROGRESS, "Key refresh is already in progress"},
+	{BT_ERR_MESH_STORE_UNAVAILABLE, "Mesh state could not be loaded from the database"}
 };
 
-void appendErrorResponse(pbnjson::JValue &obj, BluetoothError errorCode)
+#define ERROR_TEXT_COUNT(table) (sizeof(table) / sizeof(table[0]))
+
+static constexpr bool isDenseFrom(const ErrorText *table, size_t count, size_t index, int firstCode)
 {
-	std::string errorText = "Unknown Error";
+	return index == count || (table[index].code == firstCode + (int) index &&
+							  isDenseFrom(table, count, index + 1, firstCode));
+}
 
-	if (bluetoothSILErrorText.find(errorCode) !=  bluetoothSILErrorText.end())
-	{
-		errorText = bluetoothSILErrorText[errorCode];
-	}
+static_assert(ERROR_TEXT_COUNT(bluetoothErrorTextTable) == LAST_ERROR_CODE - FIRST_ERROR_CODE + 1,
+			  "bluetoothErrorTextTable must have an entry for every BluetoothErrorCode");
+static_assert(isDenseFrom(bluetoothErrorTextTable, ERROR_TEXT_COUNT(bluetoothErrorTextTable), 0, FIRST_ERROR_CODE),
+			  "bluetoothErrorTextTable must be ordered by code without gaps");
+
+// The SIL codes come from a header we don't own, so their dense index is
+// built once at first use instead of being checked at compile time
+static const std::vector<const char*> &silErrorTexts()
+{
+	static const std::vector<const char*> texts = [] {
+		std::vector<const char*> dense;
+		for (size_t i = 0; i < ERROR_TEXT_COUNT(bluetoothSILErrorTextTable); i++)
+		{
+			const ErrorText &entry = bluetoothSILErrorTextTable[i];
+			if (entry.code < 0)
+				continue;
+			if ((size_t) entry.code >= dense.size())
+				dense.resize(entry.code + 1, NULL);
+			dense[entry.code] = entry.text;
+		}
+		return dense;
+	}();
+
+	return texts;
+}
+
+static const char *findSILErrorText(BluetoothError errorCode)
+{
+	const std::vector<const char*> &texts = silErrorTexts();
+	if (errorCode < 0 || (size_t) errorCode >= texts.size())
+		return NULL;
+
+	return texts[errorCode];
+}
+
+void appendErrorResponse(pbnjson::JValue &obj, BluetoothError errorCode)
+{
+	const char *errorText = findSILErrorText(errorCode);
 
 	obj.put("returnValue", false);
 	obj.put("errorCode", static_cast<int>(errorCode));
-	obj.put("errorText", errorText);
+	obj.put("errorText", errorText ? errorText : "Unknown Error");
 }
 
-const std::string retrieveErrorText(BluetoothErrorCode errorCode)
+const char *retrieveErrorText(BluetoothErrorCode errorCode)
 {
-	return bluetoothErrorTextTable[errorCode];
+	if (errorCode < FIRST_ERROR_CODE || errorCode > LAST_ERROR_CODE)
+		return "";
+
+	return bluetoothErrorTextTable[errorCode - FIRST_ERROR_CODE].text;
 }
 
-const std::string retrieveErrorCodeText(BluetoothError errorCode)
+const char *retrieveErrorCodeText(BluetoothError errorCode)
 {
-	return bluetoothSILErrorText[errorCode];
+	const char *errorText = findSILErrorText(errorCode);
+
+	return errorText ? errorText : "";
 }
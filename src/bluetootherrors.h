@@ -21,6 +21,8 @@
 #include <bluetooth-sil-api.h>
 #include <pbnjson.hpp>
 
+// Codes are dense, a new one takes the next number and needs its text in
+// bluetootherrors.cpp; the build fails if the text table gets out of step.
 enum BluetoothErrorCode
 {
 	BT_ERR_ADAPTER_NOT_AVAILABLE = 101,
@@ -256,11 +258,16 @@ enum BluetoothErrorCode
 	BT_ERR_MESH_RETRANSMIT_INTERVAL_STEPS_PARAM_MISSING = 332,
 	BT_ERR_MESH_NODE_ADDRESS_INVALID = 333,
 	BT_ERR_MESH_PRIMARY_ELEMENT_ADDRESS_PARAM_MISSING = 334,
-	BT_ERR_MESH_KEY_REFRESH_IN_PROGRESS = 335
+	BT_ERR_MESH_KEY_REFRESH_IN_PROGRESS = 335,
+	BT_ERR_MESH_STORE_UNAVAILABLE = 336
 };
 
+#define FIRST_ERROR_CODE BT_ERR_ADAPTER_NOT_AVAILABLE
+#define LAST_ERROR_CODE BT_ERR_MESH_STORE_UNAVAILABLE
+
 void appendErrorResponse(pbnjson::JValue &obj, BluetoothError errorCode);
-const std::string retrieveErrorText(BluetoothErrorCode errorCode);
-const std::string retrieveErrorCodeText(BluetoothError errorCode);
+// Static strings, empty for unknown codes
+const char *retrieveErrorText(BluetoothErrorCode errorCode);
+const char *retrieveErrorCodeText(BluetoothError errorCode);
 
 #endif //BLUETOOTH_ERRORS_H_
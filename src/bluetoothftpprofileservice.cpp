@@ -20,6 +20,7 @@
 #include "bluetootherrors.h"
 #include "ls2utils.h"
 #include "clientwatch.h"
+#include "responseworkerpool.h"
 #include "logging.h"
 #include "utils.h"
 #include "config.h"
@@ -222,7 +223,7 @@ bool BluetoothFtpProfileService::listDirectory(LSMessage &message)
 			return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(directoryPath, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(directoryPath, string),
 								PROP(adapterAddress, string)) REQUIRED_2(address, directoryPath));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -274,10 +275,11 @@ bool BluetoothFtpProfileService::listDirectory(LSMessage &message)
 				return;
 			}
 
-			pbnjson::JValue contentsObj = pbnjson::Array();
+			ResponseWorkerPool::respond(requestMessage, elements.size(), [elements, adapterAddress]() -> std::string {
+				pbnjson::JValue contentsObj = pbnjson::Array();
 
-			for (auto element : elements)
-			{
+				for (auto element : elements)
+				{
 					pbnjson::JValue elementObj = pbnjson::Object();
 
 					elementObj.put("name", element.getName());
@@ -306,15 +308,16 @@ bool BluetoothFtpProfileService::listDirectory(LSMessage &message)
 						elementObj.put("created", (int64_t) element.getCreatedTime());
 
 					contentsObj.append(elementObj);
-			}
+				}
 
-			pbnjson::JValue responseObj = pbnjson::Object();
+				pbnjson::JValue responseObj = pbnjson::Object();
 
-			responseObj.put("returnValue", true);
-			responseObj.put("adapterAddress", adapterAddress);
-			responseObj.put("contents", contentsObj);
+				responseObj.put("returnValue", true);
+				responseObj.put("adapterAddress", adapterAddress);
+				responseObj.put("contents", contentsObj);
 
-			LSUtils::postToClient(request, responseObj);
+				return responseObj.stringify();
+			});
 	};
 
 	getImpl<BluetoothFtpProfile>()->listFolder(deviceAddress, directoryPath, listFolderCallback);
@@ -385,7 +388,7 @@ bool BluetoothFtpProfileService::prepareFileTransfer(LS::Message &request, pbnjs
 	}
 
 
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(sourceFile, string),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(sourceFile, string),
                                               PROP(destinationFile, string), PROP_WITH_VAL_1(subscribe, boolean, true),
                                               PROP(adapterAddress, string)) REQUIRED_4(address, subscribe, sourceFile, destinationFile));
 
@@ -21,8 +21,10 @@
 #include "bluetoothgattprofileservice.h"
 #include "bluetoothdevice.h"
 #include "bluetootherrors.h"
+#include "firstcallhook.h"
 #include "ls2utils.h"
 #include "logging.h"
+#include "mainloopwatchdog.h"
 #include <iostream>
 #include <sstream>
 #include <iterator>
@@ -86,13 +88,15 @@ BluetoothGattAncsProfile::BluetoothGattAncsProfile (BluetoothManagerService *man
 	manager->registerCategory("/gatt/ancs", LS_CATEGORY_TABLE_NAME(base),
 			NULL, NULL);
 	manager->setCategoryData("/gatt/ancs", this);
+	// ANCS runs on the GATT service, a call here has to bind it if it is lazy
+	LSUtils::setFirstCallHookOwner(this, btGattSrvHandle);
 	btGattSrvHandle->registerGattStatusObserver(this);
 	BT_DEBUG("ANCS Gatt Service Created");
 }
 
 BluetoothGattAncsProfile::~BluetoothGattAncsProfile()
 {
-
+	LSUtils::clearFirstCallHookOwner(this);
 }
 
 /**
@@ -129,7 +133,7 @@ bool BluetoothGattAncsProfile::advertise(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema =
+	const char *schema =
 			STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 									   OBJECT(includeTxPower, OBJSCHEMA_1(PROP(TxPower,integer))),
 									   PROP(includeName, boolean)));
@@ -383,7 +387,8 @@ bool BluetoothGattAncsProfile::connectCallback(LSMessage *requestMessage, const
 		timeoutData->adapterAddress = adapterAddress;
 		timeoutData->address = address;
 
-		g_timeout_add_seconds(CONNECT_TIMEOUT, (GSourceFunc)serviceTimeoutCallback, (gpointer) timeoutData);
+		MainLoopWatchdog::addTimeoutSeconds("BluetoothGattAncsProfile::serviceTimeout", CONNECT_TIMEOUT,
+				(GSourceFunc)serviceTimeoutCallback, (gpointer) timeoutData);
 
 	};
 	BT_DEBUG("[%s](%d) getImpl->discoverServices\n", __FUNCTION__, __LINE__);
@@ -507,7 +512,7 @@ bool BluetoothGattAncsProfile::awaitConnectionRequest(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
                                               PROP_WITH_VAL_1(subscribe, boolean, true))
                                               REQUIRED_1(subscribe));
 
@@ -619,7 +624,7 @@ bool BluetoothGattAncsProfile::awaitNotifications(LSMessage &message)
 		LSUtils::respondWithError(request, BT_ERR_PROFILE_UNAVAIL);
 		return true;
 	}
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
                                               PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress,string))
                                               REQUIRED_2(address, subscribe));
 
@@ -686,7 +691,7 @@ bool BluetoothGattAncsProfile::awaitNotifications(LSMessage &message)
 	{
 		if (error != BLUETOOTH_ERROR_NONE)
 		{
-			LSUtils::respondWithError(requestMessage, retrieveErrorText(BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL) + NOTIFICATION_SOURCE_UUID, BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL, true);
+			LSUtils::respondWithError(requestMessage, std::string(retrieveErrorText(BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL)) + NOTIFICATION_SOURCE_UUID, BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL, true);
 		}
 		else
 		{
@@ -1018,7 +1023,7 @@ bool BluetoothGattAncsProfile::queryNotificationAttributes(LSMessage &message)
 		LSUtils::respondWithError(request, BT_ERR_PROFILE_UNAVAIL);
 		return true;
 	}
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress,string), PROP(notificationId, integer),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress,string), PROP(notificationId, integer),
 			           PROP(subscribe, boolean), OBJARRAY(attributes, OBJSCHEMA_2(PROP(attributeId, integer), PROP(length, integer))))
 			           REQUIRED_4(address, notificationId, attributes, subscribe));
 
@@ -1158,7 +1163,7 @@ bool BluetoothGattAncsProfile::queryNotificationAttributes(LSMessage &message)
 			BT_INFO("ANCS", 0, "monitorCallback called with error %d for dataSourceUuid ", error);
 			if (error != BLUETOOTH_ERROR_NONE)
 			{
-				LSUtils::respondWithError(requestMessage, retrieveErrorText(BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL) + DATA_SOURCE_UUID, BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL, true);
+				LSUtils::respondWithError(requestMessage, std::string(retrieveErrorText(BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL)) + DATA_SOURCE_UUID, BT_ERR_GATT_MONITOR_CHARACTERISTIC_FAIL, true);
 			}
 			LSMessageUnref(requestMessage);
 
@@ -1208,7 +1213,8 @@ bool BluetoothGattAncsProfile::queryNotificationAttributes(LSMessage &message)
 			return true;
 		};
 
-	g_timeout_add_seconds(WRITE_TIMEOUT, (GSourceFunc) serviceTimeoutCallback, (gpointer) timeoutData);
+	MainLoopWatchdog::addTimeoutSeconds("BluetoothGattAncsProfile::serviceTimeout", WRITE_TIMEOUT,
+			(GSourceFunc) serviceTimeoutCallback, (gpointer) timeoutData);
 
 	mQueryNotificationSubscription.setServiceHandle(getManager());
 	mQueryNotificationSubscription.subscribe(request);
@@ -1235,7 +1241,7 @@ bool BluetoothGattAncsProfile::performNotificationAction(LSMessage &message)
 		LSUtils::respondWithError(request, BT_ERR_PROFILE_UNAVAIL);
 		return true;
 	}
-	const std::string schema = STRICT_SCHEMA (PROPS_4 (PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA (PROPS_4 (PROP(adapterAddress, string), PROP(address, string),
                                                PROP(notificationId, integer), PROP(actionId, integer))
                                                REQUIRED_3(address, notificationId, actionId));
 
@@ -21,6 +21,7 @@
 #include "bluetoothdevice.h"
 #include "bluetootherrors.h"
 #include "ls2utils.h"
+#include "responseworkerpool.h"
 #include "logging.h"
 #include "utils.h"
 
@@ -292,6 +293,8 @@ void BluetoothGattProfileService::characteristicValueChanged(const std::string &
 	{
 		(*obsIter)->characteristicValueChanged(address, service, characteristic, adapterAddress);
 	}
+
+	const std::string *payload = NULL;
 	for (auto it = mMonitorCharacteristicSubscriptions.begin() ; it != mMonitorCharacteristicSubscriptions.end(); ++it)
 	{
 		auto subscriptionValue = it->second;
@@ -320,26 +323,10 @@ void BluetoothGattProfileService::characteristicValueChanged(const std::string &
 			continue;
 
 		auto monitorCharacteristicsWatch = it->first;
-		pbnjson::JValue responseObj = pbnjson::Object();
-		responseObj.put("returnValue", true);
-		responseObj.put("subscribed", true);
-		responseObj.put("adapterAddress", adapterAddress);
-		if(address != "")
-			responseObj.put("address", address);
-
-		pbnjson::JValue characteristicObj = pbnjson::Object();
-		characteristicObj.put("characteristic", characteristic.getUuid().toString());
-		pbnjson::JValue valueObj = pbnjson::Object();
-		BluetoothGattValue values = characteristic.getValue();
-		pbnjson::JValue bytesArray = pbnjson::Array();
-		for (size_t i=0; i < values.size(); i++)
-			bytesArray.append((int32_t) values[i]);
-		valueObj.put("bytes", bytesArray);
+		if (!payload)
+			payload = &writeCharacteristicChanged(adapterAddress, address, characteristic);
 
-		characteristicObj.put("value", valueObj);
-		responseObj.put("changed", characteristicObj);
-
-		LSUtils::postToClient(monitorCharacteristicsWatch->getMessage(), responseObj);
+		LSUtils::postToClient(monitorCharacteristicsWatch->getMessage(), *payload);
 	}
 }
 
@@ -363,6 +350,7 @@ void BluetoothGattProfileService::characteristicValueChanged(const BluetoothUuid
 		}
 	}
 
+	const std::string *payload = NULL;
 	for (auto it = mMonitorCharacteristicSubscriptions.begin() ; it != mMonitorCharacteristicSubscriptions.end(); ++it)
 	{
 		auto subscriptionValue = it->second;
@@ -389,26 +377,40 @@ void BluetoothGattProfileService::characteristicValueChanged(const BluetoothUuid
 			continue;
 
 		auto monitorCharacteristicsWatch = it->first;
-		pbnjson::JValue responseObj = pbnjson::Object();
-		responseObj.put("returnValue", true);
-		responseObj.put("subscribed", true);
-		responseObj.put("adapterAddress", adapterAddress);
+		if (!payload)
+			payload = &writeCharacteristicChanged(adapterAddress, std::string(), characteristic);
 
-		pbnjson::JValue characteristicObj = pbnjson::Object();
-		characteristicObj.put("characteristic", characteristic.getUuid().toString());
-		pbnjson::JValue valueObj = pbnjson::Object();
-		BluetoothGattValue values = characteristic.getValue();
-		pbnjson::JValue bytesArray = pbnjson::Array();
-		for (size_t i=0; i < values.size(); i++)
-			bytesArray.append((int32_t) values[i]);
-		valueObj.put("bytes", bytesArray);
+		LSUtils::postToClient(monitorCharacteristicsWatch->getMessage(), *payload);
+	}
 
-		characteristicObj.put("value", valueObj);
-		responseObj.put("changed", characteristicObj);
+}
 
-		LSUtils::postToClient(monitorCharacteristicsWatch->getMessage(), responseObj);
-	}
+// Every matching watch gets the same notification, so it is written once
+// into a reused buffer. Same output as the pbnjson object it replaces.
+const std::string &BluetoothGattProfileService::writeCharacteristicChanged(const std::string &adapterAddress,
+		const std::string &address, const BluetoothGattCharacteristic &characteristic)
+{
+	mCharacteristicChangedWriter.reset();
+	mCharacteristicChangedWriter.beginObject();
+	mCharacteristicChangedWriter.put("returnValue", true);
+	mCharacteristicChangedWriter.put("subscribed", true);
+	mCharacteristicChangedWriter.put("adapterAddress", adapterAddress);
+	if (!address.empty())
+		mCharacteristicChangedWriter.put("address", address);
 
+	mCharacteristicChangedWriter.beginObject("changed");
+	mCharacteristicChangedWriter.put("characteristic", characteristic.getUuid().toString());
+	mCharacteristicChangedWriter.beginObject("value");
+	mCharacteristicChangedWriter.beginArray("bytes");
+	BluetoothGattValue values = characteristic.getValue();
+	for (size_t i = 0; i < values.size(); i++)
+		mCharacteristicChangedWriter.append((int32_t) values[i]);
+	mCharacteristicChangedWriter.endArray();
+	mCharacteristicChangedWriter.endObject();
+	mCharacteristicChangedWriter.endObject();
+	mCharacteristicChangedWriter.endObject();
+
+	return mCharacteristicChangedWriter.getPayload();
 }
 
 void BluetoothGattProfileService::descriptorValueChanged(const BluetoothUuid &service, const BluetoothUuid &characteristic, BluetoothGattDescriptor &descriptor)
@@ -443,7 +445,7 @@ bool BluetoothGattProfileService::discoverServices(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(address, string)));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(address, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -586,7 +588,7 @@ bool BluetoothGattProfileService::addService(LSMessage &message)
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(service, string), PROP(type, string), ARRAY(includes, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(service, string), PROP(type, string), ARRAY(includes, string),
 	                                         OBJARRAY(characteristics, OBJSCHEMA_5(PROP(characteristic, string),
 	                                                  OBJECT(value, OBJSCHEMA_3(PROP(value,string), PROP(number, integer), ARRAY(bytes, integer))),
 	                                                  OBJECT(properties, OBJSCHEMA_8(PROP(broadcast, boolean), PROP(read, boolean),
@@ -789,7 +791,7 @@ bool BluetoothGattProfileService::removeService(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(serverId, string), PROP(service, string)) REQUIRED_1(service));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(serverId, string), PROP(service, string)) REQUIRED_1(service));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -858,7 +860,7 @@ bool BluetoothGattProfileService::connect(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
 			                         PROP(autoConnect, boolean), PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -895,7 +897,7 @@ bool BluetoothGattProfileService::disconnect(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(clientId, string),
 						PROP(adapterAddress, string)) REQUIRED_1(clientId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -932,7 +934,7 @@ bool BluetoothGattProfileService::getStatus(LSMessage &message)
 	bool subscribed = false;
 
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
 				PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1020,7 +1022,7 @@ bool BluetoothGattProfileService::openServer(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
+	const char *schema = STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1081,7 +1083,7 @@ bool BluetoothGattProfileService::closeServer(LSMessage &message)
 	std::string server;
 	uint16_t appId = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(serverId, string)) REQUIRED_1(serverId));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(serverId, string)) REQUIRED_1(serverId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1401,7 +1403,7 @@ bool BluetoothGattProfileService::getServices(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string), PROP(subscribe, boolean)));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string), PROP(subscribe, boolean)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1505,16 +1507,33 @@ bool BluetoothGattProfileService::getServices(LSMessage &message)
 	}
 	BT_DEBUG("Got list of GATT services for address %s", address.c_str());
 
-	pbnjson::JValue responseObj = pbnjson::Object();
-	responseObj.put("returnValue", true);
-	responseObj.put("adapterAddress", adapterAddress);
-	if (request.isSubscription())
-		responseObj.put("subscribed", true);
-	if (!deviceAddress.empty())
-		responseObj.put("address", deviceAddress);
-	appendServiceResponse(localServices, responseObj, serviceList);
+	// Characteristics dominate the size of the response
+	size_t itemCount = serviceList.size();
+	for (auto &service : serviceList)
+		itemCount += service.getCharacteristics().size();
 
-	LSUtils::postToClient(request, responseObj);
+	bool subscribed = request.isSubscription();
+	ResponseWorkerPool::SerializeFunction serialize =
+			[localServices, subscribed, adapterAddress, deviceAddress, serviceList]() -> std::string {
+		pbnjson::JValue responseObj = pbnjson::Object();
+		responseObj.put("returnValue", true);
+		responseObj.put("adapterAddress", adapterAddress);
+		if (subscribed)
+			responseObj.put("subscribed", true);
+		if (!deviceAddress.empty())
+			responseObj.put("address", deviceAddress);
+		appendServiceResponse(localServices, responseObj, serviceList);
+
+		return responseObj.stringify();
+	};
+
+	// The client is subscribed already, so its initial response has to be
+	// sent before any notification can be. Serializing it on a worker would
+	// let a change notified meanwhile overtake it.
+	if (subscribed)
+		LSUtils::postToClient(request, serialize());
+	else
+		ResponseWorkerPool::respond(request.get(), itemCount, serialize);
 
 	return true;
 }
@@ -1607,7 +1626,7 @@ bool BluetoothGattProfileService::writeCharacteristicValue(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_7(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_7(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), PROP(characteristic, string),
 	                                                 PROP(writeType, string),
 	                                                 OBJECT(value, OBJSCHEMA_3(PROP(string, string),
@@ -1822,7 +1841,7 @@ bool BluetoothGattProfileService::readCharacteristicValue(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), PROP(characteristic, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1944,7 +1963,7 @@ bool BluetoothGattProfileService::readCharacteristicValues(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), ARRAY(characteristics, string))
 													 REQUIRED_2(service, characteristics));
 
@@ -2153,7 +2172,7 @@ bool BluetoothGattProfileService::monitorCharacteristic(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), PROP(characteristic, string),
 	                                                 PROP(subscribe, boolean))
 	                                                 REQUIRED_1(subscribe));
@@ -2369,7 +2388,7 @@ bool BluetoothGattProfileService::monitorCharacteristics(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), ARRAY(characteristics, string),
 	                                                 PROP(subscribe, boolean))
 	                                                 REQUIRED_3(subscribe, service, characteristics));
@@ -2687,7 +2706,7 @@ bool BluetoothGattProfileService::readDescriptorValue(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), PROP(characteristic, string),
 	                                                 PROP(descriptor, string))
 	                                                 );
@@ -2830,7 +2849,7 @@ bool BluetoothGattProfileService::readDescriptorValues(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), PROP(characteristic, string),
 	                                                 ARRAY(descriptors, string))
 	                                                 REQUIRED_3(service, characteristic, descriptors));
@@ -2946,7 +2965,7 @@ bool BluetoothGattProfileService::writeDescriptorValue(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_8(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_8(PROP(adapterAddress, string), PROP(serverId, string), PROP(clientId, string),
 	                                                 PROP(service, string), PROP(characteristic, string),
 	                                                 PROP(descriptor, string), PROP(writeType, string),
 	                                                 OBJECT(value, OBJSCHEMA_3(PROP(string, string),
@@ -4088,7 +4107,7 @@ bool BluetoothGattProfileService::isConnectSchemaAvailable(LS::Message &request,
 {
 	BT_INFO("BLE", 0, "[%s](%d) called\n", __FUNCTION__, __LINE__);
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(autoConnect, boolean), PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(autoConnect, boolean), PROP(address, string), PROP(adapterAddress, string),
             PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -4351,7 +4370,7 @@ void BluetoothGattProfileService::connectToStack(LS::Message &request, pbnjson::
 bool BluetoothGattProfileService::isDisconnectSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(clientId, string), PROP(adapterAddress, string)) REQUIRED_1(clientId));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(clientId, string), PROP(adapterAddress, string)) REQUIRED_1(clientId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -27,6 +27,7 @@
 class BluetoothGattAncsProfile;
 
 #include "clientwatch.h"
+#include "jsonwriter.h"
 
 namespace pbnjson
 {
@@ -517,11 +518,11 @@ protected:
 
 	void handleConnectClientDisappeared(const uint16_t &appId, const uint16_t &connectId, const std::string &adapterAddress, const std::string &address);
 private:
-	void appendServiceResponse(bool localAdapterServices, pbnjson::JValue responseObj, BluetoothGattServiceList serviceList);
+	static void appendServiceResponse(bool localAdapterServices, pbnjson::JValue responseObj, BluetoothGattServiceList serviceList);
 	pbnjson::JValue buildDescriptor(const BluetoothGattDescriptor &descriptor, bool localAdapterServices = false);
-	pbnjson::JValue buildDescriptors(const BluetoothGattDescriptorList &descriptorsList, bool localAdapterServices = false);
+	static pbnjson::JValue buildDescriptors(const BluetoothGattDescriptorList &descriptorsList, bool localAdapterServices = false);
 	pbnjson::JValue buildCharacteristic(bool localAdapterServices, const BluetoothGattCharacteristic &characteristic);
-	pbnjson::JValue buildCharacteristics(bool localAdapterServices, const BluetoothGattCharacteristicList &characteristicsList);
+	static pbnjson::JValue buildCharacteristics(bool localAdapterServices, const BluetoothGattCharacteristicList &characteristicsList);
 	void notifyGetServicesSubscribers(bool localAdapterChanged, const std::string &adapterAddress, const std::string &deviceAddress, BluetoothGattServiceList serviceList);
 	bool parseValue(pbnjson::JValue valueObj, BluetoothGattValue *value);
 	void handleMonitorCharacteristicClientDropped(MonitorCharacteristicSubscriptionInfo &subscriptionInfo, LSUtils::ClientWatch *monitorCharacteristicsWatch);
@@ -530,9 +531,12 @@ private:
 	bool isDescriptorValid(const std::string &address, const std::string &serviceUuid, const std::string &descriptorUuuid,
 	                       const std::string &characteristicUuid, BluetoothGattDescriptor &descriptor, const std::string &adapterAddress);
 	void removeSubscriptionPoint(const std::string &adapterAddress, const std::string &address);
+	const std::string &writeCharacteristicChanged(const std::string &adapterAddress, const std::string &address,
+	                                              const BluetoothGattCharacteristic &characteristic);
 
 	std::unordered_map<std::string, LS::SubscriptionPoint*> mGetServicesSubscriptions;
 	std::vector<std::pair<LSUtils::ClientWatch*, MonitorCharacteristicSubscriptionInfo>>  mMonitorCharacteristicSubscriptions;
+	JsonWriter mCharacteristicChangedWriter;
 	std::unordered_map<std::string, bool> mDiscoveringServices;
 	std::vector<CharacteristicWatch*> mCharacteristicWatchList;
 	std::vector<BluetoothGattProfileService *> mGattObservers;
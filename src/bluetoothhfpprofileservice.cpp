@@ -18,6 +18,7 @@
 #include "bluetoothhfpprofileservice.h"
 #include "bluetoothmanagerservice.h"
 #include "logging.h"
+#include "mainloopwatchdog.h"
 #include "ls2utils.h"
 #include "bluetoothdevice.h"
 
@@ -298,7 +299,7 @@ bool BluetoothHfpProfileService::openSCO(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
                                                       PROP_WITH_VAL_1(subscribe, boolean, true))
                                                       REQUIRED_1(address));
 
@@ -452,7 +453,7 @@ bool BluetoothHfpProfileService::closeSCO(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))  REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))  REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -552,7 +553,7 @@ bool BluetoothHfpProfileService::receiveAT(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
                                               PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string))
                                               REQUIRED_1(subscribe));
 
@@ -653,7 +654,7 @@ bool BluetoothHfpProfileService::sendResult(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
                                                  PROP(resultCode, string)) REQUIRED_2(address, resultCode));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -773,7 +774,7 @@ bool BluetoothHfpProfileService::indicateCall(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP_WITH_VAL_1(subscribe, boolean, true),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP_WITH_VAL_1(subscribe, boolean, true),
                                               PROP(number, string), PROP(adapterAddress, string))
                                               REQUIRED_2(address, subscribe));
 
@@ -898,7 +899,7 @@ bool BluetoothHfpProfileService::sendAT(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string),
                                                  PROP(type, string), PROP(command, string), PROP(arguments, string))
                                                 REQUIRED_3(address, type, command));
 
@@ -1025,7 +1026,7 @@ bool BluetoothHfpProfileService::receiveResult(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),
                                                 PROP_WITH_VAL_1(subscribe, boolean, true))REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1115,7 +1116,8 @@ void BluetoothHfpProfileService::startRinging(const std::string &address, const
 
 		mIndicateCallUserData.insert(std::pair<std::string, RingCallbackInfo *>(address, callbackInfo));
 
-		indicateCallIter->second.second.first = g_timeout_add_seconds(RINGING_INTERVAL, ringCallback, callbackInfo);
+		indicateCallIter->second.second.first = MainLoopWatchdog::addTimeoutSeconds("BluetoothHfpProfileService::ring",
+				RINGING_INTERVAL, ringCallback, callbackInfo);
 	}
  }
 
@@ -79,7 +79,7 @@ bool BluetoothHidProfileService::getReport(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string),
 								PROP(reportType, string), PROP(reportId, integer), PROP(reportSize, integer))
 								REQUIRED_3(address, reportType, reportId));
 
@@ -188,7 +188,7 @@ bool BluetoothHidProfileService::setReport(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
 								PROP(reportType, string), ARRAY(reportData, integer)) REQUIRED_3(address, reportType, reportData));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -293,7 +293,7 @@ bool BluetoothHidProfileService::sendData(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
 								ARRAY(reportData, integer)) REQUIRED_2(address, reportData));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
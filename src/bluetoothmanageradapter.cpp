@@ -26,6 +26,8 @@
 #include "ls2utils.h"
 #include "clientwatch.h"
 #include "bluetoothprofileservice.h"
+#include "eventqueue.h"
+#include "startuptimeline.h"
 
 using namespace std::placeholders;
 
@@ -44,6 +46,7 @@ mPowered(false),
 mDiscoverable(false),
 mDiscovering(false),
 mIsDefault(false),
+mId(0),
 mDiscoveryTimeout(0),
 mDiscoverableTimeout(0),
 mClassOfDevice(0),
@@ -54,7 +57,8 @@ mAdapter(nullptr),
 mAddress(address),
 mOutgoingPairingWatch(0),
 mIncomingPairingWatch(0),
-mBluetoothManagerService(mngr)
+mBluetoothManagerService(mngr),
+mAlive(std::make_shared<bool>(true))
 {
 	BT_INFO("MANAGER_SERVICE", 0, "BluetoothManagerAdapter address[%s] created", mAddress.c_str());
 	mGetDevicesSubscriptions.setServiceHandle(mBluetoothManagerService);
@@ -74,7 +78,7 @@ void BluetoothManagerAdapter::notifySubscriberLeDevicesChanged()
 	for (auto watchIter : mStartScanWatches)
 	{
 		pbnjson::JValue responseObj = pbnjson::Object();
-		appendLeDevices(responseObj);
+		appendLeDevices(responseObj, getStartScanFields(watchIter.first));
 
 		responseObj.put("returnValue", true);
 		LSUtils::postToClient(watchIter.second->getMessage(), responseObj);
@@ -92,9 +96,9 @@ void BluetoothManagerAdapter::notifySubscriberLeDevicesChangedbyScanId(uint32_t
 	LSUtils::ClientWatch *watch = watchIter->second;
 	pbnjson::JValue responseObj = pbnjson::Object();
 
-	appendLeDevicesByScanId(responseObj, scanId);
+	appendLeDevicesByScanId(responseObj, scanId, getStartScanFields(scanId));
 
-	appendLeRecentDevice(responseObj, device);
+	appendLeRecentDevice(responseObj, device, getStartScanFields(scanId));
 
 	responseObj.put("returnValue", true);
 
@@ -106,37 +110,104 @@ void BluetoothManagerAdapter::notifySubscriberLeDevicesChangedbyScanId(uint32_t
 
 void BluetoothManagerAdapter::notifySubscribersFilteredDevicesChanged()
 {
-	pbnjson::JValue responseObj = pbnjson::Object();
-
 	for (auto watchIter : mGetDevicesWatches)
 	{
-		std::string senderName = watchIter.first;
-		appendFilteringDevices(senderName, responseObj);
+		auto viewIter = mFilteredDevicesViews.find(watchIter.first);
+		if (viewIter == mFilteredDevicesViews.end())
+			continue;
+
+		updateFilteredDevicesView(watchIter.first, viewIter->second);
+
+		pbnjson::JValue responseObj = pbnjson::Object();
+		appendFilteredDevicesView(responseObj, viewIter->second);
 		responseObj.put("returnValue", true);
 		LSUtils::postToClient(watchIter.second->getMessage(), responseObj);
 	}
+
+	mChangedFilteredDevices.clear();
+}
+
+void BluetoothManagerAdapter::markFilteredDeviceChanged(const std::string &address)
+{
+	if (!mFilteredDevicesViews.empty())
+		mChangedFilteredDevices.insert(convertToLower(address));
+}
+
+void BluetoothManagerAdapter::updateFilteredDevicesView(const std::string &senderName, FilteredDevicesView &view)
+{
+	uint32_t fields = view.fields & ~(BluetoothDeviceFields::SCAN_RECORD | BluetoothDeviceFields::CONNECTED_ROLES);
+
+	if (!view.built)
+	{
+		view.devices.clear();
+		for (auto deviceIter : mDevices)
+		{
+			auto device = deviceIter.second;
+			if (!matchesDeviceFilter(senderName, device))
+				continue;
+
+			pbnjson::JValue deviceObj = pbnjson::Object();
+			appendDevice(deviceObj, device, fields, device->getPaired() ? mAddress : std::string());
+			view.devices[convertToLower(device->getAddress())] = deviceObj;
+		}
+
+		view.built = true;
+		return;
+	}
+
+	// Only devices changed since the last notification are filtered again
+	for (auto &address : mChangedFilteredDevices)
+	{
+		auto device = findDevice(address);
+		if (!device || !matchesDeviceFilter(senderName, device))
+		{
+			view.devices.erase(address);
+			continue;
+		}
+
+		pbnjson::JValue deviceObj = pbnjson::Object();
+		appendDevice(deviceObj, device, fields, device->getPaired() ? mAddress : std::string());
+		view.devices[address] = deviceObj;
+	}
+}
+
+void BluetoothManagerAdapter::appendFilteredDevicesView(pbnjson::JValue &object, const FilteredDevicesView &view)
+{
+	pbnjson::JValue devicesObj = pbnjson::Array();
+
+	for (auto &device : view.devices)
+		devicesObj.append(device.second);
+
+	object.put("devices", devicesObj);
 }
 
 void BluetoothManagerAdapter::notifySubscribersConnectedDevicesChanged()
 {
-	pbnjson::JValue responseObj = pbnjson::Object();
+	mGetConnectedDevicesSubscriptions.forEach([this](uint32_t fields, LS::SubscriptionPoint *subscriptionPoint) {
+		pbnjson::JValue responseObj = pbnjson::Object();
 
-	appendConnectedDevices(responseObj);
+		appendConnectedDevices(responseObj, fields);
 
-	responseObj.put("returnValue", true);
+		responseObj.put("returnValue", true);
 
-	LSUtils::postToSubscriptionPoint(&mGetConnectedDevicesSubscriptions, responseObj);
+		LSUtils::postToSubscriptionPoint(subscriptionPoint, responseObj);
+	});
 }
 
 void BluetoothManagerAdapter::notifySubscribersPairedDevicesChanged()
 {
-	pbnjson::JValue responseObj = pbnjson::Object();
+	mGetPairedDevicesSubscriptions.forEach([this](uint32_t fields, LS::SubscriptionPoint *subscriptionPoint) {
+		pbnjson::JValue responseObj = pbnjson::Object();
 
-	appendPairedDevices(responseObj);
+		appendPairedDevices(responseObj, fields);
 
-	responseObj.put("returnValue", true);
+		responseObj.put("returnValue", true);
 
-	LSUtils::postToSubscriptionPoint(&mGetPairedDevicesSubscriptions, responseObj);
+		LSUtils::postToSubscriptionPoint(subscriptionPoint, responseObj);
+	});
+
+	mBluetoothManagerService->warmStartDeviceReported();
+	mBluetoothManagerService->scheduleWarmStartSave();
 }
 
 void BluetoothManagerAdapter::notifySubscribersDiscoveredDevice(BluetoothDevice *device)
@@ -152,13 +223,33 @@ void BluetoothManagerAdapter::notifySubscribersDiscoveredDevice(BluetoothDevice
 
 void BluetoothManagerAdapter::notifySubscribersDevicesChanged()
 {
-	pbnjson::JValue responseObj = pbnjson::Object();
+	mGetDevicesSubscriptions.forEach([this](uint32_t fields, LS::SubscriptionPoint *subscriptionPoint) {
+		pbnjson::JValue responseObj = pbnjson::Object();
 
-	appendDevices(responseObj);
+		appendDevices(responseObj, fields);
 
-	responseObj.put("returnValue", true);
+		responseObj.put("returnValue", true);
 
-	LSUtils::postToSubscriptionPoint(&mGetDevicesSubscriptions, responseObj);
+		LSUtils::postToSubscriptionPoint(subscriptionPoint, responseObj);
+	});
+}
+
+uint32_t BluetoothManagerAdapter::getStartScanFields(uint32_t scanId) const
+{
+	auto fieldsIter = mStartScanFields.find(scanId);
+	if (fieldsIter == mStartScanFields.end())
+		return BluetoothDeviceFields::ALL;
+
+	return fieldsIter->second;
+}
+
+BluetoothAdvertisingScheduler *BluetoothManagerAdapter::getAdvertisingScheduler()
+{
+	if (!mAdvertisingScheduler)
+		mAdvertisingScheduler.reset(new BluetoothAdvertisingScheduler(mAdapter, WEBOS_BLUETOOTH_ADVERTISING_SETS,
+				WEBOS_BLUETOOTH_ADVERTISING_SLICE));
+
+	return mAdvertisingScheduler.get();
 }
 
 BluetoothDevice* BluetoothManagerAdapter::findDevice(const std::string &address) const
@@ -208,6 +299,9 @@ BluetoothLinkKey BluetoothManagerAdapter::findLinkKey(const std::string &address
 
 void BluetoothManagerAdapter::adapterStateChanged(bool powered)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::adapterStateChanged", mAlive, [=] { adapterStateChanged(powered); }))
+		return;
+
 	BT_INFO("MANAGER_SERVICE", 0, "Observer is called : [%s : %d]", __FUNCTION__, __LINE__);
 
 	if (powered == mPowered)
@@ -221,6 +315,7 @@ void BluetoothManagerAdapter::adapterStateChanged(bool powered)
 	{
 		bt_ready_msg2kernel();
 		write_kernel_log("[bt_time] mPowered is true ");
+		StartupTimeline::mark("adapterPowered", mAddress);
 	}
 
 	mBluetoothManagerService->notifySubscribersAboutStateChange();
@@ -228,12 +323,18 @@ void BluetoothManagerAdapter::adapterStateChanged(bool powered)
 
 void BluetoothManagerAdapter::adapterHciTimeoutOccurred()
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::adapterHciTimeoutOccurred", mAlive, [=] { adapterHciTimeoutOccurred(); }))
+		return;
+
 	BT_INFO("MANAGER_SERVICE", 0, "Observer is called : [%s : %d]", __FUNCTION__, __LINE__);
 	BT_CRITICAL( "Module Error", 0, "Failed to adapterHciTimeoutOccurred" );
 }
 
 void BluetoothManagerAdapter::discoveryStateChanged(bool active)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::discoveryStateChanged", mAlive, [=] { discoveryStateChanged(active); }))
+		return;
+
 	BT_INFO("MANAGER_SERVICE", 0, "Observer is called : [%s : %d] active : %d", __FUNCTION__, __LINE__, active);
 
 	if (mDiscovering == active)
@@ -248,6 +349,9 @@ void BluetoothManagerAdapter::discoveryStateChanged(bool active)
 
 void BluetoothManagerAdapter::adapterPropertiesChanged(BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::adapterPropertiesChanged", mAlive, [=] { adapterPropertiesChanged(properties); }))
+		return;
+
 	BT_DEBUG("Bluetooth adapter properties have changed");
 	updateFromAdapterProperties(properties);
 }
@@ -364,6 +468,7 @@ void BluetoothManagerAdapter::updateFromAdapterProperties(const BluetoothPropert
 				cancelIncomingPairingSubscription();
 			else if (BLUETOOTH_PAIRING_IO_CAPABILITY_NO_INPUT_NO_OUTPUT != mBluetoothManagerService->getIOPairingCapability())
 				mPairState.setPairable(pairableValue);
+			mBluetoothManagerService->invalidateStatus();
 			break;
 		case BluetoothProperty::Type::PAIRABLE_TIMEOUT:
 			mPairState.setPairableTimeout(prop.getValue<uint32_t>());
@@ -443,22 +548,39 @@ void BluetoothManagerAdapter::updateSupportedServiceClasses(const std::vector<st
 
 void BluetoothManagerAdapter::adapterKeepAliveStateChanged(bool enabled)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::adapterKeepAliveStateChanged", mAlive, [=] { adapterKeepAliveStateChanged(enabled); }))
+		return;
+
 	mBluetoothManagerService->adapterKeepAliveStateChanged(enabled);
 }
 
 void BluetoothManagerAdapter::deviceFound(BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::deviceFound", mAlive, [=] { deviceFound(properties); }))
+		return;
+
 	BluetoothDevice *device = new BluetoothDevice(properties);
 	BT_DEBUG("Found a new device");
 	mDevices.insert(std::pair<std::string, BluetoothDevice*>(device->getAddress(), device));
 
+	markFilteredDeviceChanged(device->getAddress());
 	notifySubscribersFilteredDevicesChanged();
 	notifySubscribersDevicesChanged();
 	notifySubscribersDiscoveredDevice(device);
+
+	// Devices already connected when first reported never see the
+	// connected edge in devicePropertiesChanged
+	if (device->getConnected())
+		mBluetoothManagerService->bindLazyProfiles(device->getUuids());
+
+	mBluetoothManagerService->warmStartDeviceReported();
 }
 
 void BluetoothManagerAdapter::deviceFound(const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::deviceFound", mAlive, [=] { deviceFound(address, properties); }))
+		return;
+
     auto device = findDevice(address);
     if (!device) {
         BluetoothDevice *device = new BluetoothDevice(properties);
@@ -469,13 +591,23 @@ void BluetoothManagerAdapter::deviceFound(const std::string &address, BluetoothP
         device->update(properties);
     }
 
+	markFilteredDeviceChanged(address);
 	notifySubscribersFilteredDevicesChanged();
 	notifySubscribersDevicesChanged();
 	notifySubscribersDiscoveredDevice(device);
+
+	auto foundDevice = findDevice(address);
+	if (foundDevice && foundDevice->getConnected())
+		mBluetoothManagerService->bindLazyProfiles(foundDevice->getUuids());
+
+	mBluetoothManagerService->warmStartDeviceReported();
 }
 
 void BluetoothManagerAdapter::devicePropertiesChanged(const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::devicePropertiesChanged", mAlive, [=] { devicePropertiesChanged(address, properties); }))
+		return;
+
 	BT_DEBUG("Properties of device %s have changed", address.c_str());
 
 	auto device = findDevice(address);
@@ -483,17 +615,25 @@ void BluetoothManagerAdapter::devicePropertiesChanged(const std::string &address
 		return;
 
 	bool prevPairedState = device->getPaired();
+	bool prevConnectedState = device->getConnected();
 	if (device->update(properties))
 	{
+		markFilteredDeviceChanged(address);
 		notifySubscribersFilteredDevicesChanged();
 		notifySubscribersDevicesChanged();
 
 		updatePairedDevices(prevPairedState, device);
+
+		if (!prevConnectedState && device->getConnected())
+			mBluetoothManagerService->bindLazyProfiles(device->getUuids());
 	}
 }
 
 void BluetoothManagerAdapter::deviceRemoved(const std::string &address)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::deviceRemoved", mAlive, [=] { deviceRemoved(address); }))
+		return;
+
 	BT_DEBUG("Device %s has disappeared", address.c_str());
 
 	auto deviceIter = mDevices.find(address);
@@ -504,6 +644,7 @@ void BluetoothManagerAdapter::deviceRemoved(const std::string &address)
 	bool pairedState = device->getPaired();
 	mDevices.erase(deviceIter);
 	delete device;
+	markFilteredDeviceChanged(address);
 	notifySubscribersFilteredDevicesChanged();
 	notifySubscribersDevicesChanged();
 	if (pairedState)
@@ -512,6 +653,9 @@ void BluetoothManagerAdapter::deviceRemoved(const std::string &address)
 
 void BluetoothManagerAdapter::leDeviceFound(const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::leDeviceFound", mAlive, [=] { leDeviceFound(address, properties); }))
+		return;
+
 	auto device = findLeDevice(address);
 	if (!device)
 	{
@@ -529,6 +673,9 @@ void BluetoothManagerAdapter::leDeviceFound(const std::string &address, Bluetoot
 
 void BluetoothManagerAdapter::leDevicePropertiesChanged(const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::leDevicePropertiesChanged", mAlive, [=] { leDevicePropertiesChanged(address, properties); }))
+		return;
+
 	BT_DEBUG("Properties of device %s have changed", address.c_str());
 
 	auto device = findLeDevice(address);
@@ -538,6 +685,9 @@ void BluetoothManagerAdapter::leDevicePropertiesChanged(const std::string &addre
 
 void BluetoothManagerAdapter::leDeviceRemoved(const std::string &address)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::leDeviceRemoved", mAlive, [=] { leDeviceRemoved(address); }))
+		return;
+
 	BT_DEBUG("Device %s has disappeared", address.c_str());
 
 	auto deviceIter = mLeDevices.find(address);
@@ -553,6 +703,9 @@ void BluetoothManagerAdapter::leDeviceRemoved(const std::string &address)
 
 void BluetoothManagerAdapter::leDeviceFoundByScanId(uint32_t scanId, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::leDeviceFoundByScanId", mAlive, [=] { leDeviceFoundByScanId(scanId, properties); }))
+		return;
+
 	BluetoothDevice *device = new BluetoothDevice(properties);
 	BT_DEBUG("Found a new LE device by %d", scanId);
 
@@ -572,6 +725,9 @@ void BluetoothManagerAdapter::leDeviceFoundByScanId(uint32_t scanId, BluetoothPr
 
 void BluetoothManagerAdapter::leDevicePropertiesChangedByScanId(uint32_t scanId, const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::leDevicePropertiesChangedByScanId", mAlive, [=] { leDevicePropertiesChangedByScanId(scanId, address, properties); }))
+		return;
+
 	BT_DEBUG("Properties of device %s have changed by %d", address.c_str(), scanId);
 
 	auto devicesIter = mLeDevicesByScanId.find(scanId);
@@ -591,6 +747,9 @@ void BluetoothManagerAdapter::leDevicePropertiesChangedByScanId(uint32_t scanId,
 
 void BluetoothManagerAdapter::leDeviceRemovedByScanId(uint32_t scanId, const std::string &address)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::leDeviceRemovedByScanId", mAlive, [=] { leDeviceRemovedByScanId(scanId, address); }))
+		return;
+
 	BT_DEBUG("Device %s has disappeared in %d", address.c_str(), scanId);
 
 	auto devicesIter = mLeDevicesByScanId.find(scanId);
@@ -609,13 +768,20 @@ void BluetoothManagerAdapter::leDeviceRemovedByScanId(uint32_t scanId, const std
 
 void BluetoothManagerAdapter::deviceLinkKeyCreated(const std::string &address, BluetoothLinkKey LinkKey)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::deviceLinkKeyCreated", mAlive, [=] { deviceLinkKeyCreated(address, LinkKey); }))
+		return;
+
 	BT_DEBUG("Link Key of device(%s) is created", address.c_str());
 
 	mLinkKeys.insert(std::pair<std::string, BluetoothLinkKey>(address, LinkKey));
+	mBluetoothManagerService->scheduleWarmStartSave();
 }
 
 void BluetoothManagerAdapter::deviceLinkKeyDestroyed(const std::string &address, BluetoothLinkKey LinkKey)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::deviceLinkKeyDestroyed", mAlive, [=] { deviceLinkKeyDestroyed(address, LinkKey); }))
+		return;
+
 	BT_DEBUG("Link Key of device(%s) is created", address.c_str());
 
 	auto linkKeyIter = mLinkKeys.find(address);
@@ -623,6 +789,7 @@ void BluetoothManagerAdapter::deviceLinkKeyDestroyed(const std::string &address,
 		return;
 
 	mLinkKeys.erase(linkKeyIter);
+	mBluetoothManagerService->scheduleWarmStartSave();
 }
 
 bool BluetoothManagerAdapter::setState(LS::Message &request, pbnjson::JValue &requestObj)
@@ -787,14 +954,38 @@ void BluetoothManagerAdapter::handleDeviceStatePropertiesSet(BluetoothProperties
 	pbnjson::JValue responseObj = pbnjson::Object();
 	responseObj.put("adapterAddress", mAddress);
 	if (device && device->update(properties))
+	{
+		markFilteredDeviceChanged(device->getAddress());
 		responseObj.put("returnValue", true);
+	}
 	else
 		responseObj.put("returnValue", false);
 
 	LSUtils::postToClient(request, responseObj);
 }
 
-void BluetoothManagerAdapter::appendFilteringDevices(std::string senderName, pbnjson::JValue &object)
+bool BluetoothManagerAdapter::matchesDeviceFilter(const std::string &senderName, BluetoothDevice *device) const
+{
+	auto filterClassOfDevices = mFilterClassOfDevices.find(senderName);
+	if (filterClassOfDevices != mFilterClassOfDevices.end())
+		if((((int32_t)(filterClassOfDevices->second) & (int32_t)(device->getClassOfDevice())) != (int32_t)(filterClassOfDevices->second)))
+			return false;
+
+	if(device->getTypeAsString() == "bredr")
+	{
+		auto filterUuid = mFilterUuids.find(senderName);
+		if (filterUuid != mFilterUuids.end())
+		{
+			auto uuidIter = std::find(device->getUuids().begin(), device->getUuids().end(), filterUuid->second);
+			if (uuidIter != device->getUuids().end())
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void BluetoothManagerAdapter::appendFilteringDevices(std::string senderName, pbnjson::JValue &object, uint32_t fields)
 {
 	pbnjson::JValue devicesObj = pbnjson::Array();
 
@@ -803,54 +994,22 @@ void BluetoothManagerAdapter::appendFilteringDevices(std::string senderName, pbn
 		auto device = deviceIter.second;
 		pbnjson::JValue deviceObj = pbnjson::Object();
 
-		auto filterClassOfDevices = mFilterClassOfDevices.find(senderName);
-		if (filterClassOfDevices != mFilterClassOfDevices.end())
-			if((((int32_t)(filterClassOfDevices->second) & (int32_t)(device->getClassOfDevice())) != (int32_t)(filterClassOfDevices->second)))
-				continue;
-
-		if(device->getTypeAsString() == "bredr")
-		{
-			if(mFilterUuids.size() > 0)
-			{
-				auto filterUuid = mFilterUuids.find(senderName);
-				if(filterUuid->second.c_str() != NULL)
-				{
-					auto uuidIter = std::find(device->getUuids().begin(), device->getUuids().end(), filterUuid->second);
-					if (filterUuid != mFilterUuids.end() && uuidIter != device->getUuids().end())
-						continue;
-				}
-			}
-		}
+		if (!matchesDeviceFilter(senderName, device))
+			continue;
 
         if ( device->getName().find("LGE MR") != std::string::npos ) {
             BT_INFO("Manager", 0, "name: %s, address: %s, paired: %d, rssi: %d, blocked: %d\n", device->getName().c_str(), device->getAddress().c_str(), device->getPaired(), device->getRssi(), device->getBlocked());
         }
 
-		deviceObj.put("name", device->getName());
-		deviceObj.put("address", device->getAddress());
-		deviceObj.put("typeOfDevice", device->getTypeAsString());
-		deviceObj.put("classOfDevice", (int32_t) device->getClassOfDevice());
-		deviceObj.put("paired", device->getPaired());
-		deviceObj.put("pairing", device->getPairing());
-		deviceObj.put("trusted", device->getTrusted());
-		deviceObj.put("blocked", device->getBlocked());
-		deviceObj.put("rssi", device->getRssi());
-
-		if(device->getPaired())
-			deviceObj.put("adapterAddress", mAddress);
-		else
-			deviceObj.put("adapterAddress", "");
-
-		appendManufacturerData(deviceObj, device->getManufacturerData());
-		appendSupportedServiceClasses(deviceObj, device->getSupportedServiceClasses());
-		appendConnectedProfiles(deviceObj, device->getAddress());
+		appendDevice(deviceObj, device, fields & ~(BluetoothDeviceFields::SCAN_RECORD | BluetoothDeviceFields::CONNECTED_ROLES),
+		             device->getPaired() ? mAddress : std::string());
 		devicesObj.append(deviceObj);
 	}
 
 	object.put("devices", devicesObj);
 }
 
-void BluetoothManagerAdapter::appendLeDevices(pbnjson::JValue &object)
+void BluetoothManagerAdapter::appendLeDevices(pbnjson::JValue &object, uint32_t fields)
 {
 	pbnjson::JValue devicesObj = pbnjson::Array();
 
@@ -860,18 +1019,15 @@ void BluetoothManagerAdapter::appendLeDevices(pbnjson::JValue &object)
 		auto device = deviceIter.second;
 		pbnjson::JValue deviceObj = pbnjson::Object();
 
-		deviceObj.put("address", device->getAddress());
-		deviceObj.put("rssi", device->getRssi());
-		deviceObj.put("adapterAddress", mAddress);
-
-		appendScanRecord(deviceObj, device->getScanRecord());
+		appendDevice(deviceObj, device, fields & (BluetoothDeviceFields::RSSI | BluetoothDeviceFields::ADAPTER_ADDRESS |
+		             BluetoothDeviceFields::SCAN_RECORD), mAddress);
 		devicesObj.append(deviceObj);
 	}
 
 	object.put("devices", devicesObj);
 }
 
-void BluetoothManagerAdapter::appendLeRecentDevice(pbnjson::JValue &object, BluetoothDevice *device)
+void BluetoothManagerAdapter::appendLeRecentDevice(pbnjson::JValue &object, BluetoothDevice *device, uint32_t fields)
 {
 
 	if(NULL == device)
@@ -882,30 +1038,13 @@ void BluetoothManagerAdapter::appendLeRecentDevice(pbnjson::JValue &object, Blue
 
 	pbnjson::JValue deviceObj = pbnjson::Object();
 
-	deviceObj.put("name", device->getName());
-	deviceObj.put("address", device->getAddress());
-	deviceObj.put("typeOfDevice", device->getTypeAsString());
-	deviceObj.put("classOfDevice", (int32_t) device->getClassOfDevice());
-	deviceObj.put("paired", device->getPaired());
-	deviceObj.put("pairing", device->getPairing());
-	deviceObj.put("trusted", device->getTrusted());
-	deviceObj.put("blocked", device->getBlocked());
-	deviceObj.put("rssi", device->getRssi());
-
-	if(device->getPaired())
-		deviceObj.put("adapterAddress", mAddress);
-	else
-		deviceObj.put("adapterAddress", "");
-
-	appendManufacturerData(deviceObj, device->getManufacturerData());
-	appendScanRecord(deviceObj, device->getScanRecord());
-	appendSupportedServiceClasses(deviceObj, device->getSupportedServiceClasses());
-	appendConnectedProfiles(deviceObj, device->getAddress());
+	appendDevice(deviceObj, device, fields & ~BluetoothDeviceFields::CONNECTED_ROLES,
+	             device->getPaired() ? mAddress : std::string());
 
 	object.put("device", deviceObj);
 }
 
-void BluetoothManagerAdapter::appendLeDevicesByScanId(pbnjson::JValue &object, uint32_t scanId)
+void BluetoothManagerAdapter::appendLeDevicesByScanId(pbnjson::JValue &object, uint32_t scanId, uint32_t fields)
 {
 	auto devicesIter = mLeDevicesByScanId.find(scanId);
 	if (devicesIter == mLeDevicesByScanId.end())
@@ -923,32 +1062,15 @@ void BluetoothManagerAdapter::appendLeDevicesByScanId(pbnjson::JValue &object, u
             BT_INFO("Manager", 0, "name: %s, address: %s, paired: %d, rssi: %d, blocked: %d\n", device->getName().c_str(), device->getAddress().c_str(), device->getPaired(), device->getRssi(), device->getBlocked());
         }
 
-		deviceObj.put("name", device->getName());
-		deviceObj.put("address", device->getAddress());
-		deviceObj.put("typeOfDevice", device->getTypeAsString());
-		deviceObj.put("classOfDevice", (int32_t) device->getClassOfDevice());
-		deviceObj.put("paired", device->getPaired());
-		deviceObj.put("pairing", device->getPairing());
-		deviceObj.put("trusted", device->getTrusted());
-		deviceObj.put("blocked", device->getBlocked());
-		deviceObj.put("rssi", device->getRssi());
-
-		if(device->getPaired())
-			deviceObj.put("adapterAddress", mAddress);
-		else
-			deviceObj.put("adapterAddress", "");
-
-		appendManufacturerData(deviceObj, device->getManufacturerData());
-		appendScanRecord(deviceObj, device->getScanRecord());
-		appendSupportedServiceClasses(deviceObj, device->getSupportedServiceClasses());
-		appendConnectedProfiles(deviceObj, device->getAddress());
+		appendDevice(deviceObj, device, fields & ~BluetoothDeviceFields::CONNECTED_ROLES,
+		             device->getPaired() ? mAddress : std::string());
 		devicesObj.append(deviceObj);
 	}
 
 	object.put("devices", devicesObj);
 }
 
-void BluetoothManagerAdapter::appendConnectedDevices(pbnjson::JValue &object)
+void BluetoothManagerAdapter::appendConnectedDevices(pbnjson::JValue &object, uint32_t fields)
 {
 	bool anyProfileConnected = false;
 
@@ -962,34 +1084,11 @@ void BluetoothManagerAdapter::appendConnectedDevices(pbnjson::JValue &object)
 
 		BT_DEBUG("appendConnectedDevices address: %s", device->getAddress().c_str());
 
-		for (auto profile : mBluetoothManagerService->getProfiles())
-		{
-			if(profile->isDeviceConnected(getAddress(), device->getAddress()))
-			{
-				BT_DEBUG("There is connected devices with [%s] profile : [%s : %d]", profile->getName().c_str(), __FUNCTION__, __LINE__);
-				anyProfileConnected = true;
-				break;
-			}
-		}
+		anyProfileConnected = isDeviceConnectedToAnyProfile(device->getAddress());
 		if (anyProfileConnected)
 		{
 			BT_DEBUG("Device is connected via at least one profile : [%s : %d]", __FUNCTION__, __LINE__);
-			deviceObj.put("name", device->getName());
-			deviceObj.put("address", device->getAddress());
-			deviceObj.put("typeOfDevice", device->getTypeAsString());
-			deviceObj.put("classOfDevice", (int32_t) device->getClassOfDevice());
-			deviceObj.put("paired", device->getPaired());
-			deviceObj.put("pairing", device->getPairing());
-			deviceObj.put("trusted", device->getTrusted());
-			deviceObj.put("blocked", device->getBlocked());
-			deviceObj.put("rssi", device->getRssi());
-
-			deviceObj.put("adapterAddress", getAddress());
-
-			appendManufacturerData(deviceObj, device->getManufacturerData());
-			appendSupportedServiceClasses(deviceObj, device->getSupportedServiceClasses());
-			appendConnectedProfiles(deviceObj, device->getAddress());
-			appendScanRecord(deviceObj, device->getScanRecord());
+			appendDevice(deviceObj, device, fields & ~BluetoothDeviceFields::CONNECTED_ROLES, getAddress());
 			devicesObj.append(deviceObj);
 		}
 	}
@@ -997,7 +1096,7 @@ void BluetoothManagerAdapter::appendConnectedDevices(pbnjson::JValue &object)
 	object.put("devices", devicesObj);
 }
 
-void BluetoothManagerAdapter::appendPairedDevices(pbnjson::JValue &object)
+void BluetoothManagerAdapter::appendPairedDevices(pbnjson::JValue &object, uint32_t fields)
 {
 	pbnjson::JValue devicesObj = pbnjson::Array();
 
@@ -1011,22 +1110,7 @@ void BluetoothManagerAdapter::appendPairedDevices(pbnjson::JValue &object)
 		BT_DEBUG("appendPairedDevice address: %s", device->getAddress().c_str());
 
 		pbnjson::JValue deviceObj = pbnjson::Object();
-		deviceObj.put("name", device->getName());
-		deviceObj.put("address", device->getAddress());
-		deviceObj.put("typeOfDevice", device->getTypeAsString());
-		deviceObj.put("classOfDevice", (int32_t) device->getClassOfDevice());
-		deviceObj.put("paired", device->getPaired());
-		deviceObj.put("pairing", device->getPairing());
-		deviceObj.put("trusted", device->getTrusted());
-		deviceObj.put("blocked", device->getBlocked());
-		deviceObj.put("rssi", device->getRssi());
-
-		deviceObj.put("adapterAddress", getAddress());
-
-		appendManufacturerData(deviceObj, device->getManufacturerData());
-		appendSupportedServiceClasses(deviceObj, device->getSupportedServiceClasses());
-		appendConnectedProfiles(deviceObj, device->getAddress());
-		appendScanRecord(deviceObj, device->getScanRecord());
+		appendDevice(deviceObj, device, fields & ~BluetoothDeviceFields::CONNECTED_ROLES, getAddress());
 		devicesObj.append(deviceObj);
 	}
 
@@ -1041,28 +1125,13 @@ void BluetoothManagerAdapter::appendDiscoveredDevice(pbnjson::JValue &object, Bl
 	{
 		BT_DEBUG("appendDiscoveredDevice address: %s", device->getAddress().c_str());
 
-		deviceObj.put("name", device->getName());
-		deviceObj.put("address", device->getAddress());
-		deviceObj.put("typeOfDevice", device->getTypeAsString());
-		deviceObj.put("classOfDevice", (int32_t) device->getClassOfDevice());
-		deviceObj.put("paired", device->getPaired());
-		deviceObj.put("pairing", device->getPairing());
-		deviceObj.put("trusted", device->getTrusted());
-		deviceObj.put("blocked", device->getBlocked());
-		deviceObj.put("rssi", device->getRssi());
-
-		deviceObj.put("adapterAddress", getAddress());
-
-		appendManufacturerData(deviceObj, device->getManufacturerData());
-		appendSupportedServiceClasses(deviceObj, device->getSupportedServiceClasses());
-		appendConnectedProfiles(deviceObj, device->getAddress());
-		appendScanRecord(deviceObj, device->getScanRecord());
+		appendDevice(deviceObj, device, BluetoothDeviceFields::ALL & ~BluetoothDeviceFields::CONNECTED_ROLES, getAddress());
 	}
 
 	object.put("device", deviceObj);
 }
 
-void BluetoothManagerAdapter::appendDevices(pbnjson::JValue &object)
+void BluetoothManagerAdapter::appendDevices(pbnjson::JValue &object, uint32_t fields)
 {
 	pbnjson::JValue devicesObj = pbnjson::Array();
 
@@ -1076,31 +1145,46 @@ void BluetoothManagerAdapter::appendDevices(pbnjson::JValue &object)
 					device->getBlocked());
 		}
 
-		deviceObj.put("name", device->getName());
-		deviceObj.put("address", device->getAddress());
-		deviceObj.put("typeOfDevice", device->getTypeAsString());
-		deviceObj.put("classOfDevice", (int32_t) device->getClassOfDevice());
-		deviceObj.put("paired", device->getPaired());
-		deviceObj.put("pairing", device->getPairing());
-		deviceObj.put("trusted", device->getTrusted());
-		deviceObj.put("blocked", device->getBlocked());
-		deviceObj.put("rssi", device->getRssi());
-
-		appendConnectedRoles(deviceObj, device);
-
-
-		deviceObj.put("adapterAddress", getAddress());
-
-		appendManufacturerData(deviceObj, device->getManufacturerData());
-		appendSupportedServiceClasses(deviceObj, device->getSupportedServiceClasses());
-		appendConnectedProfiles(deviceObj, device->getAddress());
-		appendScanRecord(deviceObj, device->getScanRecord());
+		appendDevice(deviceObj, device, fields, getAddress());
 		devicesObj.append(deviceObj);
 	}
 
 	object.put("devices", devicesObj);
 }
 
+void BluetoothManagerAdapter::appendDevice(pbnjson::JValue &object, BluetoothDevice *device, uint32_t fields, const std::string &adapterAddress)
+{
+	if (fields & BluetoothDeviceFields::NAME)
+		object.put("name", device->getName());
+	object.put("address", device->getAddress());
+	if (fields & BluetoothDeviceFields::TYPE_OF_DEVICE)
+		object.put("typeOfDevice", device->getTypeAsString());
+	if (fields & BluetoothDeviceFields::CLASS_OF_DEVICE)
+		object.put("classOfDevice", (int32_t) device->getClassOfDevice());
+	if (fields & BluetoothDeviceFields::PAIRED)
+		object.put("paired", device->getPaired());
+	if (fields & BluetoothDeviceFields::PAIRING)
+		object.put("pairing", device->getPairing());
+	if (fields & BluetoothDeviceFields::TRUSTED)
+		object.put("trusted", device->getTrusted());
+	if (fields & BluetoothDeviceFields::BLOCKED)
+		object.put("blocked", device->getBlocked());
+	if (fields & BluetoothDeviceFields::RSSI)
+		object.put("rssi", device->getRssi());
+	if (fields & BluetoothDeviceFields::CONNECTED_ROLES)
+		appendConnectedRoles(object, device);
+	if (fields & BluetoothDeviceFields::ADAPTER_ADDRESS)
+		object.put("adapterAddress", adapterAddress);
+	if (fields & BluetoothDeviceFields::MANUFACTURER_DATA)
+		appendManufacturerData(object, device->getManufacturerData());
+	if (fields & BluetoothDeviceFields::SERVICE_CLASSES)
+		appendSupportedServiceClasses(object, device->getSupportedServiceClasses());
+	if (fields & BluetoothDeviceFields::CONNECTED_PROFILES)
+		appendConnectedProfiles(object, device->getAddress());
+	if (fields & BluetoothDeviceFields::SCAN_RECORD)
+		appendScanRecord(object, device->getScanRecord());
+}
+
 void BluetoothManagerAdapter::appendScanRecord(pbnjson::JValue &object, const std::vector<uint8_t> scanRecord)
 {
 	pbnjson::JValue scanRecordArray = pbnjson::Array();
@@ -1174,15 +1258,47 @@ void BluetoothManagerAdapter::appendConnectedProfiles(pbnjson::JValue &object, c
 {
 	pbnjson::JValue connectedProfilesObj = pbnjson::Array();
 
-	for (auto profile : mBluetoothManagerService->getProfiles())
+	auto connectedIter = mConnectedProfiles.find(convertToLower(deviceAddress));
+	if (connectedIter != mConnectedProfiles.end())
 	{
-		if (profile->isDeviceConnected(mAddress, deviceAddress))
-			connectedProfilesObj.append(convertToLower(profile->getName()));
+		// Keep the order of the profile list
+		for (auto profile : mBluetoothManagerService->getProfiles())
+		{
+			if (connectedIter->second.count(profile))
+				connectedProfilesObj.append(convertToLower(profile->getName()));
+		}
 	}
 
 	object.put("connectedProfiles", connectedProfilesObj);
 }
 
+void BluetoothManagerAdapter::updateConnectedProfile(BluetoothProfileService *profile, const std::string &address, bool connected)
+{
+	std::string convertedAddress = convertToLower(address);
+
+	// Picked up by the next filtered devices notification
+	markFilteredDeviceChanged(convertedAddress);
+
+	if (connected)
+	{
+		mConnectedProfiles[convertedAddress].insert(profile);
+		return;
+	}
+
+	auto connectedIter = mConnectedProfiles.find(convertedAddress);
+	if (connectedIter == mConnectedProfiles.end())
+		return;
+
+	connectedIter->second.erase(profile);
+	if (connectedIter->second.empty())
+		mConnectedProfiles.erase(connectedIter);
+}
+
+bool BluetoothManagerAdapter::isDeviceConnectedToAnyProfile(const std::string &address) const
+{
+	return mConnectedProfiles.find(convertToLower(address)) != mConnectedProfiles.end();
+}
+
 bool BluetoothManagerAdapter::startDiscovery(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	if (!mPowered)
@@ -1245,6 +1361,7 @@ bool BluetoothManagerAdapter::cancelDiscovery(LS::Message &request)
 
 		LSUtils::ClientWatch *watch = watchIter->second;
 		mGetDevicesWatches.erase(watchIter);
+		mFilteredDevicesViews.erase(senderName);
 		delete watch;
 	}
 	});
@@ -1302,6 +1419,13 @@ bool BluetoothManagerAdapter::getFilteringDeviceStatus(LS::Message &request, pbn
 		}
 	}
 
+	uint32_t fields = BluetoothDeviceFields::ALL;
+	if (!BluetoothDeviceFields::compile(requestObj, fields))
+	{
+		LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
+		return true;
+	}
+
 	if (requestObj.hasKey("classOfDevice"))
 	{
 		if(mFilterClassOfDevices.find(appName) != mFilterClassOfDevices.end())
@@ -1341,10 +1465,19 @@ bool BluetoothManagerAdapter::getFilteringDeviceStatus(LS::Message &request, pbn
 		else
 			mGetDevicesWatches.insert(std::pair<std::string, LSUtils::ClientWatch*>(senderName, watch));
 
+		// The filter may have changed, the view is built again from all devices
+		FilteredDevicesView &view = mFilteredDevicesViews[senderName];
+		view.fields = fields;
+		view.built = false;
+		updateFilteredDevicesView(senderName, view);
+		appendFilteredDevicesView(responseObj, view);
+
 		subscribed = true;
 	}
-
-	appendFilteringDevices(senderName, responseObj);
+	else
+	{
+		appendFilteringDevices(senderName, responseObj, fields);
+	}
 
 	responseObj.put("returnValue", true);
 	responseObj.put("subscribed", subscribed);
@@ -1359,15 +1492,22 @@ bool BluetoothManagerAdapter::getConnectedDevices(LS::Message &request, pbnjson:
 {
 	bool subscribed = false;
 
+	uint32_t fields = BluetoothDeviceFields::ALL;
+	if (!BluetoothDeviceFields::compile(requestObj, fields))
+	{
+		LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
+		return true;
+	}
+
 	if (request.isSubscription())
 	{
-		mGetConnectedDevicesSubscriptions.subscribe(request);
+		mGetConnectedDevicesSubscriptions.subscribe(request, fields);
 		subscribed = true;
 	}
 
 	pbnjson::JValue responseObj = pbnjson::Object();
 
-	appendConnectedDevices(responseObj);
+	appendConnectedDevices(responseObj, fields);
 
 	responseObj.put("returnValue", true);
 	responseObj.put("subscribed", subscribed);
@@ -1382,15 +1522,22 @@ bool BluetoothManagerAdapter::getPairedDevicesStatus(LS::Message &request, pbnjs
 {
 	bool subscribed = false;
 
+	uint32_t fields = BluetoothDeviceFields::ALL;
+	if (!BluetoothDeviceFields::compile(requestObj, fields))
+	{
+		LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
+		return true;
+	}
+
 	if (request.isSubscription())
 	{
-		mGetPairedDevicesSubscriptions.subscribe(request);
+		mGetPairedDevicesSubscriptions.subscribe(request, fields);
 		subscribed = true;
 	}
 
 	pbnjson::JValue responseObj = pbnjson::Object();
 
-	appendPairedDevices(responseObj);
+	appendPairedDevices(responseObj, fields);
 
 	responseObj.put("returnValue", true);
 	responseObj.put("subscribed", subscribed);
@@ -1426,15 +1573,22 @@ bool BluetoothManagerAdapter::getDeviceStatus(LS::Message &request, pbnjson::JVa
 {
 	bool subscribed = false;
 
+	uint32_t fields = BluetoothDeviceFields::ALL;
+	if (!BluetoothDeviceFields::compile(requestObj, fields))
+	{
+		LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
+		return true;
+	}
+
 	if (request.isSubscription())
 	{
-		mGetDevicesSubscriptions.subscribe(request);
+		mGetDevicesSubscriptions.subscribe(request, fields);
 		subscribed = true;
 	}
 
 	pbnjson::JValue responseObj = pbnjson::Object();
 
-	appendDevices(responseObj);
+	appendDevices(responseObj, fields);
 
 	responseObj.put("returnValue", true);
 	responseObj.put("subscribed", subscribed);
@@ -1764,6 +1918,9 @@ bool BluetoothManagerAdapter::awaitPairingRequests(LS::Message &request, pbnjson
 
 void BluetoothManagerAdapter::requestPairingSecret(const std::string &address, BluetoothPairingSecretType type)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::requestPairingSecret", mAlive, [=] { requestPairingSecret(address, type); }))
+		return;
+
 		pbnjson::JValue responseObj = pbnjson::Object();
 
 	// If we're not pairing yet then this is a pairing request from a remote device
@@ -1809,6 +1966,9 @@ void BluetoothManagerAdapter::requestPairingSecret(const std::string &address, B
 
 void BluetoothManagerAdapter::displayPairingConfirmation(const std::string &address, BluetoothPasskey passkey)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::displayPairingConfirmation", mAlive, [=] { displayPairingConfirmation(address, passkey); }))
+		return;
+
 	BT_DEBUG("Received display pairing confirmation request from SIL for address %s, passkey %d", address.c_str(), passkey);
 
 	pbnjson::JValue responseObj = pbnjson::Object();
@@ -1846,6 +2006,9 @@ void BluetoothManagerAdapter::displayPairingConfirmation(const std::string &addr
 
 void BluetoothManagerAdapter::pairingCanceled()
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::pairingCanceled", mAlive, [=] { pairingCanceled(); }))
+		return;
+
 	BT_DEBUG ("Pairing has been canceled from remote user");
 	if (!(mPairState.isPairing()))
 		return;
@@ -1869,6 +2032,9 @@ void BluetoothManagerAdapter::pairingCanceled()
 
 void BluetoothManagerAdapter::displayPairingSecret(const std::string &address, const std::string &pin)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::displayPairingSecret", mAlive, [=] { displayPairingSecret(address, pin); }))
+		return;
+
 	pbnjson::JValue responseObj = pbnjson::Object();
 
 	// If we're not pairing yet then this is a pairing request from a remote device
@@ -1903,6 +2069,9 @@ void BluetoothManagerAdapter::displayPairingSecret(const std::string &address, c
 
 void BluetoothManagerAdapter::displayPairingSecret(const std::string &address, BluetoothPasskey passkey)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::displayPairingSecret", mAlive, [=] { displayPairingSecret(address, passkey); }))
+		return;
+
 	pbnjson::JValue responseObj = pbnjson::Object();
 
 	// If we're not pairing yet then this is a pairing request from a remote device
@@ -1978,6 +2147,9 @@ void BluetoothManagerAdapter::beginIncomingPair(const std::string &address)
 
 void BluetoothManagerAdapter::abortPairing(bool incoming)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::abortPairing", mAlive, [=] { abortPairing(incoming); }))
+		return;
+
 	bool cancelPairing = false;
 
 	BT_DEBUG("Abort pairing");
@@ -2068,6 +2240,7 @@ void BluetoothManagerAdapter::notifyStartScanListenerDropped(uint32_t scanId)
 	LSUtils::postToClient(watch->getMessage(), responseObj);
 
 	mStartScanWatches.erase(watchIter);
+	mStartScanFields.erase(scanId);
 	delete watch;
 
 	mAdapter->removeLeDiscoveryFilter(scanId);
@@ -2174,6 +2347,8 @@ void BluetoothManagerAdapter::cancelDiscoveryCallback(BluetoothDevice *device, B
 void BluetoothManagerAdapter::startPairing(BluetoothDevice *device)
 {
 	getPairState().startPairing(device);
+	if (device)
+		markFilteredDeviceChanged(device->getAddress());
 	mBluetoothManagerService->notifySubscribersAboutStateChange();
 	notifySubscribersFilteredDevicesChanged();
 	notifySubscribersDevicesChanged();
@@ -2184,6 +2359,8 @@ void BluetoothManagerAdapter::startPairing(BluetoothDevice *device)
 
 void BluetoothManagerAdapter::stopPairing()
 {
+	if (getPairState().getDevice())
+		markFilteredDeviceChanged(getPairState().getDevice()->getAddress());
 	getPairState().stopPairing();
 
 	mBluetoothManagerService->notifySubscribersAboutStateChange();
@@ -2337,6 +2514,13 @@ bool BluetoothManagerAdapter::startScan(LS::Message &request, pbnjson::JValue &r
 		leFilter.setManufacturerData(manufacturerData);
 	}
 
+	uint32_t fields = BluetoothDeviceFields::ALL;
+	if (!BluetoothDeviceFields::compile(requestObj, fields))
+	{
+		LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
+		return true;
+	}
+
 	if (request.isSubscription())
 	{
 		leScanId = mAdapter->addLeDiscoveryFilter(leFilter);
@@ -2350,6 +2534,7 @@ bool BluetoothManagerAdapter::startScan(LS::Message &request, pbnjson::JValue &r
 		                    std::bind(&BluetoothManagerAdapter::notifyStartScanListenerDropped, this, leScanId));
 
 		mStartScanWatches.insert(std::pair<uint32_t, LSUtils::ClientWatch*>(leScanId, watch));
+		mStartScanFields[leScanId] = fields;
 		subscribed = true;
 	}
 
@@ -2380,5 +2565,8 @@ bool BluetoothManagerAdapter::startScan(LS::Message &request, pbnjson::JValue &r
 
 void BluetoothManagerAdapter::leConnectionRequest(const std::string &address, bool state)
 {
+	if (EventQueue::deferToMainLoop("BluetoothManagerAdapter::leConnectionRequest", mAlive, [=] { leConnectionRequest(address, state); }))
+		return;
+
 	mBluetoothManagerService->leConnectionRequest(address, state);
 }
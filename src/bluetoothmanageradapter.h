@@ -17,6 +17,9 @@
 #ifndef BLUETOOTH_MANAGER_ADAPTER_H
 #define BLUETOOTH_MANAGER_ADAPTER_H
 
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -24,6 +27,8 @@
 #include <bluetooth-sil-api.h>
 
 #include "bluetoothpairstate.h"
+#include "bluetoothdevicefields.h"
+#include "bluetoothadvertisingscheduler.h"
 
 namespace LSUtils
 {
@@ -38,6 +43,7 @@ namespace LS
 
 class BluetoothManagerService;
 class BluetoothDevice;
+class BluetoothProfileService;
 class BluetoothServiceClassInfo;
 
 class BluetoothManagerAdapter: public BluetoothAdapterStatusObserver
@@ -105,6 +111,9 @@ public:
 
 	void setAdapter(BluetoothAdapter *adapter) { mAdapter = adapter; }
 	BluetoothAdapter *getAdapter() const { return mAdapter; }
+	// Created on first use, advertisements with their own settings go through it
+	BluetoothAdvertisingScheduler *getAdvertisingScheduler();
+	bool hasAdvertisingScheduler() const { return mAdvertisingScheduler != nullptr; }
 
 	std::string getName() { return mName; }
 	std::string getInterface() const { return mInterfaceName; }
@@ -118,6 +127,9 @@ public:
 	bool getDiscoveringState() const { return mDiscovering; }
 	void setDefaultAdapter(bool isDefault) { mIsDefault = isDefault; }
 	bool isDefaultAdapter() const { return mIsDefault; }
+	// Small id, unique among the present adapters, profiles index their impls by
+	void setId(unsigned int id) { mId = id; }
+	unsigned int getId() const { return mId; }
 	uint32_t getDiscoverableTimeout() const { return mDiscoverableTimeout; }
 	uint32_t getClassOfDevice() const { return mClassOfDevice; }
 	BluetoothPairState& getPairState() { return mPairState; }
@@ -131,19 +143,24 @@ public:
 	std::vector<BluetoothServiceClassInfo> getSupportedServiceClasses(){ return mSupportedServiceClasses; }
 
 	BluetoothDevice* findDevice(const std::string &address) const;
+	uint32_t getStartScanFields(uint32_t scanId) const;
 	BluetoothDevice* findLeDevice(const std::string &address) const;
 	BluetoothLinkKey findLinkKey(const std::string &address) const;
 	void updateSupportedServiceClasses(const std::vector<std::string> uuids);
+	void updateConnectedProfile(BluetoothProfileService *profile, const std::string &address, bool connected);
+	bool isDeviceConnectedToAnyProfile(const std::string &address) const;
 
-	void appendFilteringDevices(std::string senderName, pbnjson::JValue &object);
-	void appendConnectedDevices(pbnjson::JValue &object);
-	void appendPairedDevices(pbnjson::JValue &object);
+	void appendFilteringDevices(std::string senderName, pbnjson::JValue &object, uint32_t fields = BluetoothDeviceFields::ALL);
+	void appendConnectedDevices(pbnjson::JValue &object, uint32_t fields = BluetoothDeviceFields::ALL);
+	void appendPairedDevices(pbnjson::JValue &object, uint32_t fields = BluetoothDeviceFields::ALL);
 	void appendDiscoveredDevice(pbnjson::JValue &object, BluetoothDevice *device);
-	void appendDevices(pbnjson::JValue &object);
-	void appendLeDevices(pbnjson::JValue &object);
-	void appendLeRecentDevice(pbnjson::JValue &object, BluetoothDevice *device);
-	void appendLeDevicesByScanId(pbnjson::JValue &object, uint32_t scanId);
-	void appendSupportedServiceClasses(pbnjson::JValue &object, const std::vector<BluetoothServiceClassInfo> &supportedProfiles);
+	void appendDevices(pbnjson::JValue &object, uint32_t fields = BluetoothDeviceFields::ALL);
+	void appendLeDevices(pbnjson::JValue &object, uint32_t fields = BluetoothDeviceFields::ALL);
+	void appendLeRecentDevice(pbnjson::JValue &object, BluetoothDevice *device, uint32_t fields = BluetoothDeviceFields::ALL);
+	void appendLeDevicesByScanId(pbnjson::JValue &object, uint32_t scanId, uint32_t fields = BluetoothDeviceFields::ALL);
+	// Device members selected by fields, the address is always included
+	void appendDevice(pbnjson::JValue &object, BluetoothDevice *device, uint32_t fields, const std::string &adapterAddress);
+	static void appendSupportedServiceClasses(pbnjson::JValue &object, const std::vector<BluetoothServiceClassInfo> &supportedProfiles);
 	void appendConnectedProfiles(pbnjson::JValue &object, const std::string deviceAddress);
 	void appendManufacturerData(pbnjson::JValue &object, const std::vector<uint8_t> manufacturerData);
 	void appendScanRecord(pbnjson::JValue &object, const std::vector<uint8_t> scanRecord);
@@ -166,10 +183,24 @@ public:
 	void beginIncomingPair(const std::string &address);
 
 private:
+	typedef struct
+	{
+		uint32_t fields;
+		bool built;
+		// Serialized devices passing the client's filter, by address
+		std::map<std::string, pbnjson::JValue> devices;
+	} FilteredDevicesView;
+
+	bool matchesDeviceFilter(const std::string &senderName, BluetoothDevice *device) const;
+	void markFilteredDeviceChanged(const std::string &address);
+	void updateFilteredDevicesView(const std::string &senderName, FilteredDevicesView &view);
+	void appendFilteredDevicesView(pbnjson::JValue &object, const FilteredDevicesView &view);
+
 	bool mPowered;
 	bool mDiscoverable;
 	bool mDiscovering;
 	bool mIsDefault;
+	unsigned int mId;
 
 	uint32_t mDiscoveryTimeout;
 	uint32_t mDiscoverableTimeout;
@@ -180,6 +211,7 @@ private:
 #endif
 
 	BluetoothAdapter* mAdapter;
+	std::unique_ptr<BluetoothAdvertisingScheduler> mAdvertisingScheduler;
 	std::string mName;
 	std::string mInterfaceName;
 	std::string mStackName;
@@ -200,13 +232,22 @@ private:
 
 	std::unordered_map <std::string, LSUtils::ClientWatch*> mGetDevicesWatches;
 	std::unordered_map <uint32_t, LSUtils::ClientWatch*> mStartScanWatches;
-	LS::SubscriptionPoint mGetDevicesSubscriptions;
-	LS::SubscriptionPoint mGetConnectedDevicesSubscriptions;
-	LS::SubscriptionPoint mGetPairedDevicesSubscriptions;
+	// Filtered getStatus view of each watching client, by sender name
+	std::unordered_map<std::string, FilteredDevicesView> mFilteredDevicesViews;
+	std::set<std::string> mChangedFilteredDevices;
+	// Field sets requested by scans
+	std::unordered_map<uint32_t, uint32_t> mStartScanFields;
+	BluetoothDeviceFieldSubscriptions mGetDevicesSubscriptions;
+	BluetoothDeviceFieldSubscriptions mGetConnectedDevicesSubscriptions;
+	BluetoothDeviceFieldSubscriptions mGetPairedDevicesSubscriptions;
 	LS::SubscriptionPoint mGetDiscoveredDeviceSubscriptions;
 	std::vector<BluetoothServiceClassInfo> mSupportedServiceClasses;
 	std::vector<std::string> mEnabledServiceClasses;
+	// Profiles each device is connected with, fed by the profiles' connection tables
+	std::unordered_map<std::string, std::set<BluetoothProfileService*>> mConnectedProfiles;
 	BluetoothManagerService *mBluetoothManagerService;
+	// Observer events queued from SIL threads are dropped once this is gone
+	std::shared_ptr<bool> mAlive;
 };
 #endif
 
@@ -19,6 +19,7 @@
 #include <assert.h>
 #undef NDEBUG
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <regex>
@@ -46,6 +47,9 @@
 #include "clientwatch.h"
 #include "logging.h"
 #include "config.h"
+#include "eventqueue.h"
+#include "mainloopwatchdog.h"
+#include "startuptimeline.h"
 #include "utils.h"
 #ifdef MULTI_SESSION_SUPPORT
 #include "bluetoothpdminterface.h"
@@ -53,6 +57,13 @@
 
 #define BLUETOOTH_LE_START_SCAN_MAX_ID 999
 #define MAX_ADVERTISING_DATA_BYTES 31
+// Seconds state changes are coalesced before the snapshot is written
+#define WARM_START_SAVE_DELAY 2
+// Milliseconds without a device report after which the SIL is assumed to have
+// finished enumerating the paired devices of the default adapter
+#define WARM_START_ENUMERATION_QUIET 1000
+// Upper bound, in milliseconds, on waiting for the paired devices
+#define WARM_START_ENUMERATION_MAX 10000
 
 using namespace std::placeholders;
 
@@ -71,15 +82,29 @@ BluetoothManagerService::BluetoothManagerService() :
 	mWoBleEnabled(false),
 	mKeepAliveEnabled(false),
 	mKeepAliveInterval(1),
+	mPerformanceLogSource(0),
 	mSil(0),
 	mDefaultAdapter(0),
+	mRequestedAdapterId(-1),
 	mAdvertisingWatch(0),
+	mStatusStateVersion(1),
+	mWarmStartSnapshot(WEBOS_BLUETOOTH_WARM_START_SNAPSHOT),
+	mWarmStartSaveSource(0),
+	mWarmStartEnumerated(false),
+	mWarmStartEnumerationStart(0),
+	mWarmStartEnumerationSource(0),
 	mGattAnsc(0)
 #ifdef MULTI_SESSION_SUPPORT
 	,
 	mPdmInterface(this)
 #endif
 {
+	for (auto &snapshot : mStatusSnapshots)
+	{
+		snapshot.stateVersion = 0;
+		snapshot.version = 0;
+	}
+
 	std::string bluetoothCapability = WEBOS_BLUETOOTH_PAIRING_IO_CAPABILITY;
 	const char* capabilityOverride = getenv("WEBOS_BLUETOOTH_PAIRING_IO_CAPABILITY");
 	if (capabilityOverride != NULL)
@@ -95,8 +120,15 @@ BluetoothManagerService::BluetoothManagerService() :
 	}
 
 	mEnabledServiceClasses = split(std::string(WEBOS_BLUETOOTH_ENABLED_SERVICE_CLASSES), ' ');
+	mLazyServiceClasses = split(std::string(WEBOS_BLUETOOTH_LAZY_SERVICE_CLASSES), ' ');
 
 	mWoBleTriggerDevices.clear();
+
+	int64_t snapshotStart = g_get_monotonic_time();
+	if (mWarmStartSnapshot.load())
+		StartupTimeline::record("warmStartLoad", snapshotStart,
+				std::to_string(mWarmStartSnapshot.getAdapters().size()) + " adapters");
+
 	createProfiles();
 
 	BT_DEBUG("Creating SIL for API version %d, capability %s", BLUETOOTH_SIL_API_VERSION, bluetoothCapability.c_str());
@@ -107,6 +139,12 @@ BluetoothManagerService::BluetoothManagerService() :
 		mSil->registerObserver(this);
 		assignDefaultAdapter();
 	}
+	else
+	{
+		// Nothing further will happen, close the timeline right away
+		StartupTimeline::mark("silUnavailable");
+		StartupTimeline::finish();
+	}
 
 	LS_CREATE_CATEGORY_BEGIN(BluetoothManagerService, adapter)
 		LS_CATEGORY_METHOD(setState)
@@ -132,6 +170,8 @@ BluetoothManagerService::BluetoothManagerService() :
 		LS_CATEGORY_METHOD(getTraceStatus)
 		LS_CATEGORY_METHOD(setKeepAlive)
 		LS_CATEGORY_METHOD(getKeepAliveStatus)
+		LS_CATEGORY_METHOD(getPerformanceStats)
+		LS_CATEGORY_METHOD(getStartupTimeline)
 		LS_CATEGORY_MAPPED_METHOD(startDiscovery, startFilteringDiscovery)
 	LS_CREATE_CATEGORY_END
 
@@ -160,6 +200,8 @@ BluetoothManagerService::BluetoothManagerService() :
 		LS_CATEGORY_METHOD(startScan)
 	LS_CREATE_CATEGORY_END
 
+	int64_t registerStart = g_get_monotonic_time();
+
 	registerCategory("/adapter", LS_CATEGORY_TABLE_NAME(adapter), NULL, NULL);
 	setCategoryData("/adapter", this);
 
@@ -175,6 +217,8 @@ BluetoothManagerService::BluetoothManagerService() :
 	registerCategory("/le", LS_CATEGORY_TABLE_NAME(le), NULL, NULL);
 	setCategoryData("/le", this);
 
+	StartupTimeline::record("categoryRegistration", registerStart, "manager");
+
 #ifdef MULTI_SESSION_SUPPORT
 	for (int32_t idx = 0; idx < MAX_SUBSCRIPTION_SESSIONS; idx++)
 	{
@@ -188,12 +232,25 @@ BluetoothManagerService::BluetoothManagerService() :
 
 	mGetAdvStatusSubscriptions.setServiceHandle(this);
 	mGetKeepAliveStatusSubscriptions.setServiceHandle(this);
+
+	if (WEBOS_BLUETOOTH_PERFORMANCE_LOG_INTERVAL > 0)
+		mPerformanceLogSource = MainLoopWatchdog::addTimeoutSeconds("BluetoothManagerService::logPerformanceStats",
+				WEBOS_BLUETOOTH_PERFORMANCE_LOG_INTERVAL, &BluetoothManagerService::logPerformanceStats, this);
 }
 
 BluetoothManagerService::~BluetoothManagerService()
 {
 	BT_DEBUG("Shutting down bluetooth manager service ...");
 
+	if (mPerformanceLogSource)
+		g_source_remove(mPerformanceLogSource);
+
+	if (mWarmStartSaveSource)
+		g_source_remove(mWarmStartSaveSource);
+
+	if (mWarmStartEnumerationSource)
+		g_source_remove(mWarmStartEnumerationSource);
+
 	if (mSil)
 		delete mSil;
 
@@ -203,6 +260,21 @@ BluetoothManagerService::~BluetoothManagerService()
 	BluetoothSILFactory::freeSILHandle();
 }
 
+gboolean BluetoothManagerService::logPerformanceStats(gpointer user_data)
+{
+	uint64_t schemaHits = 0;
+	uint64_t schemaMisses = 0;
+	LSUtils::getSchemaCacheStatistics(schemaHits, schemaMisses);
+
+	BT_INFO("MANAGER_SERVICE", 0, "Schema cache hits %llu misses %llu",
+			(unsigned long long) schemaHits, (unsigned long long) schemaMisses);
+	LSUtils::logMethodStatistics();
+	MainLoopWatchdog::logStatistics();
+	EventQueue::logStatistics();
+
+	return TRUE;
+}
+
 //TODO move to BluetoothManagerAdapter (Based on discussion mProfiles should be part of each adapter?)
 bool BluetoothManagerService::isServiceClassEnabled(const std::string &serviceClass)
 {
@@ -260,6 +332,7 @@ bool BluetoothManagerService::isRequestedAdapterAvailable(LS::Message &request,
 			{
 				BT_DEBUG("Adapter for displayId %d found adapterAddress %s", displayId, it->second->getAddress().c_str());
 				adapterAddress = it->second->getAddress();
+				selectRequestedAdapter(adapterAddress);
 				return true;
 			}
 		}
@@ -274,7 +347,7 @@ bool BluetoothManagerService::isRequestedAdapterAvailable(LS::Message &request,
 		if (requestObj.hasKey("adapterAddress"))
 		{
 			adapterAddress = convertToLower(requestObj["adapterAddress"].asString());
-			if (!isValidAddress(adapterAddress) || !isAdapterAvailable(adapterAddress))
+			if (!isValidAddress(adapterAddress) || !selectRequestedAdapter(adapterAddress))
 			{
 				LSUtils::respondWithError(request, BT_ERR_INVALID_ADAPTER_ADDRESS);
 				return false;
@@ -285,7 +358,7 @@ bool BluetoothManagerService::isRequestedAdapterAvailable(LS::Message &request,
 		{
 			BT_DEBUG("Host request doesn't contain adapterAddress so using default adapter address %s", mAddress.c_str());
 			adapterAddress = mAddress;
-			if (!isAdapterAvailable(adapterAddress))
+			if (!selectRequestedAdapter(adapterAddress))
 			{
 				LSUtils::respondWithError(request, BT_ERR_ADAPTER_NOT_AVAILABLE);
 				return false;
@@ -298,7 +371,7 @@ bool BluetoothManagerService::isRequestedAdapterAvailable(LS::Message &request,
 	if (requestObj.hasKey("adapterAddress"))
 	{
 		adapterAddress = convertToLower(requestObj["adapterAddress"].asString());
-		if (!isValidAddress(adapterAddress) || !isAdapterAvailable(adapterAddress))
+		if (!isValidAddress(adapterAddress) || !selectRequestedAdapter(adapterAddress))
 		{
 			LSUtils::respondWithError(request, BT_ERR_INVALID_ADAPTER_ADDRESS);
 			return false;
@@ -307,7 +380,7 @@ bool BluetoothManagerService::isRequestedAdapterAvailable(LS::Message &request,
 	else
 	{
 		adapterAddress = mAddress;
-		if (!isAdapterAvailable(adapterAddress))
+		if (!selectRequestedAdapter(adapterAddress))
 		{
 			LSUtils::respondWithError(request, BT_ERR_ADAPTER_NOT_AVAILABLE);
 			return false;
@@ -318,6 +391,41 @@ bool BluetoothManagerService::isRequestedAdapterAvailable(LS::Message &request,
 #endif
 }
 
+bool BluetoothManagerService::selectRequestedAdapter(const std::string &adapterAddress)
+{
+	// Keys are lower case and so is every address resolved above
+	auto adapterInfoIter = mAdaptersInfo.find(adapterAddress);
+	if (adapterInfoIter == mAdaptersInfo.end())
+		return false;
+
+	mRequestedAdapterAddress = adapterAddress;
+	mRequestedAdapterId = adapterInfoIter->second->getId();
+
+	return true;
+}
+
+unsigned int BluetoothManagerService::allocateAdapterId() const
+{
+	unsigned int id = 0;
+	bool used = true;
+
+	while (used)
+	{
+		used = false;
+		for (auto &adapterInfo : mAdaptersInfo)
+		{
+			if (adapterInfo.second->getId() == id)
+			{
+				used = true;
+				id++;
+				break;
+			}
+		}
+	}
+
+	return id;
+}
+
 bool BluetoothManagerService::isRoleEnable(const std::string &address, const std::string &role)
 {
 	for (auto profile : findAdapterInfo(address)->getSupportedServiceClasses())
@@ -410,6 +518,20 @@ int BluetoothManagerService::getAdvSize(AdvertiseData advData, bool flagRequired
 	return size;
 }
 
+int BluetoothManagerService::getUpdatedAdvSize(const AdvertiseData &current, int currentSize, const AdvertiseData &updated,
+		bool flagRequired)
+{
+	// Rotating beacons only change their manufacturer data, so adjust the
+	// known size by its difference instead of walking the whole payload. The
+	// name is left out as the adapter may have been renamed since.
+	if (currentSize < 0 || updated.includeName ||
+		current.manufacturerData.empty() != updated.manufacturerData.empty() ||
+		!BluetoothAdvertisingScheduler::isSameData(current, updated, true))
+		return getAdvSize(updated, flagRequired);
+
+	return currentSize - (int) current.manufacturerData.size() + (int) updated.manufacturerData.size();
+}
+
 bool BluetoothManagerService::isValidAddress(std::string& address)
 {
 	std::replace(address.begin(), address.end(), '-', ':');
@@ -464,72 +586,127 @@ bool BluetoothManagerService::isDeviceAvailable(const std::string &address) cons
 	return false;
 }
 
+template<typename T>
+T *BluetoothManagerService::createProfile(const std::string &serviceClass)
+{
+	if (!isServiceClassEnabled(serviceClass))
+		return NULL;
+
+	int64_t start = g_get_monotonic_time();
+	T *profile = new T(this);
+	int64_t duration = g_get_monotonic_time() - start;
+	StartupTimeline::record("profileCreate", start, serviceClass);
+
+	bool lazy = std::find(mLazyServiceClasses.begin(), mLazyServiceClasses.end(), serviceClass) != mLazyServiceClasses.end();
+	profile->setLazy(lazy);
+
+	BT_INFO(MSGID_PROFILE_STARTUP, 0, "%s profile service created in %lld us%s", serviceClass.c_str(),
+			(long long) duration, lazy ? ", binding deferred" : "");
+
+	return profile;
+}
+
 void BluetoothManagerService::createProfiles()
 {
-	if (isServiceClassEnabled("FTP"))
-		mProfiles.push_back(new BluetoothFtpProfileService(this));
+	int64_t start = g_get_monotonic_time();
 
-	if (isServiceClassEnabled("OPP"))
-		mProfiles.push_back(new BluetoothOppProfileService(this));
+	if (auto ftpService = createProfile<BluetoothFtpProfileService>("FTP"))
+		mProfiles.push_back(ftpService);
 
-	if (isServiceClassEnabled("A2DP"))
-		mProfiles.push_back(new BluetoothA2dpProfileService(this));
+	if (auto oppService = createProfile<BluetoothOppProfileService>("OPP"))
+		mProfiles.push_back(oppService);
 
-	if (isServiceClassEnabled("GATT"))
-	{
-		BluetoothGattProfileService *gattService = new BluetoothGattProfileService(this);
+	if (auto a2dpService = createProfile<BluetoothA2dpProfileService>("A2DP"))
+		mProfiles.push_back(a2dpService);
 
+	if (auto gattService = createProfile<BluetoothGattProfileService>("GATT"))
+	{
 		if (isServiceClassEnabled("ANCS")) {
 			mGattAnsc = new BluetoothGattAncsProfile(this, gattService);
 			//BluetoothGattAncsProfile registers with gattService
 		}
 		mProfiles.push_back(gattService);
 	}
-	if (isServiceClassEnabled("PBAP"))
-		mProfiles.push_back(new BluetoothPbapProfileService(this));
+	if (auto pbapService = createProfile<BluetoothPbapProfileService>("PBAP"))
+		mProfiles.push_back(pbapService);
 
-	if (isServiceClassEnabled("AVRCP"))
-		mProfiles.push_back(new BluetoothAvrcpProfileService(this));
+	if (auto avrcpService = createProfile<BluetoothAvrcpProfileService>("AVRCP"))
+		mProfiles.push_back(avrcpService);
 
-	if (isServiceClassEnabled("SPP"))
-		mProfiles.push_back(new BluetoothSppProfileService(this));
+	if (auto sppService = createProfile<BluetoothSppProfileService>("SPP"))
+		mProfiles.push_back(sppService);
 
-	if (isServiceClassEnabled("HFP"))
-		mProfiles.push_back(new BluetoothHfpProfileService(this));
+	if (auto hfpService = createProfile<BluetoothHfpProfileService>("HFP"))
+		mProfiles.push_back(hfpService);
 
-	if (isServiceClassEnabled("PAN"))
-		mProfiles.push_back(new BluetoothPanProfileService(this));
+	if (auto panService = createProfile<BluetoothPanProfileService>("PAN"))
+		mProfiles.push_back(panService);
 
-	if (isServiceClassEnabled("HID"))
-		mProfiles.push_back(new BluetoothHidProfileService(this));
+	if (auto hidService = createProfile<BluetoothHidProfileService>("HID"))
+		mProfiles.push_back(hidService);
 
-	if (isServiceClassEnabled("MAP"))
-		mProfiles.push_back(new BluetoothMapProfileService(this));
-	if (isServiceClassEnabled("MESH"))
+	if (auto mapService = createProfile<BluetoothMapProfileService>("MAP"))
+		mProfiles.push_back(mapService);
+	if (auto meshService = createProfile<BluetoothMeshProfileService>("MESH"))
 	{
 			BT_INFO("MANAGER_SERVICE", 0, "Mesh profile service created : [%s : %d]", __FUNCTION__, __LINE__);
-			mProfiles.push_back(new BluetoothMeshProfileService(this));
+			mProfiles.push_back(meshService);
 	}
+
+	BT_INFO(MSGID_PROFILE_STARTUP, 0, "%zu profile services created in %lld us", mProfiles.size(),
+			(long long) (g_get_monotonic_time() - start));
 }
 
-void BluetoothManagerService::notifySubscribersAboutStateChange()
+const BluetoothManagerService::StatusSnapshot &BluetoothManagerService::getStatusSnapshot(int displaySetIndex)
 {
+	StatusSnapshot &snapshot = mStatusSnapshots[displaySetIndex];
+	if (snapshot.stateVersion == mStatusStateVersion)
+		return snapshot;
+
 	pbnjson::JValue responseObj = pbnjson::Object();
+#ifdef MULTI_SESSION_SUPPORT
+	appendCurrentStatus(responseObj, (LSUtils::DisplaySetId) displaySetIndex);
+#else
+	appendCurrentStatus(responseObj);
+#endif
+	responseObj.put("returnValue", true);
+
+	snapshot.stateVersion = mStatusStateVersion;
+
+	std::string notification = responseObj.stringify();
+	if (snapshot.version && notification == snapshot.notification)
+		return snapshot;
+
+	snapshot.version++;
+	snapshot.notification = notification;
+	responseObj.put("subscribed", false);
+	snapshot.response = responseObj.stringify();
+	responseObj.put("subscribed", true);
+	snapshot.subscribedResponse = responseObj.stringify();
+
+	return snapshot;
+}
+
+void BluetoothManagerService::notifySubscribersAboutStateChange()
+{
+	invalidateStatus();
 
 #ifdef MULTI_SESSION_SUPPORT
 	for (int i = 0; i < MAX_SUBSCRIPTION_SESSIONS; i++)
 	{
-		appendCurrentStatus(responseObj, (LSUtils::DisplaySetId)i);
-		responseObj.put("returnValue", true);
-		LSUtils::postToSubscriptionPoint(&(mGetStatusSubscriptions[i]), responseObj);
+		uint64_t previousVersion = mStatusSnapshots[i].version;
+		const StatusSnapshot &snapshot = getStatusSnapshot(i);
+		if (snapshot.version != previousVersion)
+			LSUtils::postToSubscriptionPoint(&(mGetStatusSubscriptions[i]), snapshot.notification);
 	}
 #else
-	appendCurrentStatus(responseObj);
-
-	responseObj.put("returnValue", true);
-
-	LSUtils::postToSubscriptionPoint(&mGetStatusSubscriptions, responseObj);
+	uint64_t previousVersion = mStatusSnapshots[0].version;
+	const StatusSnapshot &snapshot = getStatusSnapshot(0);
+	if (snapshot.version != previousVersion)
+		LSUtils::postToSubscriptionPoint(&mGetStatusSubscriptions, snapshot.notification);
 #endif
+
+	scheduleWarmStartSave();
 }
 
 void BluetoothManagerService::notifySubscribersAdvertisingChanged(std::string adapterAddress)
@@ -563,15 +740,25 @@ void BluetoothManagerService::notifySubscribersAdaptersChanged()
 
 	LSUtils::postToSubscriptionPoint(&mQueryAvailableSubscriptions, responseObj);
 #endif
+
+	scheduleWarmStartSave();
 }
 
 void BluetoothManagerService::adaptersChanged()
 {
 	BT_INFO("MANAGER_SERVICE", 0, "Observer is called : [%s : %d]", __FUNCTION__, __LINE__);
 
+	StartupTimeline::mark("adaptersChanged");
+
 	assignDefaultAdapter();
 
+	int64_t enumerationStart = g_get_monotonic_time();
 	mAdapters = mSil->getAdapters();
+	StartupTimeline::record("adapterEnumeration", enumerationStart, std::to_string(mAdapters.size()) + " adapters");
+
+	// The adapters we remember are gone, stop answering for them
+	if (mAdapters.empty())
+		reconcileWarmStartSnapshot();
 
 	for (auto it = mAdaptersInfo.begin(); it != mAdaptersInfo.end(); )
 	{
@@ -588,6 +775,8 @@ void BluetoothManagerService::adaptersChanged()
 		if (!found)
 		{
 			BT_INFO("MANAGER_SERVICE", 0, "adaptersChanged erasing adapter [%s] from list", it->first.c_str());
+			if (it->first == mRequestedAdapterAddress)
+				mRequestedAdapterAddress.clear();
 			delete it->second;
 			it = mAdaptersInfo.erase(it);
 			notifySubscribersAboutStateChange();
@@ -623,10 +812,27 @@ void BluetoothManagerService::initializeProfiles()
 
 void BluetoothManagerService::initializeProfiles(BluetoothManagerAdapter *adapter)
 {
+	int64_t start = g_get_monotonic_time();
+	int deferred = 0;
+
 	for (auto profile : mProfiles)
 	{
+		if (profile->isLazy())
+		{
+			profile->deferInitialize(adapter->getAddress());
+			deferred++;
+			continue;
+		}
+
+		int64_t profileStart = g_get_monotonic_time();
 		profile->initialize(adapter->getAddress());
+		StartupTimeline::record("profileInitialize", profileStart, profile->getName() + " " + adapter->getAddress());
+		BT_INFO(MSGID_PROFILE_STARTUP, 0, "%s profile bound to %s in %lld us", profile->getName().c_str(),
+				adapter->getAddress().c_str(), (long long) (g_get_monotonic_time() - profileStart));
 	}
+
+	BT_INFO(MSGID_PROFILE_STARTUP, 0, "Profiles bound to %s in %lld us, %d deferred", adapter->getAddress().c_str(),
+			(long long) (g_get_monotonic_time() - start), deferred);
 }
 
 void BluetoothManagerService::resetProfiles()
@@ -641,16 +847,47 @@ void BluetoothManagerService::resetProfiles(const std::string &adapterAddress)
 {
 	for (auto profile : mProfiles)
 	{
+		profile->cancelDeferredInitialize(adapterAddress);
 		profile->reset(adapterAddress);
 	}
 }
 
+void BluetoothManagerService::profileConnectionChanged(BluetoothProfileService *profile, const std::string &adapterAddress,
+                                                       const std::string &address, bool connected)
+{
+	auto adapter = findAdapterInfo(adapterAddress);
+	if (!adapter)
+		return;
+
+	adapter->updateConnectedProfile(profile, address, connected);
+}
+
+void BluetoothManagerService::bindLazyProfiles(const std::vector<std::string> &uuids)
+{
+	for (auto profile : mProfiles)
+	{
+		if (!profile->hasDeferredInitialize())
+			continue;
+
+		for (auto &uuid : profile->getUuids())
+		{
+			if (std::find(uuids.begin(), uuids.end(), uuid) != uuids.end())
+			{
+				profile->bindDeferred("device connection");
+				break;
+			}
+		}
+	}
+}
+
 void BluetoothManagerService::assignDefaultAdapter()
 {
 	if (!mSil)
 		return;
 
+	int64_t start = g_get_monotonic_time();
 	mDefaultAdapter = mSil->getDefaultAdapter();
+	StartupTimeline::record("assignDefaultAdapter", start, mDefaultAdapter ? "found" : "none");
 
 	if (!mDefaultAdapter)
 	{
@@ -718,6 +955,8 @@ void BluetoothManagerService::updateFromAdapterAddressForQueryAvailable(Bluetoot
 	}
 
 	btmngrAdapter->setAdapter(adapter);
+	btmngrAdapter->setId(allocateAdapterId());
+	invalidateStatus();
 
 	adapter->registerObserver(btmngrAdapter);
 	mAdaptersInfo.insert(std::pair<std::string, BluetoothManagerAdapter*>(address, btmngrAdapter));
@@ -728,6 +967,21 @@ void BluetoothManagerService::updateFromAdapterAddressForQueryAvailable(Bluetoot
 	if (mPairingIOCapability == BLUETOOTH_PAIRING_IO_CAPABILITY_NO_INPUT_NO_OUTPUT)
 		setPairableState(address, true);
 
+	// The default adapter being usable is what startup is waiting for,
+	// powering it and enumerating its paired devices still belong to the
+	// boot when they complete afterwards
+	if (btmngrAdapter->isDefaultAdapter())
+	{
+		if (!btmngrAdapter->getPowerState())
+			StartupTimeline::expect("adapterPowered");
+
+		startWarmStartEnumeration();
+		if (!mWarmStartEnumerated)
+			StartupTimeline::expect("pairedDevicesEnumerated");
+
+		StartupTimeline::finish();
+	}
+
 	adapter->getAdapterProperties([this, address](BluetoothError error, const BluetoothPropertiesList &properties) {
 		if (error != BLUETOOTH_ERROR_NONE)
 			return;
@@ -765,7 +1019,7 @@ bool BluetoothManagerService::setState(LSMessage &msg)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_8(
+	const char *schema =  STRICT_SCHEMA(PROPS_8(
                                     PROP(adapterAddress, string), PROP(name, string), PROP(powered, boolean),
                                     PROP(discoveryTimeout, integer), PROP(discoverable, boolean),
                                     PROP(discoverableTimeout, integer), PROP(pairable, boolean),
@@ -864,6 +1118,32 @@ void BluetoothManagerService::appendCurrentStatus(pbnjson::JValue &object)
 		adaptersObj.append(adapterObj);
 	}
 
+	for (auto &snapshotAdapter : mWarmStartSnapshot.getAdapters())
+	{
+#ifdef MULTI_SESSION_SUPPORT
+		if (displayId != LSUtils::DisplaySetId::HOST)
+			break;
+#endif
+		if (findAdapterInfo(snapshotAdapter.address))
+			continue;
+
+		pbnjson::JValue adapterObj = pbnjson::Object();
+		adapterObj.put("powered", snapshotAdapter.powered);
+		adapterObj.put("name", snapshotAdapter.name);
+		adapterObj.put("interfaceName", snapshotAdapter.interfaceName);
+		adapterObj.put("adapterAddress", snapshotAdapter.address);
+		adapterObj.put("discovering", false);
+		adapterObj.put("discoveryTimeout", (int32_t) snapshotAdapter.discoveryTimeout);
+		adapterObj.put("discoverable", snapshotAdapter.discoverable);
+		adapterObj.put("discoverableTimeout", (int32_t) snapshotAdapter.discoverableTimeout);
+		adapterObj.put("pairable", snapshotAdapter.pairable);
+		adapterObj.put("pairableTimeout", (int32_t) snapshotAdapter.pairableTimeout);
+		adapterObj.put("pairing", false);
+		adapterObj.put("stale", true);
+
+		adaptersObj.append(adapterObj);
+	}
+
 	object.put("adapters", adaptersObj);
 }
 
@@ -902,6 +1182,29 @@ void BluetoothManagerService::appendAvailableStatus(pbnjson::JValue &object)
 		adaptersObj.append(adapterObj);
 	}
 
+	for (auto &snapshotAdapter : mWarmStartSnapshot.getAdapters())
+	{
+#ifdef MULTI_SESSION_SUPPORT
+		if (displayId != LSUtils::DisplaySetId::HOST)
+			break;
+#endif
+		if (findAdapterInfo(snapshotAdapter.address))
+			continue;
+
+		pbnjson::JValue adapterObj = pbnjson::Object();
+
+		adapterObj.put("adapterAddress", snapshotAdapter.address);
+		adapterObj.put("default", snapshotAdapter.isDefault);
+		adapterObj.put("classOfDevice", (int32_t) snapshotAdapter.classOfDevice);
+		adapterObj.put("stackName", snapshotAdapter.stackName);
+		adapterObj.put("stackVersion", snapshotAdapter.stackVersion);
+		adapterObj.put("firmwareVersion", snapshotAdapter.firmwareVersion);
+		BluetoothManagerAdapter::appendSupportedServiceClasses(adapterObj, snapshotAdapter.serviceClasses);
+		adapterObj.put("stale", true);
+
+		adaptersObj.append(adapterObj);
+	}
+
 	object.put("adapters", adaptersObj);
 }
 
@@ -924,8 +1227,6 @@ bool BluetoothManagerService::getStatus(LSMessage &message)
 		return true;
 	}
 
-	pbnjson::JValue responseObj = pbnjson::Object();
-
 #ifdef MULTI_SESSION_SUPPORT
 	LSUtils::DisplaySetId displaySetIndex = LSUtils::getDisplaySetIdIndex(message, this);
 	if (request.isSubscription())
@@ -933,20 +1234,17 @@ bool BluetoothManagerService::getStatus(LSMessage &message)
 		mGetStatusSubscriptions[displaySetIndex].subscribe(request);
 		subscribed = true;
 	}
-	appendCurrentStatus(responseObj, displaySetIndex);
+	const StatusSnapshot &snapshot = getStatusSnapshot(displaySetIndex);
 #else
 	if (request.isSubscription())
 	{
 		mGetStatusSubscriptions.subscribe(request);
 		subscribed = true;
 	}
-	appendCurrentStatus(responseObj);
+	const StatusSnapshot &snapshot = getStatusSnapshot(0);
 #endif
 
-	responseObj.put("returnValue", true);
-	responseObj.put("subscribed", subscribed);
-
-	LSUtils::postToClient(request, responseObj);
+	LSUtils::postToClient(request, subscribed ? snapshot.subscribedResponse : snapshot.response);
 
 	return true;
 }
@@ -1005,7 +1303,7 @@ bool BluetoothManagerService::startFilteringDiscovery(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_2(PROP(typeOfDevice, string), PROP(accessCode, string)));
+	const char *schema =  STRICT_SCHEMA(PROPS_2(PROP(typeOfDevice, string), PROP(accessCode, string)));
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
 		if (parseError == JSON_PARSE_SCHEMA_ERROR)
@@ -1154,7 +1452,7 @@ bool BluetoothManagerService::getLinkKey(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1183,7 +1481,7 @@ bool BluetoothManagerService::startSniff(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string),
 													PROP(minInterval, integer), PROP(maxInterval, integer),
 													PROP(attempt, integer), PROP(timeout, integer))
 													REQUIRED_5(address, minInterval, maxInterval, attempt, timeout));
@@ -1251,7 +1549,7 @@ bool BluetoothManagerService::stopSniff(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
 													REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1303,7 +1601,8 @@ bool BluetoothManagerService::getFilteringDeviceStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_4(PROP(subscribe, boolean), PROP(adapterAddress, string), PROP(classOfDevice, integer), PROP(uuid, string)));
+	const char *schema =  STRICT_SCHEMA(PROPS_5(PROP(subscribe, boolean), PROP(adapterAddress, string), PROP(classOfDevice, integer), PROP(uuid, string),
+	                                          ARRAY(fields, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1333,7 +1632,8 @@ bool BluetoothManagerService::getConnectedDevices(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_3(PROP(subscribe, boolean), PROP(adapterAddress, string), PROP(classOfDevice, integer)));
+	const char *schema =  STRICT_SCHEMA(PROPS_4(PROP(subscribe, boolean), PROP(adapterAddress, string), PROP(classOfDevice, integer),
+	                                          ARRAY(fields, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1362,7 +1662,7 @@ bool BluetoothManagerService::getPairedDevicesStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_2(PROP(subscribe, boolean), PROP(adapterAddress, string)));
+	const char *schema =  STRICT_SCHEMA(PROPS_3(PROP(subscribe, boolean), PROP(adapterAddress, string), ARRAY(fields, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1374,6 +1674,9 @@ bool BluetoothManagerService::getPairedDevicesStatus(LSMessage &message)
 		return true;
 	}
 
+	if (respondPairedDevicesFromSnapshot(request, requestObj))
+		return true;
+
 	std::string adapterAddress;
 	if (!isRequestedAdapterAvailable(request, requestObj, adapterAddress))
 		return true;
@@ -1383,6 +1686,229 @@ bool BluetoothManagerService::getPairedDevicesStatus(LSMessage &message)
 	return adapter->getPairedDevicesStatus(request, requestObj);
 }
 
+bool BluetoothManagerService::respondPairedDevicesFromSnapshot(LS::Message &request, pbnjson::JValue &requestObj)
+{
+	if (!mWarmStartSnapshot.isStale())
+		return false;
+
+#ifdef MULTI_SESSION_SUPPORT
+	if (LSUtils::getDisplaySetIdIndex(*request.get(), this) != LSUtils::DisplaySetId::HOST)
+		return false;
+#endif
+
+	const BluetoothWarmStartSnapshot::Adapter *snapshotAdapter = NULL;
+	if (requestObj.hasKey("adapterAddress"))
+		snapshotAdapter = mWarmStartSnapshot.findAdapter(requestObj["adapterAddress"].asString());
+	else
+		snapshotAdapter = mWarmStartSnapshot.findDefaultAdapter();
+
+	if (!snapshotAdapter)
+		return false;
+
+	// A live default adapter may not have reported its paired devices yet,
+	// so its list keeps coming from the snapshot until it is reconciled
+	if (findAdapterInfo(snapshotAdapter->address) && snapshotAdapter != mWarmStartSnapshot.findDefaultAdapter())
+		return false;
+
+	uint32_t fields = BluetoothDeviceFields::ALL;
+	if (!BluetoothDeviceFields::compile(requestObj, fields))
+	{
+		LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
+		return true;
+	}
+
+	bool subscribed = false;
+	if (request.isSubscription())
+	{
+		WarmStartRequest *pendingRequest = new WarmStartRequest;
+		pendingRequest->request = request;
+		pendingRequest->requestObj = requestObj;
+		pendingRequest->dropped = false;
+		pendingRequest->watch.reset(new LSUtils::ClientWatch(get(), request.get(), [pendingRequest]() {
+			pendingRequest->dropped = true;
+		}));
+		mWarmStartPairedDevicesRequests.push_back(std::unique_ptr<WarmStartRequest>(pendingRequest));
+		subscribed = true;
+	}
+
+	pbnjson::JValue devicesObj = pbnjson::Array();
+	for (auto &device : snapshotAdapter->pairedDevices)
+	{
+		pbnjson::JValue deviceObj = pbnjson::Object();
+		if (fields & BluetoothDeviceFields::NAME)
+			deviceObj.put("name", device.name);
+		deviceObj.put("address", device.address);
+		if (fields & BluetoothDeviceFields::TYPE_OF_DEVICE)
+			deviceObj.put("typeOfDevice", device.typeOfDevice);
+		if (fields & BluetoothDeviceFields::CLASS_OF_DEVICE)
+			deviceObj.put("classOfDevice", (int32_t) device.classOfDevice);
+		if (fields & BluetoothDeviceFields::PAIRED)
+			deviceObj.put("paired", true);
+		if (fields & BluetoothDeviceFields::PAIRING)
+			deviceObj.put("pairing", false);
+		if (fields & BluetoothDeviceFields::TRUSTED)
+			deviceObj.put("trusted", device.trusted);
+		if (fields & BluetoothDeviceFields::BLOCKED)
+			deviceObj.put("blocked", device.blocked);
+		if (fields & BluetoothDeviceFields::ADAPTER_ADDRESS)
+			deviceObj.put("adapterAddress", snapshotAdapter->address);
+		if (fields & BluetoothDeviceFields::SERVICE_CLASSES)
+			BluetoothManagerAdapter::appendSupportedServiceClasses(deviceObj, device.serviceClasses);
+		if (fields & BluetoothDeviceFields::CONNECTED_PROFILES)
+			deviceObj.put("connectedProfiles", pbnjson::Array());
+		devicesObj.append(deviceObj);
+	}
+
+	pbnjson::JValue responseObj = pbnjson::Object();
+	responseObj.put("devices", devicesObj);
+	responseObj.put("returnValue", true);
+	responseObj.put("subscribed", subscribed);
+	responseObj.put("adapterAddress", snapshotAdapter->address);
+	responseObj.put("stale", true);
+
+	LSUtils::postToClient(request, responseObj);
+
+	return true;
+}
+
+void BluetoothManagerService::startWarmStartEnumeration()
+{
+	if (mWarmStartEnumerated || mWarmStartEnumerationStart)
+		return;
+
+	mWarmStartEnumerationStart = g_get_monotonic_time();
+	checkWarmStartEnumeration();
+}
+
+void BluetoothManagerService::warmStartDeviceReported()
+{
+	if (mWarmStartEnumerated || !mWarmStartEnumerationStart)
+		return;
+
+	checkWarmStartEnumeration();
+}
+
+void BluetoothManagerService::checkWarmStartEnumeration()
+{
+	const BluetoothWarmStartSnapshot::Adapter *snapshotAdapter = mWarmStartSnapshot.findDefaultAdapter();
+	BluetoothManagerAdapter *adapter = snapshotAdapter ? findAdapterInfo(snapshotAdapter->address) : NULL;
+
+	// Done as soon as every device paired at the last run is reported paired
+	// again, otherwise wait until the SIL goes quiet for a while
+	bool complete = (snapshotAdapter == NULL);
+	if (adapter)
+	{
+		complete = true;
+		for (auto &snapshotDevice : snapshotAdapter->pairedDevices)
+		{
+			BluetoothDevice *device = adapter->findDevice(snapshotDevice.address);
+			if (!device || !device->getPaired())
+			{
+				complete = false;
+				break;
+			}
+		}
+	}
+
+	gint64 elapsed = (g_get_monotonic_time() - mWarmStartEnumerationStart) / 1000;
+	if (complete || elapsed >= WARM_START_ENUMERATION_MAX)
+	{
+		StartupTimeline::record("pairedDevicesEnumerated", mWarmStartEnumerationStart,
+				complete ? "complete" : "timed out");
+		reconcileWarmStartSnapshot();
+		return;
+	}
+
+	if (mWarmStartEnumerationSource)
+		g_source_remove(mWarmStartEnumerationSource);
+
+	mWarmStartEnumerationSource = MainLoopWatchdog::addTimeout("BluetoothManagerService::handleWarmStartEnumerationTimeout",
+			std::min<gint64>(WARM_START_ENUMERATION_QUIET, WARM_START_ENUMERATION_MAX - elapsed),
+			&BluetoothManagerService::handleWarmStartEnumerationTimeout, this);
+}
+
+gboolean BluetoothManagerService::handleWarmStartEnumerationTimeout(gpointer user_data)
+{
+	BluetoothManagerService *service = static_cast<BluetoothManagerService*>(user_data);
+	service->mWarmStartEnumerationSource = 0;
+
+	BT_INFO("MANAGER_SERVICE", 0, "No paired device reported for %d ms, reconciling warm start snapshot",
+			WARM_START_ENUMERATION_QUIET);
+
+	service->reconcileWarmStartSnapshot();
+
+	return FALSE;
+}
+
+void BluetoothManagerService::reconcileWarmStartSnapshot()
+{
+	mWarmStartEnumerated = true;
+
+	if (mWarmStartEnumerationSource)
+	{
+		g_source_remove(mWarmStartEnumerationSource);
+		mWarmStartEnumerationSource = 0;
+	}
+
+	if (!mWarmStartSnapshot.isStale())
+		return;
+
+	mWarmStartSnapshot.discard();
+
+	std::vector<std::unique_ptr<WarmStartRequest>> requests;
+	requests.swap(mWarmStartPairedDevicesRequests);
+
+	// Clients subscribed to the snapshot now get the live list and updates,
+	// unless they went away in the meantime
+	size_t handedOver = 0;
+	for (auto &pendingRequest : requests)
+	{
+		if (pendingRequest->dropped)
+			continue;
+
+		std::string adapterAddress;
+		if (!isRequestedAdapterAvailable(pendingRequest->request, pendingRequest->requestObj, adapterAddress))
+			continue;
+
+		findAdapterInfo(adapterAddress)->getPairedDevicesStatus(pendingRequest->request, pendingRequest->requestObj);
+		handedOver++;
+	}
+
+	BT_INFO("MANAGER_SERVICE", 0, "Reconciled warm start snapshot, %zu of %zu paired device subscriptions handed over",
+			handedOver, requests.size());
+
+	notifySubscribersAboutStateChange();
+	notifySubscribersAdaptersChanged();
+}
+
+void BluetoothManagerService::scheduleWarmStartSave()
+{
+	if (mWarmStartSaveSource)
+		return;
+
+	mWarmStartSaveSource = MainLoopWatchdog::addTimeoutSeconds("BluetoothManagerService::handleWarmStartSaveTimeout",
+			WARM_START_SAVE_DELAY, &BluetoothManagerService::handleWarmStartSaveTimeout, this);
+}
+
+gboolean BluetoothManagerService::handleWarmStartSaveTimeout(gpointer user_data)
+{
+	BluetoothManagerService *service = static_cast<BluetoothManagerService*>(user_data);
+	service->mWarmStartSaveSource = 0;
+
+	// Never replace a good snapshot with the partial state seen before the
+	// SIL has reported the default adapter and its paired devices
+	if (!service->mWarmStartEnumerated || service->mWarmStartSnapshot.isStale() || service->mAdaptersInfo.empty())
+		return FALSE;
+
+	std::vector<BluetoothManagerAdapter*> adapters;
+	for (auto &adapterInfo : service->mAdaptersInfo)
+		adapters.push_back(adapterInfo.second);
+
+	service->mWarmStartSnapshot.save(adapters);
+
+	return FALSE;
+}
+
 bool BluetoothManagerService::getDiscoveredDeviceStatus(LSMessage &message)
 {
 	BT_INFO("MANAGER_SERVICE", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
@@ -1391,7 +1917,7 @@ bool BluetoothManagerService::getDiscoveredDeviceStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_2(PROP(subscribe, boolean), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
+	const char *schema =  STRICT_SCHEMA(PROPS_2(PROP(subscribe, boolean), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1420,7 +1946,8 @@ bool BluetoothManagerService::getDeviceStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_3(PROP(subscribe, boolean), PROP(adapterAddress, string), PROP(classOfDevice, integer)));
+	const char *schema =  STRICT_SCHEMA(PROPS_4(PROP(subscribe, boolean), PROP(adapterAddress, string), PROP(classOfDevice, integer),
+	                                          ARRAY(fields, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1449,7 +1976,7 @@ bool BluetoothManagerService::setDeviceState(LSMessage &msg)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_4(
+	const char *schema =  STRICT_SCHEMA(PROPS_4(
                                     PROP(address, string), PROP(trusted, boolean), PROP(blocked, boolean), PROP(adapterAddress, string))
                                     REQUIRED_1(address));
 
@@ -1484,7 +2011,7 @@ bool BluetoothManagerService::pair(LSMessage &message)
 	LS::Message request(&message);
 
 	BT_INFO("MANAGER_SERVICE", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string),
                                               PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress,string))
                                               REQUIRED_2(address,subscribe));
 
@@ -1522,7 +2049,7 @@ bool BluetoothManagerService::supplyPasskey(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(passkey, integer), PROP(adapterAddress, string))
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(passkey, integer), PROP(adapterAddress, string))
                                               REQUIRED_2(address, passkey));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1559,7 +2086,7 @@ bool BluetoothManagerService::supplyPinCode(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(pin, string), PROP(adapterAddress, string))
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(pin, string), PROP(adapterAddress, string))
                                              REQUIRED_2(address, pin));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1596,7 +2123,7 @@ bool BluetoothManagerService::supplyPasskeyConfirmation(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(accept, boolean), PROP(adapterAddress, string))
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(accept, boolean), PROP(adapterAddress, string))
                                               REQUIRED_2(address, accept));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1633,7 +2160,7 @@ bool BluetoothManagerService::cancelPairing(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1666,7 +2193,7 @@ bool BluetoothManagerService::unpair(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1699,7 +2226,7 @@ bool BluetoothManagerService::awaitPairingRequests(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1731,7 +2258,7 @@ bool BluetoothManagerService::setWoBle(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(woBleEnabled, boolean), PROP(adapterAddress, string) , PROP(suspend, boolean)) REQUIRED_2(woBleEnabled, suspend));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(woBleEnabled, boolean), PROP(adapterAddress, string) , PROP(suspend, boolean)) REQUIRED_2(woBleEnabled, suspend));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1793,7 +2320,7 @@ bool BluetoothManagerService::setWoBleTriggerDevices(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(ARRAY(triggerDevices, string), PROP(adapterAddress, string)) REQUIRED_1(triggerDevices));
+	const char *schema = STRICT_SCHEMA(PROPS_2(ARRAY(triggerDevices, string), PROP(adapterAddress, string)) REQUIRED_1(triggerDevices));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1855,7 +2382,7 @@ bool BluetoothManagerService::getWoBleStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
+	const char *schema = STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1897,7 +2424,7 @@ bool BluetoothManagerService::sendHciCommand(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(ogf, integer), PROP(ocf, integer), ARRAY(parameters, integer)) REQUIRED_3(ogf, ocf, parameters));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(ogf, integer), PROP(ocf, integer), ARRAY(parameters, integer)) REQUIRED_3(ogf, ocf, parameters));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1974,7 +2501,7 @@ bool BluetoothManagerService::setTrace(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_7(
+	const char *schema = STRICT_SCHEMA(PROPS_7(
 									PROP(stackTraceEnabled, boolean), PROP(snoopTraceEnabled, boolean),
 									PROP(stackTraceLevel, integer), PROP(isTraceLogOverwrite, boolean),
 									PROP(stackLogPath, string), PROP(snoopLogPath, string),
@@ -2092,7 +2619,7 @@ bool BluetoothManagerService::getTraceStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
+	const char *schema = STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -2152,7 +2679,7 @@ bool BluetoothManagerService::setKeepAlive(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(keepAliveEnabled, boolean), PROP(adapterAddress, string), PROP(keepAliveInterval, integer)));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(keepAliveEnabled, boolean), PROP(adapterAddress, string), PROP(keepAliveInterval, integer)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -2264,6 +2791,78 @@ bool BluetoothManagerService::getKeepAliveStatus(LSMessage &message)
 	return true;
 }
 
+bool BluetoothManagerService::getPerformanceStats(LSMessage &message)
+{
+	BT_INFO("MANAGER_SERVICE", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
+
+	LS::Message request(&message);
+	pbnjson::JValue requestObj;
+	int parseError = 0;
+
+	const char *schema = SCHEMA_ANY;
+
+	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
+	{
+		LSUtils::respondWithError(request, BT_ERR_BAD_JSON);
+		return true;
+	}
+
+	uint64_t schemaHits = 0;
+	uint64_t schemaMisses = 0;
+	LSUtils::getSchemaCacheStatistics(schemaHits, schemaMisses);
+
+	pbnjson::JValue schemaCacheObj = pbnjson::Object();
+	schemaCacheObj.put("hits", (int64_t) schemaHits);
+	schemaCacheObj.put("misses", (int64_t) schemaMisses);
+
+	pbnjson::JValue responseObj = pbnjson::Object();
+	responseObj.put("returnValue", true);
+	responseObj.put("methods", LSUtils::getMethodStatistics());
+	responseObj.put("schemaCache", schemaCacheObj);
+	responseObj.put("mainLoop", MainLoopWatchdog::getStatistics());
+	responseObj.put("eventQueue", EventQueue::getStatistics());
+
+	pbnjson::JValue advertisingObj = pbnjson::Array();
+	for (auto adapterIter : mAdaptersInfo)
+	{
+		if (!adapterIter.second->hasAdvertisingScheduler())
+			continue;
+
+		pbnjson::JValue schedulerObj = adapterIter.second->getAdvertisingScheduler()->getStatistics();
+		schedulerObj.put("adapterAddress", adapterIter.first);
+		advertisingObj.append(schedulerObj);
+	}
+	responseObj.put("advertising", advertisingObj);
+
+	LSUtils::postToClient(request, responseObj);
+
+	return true;
+}
+
+bool BluetoothManagerService::getStartupTimeline(LSMessage &message)
+{
+	BT_INFO("MANAGER_SERVICE", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
+
+	LS::Message request(&message);
+	pbnjson::JValue requestObj;
+	int parseError = 0;
+
+	const char *schema = SCHEMA_ANY;
+
+	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
+	{
+		LSUtils::respondWithError(request, BT_ERR_BAD_JSON);
+		return true;
+	}
+
+	pbnjson::JValue responseObj = StartupTimeline::getTimeline();
+	responseObj.put("returnValue", true);
+
+	LSUtils::postToClient(request, responseObj);
+
+	return true;
+}
+
 bool BluetoothManagerService::notifyAdvertisingDisabled(uint8_t advertiserId)
 {
 	notifySubscribersAdvertisingChanged(mAddress);
@@ -2289,42 +2888,30 @@ bool BluetoothManagerService::notifyAdvertisingDropped(uint8_t advertiserId)
 	if (adapterAddress.empty())
 		return true;
 
-	auto leAdvEnableCallback = [this, advertiserId, adapterAddress](BluetoothError enableError)
+	auto removeAdvCallback = [this,adapterAddress, advertiserId](BluetoothError error)
 	{
-		auto unregisterAdvCallback = [this,adapterAddress, advertiserId](BluetoothError registerError)
-		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-
-			if (BLUETOOTH_ERROR_NONE == registerError)
-			{
-				notifySubscribersAdvertisingChanged(adapterAddress);
-				responseObj.put("advertiserId", advertiserId);
-			}
-			else
-			{
-				appendErrorResponse(responseObj, registerError);
-			}
-
-			responseObj.put("adapterAddress", mAddress);
-			responseObj.put("subscribed", false);
-			responseObj.put("returnValue", true);
-			LSUtils::postToClient(mAdvertisingWatch->getMessage(), responseObj);
-			auto itr = mAdvIdAdapterMap.find(advertiserId);
-			if (itr != mAdvIdAdapterMap.end())
-				mAdvIdAdapterMap.erase(itr);
-		};
-		findAdapterInfo(adapterAddress)->getAdapter()->unregisterAdvertiser(advertiserId, unregisterAdvCallback);
+		pbnjson::JValue responseObj = pbnjson::Object();
 
-		if (enableError != BLUETOOTH_ERROR_NONE)
+		if (BLUETOOTH_ERROR_NONE == error)
 		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-			responseObj.put("adapterAddress", adapterAddress);
-			appendErrorResponse(responseObj, enableError);
-			LSUtils::postToClient(mAdvertisingWatch->getMessage(), responseObj);
+			notifySubscribersAdvertisingChanged(adapterAddress);
+			responseObj.put("advertiserId", advertiserId);
+		}
+		else
+		{
+			appendErrorResponse(responseObj, error);
 		}
+
+		responseObj.put("adapterAddress", mAddress);
+		responseObj.put("subscribed", false);
+		responseObj.put("returnValue", true);
+		LSUtils::postToClient(mAdvertisingWatch->getMessage(), responseObj);
+		auto itr = mAdvIdAdapterMap.find(advertiserId);
+		if (itr != mAdvIdAdapterMap.end())
+			mAdvIdAdapterMap.erase(itr);
 	};
 
-	findAdapterInfo(adapterAddress)->getAdapter()->disableAdvertiser(advertiserId, leAdvEnableCallback);
+	findAdapterInfo(adapterAddress)->getAdvertisingScheduler()->remove(advertiserId, removeAdvCallback);
 	return true;
 }
 
@@ -2341,7 +2928,7 @@ bool BluetoothManagerService::configureAdvertisement(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_9(PROP(adapterAddress, string), PROP(connectable, boolean), PROP(includeTxPower, boolean),
+	const char *schema = STRICT_SCHEMA(PROPS_9(PROP(adapterAddress, string), PROP(connectable, boolean), PROP(includeTxPower, boolean),
                                                      PROP(TxPower,integer), PROP(includeName, boolean), PROP(isScanResponse, boolean),
 													 ARRAY(manufacturerData, integer),
                                                      OBJARRAY(services, OBJSCHEMA_2(PROP(uuid, string), ARRAY(data,integer))),
@@ -2637,9 +3224,10 @@ bool BluetoothManagerService::startAdvertising(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(subscribe, boolean),
-											  OBJECT(settings, OBJSCHEMA_5(PROP(connectable, boolean), PROP(txPower, integer),
-													  PROP(minInterval, integer), PROP(maxInterval, integer), PROP(timeout, integer))),
+	const char *schema =  STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(subscribe, boolean),
+											  OBJECT(settings, OBJSCHEMA_6(PROP(connectable, boolean), PROP(txPower, integer),
+													  PROP(minInterval, integer), PROP(maxInterval, integer), PROP(timeout, integer),
+													  PROP(weight, integer))),
 											  OBJECT(advertiseData, OBJSCHEMA_5(PROP(includeTxPower, boolean), PROP(includeName, boolean),
 													  ARRAY(manufacturerData, integer), OBJARRAY(services, OBJSCHEMA_2(PROP(uuid, string),ARRAY(data,integer))),
 													  OBJARRAY(proprietaryData, OBJSCHEMA_2(PROP(type, integer), ARRAY(data, integer))))),
@@ -2662,6 +3250,7 @@ bool BluetoothManagerService::startAdvertising(LSMessage &message)
 	}
 
 	AdvertiserInfo advInfo{};
+	unsigned int weight = 1;
 	//Assign default value true
 	advInfo.settings.connectable = true;
 	BT_DEBUG("BluetoothManagerService::%s %d advertiseData.includeTxPower:%d", __FUNCTION__, __LINE__, advInfo.advertiseData.includeTxPower);
@@ -2688,6 +3277,9 @@ bool BluetoothManagerService::startAdvertising(LSMessage &message)
 
 		if (settingsObj.hasKey("timeout"))
 			advInfo.settings.timeout = settingsObj["timeout"].asNumber<int32_t>();
+
+		if (settingsObj.hasKey("weight") && settingsObj["weight"].asNumber<int32_t>() > 0)
+			weight = settingsObj["weight"].asNumber<int32_t>();
 	}
 
 	if(requestObj.hasKey("advertiseData"))
@@ -2707,55 +3299,44 @@ bool BluetoothManagerService::startAdvertising(LSMessage &message)
 
 	if (requestObj.hasKey("settings") || requestObj.hasKey("advertiseData") || requestObj.hasKey("advertiseData"))
 	{
+		advInfo.advertiseDataSize = getAdvSize(advInfo.advertiseData, true);
+		advInfo.scanResponseSize = getAdvSize(advInfo.scanResponse, false);
+		if (advInfo.advertiseDataSize > MAX_ADVERTISING_DATA_BYTES ||
+						advInfo.scanResponseSize > MAX_ADVERTISING_DATA_BYTES)
+		{
+			LSUtils::respondWithError(request, BT_ERR_BLE_ADV_EXCEED_SIZE_LIMIT);
+			LSMessageUnref(requestMessage);
+			return true;
+		}
+
 		mAdvertisingWatch = new LSUtils::ClientWatch(get(), &message, nullptr);
-		auto leRegisterAdvCallback = [this,requestMessage,advInfo,adapterAddress](BluetoothError error, uint8_t advertiserId) {
+		auto leAddAdvCallback = [this,requestMessage,adapterAddress](BluetoothError error, uint8_t advertiserId) {
 
 			pbnjson::JValue responseObj = pbnjson::Object();
+			responseObj.put("adapterAddress", adapterAddress);
+
 			if (BLUETOOTH_ERROR_NONE == error)
 			{
-				auto leStartAdvCallback = [this,requestMessage,advertiserId,adapterAddress](BluetoothError error) {
-					pbnjson::JValue responseObj = pbnjson::Object();
-
-					if (BLUETOOTH_ERROR_NONE == error)
-					{
-						responseObj.put("adapterAddress", adapterAddress);
-						responseObj.put("returnValue", true);
-						responseObj.put("advertiserId", advertiserId);
-						notifySubscribersAdvertisingChanged(adapterAddress);
-						mAdvIdAdapterMap[advertiserId] = adapterAddress;
-					}
-					else
-					{
-						responseObj.put("adapterAddress", adapterAddress);
-						appendErrorResponse(responseObj, error);
-					}
-					LSUtils::postToClient(requestMessage, responseObj);
-					LSMessageUnref(requestMessage);
-				};
-
 				LS::Message request(requestMessage);
 				if(request.isSubscription())
 					mAdvertisingWatch->setCallback(std::bind(&BluetoothManagerService::notifyAdvertisingDropped, this, advertiserId));
 
-				findAdapterInfo(adapterAddress)->getAdapter()->startAdvertising(advertiserId, advInfo.settings, advInfo.advertiseData, advInfo.scanResponse, leStartAdvCallback);
+				responseObj.put("returnValue", true);
+				responseObj.put("advertiserId", advertiserId);
+				notifySubscribersAdvertisingChanged(adapterAddress);
+				mAdvIdAdapterMap[advertiserId] = adapterAddress;
 			}
 			else
 			{
-				responseObj.put("adapterAddress", adapterAddress);
 				appendErrorResponse(responseObj, error);
-				LSUtils::postToClient(requestMessage, responseObj);
-				LSMessageUnref(requestMessage);
 			}
-		};
 
-		if (getAdvSize(advInfo.advertiseData, true) > MAX_ADVERTISING_DATA_BYTES ||
-						getAdvSize(advInfo.scanResponse, false) > MAX_ADVERTISING_DATA_BYTES)
-		{
-			LSUtils::respondWithError(request, BT_ERR_BLE_ADV_EXCEED_SIZE_LIMIT);
-			return true;
-		}
+			LSUtils::postToClient(requestMessage, responseObj);
+			LSMessageUnref(requestMessage);
+		};
 
-		findAdapterInfo(adapterAddress)->getAdapter()->registerAdvertiser(leRegisterAdvCallback);
+		// More advertisements than the controller has sets take turns on air
+		findAdapterInfo(adapterAddress)->getAdvertisingScheduler()->add(advInfo, weight, leAddAdvCallback);
 	}
 	else
 	{
@@ -2795,7 +3376,7 @@ bool BluetoothManagerService::disableAdvertising(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(advertiserId, integer)) REQUIRED_1(advertiserId));
+	const char *schema =  STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(advertiserId, integer)) REQUIRED_1(advertiserId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -2820,42 +3401,30 @@ bool BluetoothManagerService::disableAdvertising(LSMessage &message)
 	LSMessage *requestMessage = request.get();
 	LSMessageRef(requestMessage);
 
-	auto leAdvEnableCallback = [this, advertiserId, adapterAddress](BluetoothError error)
+	auto removeAdvCallback = [this,adapterAddress, advertiserId](BluetoothError error)
 	{
-		auto unregisterAdvCallback = [this,adapterAddress, advertiserId](BluetoothError error)
-		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-
-			if (BLUETOOTH_ERROR_NONE == error)
-			{
-				notifySubscribersAdvertisingChanged(adapterAddress);
-				responseObj.put("advertiserId", advertiserId);
-			}
-			else
-			{
-				appendErrorResponse(responseObj, error);
-			}
-
-			responseObj.put("adapterAddress", mAddress);
-			responseObj.put("subscribed", false);
-			responseObj.put("returnValue", true);
-			LSUtils::postToClient(mAdvertisingWatch->getMessage(), responseObj);
-			auto itr = mAdvIdAdapterMap.find(advertiserId);
-			if (itr != mAdvIdAdapterMap.end())
-				mAdvIdAdapterMap.erase(itr);
-		};
-		findAdapterInfo(adapterAddress)->getAdapter()->unregisterAdvertiser(advertiserId, unregisterAdvCallback);
+		pbnjson::JValue responseObj = pbnjson::Object();
 
-		if (error != BLUETOOTH_ERROR_NONE)
+		if (BLUETOOTH_ERROR_NONE == error)
+		{
+			notifySubscribersAdvertisingChanged(adapterAddress);
+			responseObj.put("advertiserId", advertiserId);
+		}
+		else
 		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-			responseObj.put("adapterAddress", adapterAddress);
 			appendErrorResponse(responseObj, error);
-			LSUtils::postToClient(mAdvertisingWatch->getMessage(), responseObj);
 		}
+
+		responseObj.put("adapterAddress", mAddress);
+		responseObj.put("subscribed", false);
+		responseObj.put("returnValue", true);
+		LSUtils::postToClient(mAdvertisingWatch->getMessage(), responseObj);
+		auto itr = mAdvIdAdapterMap.find(advertiserId);
+		if (itr != mAdvIdAdapterMap.end())
+			mAdvIdAdapterMap.erase(itr);
 	};
 
-	findAdapterInfo(adapterAddress)->getAdapter()->disableAdvertiser(advertiserId, leAdvEnableCallback);
+	findAdapterInfo(adapterAddress)->getAdvertisingScheduler()->remove(advertiserId, removeAdvCallback);
 
 	pbnjson::JValue responseObj = pbnjson::Object();
 	responseObj.put("advertiserId", advertiserId);
@@ -2873,7 +3442,7 @@ bool BluetoothManagerService::updateAdvertising(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(advertiserId, integer),
+	const char *schema =  STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(advertiserId, integer),
 											  OBJECT(settings, OBJSCHEMA_5(PROP(connectable, boolean), PROP(txPower, integer),
 													  PROP(minInterval, integer), PROP(maxInterval, integer), PROP(timeout, integer))),
 											  OBJECT(advertiseData, OBJSCHEMA_5(PROP(includeTxPower, boolean), PROP(includeName, boolean),
@@ -2923,25 +3492,26 @@ bool BluetoothManagerService::updateAdvertising(LSMessage &message)
 			advInfo.settings.timeout = settingsObj["timeout"].asNumber<int32_t>();
 	}
 
-	LSMessage *requestMessage = request.get();
-	LSMessageRef(requestMessage);
-	auto leUpdateAdvCallback = [requestMessage,adapterAddress](BluetoothError error) {
-		if (BLUETOOTH_ERROR_NONE != error)
-		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-			responseObj.put("adapterAddress", adapterAddress);
-			appendErrorResponse(responseObj, error);
-			LSUtils::postToClient(requestMessage, responseObj);
-			LSMessageUnref(requestMessage);
-		}
-	};
+	auto scheduler = findAdapterInfo(adapterAddress)->getAdvertisingScheduler();
+	const AdvertiserInfo *currentInfo = scheduler->find(advertiserId);
+	if (!currentInfo)
+	{
+		LSUtils::respondWithError(request, BT_ERR_BLE_ADV_CONFIG_FAIL);
+		return true;
+	}
+
+	bool isAdvDataChanged = false;
+	bool isScanRspChanged = false;
 
 	if(requestObj.hasKey("advertiseData"))
 	{
 		if(!setAdvertiseData(message, requestObj,advInfo.advertiseData, false))
 			return true;
 
-		findAdapterInfo(adapterAddress)->getAdapter()->setAdvertiserData(advertiserId, false, advInfo.advertiseData, leUpdateAdvCallback);
+		isAdvDataChanged = !BluetoothAdvertisingScheduler::isSameData(currentInfo->advertiseData, advInfo.advertiseData, false);
+		if (isAdvDataChanged)
+			advInfo.advertiseDataSize = getUpdatedAdvSize(currentInfo->advertiseData, currentInfo->advertiseDataSize,
+														  advInfo.advertiseData, true);
 	}
 
 	if(requestObj.hasKey("scanResponse"))
@@ -2949,85 +3519,68 @@ bool BluetoothManagerService::updateAdvertising(LSMessage &message)
 		if(!setAdvertiseData(message, requestObj, advInfo.scanResponse, true))
 			return true;
 
-		findAdapterInfo(adapterAddress)->getAdapter()->setAdvertiserData(advertiserId, true, advInfo.scanResponse, leUpdateAdvCallback);
+		isScanRspChanged = !BluetoothAdvertisingScheduler::isSameData(currentInfo->scanResponse, advInfo.scanResponse, false);
+		if (isScanRspChanged)
+			advInfo.scanResponseSize = getUpdatedAdvSize(currentInfo->scanResponse, currentInfo->scanResponseSize,
+														 advInfo.scanResponse, false);
 	}
 
-	pbnjson::JValue responseObj = pbnjson::Object();
-	responseObj.put("advertiserId", advertiserId);
-	responseObj.put("adapterAddress", mAddress);
-	responseObj.put("returnValue", true);
-	LSUtils::postToClient(request, responseObj);
-
-	return true;
-}
-
-void BluetoothManagerService::updateAdvertiserData(LSMessage *requestMessage, uint8_t advertiserId, AdvertiserInfo &advInfo,
-		bool isSettingsChanged, bool isAdvDataChanged, bool isScanRspChanged)
-{
-	if(isSettingsChanged)
+	if ((isAdvDataChanged && advInfo.advertiseDataSize > MAX_ADVERTISING_DATA_BYTES) ||
+		(isScanRspChanged && advInfo.scanResponseSize > MAX_ADVERTISING_DATA_BYTES))
 	{
-		auto leAdvSettingCallback = [this, requestMessage,advInfo](BluetoothError error)
-		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-			if (BLUETOOTH_ERROR_NONE == error)
-			{
-				notifySubscribersAdvertisingChanged(mAddress);
-			}
-			else
-			{
-				responseObj.put("adapterAddress", mAddress);
-				appendErrorResponse(responseObj, error);
-				LSUtils::postToClient(requestMessage, responseObj);
-				LSMessageUnref(requestMessage);
-			}
-		};
-		//TODO remove default adapter usage
-		mDefaultAdapter->setAdvertiserParameters(advertiserId, advInfo.settings, leAdvSettingCallback);
+		LSUtils::respondWithError(request, BT_ERR_BLE_ADV_EXCEED_SIZE_LIMIT);
+		return true;
 	}
 
-	if(isAdvDataChanged)
+	if (!isAdvDataChanged && !isScanRspChanged)
 	{
-		auto leAdvDataChangedCallback = [this, requestMessage,advInfo](BluetoothError error)
-		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-			if (BLUETOOTH_ERROR_NONE == error)
-			{
-				notifySubscribersAdvertisingChanged(mAddress);
-			}
-			else
-			{
-				responseObj.put("adapterAddress", mAddress);
-				appendErrorResponse(responseObj, error);
-				LSUtils::postToClient(requestMessage, responseObj);
-				LSMessageUnref(requestMessage);
-			}
-		};
-
-		//TODO remove default adapter usage
-		mDefaultAdapter->setAdvertiserData(advertiserId, false, advInfo.advertiseData, leAdvDataChangedCallback);
+		pbnjson::JValue responseObj = pbnjson::Object();
+		responseObj.put("advertiserId", advertiserId);
+		responseObj.put("adapterAddress", mAddress);
+		responseObj.put("returnValue", true);
+		LSUtils::postToClient(request, responseObj);
+		return true;
 	}
 
-	if(isScanRspChanged)
-	{
-		auto leScanRspChangedCallback = [this,requestMessage,advInfo](BluetoothError error)
+	// Only the changed payload is pushed, the set keeps advertising meanwhile.
+	// The client is answered once the scheduler has taken every payload; one
+	// arriving while the set is being started or rotated is sent as soon as
+	// the set settles.
+	LSMessage *requestMessage = request.get();
+	LSMessageRef(requestMessage);
+
+	std::string address = mAddress;
+	std::shared_ptr<int> pendingUpdates = std::make_shared<int>((isAdvDataChanged ? 1 : 0) + (isScanRspChanged ? 1 : 0));
+	std::shared_ptr<BluetoothError> updateError = std::make_shared<BluetoothError>(BLUETOOTH_ERROR_NONE);
+	auto leUpdateAdvCallback = [requestMessage, address, advertiserId, pendingUpdates, updateError](BluetoothError error) {
+		if (BLUETOOTH_ERROR_NONE == *updateError)
+			*updateError = error;
+
+		if (--(*pendingUpdates) > 0)
+			return;
+
+		pbnjson::JValue responseObj = pbnjson::Object();
+		responseObj.put("adapterAddress", address);
+		if (BLUETOOTH_ERROR_NONE == *updateError)
 		{
-			pbnjson::JValue responseObj = pbnjson::Object();
-			if (BLUETOOTH_ERROR_NONE == error)
-			{
-				notifySubscribersAdvertisingChanged(mAddress);
-			}
-			else
-			{
-				responseObj.put("adapterAddress", mAddress);
-				appendErrorResponse(responseObj, error);
-				LSUtils::postToClient(requestMessage, responseObj);
-				LSMessageUnref(requestMessage);
-			}
-		};
+			responseObj.put("advertiserId", advertiserId);
+			responseObj.put("returnValue", true);
+		}
+		else
+		{
+			appendErrorResponse(responseObj, *updateError);
+		}
+		LSUtils::postToClient(requestMessage, responseObj);
+		LSMessageUnref(requestMessage);
+	};
 
-		//TODO remove default adapter usage
-		mDefaultAdapter->setAdvertiserData(advertiserId, true, advInfo.scanResponse, leScanRspChangedCallback);
-	}
+	if (isAdvDataChanged)
+		scheduler->setData(advertiserId, false, advInfo.advertiseData, advInfo.advertiseDataSize, leUpdateAdvCallback);
+
+	if (isScanRspChanged)
+		scheduler->setData(advertiserId, true, advInfo.scanResponse, advInfo.scanResponseSize, leUpdateAdvCallback);
+
+	return true;
 }
 
 bool BluetoothManagerService::stopAdvertising(LSMessage &message)
@@ -3036,7 +3589,7 @@ bool BluetoothManagerService::stopAdvertising(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
+	const char *schema =  STRICT_SCHEMA(PROPS_1(PROP(adapterAddress, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -3088,7 +3641,7 @@ bool BluetoothManagerService::getAdvStatus(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),PROP(subscribe,boolean)));
+	const char *schema =  STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),PROP(subscribe,boolean)));
 
 	if(!LSUtils::parsePayload(request.getPayload(),requestObj,schema,&parseError))
 	{
@@ -3128,8 +3681,8 @@ bool BluetoothManagerService::startScan(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema =  STRICT_SCHEMA(PROPS_7(PROP(address, string), PROP(name, string),
-													PROP(subscribe, boolean), PROP(adapterAddress, string),
+	const char *schema =  STRICT_SCHEMA(PROPS_8(PROP(address, string), PROP(name, string),
+													PROP(subscribe, boolean), PROP(adapterAddress, string), ARRAY(fields, string),
 													OBJECT(serviceUuid, OBJSCHEMA_2(PROP(uuid, string), PROP(mask, string))),
 													OBJECT(serviceData, OBJSCHEMA_3(PROP(uuid, string), ARRAY(data, integer), ARRAY(mask, integer))),
 													OBJECT(manufacturerData, OBJSCHEMA_3(PROP(id, integer), ARRAY(data, integer), ARRAY(mask, integer)))) REQUIRED_1(subscribe));
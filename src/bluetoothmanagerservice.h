@@ -20,6 +20,7 @@
 
 #include <string>
 #include <sstream>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -27,6 +28,8 @@
 #include <luna-service2/lunaservice.hpp>
 #include <bluetooth-sil-api.h>
 #include "bluetoothpairstate.h"
+#include "bluetoothwarmstartsnapshot.h"
+#include "bluetoothadvertisingscheduler.h"
 #ifdef MULTI_SESSION_SUPPORT
 #include "ls2utils.h"
 #include "bluetoothpdminterface.h"
@@ -59,13 +62,6 @@ namespace LSUtils
 	class ClientWatch;
 }
 
-struct AdvertiserInfo
-{
-	AdvertiseData advertiseData = {};
-	AdvertiseData scanResponse = {};
-	AdvertiseSettings settings = {};
-};
-
 class AdapterInfo
 {
 public:
@@ -108,6 +104,12 @@ public:
 	void initializeProfiles(BluetoothManagerAdapter *adapter);
 	void resetProfiles();
 	void resetProfiles(const std::string &adapterAddress);
+	std::vector<BluetoothProfileService*>& getProfiles() { return mProfiles; }
+	// Keeps the connected profiles of each device up to date in its adapter
+	void profileConnectionChanged(BluetoothProfileService *profile, const std::string &adapterAddress,
+	                              const std::string &address, bool connected);
+	// Binds deferred profiles a newly connected device has one of the uuids of
+	void bindLazyProfiles(const std::vector<std::string> &uuids);
 
 	BluetoothManagerAdapter* findAdapterInfo(const std::string &address) const;
 	BluetoothDevice* findDevice(const std::string &address) const;
@@ -115,11 +117,18 @@ public:
 	bool getPowered(const std::string &address);
 	bool isAdapterAvailable(const std::string &address);
 	bool isRequestedAdapterAvailable(LS::Message &request, const pbnjson::JValue &requestObj, std::string &adapterAddress);
+	// Id of the adapter the last isRequestedAdapterAvailable resolved, if it
+	// is the given one, -1 otherwise
+	int getRequestedAdapterId(const std::string &adapterAddress) const
+	{
+		return adapterAddress == mRequestedAdapterAddress ? mRequestedAdapterId : -1;
+	}
 	bool getAdvertisingState();
 	void setAdvertisingState(bool advertising);
 	bool isRoleEnable(const std::string &address, const std::string &role);
 	std::string getMessageOwner(LSMessage *message);
 	int getAdvSize(AdvertiseData advData, bool flagRequired);
+	int getUpdatedAdvSize(const AdvertiseData &current, int currentSize, const AdvertiseData &updated, bool flagRequired);
 	bool isValidAddress(std::string& address);
 #ifdef MULTI_SESSION_SUPPORT
 	std::unordered_map<std::string, BluetoothManagerAdapter*> getAvailableBluetoothAdapters() { return mAdaptersInfo; }
@@ -150,13 +159,13 @@ private:
 	bool getWoBleStatus(LSMessage &message);
 	bool sendHciCommand(LSMessage &message);
 	bool setAdvertiseData(LSMessage &message, pbnjson::JValue &value, AdvertiseData &data, bool isScanRsp);
-	void updateAdvertiserData(LSMessage *requestMessage, uint8_t advertiserId, AdvertiserInfo &advInfo,
-			bool isSettingsChanged, bool isAdvDataChanged, bool isScanRspChanged);
 	bool setTrace(LSMessage &message);
 	bool getTraceStatus(LSMessage &message);
 	bool getLinkKey(LSMessage &message);
 	bool setKeepAlive(LSMessage &message);
 	bool getKeepAliveStatus(LSMessage &message);
+	bool getPerformanceStats(LSMessage &message);
+	bool getStartupTimeline(LSMessage &message);
 	bool startSniff(LSMessage &message);
 	bool stopSniff(LSMessage &message);
 
@@ -174,15 +183,21 @@ private:
 #endif
 
 	void notifySubscribersAboutStateChange();
+	// For state shown by getStatus that changes without notifying subscribers
+	void invalidateStatus() { mStatusStateVersion++; }
 	void notifySubscribersAdvertisingChanged(std::string adapterAddress);
 	void notifySubscribersAdaptersChanged();
+	void scheduleWarmStartSave();
+	void warmStartDeviceReported();
 	void updateFromAdapterAddressForQueryAvailable(BluetoothAdapter *adapter, const BluetoothProperty &property);
 	void assignDefaultAdapter();
 	bool isServiceClassEnabled(const std::string& serviceClass);
 	void createProfiles();
+	template<typename T> T *createProfile(const std::string &serviceClass);
 	bool notifyAdvertisingDropped(uint8_t advertiserId);
 	bool notifyAdvertisingDisabled(uint8_t advertiserId);
 	bool setPairableState(const std::string &adapterAddress, bool value);
+	static gboolean logPerformanceStats(gpointer user_data);
 
 	//BLE
 	bool configureAdvertisement(LSMessage &message);
@@ -192,27 +207,61 @@ private:
 	bool stopAdvertising(LSMessage &message);
 	bool getAdvStatus(LSMessage &message);
 	bool startScan(LSMessage &message);
-	std::vector<BluetoothProfileService*>& getProfiles() { return mProfiles; }
 	BluetoothPairingIOCapability getIOPairingCapability() { return mPairingIOCapability; }
 
 private:
+	// getStatus responses of one display set, serialized when first needed
+	// after the state changed. The version only moves when the content does.
+	// getPairedDevices subscription answered from the warm start snapshot.
+	// The watch flags clients that went away before the hand-over.
+	typedef struct
+	{
+		LS::Message request;
+		pbnjson::JValue requestObj;
+		std::unique_ptr<LSUtils::ClientWatch> watch;
+		bool dropped;
+	} WarmStartRequest;
+
+	typedef struct
+	{
+		uint64_t stateVersion;
+		uint64_t version;
+		std::string notification;
+		std::string response;
+		std::string subscribedResponse;
+	} StatusSnapshot;
+
+	const StatusSnapshot &getStatusSnapshot(int displaySetIndex);
+
+	bool selectRequestedAdapter(const std::string &adapterAddress);
+	unsigned int allocateAdapterId() const;
+	static gboolean handleWarmStartSaveTimeout(gpointer user_data);
+	bool respondPairedDevicesFromSnapshot(LS::Message &request, pbnjson::JValue &requestObj);
+	void startWarmStartEnumeration();
+	void checkWarmStartEnumeration();
+	static gboolean handleWarmStartEnumerationTimeout(gpointer user_data);
+	void reconcileWarmStartSnapshot();
+
 	std::vector<BluetoothProfileService*> mProfiles;
 	std::string mAddress;
 	bool mAdvertising;
 	bool mWoBleEnabled;
 	bool mKeepAliveEnabled;
 	uint32_t mKeepAliveInterval;
+	guint mPerformanceLogSource;
 	BluetoothSIL *mSil;
 	BluetoothAdapter *mDefaultAdapter;
 	std::vector<BluetoothAdapter*> mAdapters;
 	std::unordered_map<std::string, BluetoothManagerAdapter*> mAdaptersInfo;
+	std::string mRequestedAdapterAddress;
+	int mRequestedAdapterId;
 	std::vector<std::string> mEnabledServiceClasses;
+	std::vector<std::string> mLazyServiceClasses;
 	BluetoothWoBleTriggerDeviceList mWoBleTriggerDevices;
 	BluetoothPairingIOCapability mPairingIOCapability;
 
 	LSUtils::ClientWatch *mAdvertisingWatch;
 
-	std::unordered_map<uint8_t, AdvertiserInfo*> mAdvertisers;
 	std::map<uint8_t, std::string> mAdvIdAdapterMap;
 
 #ifdef MULTI_SESSION_SUPPORT
@@ -223,9 +272,26 @@ private:
 	LS::SubscriptionPoint mGetStatusSubscriptions;
 	LS::SubscriptionPoint mQueryAvailableSubscriptions;
 #endif
+#ifdef MULTI_SESSION_SUPPORT
+	StatusSnapshot mStatusSnapshots[MAX_SUBSCRIPTION_SESSIONS];
+#else
+	StatusSnapshot mStatusSnapshots[1];
+#endif
+	uint64_t mStatusStateVersion;
 	LS::SubscriptionPoint mGetAdvStatusSubscriptions;
 	LS::SubscriptionPoint mGetKeepAliveStatusSubscriptions;
 
+	BluetoothWarmStartSnapshot mWarmStartSnapshot;
+	guint mWarmStartSaveSource;
+	// The snapshot is only reconciled, and the live state only saved, once the
+	// SIL has had the chance to report the paired devices of the default adapter
+	bool mWarmStartEnumerated;
+	gint64 mWarmStartEnumerationStart;
+	guint mWarmStartEnumerationSource;
+	// getPairedDevices subscriptions answered from the snapshot, handed over
+	// to the adapter once the snapshot is reconciled
+	std::vector<std::unique_ptr<WarmStartRequest>> mWarmStartPairedDevicesRequests;
+
 	BluetoothGattAncsProfile *mGattAnsc;
 	friend class BluetoothManagerAdapter;
 };
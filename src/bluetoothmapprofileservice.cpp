@@ -20,6 +20,8 @@
 #include "bluetootherrors.h"
 #include "ls2utils.h"
 #include "clientwatch.h"
+#include "responseworkerpool.h"
+#include "eventqueue.h"
 #include "logging.h"
 #include "utils.h"
 #include "config.h"
@@ -84,6 +86,10 @@ void BluetoothMapProfileService::initialize(const std::string &adapterAddress)
 
 void BluetoothMapProfileService::propertiesChanged(const std::string &adapterAddress, const std::string &sessionKey, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothMapProfileService::propertiesChanged", mAlive,
+			[=] { BluetoothMapProfileService::propertiesChanged(adapterAddress, sessionKey, properties); }))
+		return;
+
 	bool connected = false;
 
 	for (auto prop : properties)
@@ -156,7 +162,7 @@ bool BluetoothMapProfileService::prepareGetMasInstances(LS::Message &request, pb
 
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
                                               REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -445,7 +451,7 @@ void BluetoothMapProfileService::handleDeviceClientDisappeared(const std::string
 bool BluetoothMapProfileService::prepareConnect(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
 			                         PROP(instanceName, string), PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -579,7 +585,7 @@ bool BluetoothMapProfileService::disconnect(LSMessage &message)
 bool BluetoothMapProfileService::isSessionIdSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string))  REQUIRED_2(address, sessionId));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string))  REQUIRED_2(address, sessionId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -691,7 +697,7 @@ bool BluetoothMapProfileService::prepareGetStatus(LS::Message &request, pbnjson:
 {
 
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string), PROP(instanceName, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string), PROP(instanceName, string),
 			                                  PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -878,7 +884,7 @@ bool BluetoothMapProfileService::getMessageList(LSMessage &message)
 bool BluetoothMapProfileService::isGetMessageListSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string),
 								PROP(folder, string), OBJECT(filter, OBJSCHEMA_11(PROP(startOffset, integer), PROP(maxCount, integer),
 								PROP(subjectLength, integer), PROP(periodBegin, string), PROP(periodEnd, string), PROP(recipient, string),
 								PROP(sender, string), PROP(priority, boolean), PROP(read, boolean), ARRAY(fields, string), ARRAY(messageTypes, string))))
@@ -952,16 +958,20 @@ void BluetoothMapProfileService::getMessageListCallback(LS::Message &request,con
 		LSUtils::respondWithError(request, error);
 		return;
 	}
-	pbnjson::JValue responseObj = pbnjson::Object();
-	responseObj.put("returnValue", true);
-	responseObj.put("adapterAddress", adapterAddress);
-	responseObj.put("address", address);
-	responseObj.put("instanceName", parseInstanceNameFromSessionKey(sessionKey));
-	appendMessageList(responseObj,messageList);
-	LSUtils::postToClient(request, responseObj);
+	std::string instanceName = parseInstanceNameFromSessionKey(sessionKey);
+	ResponseWorkerPool::respond(request.get(), messageList.size(),
+								[address, adapterAddress, instanceName, messageList]() -> std::string {
+		pbnjson::JValue responseObj = pbnjson::Object();
+		responseObj.put("returnValue", true);
+		responseObj.put("adapterAddress", adapterAddress);
+		responseObj.put("address", address);
+		responseObj.put("instanceName", instanceName);
+		appendMessageList(responseObj,messageList);
+		return responseObj.stringify();
+	});
 }
 
-void BluetoothMapProfileService::appendMessageList(pbnjson::JValue &responseObject , BluetoothMessageList& messageList)
+void BluetoothMapProfileService::appendMessageList(pbnjson::JValue &responseObject , const BluetoothMessageList& messageList)
 {
 	BT_INFO("MAP", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
 	pbnjson::JValue messageValue = pbnjson::Array();
@@ -1096,7 +1106,7 @@ void BluetoothMapProfileService::getFolderCallback(LS::Message &request,const st
 bool BluetoothMapProfileService::isGetFolderListSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string),
 								PROP(startOffset, integer),PROP(maxListCount, integer))  REQUIRED_2(address,sessionId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1153,7 +1163,7 @@ bool BluetoothMapProfileService::setFolder(LSMessage &message)
 bool BluetoothMapProfileService::isSetFolderSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string),
 								PROP(folder, string))  REQUIRED_3(address,sessionId,folder));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1265,7 +1275,7 @@ bool BluetoothMapProfileService::getMessage(LSMessage &message)
 bool BluetoothMapProfileService::isGetMessageSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(destinationFile, string), PROP(handle, string), PROP(attachment, boolean))  REQUIRED_3(address, handle, sessionId));
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(destinationFile, string), PROP(handle, string), PROP(attachment, boolean))  REQUIRED_3(address, handle, sessionId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1354,7 +1364,7 @@ bool BluetoothMapProfileService::setMessageStatus(LSMessage &message)
 bool BluetoothMapProfileService::isSetMessageStatusSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(handle, string), PROP(statusIndicator, string), PROP(statusValue, boolean))  REQUIRED_5(address, handle, statusIndicator, sessionId, statusValue));
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(handle, string), PROP(statusIndicator, string), PROP(statusValue, boolean))  REQUIRED_5(address, handle, statusIndicator, sessionId, statusValue));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1457,7 +1467,7 @@ bool BluetoothMapProfileService::pushMessage(LSMessage &message)
 bool BluetoothMapProfileService::isPushMessageSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_8(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(sourceFile, string), PROP(folder, string), PROP(transparent, boolean), PROP(retry, boolean), PROP(charset, string))  REQUIRED_4(address, sourceFile, folder, sessionId));
+	const char *schema = STRICT_SCHEMA(PROPS_8(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(sourceFile, string), PROP(folder, string), PROP(transparent, boolean), PROP(retry, boolean), PROP(charset, string))  REQUIRED_4(address, sourceFile, folder, sessionId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1576,7 +1586,7 @@ void BluetoothMapProfileService::handleMessageNotificationClientDisappeared(cons
 bool BluetoothMapProfileService::isGetMessageNotificationSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(subscribe, boolean), PROP_WITH_VAL_1(subscribe, boolean, true))  REQUIRED_3(address, sessionId, subscribe));
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(address, string), PROP(adapterAddress, string), PROP(sessionId, string), PROP(subscribe, boolean), PROP_WITH_VAL_1(subscribe, boolean, true))  REQUIRED_3(address, sessionId, subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -64,7 +64,7 @@ private:
 	bool isGetMessageListSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj);
 	void addGetMessageFilters(const pbnjson::JValue &requestObj, BluetoothMapPropertiesList &filters);
 	void getMessageListCallback(LS::Message &request,const std::string& address, const std::string& sessionKey,const std::string& adapterAddress,BluetoothError error, BluetoothMessageList& messageList);
-	void appendMessageList(pbnjson::JValue &responseObject , BluetoothMessageList& messageList);
+	static void appendMessageList(pbnjson::JValue &responseObject , const BluetoothMessageList& messageList);
 	bool isGetMessageSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress);
 	std::string buildStorageDirPath(const std::string &path, const std::string &address);
 	bool isSetMessageStatusSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj, std::string &adapterAddress);
@@ -35,7 +35,8 @@
 BluetoothMeshProfileService::BluetoothMeshProfileService(BluetoothManagerService *manager) :
 BluetoothProfileService(manager, "MESH", "00001827-0000-1000-8000-00805f9b34fb"),
 mNetworkCreated(0),
-mAppKeyIndex(0)
+mAppKeyIndex(0),
+mStore(manager)
 {
 	LS_CREATE_CATEGORY_BEGIN(BluetoothMeshProfileService, base)
 	LS_CATEGORY_CLASS_METHOD(BluetoothMeshProfileService, scanUnprovisionedDevices)
@@ -138,53 +139,57 @@ void BluetoothMeshProfileService::initialize(const std::string &adapterAddress)
 		getImpl<BluetoothMeshProfile>(adapterAddress)->registerObserver(this);
 	}
 
-	/* Get Appkeys from db */
-	pbnjson::JValue result;
-	LSUtils::callDb8MeshGetAppKeys(getManager(), result);
-	pbnjson::JValue results = result["results"];
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
-		{
-			pbnjson::JValue meshEntry = results[i];
-			if (meshEntry.hasKey("appKey"))
-			{
-				uint16_t appKeyIndex = (uint16_t)meshEntry["appKey"].asNumber<int32_t>();
-				std::string appName = meshEntry["appName"].asString();
-				BT_DEBUG("appkey: %d, appname: %s", appKeyIndex, appName.c_str());
-				mAppKeys.insert(std::pair<uint16_t, std::string>(appKeyIndex, appName));
-			}
-		}
+	mStore.load();
+	mStore.whenLoaded([this, adapterAddress]() {
+		if (!mStore.isLoaded())
+			return;
 
 		/* Keep the app key index to next available index */
 		while (isAppKeyExist(mAppKeyIndex))
 		{
 			mAppKeyIndex++;
 		}
-	}
-
-	/*Get node info from db */
-	pbnjson::JValue nodeInfo;
-	LSUtils::callDb8MeshGetNodeInfo(getManager(), nodeInfo);
-	results = nodeInfo["results"];
-	std::vector<uint16_t> unicastAddresses;
 
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
+		std::vector<uint16_t> unicastAddresses;
+		for (auto &node : mStore.getNodes())
 		{
-			pbnjson::JValue meshEntry = results[i];
-			if (meshEntry.hasKey("unicastAddress"))
+			for (int i = 0; i < node.second.count; ++i)
 			{
-				uint16_t uincastAddress = (uint16_t)meshEntry["unicastAddress"].asNumber<int32_t>();
-				for (int i = 0; i < meshEntry["count"].asNumber<int32_t>(); ++i)
-				{
-					unicastAddresses.push_back(uincastAddress + i);
-				}
+				unicastAddresses.push_back(node.first + i);
 			}
 		}
-		getImpl<BluetoothMeshProfile>(adapterAddress)->updateNodeInfo("PB-ADV", unicastAddresses);
+
+		BluetoothMeshProfile *impl = getImpl<BluetoothMeshProfile>(adapterAddress);
+		if (impl && !unicastAddresses.empty())
+			impl->updateNodeInfo("PB-ADV", unicastAddresses);
+	});
+}
+
+bool BluetoothMeshProfileService::deferUntilStoreLoaded(LSMessage &message,
+							bool (BluetoothMeshProfileService::*method)(LSMessage &))
+{
+	if (mStore.isLoaded())
+		return false;
+
+	// Acting on an empty store would for example create a second network
+	if (mStore.hasLoadFailed())
+	{
+		LSUtils::respondWithError(&message, BT_ERR_MESH_STORE_UNAVAILABLE);
+		mStore.load();
+		return true;
 	}
+
+	LSMessage *requestMessage = &message;
+	LSMessageRef(requestMessage);
+	mStore.whenLoaded([this, requestMessage, method]() {
+		if (mStore.isLoaded())
+			(this->*method)(*requestMessage);
+		else
+			LSUtils::respondWithError(requestMessage, BT_ERR_MESH_STORE_UNAVAILABLE);
+		LSMessageUnref(requestMessage);
+	});
+
+	return true;
 }
 
 bool BluetoothMeshProfileService::isValidApplication(uint16_t appKeyIndex, LS::Message &request)
@@ -202,8 +207,8 @@ bool BluetoothMeshProfileService::isValidApplication(uint16_t appKeyIndex, LS::M
 	/* If app index exists and the sender name is same as the stored app name, then
 	 * valid application
 	 */
-	auto appIter = mAppKeys.find(appKeyIndex);
-	if (appIter != mAppKeys.end() && appIter->second == senderName)
+	auto appIter = mStore.getAppKeys().find(appKeyIndex);
+	if (appIter != mStore.getAppKeys().end() && appIter->second.appName == senderName)
 	{
 		return true;
 	}
@@ -286,7 +291,7 @@ bool BluetoothMeshProfileService::scanUnprovisionedDevices(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
 	PROP(bearer, string), PROP(scanTimeout, integer), PROP(subscribe, boolean)) REQUIRED_1( subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -424,7 +429,7 @@ void BluetoothMeshProfileService::modelConfigResult(const std::string &adapterAd
 			else if (config == "APPKEYINDEX")
 			{
 				object.put("appKeyIndexes", appendAppKeyIndexes(configuration.getAppKeyIndexes()));
-				LSUtils::callDb8UpdateAppkey(getManager(), configuration.getNodeAddress(), configuration.getAppKeyIndexes());
+				mStore.setNodeAppKeyIndexes(configuration.getNodeAddress(), configuration.getAppKeyIndexes());
 			}
 			else if (config == "APPKEY_ADD")
 			{
@@ -630,7 +635,7 @@ bool BluetoothMeshProfileService::unprovisionedScanCancel(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
 	PROP(bearer, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -684,11 +689,14 @@ bool BluetoothMeshProfileService::unprovisionedScanCancel(LSMessage &message)
 bool BluetoothMeshProfileService::createNetwork(LSMessage &message)
 {
 	BT_INFO("MESH", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::createNetwork))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
 	PROP(bearer, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -718,14 +726,12 @@ bool BluetoothMeshProfileService::createNetwork(LSMessage &message)
 		return true;
 	}
 
-	std::string meshToken;
-	bool networkTokenExists = LSUtils::callDb8MeshFindToken(getManager(), meshToken);
-	if (networkTokenExists)
+	if (mStore.hasToken())
 	{
-		BT_INFO("MESH", 0, "network already exists, token : %s: [%s : %d]", meshToken.c_str(),
+		BT_INFO("MESH", 0, "network already exists, token : %s: [%s : %d]", mStore.getToken().c_str(),
 				 __FUNCTION__, __LINE__);
 		mNetworkCreated = true;
-		impl->attach("PB-ADV", meshToken);
+		impl->attach("PB-ADV", mStore.getToken());
 		LSUtils::respondWithError(request, BLUETOOTH_ERROR_MESH_NETWORK_EXISTS);
 		return true;
 	}
@@ -769,14 +775,7 @@ void BluetoothMeshProfileService::updateNetworkId(const std::string &adapterAddr
 			BT_INFO("MESH", 0, "networkId : [%s : %llu]", __FUNCTION__, networkId);
 			std::string networkID = std::to_string(networkId);
 			object.put("networkId", networkID);
-			if (!LSUtils::callDb8MeshSetToken(getManager(), networkID))
-			{
-				BT_ERROR("MESH", 0, "Db8 set mesh token failed");
-			}
-			else
-			{
-				BT_DEBUG("Db8 set mesh token success");
-			}
+			mStore.setToken(networkID);
 			LSUtils::postToClient(watch->getMessage(), object);
 
 
@@ -791,7 +790,7 @@ bool BluetoothMeshProfileService::provision(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(timeout, integer),
+	const char *schema = STRICT_SCHEMA(PROPS_5(PROP(adapterAddress, string), PROP(timeout, integer),
 													 PROP(bearer, string), PROP(uuid, string),
 													 PROP_WITH_VAL_1(subscribe, boolean, true))
 												 REQUIRED_2(uuid, subscribe));
@@ -880,7 +879,7 @@ bool BluetoothMeshProfileService::supplyProvisioningOob(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 													 PROP(bearer, string), PROP(oobData, string))
 												 REQUIRED_1(oobData));
 
@@ -941,7 +940,7 @@ bool BluetoothMeshProfileService::supplyProvisioningNumeric(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 													 PROP(bearer, string), PROP(number, integer))
 												 REQUIRED_1(number));
 
@@ -997,11 +996,14 @@ bool BluetoothMeshProfileService::supplyProvisioningNumeric(LSMessage &message)
 bool BluetoothMeshProfileService::setOnOff(LSMessage &message)
 {
 	BT_INFO("MESH", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::setOnOff))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(bearer, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string), PROP(bearer, string),
 							PROP(destAddress, integer), PROP(appKeyIndex, integer),
 							PROP(state, boolean), PROP(subscribe, boolean))
 							REQUIRED_3(destAddress, appKeyIndex, state));
@@ -1096,11 +1098,14 @@ bool BluetoothMeshProfileService::setOnOff(LSMessage &message)
 bool BluetoothMeshProfileService::send(LSMessage &message)
 {
 	BT_INFO("MESH", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::send))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_7(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_7(PROP(adapterAddress, string),
 							PROP(bearer, string), PROP(srcAddress, integer),
 							PROP(destAddress, integer), PROP(appKeyIndex, integer),
 							PROP(command, string), OBJECT(payload, SCHEMA_ANY))
@@ -1135,10 +1140,10 @@ bool BluetoothMeshProfileService::send(LSMessage &message)
 	if (cmd.compare("onOff") == 0)
 	{
 		pbnjson::JValue requestPayloadObj;
-		const std::string payloadSchema = STRICT_SCHEMA (PROPS_1(PROP(value, boolean))
+		const char *payloadSchema = STRICT_SCHEMA (PROPS_1(PROP(value, boolean))
 					REQUIRED_1(value));
 		std::string str1 = sendPayload.stringify(NULL);
-		BT_INFO("MESH", 0, "onOFF: [%s : %s]", str1.c_str(), payloadSchema.c_str());
+		BT_INFO("MESH", 0, "onOFF: [%s : %s]", str1.c_str(), payloadSchema);
 		if (!LSUtils::parsePayload(sendPayload.stringify(NULL), requestPayloadObj, payloadSchema, &parseError))
 		{
 			if (parseError != JSON_PARSE_SCHEMA_ERROR)
@@ -1155,10 +1160,10 @@ bool BluetoothMeshProfileService::send(LSMessage &message)
 	else if(cmd.compare("passThrough") == 0)
 	{
 		pbnjson::JValue requestPayloadObj;
-		const std::string payloadSchema = STRICT_SCHEMA (PROPS_1(ARRAY(value, integer))
+		const char *payloadSchema = STRICT_SCHEMA (PROPS_1(ARRAY(value, integer))
 					REQUIRED_1(value));
 		std::string str1 = sendPayload.stringify(NULL);
-		BT_INFO("MESH", 0, "passThrough: [%s : %s]", str1.c_str(), payloadSchema.c_str());
+		BT_INFO("MESH", 0, "passThrough: [%s : %s]", str1.c_str(), payloadSchema);
 		if (!LSUtils::parsePayload(sendPayload.stringify(NULL), requestPayloadObj, payloadSchema, &parseError))
 		{
 			if (parseError != JSON_PARSE_SCHEMA_ERROR)
@@ -1241,11 +1246,14 @@ bool BluetoothMeshProfileService::send(LSMessage &message)
 bool BluetoothMeshProfileService::receive(LSMessage &message)
 {
 	BT_INFO("MESH", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::receive))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
 							PROP(bearer, string), PROP(appKeyIndex, integer),
 							PROP_WITH_VAL_1(subscribe, boolean, true))
 							REQUIRED_2(appKeyIndex, subscribe));
@@ -1401,11 +1409,14 @@ void BluetoothMeshProfileService::provisionResult(BluetoothError error, const st
 
 bool BluetoothMeshProfileService::createAppKey(LSMessage &message)
 {
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::createAppKey))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
 													 PROP(bearer, string), PROP(netKeyIndex, integer),
 													 PROP(appKeyIndex, integer)));
 
@@ -1492,11 +1503,7 @@ bool BluetoothMeshProfileService::createAppKey(LSMessage &message)
 		LSUtils::respondWithError(request, error);
 		return true;
 	}
-	if (!LSUtils::callDb8MeshPutAppKey(getManager(), appKeyIndex, senderName))
-	{
-		BT_INFO("MESH", 0, "Db8 put appkey failed");
-	}
-	mAppKeys.insert(std::pair<uint16_t, std::string>(appKeyIndex, senderName));
+	mStore.putAppKey(appKeyIndex, senderName);
 	pbnjson::JValue responseObj = pbnjson::Object();
 	responseObj.put("returnValue", true);
 	responseObj.put("adapterAddress", adapterAddress);
@@ -1509,7 +1516,7 @@ bool BluetoothMeshProfileService::createAppKey(LSMessage &message)
 
 bool BluetoothMeshProfileService::isAppKeyExist(uint16_t appKeyIndex)
 {
-	return (mAppKeys.find(appKeyIndex) != mAppKeys.end());
+	return mStore.hasAppKey(appKeyIndex);
 }
 
 bool BluetoothMeshProfileService::get(LSMessage &message)
@@ -1520,7 +1527,7 @@ bool BluetoothMeshProfileService::get(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(adapterAddress, string),
 													PROP(bearer, string), PROP(destAddress, integer),
 													PROP_WITH_VAL_1(subscribe, boolean, true),
 													PROP(config, string),
@@ -1608,12 +1615,15 @@ bool BluetoothMeshProfileService::get(LSMessage &message)
 bool BluetoothMeshProfileService::set(LSMessage &message)
 {
 	BT_INFO("MESH", 0, "Luna API is called : [%s : %d]", __FUNCTION__, __LINE__);
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::set))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 	BleMeshRelayStatus relayStatus;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_11(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_11(PROP(adapterAddress, string),
 													PROP(bearer, string), PROP(destAddress, integer),
 													PROP_WITH_VAL_1(subscribe, boolean, true),
 													PROP(config, string),
@@ -1812,17 +1822,19 @@ void BluetoothMeshProfileService::modelDataReceived(const std::string &adapterAd
 		return;
 
 	LS::SubscriptionPoint *subscriptionPoint = modelAppKeySubsIter->second;
-	pbnjson::JValue dataArray = pbnjson::Array();
+	mReceiveWriter.reset();
+	mReceiveWriter.beginObject();
+	mReceiveWriter.put("srcAddress", (int32_t) srcAddress);
+	mReceiveWriter.put("destAddress", (int32_t) destAddress);
+	mReceiveWriter.beginArray("data");
 	for (size_t j=0; j < datalen; j++)
-		dataArray.append(data[j]);
-	pbnjson::JValue responseObj = pbnjson::Object();
-	responseObj.put("srcAddress", srcAddress);
-	responseObj.put("destAddress", destAddress);
-	responseObj.put("data", dataArray);
-	responseObj.put("subscribed", true);
-	responseObj.put("returnValue", true);
-	responseObj.put("adapterAddress", adapterAddress);
-	LSUtils::postToSubscriptionPoint(subscriptionPoint, responseObj);
+		mReceiveWriter.append((int32_t) data[j]);
+	mReceiveWriter.endArray();
+	mReceiveWriter.put("subscribed", true);
+	mReceiveWriter.put("returnValue", true);
+	mReceiveWriter.put("adapterAddress", adapterAddress);
+	mReceiveWriter.endObject();
+	LSUtils::postToSubscriptionPoint(subscriptionPoint, mReceiveWriter.getPayload());
 }
 
 bool BluetoothMeshProfileService::getCompositionData(LSMessage &message)
@@ -1831,7 +1843,7 @@ bool BluetoothMeshProfileService::getCompositionData(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string),
 													 PROP(bearer, string), PROP(destAddress, integer),
 													 PROP(subscribe, boolean))  REQUIRED_2(destAddress, subscribe));
 
@@ -1905,11 +1917,14 @@ bool BluetoothMeshProfileService::getCompositionData(LSMessage &message)
 
 bool BluetoothMeshProfileService::getMeshInfo(LSMessage &message)
 {
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::getMeshInfo))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
 													 PROP(bearer, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1978,7 +1993,7 @@ pbnjson::JValue BluetoothMeshProfileService::appendNetKeys()
 pbnjson::JValue BluetoothMeshProfileService::appendAppKeys()
 {
 	pbnjson::JValue platformObjArr = pbnjson::Array();
-	for (auto itr = mAppKeys.begin(); itr != mAppKeys.end(); ++itr)
+	for (auto itr = mStore.getAppKeys().begin(); itr != mStore.getAppKeys().end(); ++itr)
 	{
 		pbnjson::JValue object = pbnjson::Object();
 		object.put("index", itr->first);
@@ -2000,11 +2015,14 @@ pbnjson::JValue BluetoothMeshProfileService::appendProvisioners()
 
 bool BluetoothMeshProfileService::listProvisionedNodes(LSMessage &message)
 {
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::listProvisionedNodes))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string),
 													 PROP(bearer, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -2065,39 +2083,31 @@ bool BluetoothMeshProfileService::listProvisionedNodes(LSMessage &message)
 
 pbnjson::JValue BluetoothMeshProfileService::appendNodesInfo()
 {
-	/*Get node info from db */
-	pbnjson::JValue nodeInfo;
-	LSUtils::callDb8MeshGetNodeInfo(getManager(), nodeInfo);
-	pbnjson::JValue results = nodeInfo["results"];
 	pbnjson::JValue nodeObjectArr = pbnjson::Array();
 
-	if (results.isValid() && (results.arraySize() > 0))
+	for (auto &node : mStore.getNodes())
 	{
-		for (int i = 0; i < results.arraySize(); ++i)
-		{
-			pbnjson::JValue meshEntry = results[i];
-			if (meshEntry.hasKey("unicastAddress"))
-			{
-				pbnjson::JValue object = pbnjson::Object();
-				object.put("primaryElementAddress",meshEntry["unicastAddress"].asNumber<int32_t>());
-				object.put("uuid", meshEntry["uuid"].asString());
-				object.put("numberOfElements", meshEntry["count"].asNumber<int32_t>());
-				object.put("netKeyIndex", meshEntry["netKeyIndex"].asNumber<int32_t>());
-				object.put("appKeyIndexes", meshEntry["appKeyIndexes"]);
-				nodeObjectArr.append(object);
-			}
-		}
+		pbnjson::JValue object = pbnjson::Object();
+		object.put("primaryElementAddress", node.first);
+		object.put("uuid", node.second.uuid);
+		object.put("numberOfElements", node.second.count);
+		object.put("netKeyIndex", node.second.netKeyIndex);
+		object.put("appKeyIndexes", appendAppKeyIndexes(node.second.appKeyIndexes));
+		nodeObjectArr.append(object);
 	}
 	return nodeObjectArr;
 }
 
 bool BluetoothMeshProfileService::removeNode(LSMessage &message)
 {
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::removeNode))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string),
 													 PROP(bearer, string), PROP(primaryElementAddress, integer)) REQUIRED_1(primaryElementAddress));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -2169,10 +2179,7 @@ bool BluetoothMeshProfileService::removeNode(LSMessage &message)
 		return true;
 	}
 
-	if(!LSUtils::callDb8MeshDeleteNode(getManager(), unicastAddress))
-	{
-		BT_ERROR("MESH", 0, "Db8 delete node failed");
-	}
+	mStore.removeNode(unicastAddress);
 
 	pbnjson::JValue responseObj = pbnjson::Object();
 	responseObj.put("returnValue", true);
@@ -2189,47 +2196,15 @@ bool BluetoothMeshProfileService::isValidUnicastAddress(uint16_t unicastAddress)
 	if(unicastAddress == LOCAL_NODE_ADDRESS)
 		return true;
 
-	/*Get node info from db */
-	pbnjson::JValue nodeInfo;
-	LSUtils::callDb8MeshGetNodeInfo(getManager(), nodeInfo);
-	pbnjson::JValue results = nodeInfo["results"];
-
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
-		{
-			pbnjson::JValue meshEntry = results[i];
-			if (meshEntry.hasKey("unicastAddress"))
-			{
-				if(unicastAddress == meshEntry["unicastAddress"].asNumber<int32_t>())
-					return true;
-			}
-		}
-	}
-	return false;
+	return mStore.findNode(unicastAddress) != nullptr;
 }
 
 uint8_t BluetoothMeshProfileService::getElementCount(uint16_t unicastAddress)
 {
-	/*Get node info from db */
-	pbnjson::JValue nodeInfo;
-	LSUtils::callDb8MeshGetNodeInfo(getManager(), nodeInfo);
-	pbnjson::JValue results = nodeInfo["results"];
+	const BluetoothMeshStore::Node *node = mStore.findNode(unicastAddress);
+	if (node)
+		return node->count;
 
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
-		{
-			pbnjson::JValue meshEntry = results[i];
-			if (meshEntry.hasKey("unicastAddress"))
-			{
-				if(unicastAddress == meshEntry["unicastAddress"].asNumber<int32_t>())
-				{
-					return meshEntry["count"].asNumber<int32_t>();
-				}
-			}
-		}
-	}
 	return 0;
 }
 
@@ -2237,54 +2212,19 @@ void BluetoothMeshProfileService::updateAppkeyList(uint16_t unicastAddress, uint
 {
 	BT_DEBUG("unicastAddress: %d, appKeyIndex: %d remove: %d", unicastAddress, appKeyIndex, remove);
 
-	pbnjson::JValue nodeInfo;
-	LSUtils::callDb8MeshGetNodeInfo(getManager(), nodeInfo);
-	pbnjson::JValue results = nodeInfo["results"];
-
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
-		{
-			pbnjson::JValue meshEntry = results[i];
-			if(unicastAddress == meshEntry["unicastAddress"].asNumber<int32_t>())
-			{
-				if (meshEntry.hasKey("appKeyIndexes"))
-				{
-					std::vector<uint16_t> appKeyIndexesList;
-					auto appKeyIndexesObjArray = meshEntry["appKeyIndexes"];
-					for (int n = 0; n < appKeyIndexesObjArray.arraySize(); n++)
-					{
-						pbnjson::JValue element = appKeyIndexesObjArray[n];
-						appKeyIndexesList.push_back(element.asNumber<int32_t>());
-					}
-
-					auto findIter = std::find(appKeyIndexesList.begin(), appKeyIndexesList.end(), appKeyIndex);
-					if(remove)
-					{
-						if (findIter == appKeyIndexesList.end())
-							return;
-						appKeyIndexesList.erase(findIter);
-					}
-					else
-					{
-						if (findIter != appKeyIndexesList.end())
-							return;
-						appKeyIndexesList.push_back(appKeyIndex);
-					}
-					LSUtils::callDb8UpdateAppkey(getManager(), unicastAddress, appKeyIndexesList);
-				}
-			}
-		}
-	}
+	mStore.updateNodeAppKeyIndex(unicastAddress, appKeyIndex, remove);
 }
 
 bool BluetoothMeshProfileService::keyRefresh(LSMessage &message)
 {
+	if (deferUntilStoreLoaded(message, &BluetoothMeshProfileService::keyRefresh))
+		return true;
+
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_8(PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_8(PROP(adapterAddress, string),
 												PROP(bearer, string),
 												PROP(subscribe, boolean),
 												PROP(netKeyIndex, integer),
@@ -2350,7 +2290,7 @@ bool BluetoothMeshProfileService::keyRefresh(LSMessage &message)
 		}
 		if (0 == indexes.arraySize())
 		{
-			for (auto appKeys : mAppKeys)
+			for (auto &appKeys : mStore.getAppKeys())
 			{
 				appKeyIndexesToRefresh.push_back(appKeys.first);
 			}
@@ -2359,7 +2299,7 @@ bool BluetoothMeshProfileService::keyRefresh(LSMessage &message)
 		{
 			for (int i = 0; i < indexes.arraySize(); ++i)
 			{
-				if (mAppKeys.end() != mAppKeys.find(indexes[i].asNumber<int32_t>()))
+				if (isAppKeyExist(indexes[i].asNumber<int32_t>()))
 				{
 					appKeyIndexesToRefresh.push_back((uint16_t)indexes[i].asNumber<int32_t>());
 				}
@@ -2413,10 +2353,7 @@ bool BluetoothMeshProfileService::keyRefresh(LSMessage &message)
 			responseObj.put("adapterAddress", adapterAddress);
 			for (int i = 0; i < blackListedNodes.size(); ++i)
 			{
-				if(!LSUtils::callDb8MeshDeleteNode(getManager(), blackListedNodes[i]))
-				{
-					BT_ERROR("MESH", 0, "Db8 delete node failed");
-				}
+				mStore.removeNode(blackListedNodes[i]);
 			}
 			LSUtils::postToClient(requestMessage, responseObj);
 		}
@@ -2468,10 +2405,7 @@ void BluetoothMeshProfileService::keyRefreshResult(BluetoothError error,
 				}
 				else if (BLUETOOTH_ERROR_MESH_NETKEY_UPDATE_FAILED == error)
 				{
-					if (!LSUtils::callDb8MeshDeleteNode(getManager(), nodeAddress))
-					{
-						BT_ERROR("MESH", 0, "Db8 delete node failed");
-					}
+					mStore.removeNode(nodeAddress);
 				}
 				else
 				{
@@ -2493,45 +2427,20 @@ void BluetoothMeshProfileService::keyRefreshResult(BluetoothError error,
 
 std::vector<BleMeshNode> BluetoothMeshProfileService::getProvisionedNodes()
 {
-	pbnjson::JValue nodeInfo;
 	std::vector<BleMeshNode> meshNodes;
-	LSUtils::callDb8MeshGetNodeInfo(getManager(), nodeInfo);
-	pbnjson::JValue results = nodeInfo["results"];
-	if (results.isValid() && (results.arraySize() > 0))
+	for (auto &node : mStore.getNodes())
 	{
-		for (int i = 0; i < results.arraySize(); ++i)
-		{
-			pbnjson::JValue result = results[i];
-			std::vector<uint16_t> appKeyIndexes;
-			pbnjson::JValue appKeyIndexesObj = result["appKeyIndexes"];
-			for (int j = 0; j < appKeyIndexesObj.arraySize(); ++j)
-			{
-				appKeyIndexes.push_back(appKeyIndexesObj[j].asNumber<int32_t>());
-			}
-			std::string uuid = result["uuid"].asString();
-			BleMeshNode node(uuid,
-				result["unicastAddress"].asNumber<int32_t>(),
-				result["count"].asNumber<int32_t>(),
-				result["netKeyIndex"].asNumber<int32_t>(), appKeyIndexes);
-			meshNodes.push_back(std::move(node));
-		}
+		BleMeshNode meshNode(node.second.uuid, node.first, node.second.count,
+			node.second.netKeyIndex, node.second.appKeyIndexes);
+		meshNodes.push_back(std::move(meshNode));
 	}
 	return meshNodes;
 }
 
 void BluetoothMeshProfileService::storeProvisionedDevice(uint16_t unicastAddress, const std::string &uuid, uint8_t count)
 {
-	std::string id =  LSUtils::getObjectIDByUUID(getManager(), uuid);
-
-	if(!id.empty() && !LSUtils::callDb8DeleteId(getManager(), id))
-	{
-		BT_INFO("MESH", 0, "delete id from db failed: %s", id.c_str());
-	}
-
-	if (!LSUtils::callDb8MeshPutNodeInfo(getManager(), unicastAddress, uuid, count))
-	{
-		BT_ERROR("MESH", 0, "Failed to store unicastAddresse: %d", unicastAddress);
-	}
+	/* Replaces the record of a device provisioned earlier with the same uuid */
+	mStore.putNode(unicastAddress, uuid, count);
 }
 
 void BluetoothMeshProfileService:: applyCGroupSecurity(const std::string &folder)
@@ -26,6 +26,8 @@
 #include <pbnjson.hpp>
 
 #include "bluetoothprofileservice.h"
+#include "jsonwriter.h"
+#include "bluetoothmeshstore.h"
 
 namespace pbnjson
 {
@@ -135,6 +137,8 @@ private:
 													uint16_t unicastAddress);
 	std::vector<BleMeshNode> getProvisionedNodes();
 	void storeProvisionedDevice(uint16_t unicastAddress, const std::string &uuid, uint8_t count);
+	/* Replays the request once the mesh store is loaded, returns false if it already is */
+	bool deferUntilStoreLoaded(LSMessage &message, bool (BluetoothMeshProfileService::*method)(LSMessage &));
 	void applyCGroupSecurity(const std::string &folder);
 private:
 	typedef struct device
@@ -153,12 +157,14 @@ private:
 	/* map<adapterAddress, map<uuid, UnprovisionedDeviceInfo>> */
 	std::unordered_map<std::string, std::map<std::string, UnprovisionedDeviceInfo>> mUnprovisionedDevices;
 	std::map<uint16_t, LS::SubscriptionPoint*> recvSubscriptions;
+	JsonWriter mReceiveWriter;
 
 	bool mNetworkCreated;
 	/* App Key Index created so far */
 	uint16_t mAppKeyIndex;
 
-	std::unordered_map<uint16_t, std::string> mAppKeys;
+	/* Nodes, app keys and network token, persisted to db8 */
+	BluetoothMeshStore mStore;
 	std::map<uint16_t, BluetoothClientWatch *> mKeyRefreshWatch;
 };
 
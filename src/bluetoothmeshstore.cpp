@@ -0,0 +1,671 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <algorithm>
+
+#include "bluetoothmeshstore.h"
+#include "ls2utils.h"
+#include "logging.h"
+#include "mainloopwatchdog.h"
+
+#define MESH_NODE_KIND		"com.webos.service.bluetooth2.meshnodeinfo:1"
+#define MESH_APPKEY_KIND	"com.webos.service.bluetooth2.meshappkey:1"
+#define MESH_TOKEN_KIND		"com.webos.service.bluetooth2.meshtoken:1"
+
+/* Changes made within this many milliseconds go out in the same batch */
+#define MESH_STORE_FLUSH_DELAY			500
+#define MESH_STORE_RETRY_DELAY			5000
+/* Failed reads are retried after 1, 2, 4 and 8 seconds before the load fails */
+#define MESH_STORE_FIND_RETRY_DELAY		1000
+#define MESH_STORE_MAX_FIND_RETRIES		4
+/* Upper bound of records written by a single db8 batch call */
+#define MESH_STORE_MAX_BATCH_OBJECTS	100
+
+BluetoothMeshStore::BluetoothMeshStore(LS::Handle *serviceHandle) :
+	mServiceHandle(serviceHandle),
+	mAlive(std::make_shared<bool>(true)),
+	mLoaded(false),
+	mLoadFailed(false),
+	mPendingFinds(0),
+	mFindRetries(0),
+	mFindFailed(false),
+	mTokenDirty(false),
+	mFlushSource(0),
+	mFlushInFlight(false)
+{
+}
+
+BluetoothMeshStore::~BluetoothMeshStore()
+{
+	mAlive.reset();
+
+	if (mFlushSource)
+		g_source_remove(mFlushSource);
+
+	if (!mLoaded)
+		return;
+
+	// Last chance to persist pending changes, nobody is left to see the reply
+	std::vector<PendingPut> puts;
+	std::vector<std::string> deletedIds;
+	for (std::string payload = buildBatch(puts, deletedIds, MESH_STORE_MAX_BATCH_OBJECTS); !payload.empty();
+		 payload = buildBatch(puts, deletedIds, MESH_STORE_MAX_BATCH_OBJECTS))
+	{
+		callDb8("luna://com.webos.service.db/batch", payload, nullptr);
+		puts.clear();
+		deletedIds.clear();
+	}
+}
+
+bool BluetoothMeshStore::handleDb8Reply(LSHandle *handle, LSMessage *reply, void *context)
+{
+	std::unique_ptr<Db8Callback> callback(static_cast<Db8Callback*>(context));
+
+	pbnjson::JValue replyObj = pbnjson::Object();
+	LSUtils::parsePayload(LSMessageGetPayload(reply), replyObj);
+
+	bool returnValue = replyObj["returnValue"].asBool();
+	if (!returnValue)
+	{
+		BT_INFO("MESH", 0, "Db8 %s returned error: %d==%s", LSMessageGetMethod(reply),
+			replyObj["errorCode"].asNumber<int32_t>(), replyObj["errorText"].asString().c_str());
+	}
+
+	if (*callback)
+		(*callback)(returnValue, replyObj);
+
+	return true;
+}
+
+bool BluetoothMeshStore::callDb8(const char *uri, const std::string &payload, Db8Callback callback)
+{
+	LSError error;
+	LSErrorInit(&error);
+
+	Db8Callback *context = new Db8Callback(callback);
+	if (!LSCallOneReply(mServiceHandle->get(), uri, payload.c_str(), handleDb8Reply, context, NULL, &error))
+	{
+		BT_ERROR("MESH", 0, "Failed to call %s: %s", uri, error.message);
+		LSErrorFree(&error);
+		delete context;
+
+		if (callback)
+		{
+			pbnjson::JValue replyObj = pbnjson::Object();
+			callback(false, replyObj);
+		}
+		return false;
+	}
+
+	return true;
+}
+
+void BluetoothMeshStore::load()
+{
+	if (mLoaded || mPendingFinds)
+		return;
+
+	BT_INFO("MESH", 0, "Loading mesh store from db8");
+
+	// Nothing of an earlier failed attempt is kept
+	mNodes.clear();
+	mAppKeys.clear();
+	mToken.clear();
+	mTokenId.clear();
+	mDeletedIds.clear();
+	mLoadFailed = false;
+	mFindRetries = 0;
+	mFindFailed = false;
+
+	mPendingFinds = 3;
+	find(MESH_TOKEN_KIND, std::string());
+	find(MESH_APPKEY_KIND, std::string());
+	find(MESH_NODE_KIND, std::string());
+}
+
+void BluetoothMeshStore::whenLoaded(std::function<void()> callback)
+{
+	if (mLoaded || mLoadFailed)
+		callback();
+	else
+		mLoadedCallbacks.push_back(callback);
+}
+
+bool BluetoothMeshStore::deferChange(std::function<void()> change)
+{
+	if (mLoaded)
+		return false;
+
+	if (mLoadFailed)
+		BT_ERROR("MESH", 0, "Mesh store is not loaded, dropping change");
+	else
+		mLoadedCallbacks.push_back(change);
+
+	return true;
+}
+
+void BluetoothMeshStore::find(const char *kind, const std::string &page)
+{
+	pbnjson::JValue queryObj = pbnjson::Object();
+	queryObj.put("from", kind);
+	if (!page.empty())
+		queryObj.put("page", page);
+
+	pbnjson::JValue reqObj = pbnjson::Object();
+	reqObj.put("query", queryObj);
+
+	std::weak_ptr<bool> alive = mAlive;
+	callDb8("luna://com.webos.service.db/find", reqObj.stringify(),
+		[this, alive, kind, page](bool success, pbnjson::JValue &replyObj) {
+			if (alive.expired())
+				return;
+
+			if (!success)
+			{
+				// Retry the same page, records of earlier pages are already in
+				if (mFindRetries < MESH_STORE_MAX_FIND_RETRIES && !mFindFailed)
+				{
+					guint delay = MESH_STORE_FIND_RETRY_DELAY << mFindRetries++;
+					BT_ERROR("MESH", 0, "Failed to load %s from db8, retrying in %u ms", kind, delay);
+
+					FindRetry *retry = new FindRetry;
+					retry->store = this;
+					retry->alive = mAlive;
+					retry->kind = kind;
+					retry->page = page;
+					MainLoopWatchdog::addTimeout("BluetoothMeshStore::findRetry", delay, handleFindRetry, retry);
+					return;
+				}
+
+				BT_ERROR("MESH", 0, "Failed to load %s from db8, giving up", kind);
+				mFindFailed = true;
+			}
+			else
+			{
+				loadRecords(kind, replyObj["results"]);
+
+				// db8 pages large result sets, keep going until the last page
+				if (replyObj.hasKey("next"))
+				{
+					find(kind, replyObj["next"].asString());
+					return;
+				}
+			}
+
+			if (0 == --mPendingFinds)
+				finishLoad();
+		});
+}
+
+gboolean BluetoothMeshStore::handleFindRetry(gpointer userData)
+{
+	std::unique_ptr<FindRetry> retry(static_cast<FindRetry*>(userData));
+
+	if (!retry->alive.expired())
+		retry->store->find(retry->kind, retry->page);
+
+	return FALSE;
+}
+
+void BluetoothMeshStore::loadRecords(const char *kind, const pbnjson::JValue &results)
+{
+	for (int i = 0; results.isArray() && i < results.arraySize(); ++i)
+	{
+		pbnjson::JValue record = results[i];
+		std::string id = record["_id"].asString();
+
+		if (MESH_NODE_KIND == std::string(kind) && record.hasKey("unicastAddress"))
+		{
+			uint16_t unicastAddress = (uint16_t) record["unicastAddress"].asNumber<int32_t>();
+
+			// Older releases could leave duplicate records behind, keep the first
+			if (mNodes.find(unicastAddress) != mNodes.end())
+			{
+				mDeletedIds.push_back(id);
+				continue;
+			}
+
+			Node node;
+			node.id = id;
+			node.uuid = record["uuid"].asString();
+			node.count = (uint8_t) record["count"].asNumber<int32_t>();
+			node.netKeyIndex = (uint16_t) record["netKeyIndex"].asNumber<int32_t>();
+
+			pbnjson::JValue appKeyIndexesObj = record["appKeyIndexes"];
+			for (int j = 0; appKeyIndexesObj.isArray() && j < appKeyIndexesObj.arraySize(); ++j)
+				node.appKeyIndexes.push_back((uint16_t) appKeyIndexesObj[j].asNumber<int32_t>());
+
+			mNodes.insert(std::make_pair(unicastAddress, node));
+		}
+		else if (MESH_APPKEY_KIND == std::string(kind) && record.hasKey("appKey"))
+		{
+			uint16_t appKeyIndex = (uint16_t) record["appKey"].asNumber<int32_t>();
+
+			// Same as for nodes, only the first record of an index is used
+			if (mAppKeys.find(appKeyIndex) != mAppKeys.end())
+			{
+				mDeletedIds.push_back(id);
+				continue;
+			}
+
+			AppKey appKey;
+			appKey.id = id;
+			appKey.appName = record["appName"].asString();
+			mAppKeys.insert(std::make_pair(appKeyIndex, appKey));
+		}
+		else if (MESH_TOKEN_KIND == std::string(kind) && record.hasKey("meshToken"))
+		{
+			// Every network id update used to add a token record, the first
+			// one is the one that was always used
+			if (!mTokenId.empty())
+			{
+				mDeletedIds.push_back(id);
+				continue;
+			}
+
+			mToken = record["meshToken"].asString();
+			mTokenId = id;
+		}
+	}
+}
+
+void BluetoothMeshStore::finishLoad()
+{
+	if (mFindFailed)
+	{
+		// An empty store would look like no network was ever created
+		mNodes.clear();
+		mAppKeys.clear();
+		mToken.clear();
+		mTokenId.clear();
+		mDeletedIds.clear();
+		mLoadFailed = true;
+
+		BT_ERROR("MESH", 0, "Mesh store could not be loaded, mesh requests are rejected until it is");
+	}
+	else
+	{
+		mLoaded = true;
+
+		BT_INFO("MESH", 0, "Mesh store loaded: %zu nodes, %zu app keys, token %s",
+				mNodes.size(), mAppKeys.size(), hasToken() ? "present" : "absent");
+	}
+
+	std::vector<std::function<void()>> callbacks;
+	callbacks.swap(mLoadedCallbacks);
+	for (auto &callback : callbacks)
+		callback();
+
+	if (mLoaded && !mDeletedIds.empty())
+		scheduleFlush(MESH_STORE_FLUSH_DELAY);
+}
+
+const BluetoothMeshStore::Node *BluetoothMeshStore::findNode(uint16_t unicastAddress) const
+{
+	auto nodeIter = mNodes.find(unicastAddress);
+	if (nodeIter == mNodes.end())
+		return nullptr;
+
+	return &nodeIter->second;
+}
+
+void BluetoothMeshStore::putNode(uint16_t unicastAddress, const std::string &uuid, uint8_t count)
+{
+	if (deferChange(std::bind(&BluetoothMeshStore::putNode, this, unicastAddress, uuid, count)))
+		return;
+
+	for (auto nodeIter = mNodes.begin(); nodeIter != mNodes.end();)
+	{
+		if (nodeIter->first != unicastAddress && nodeIter->second.uuid == uuid)
+		{
+			uint16_t staleAddress = (nodeIter++)->first;
+			removeNode(staleAddress);
+		}
+		else
+			++nodeIter;
+	}
+
+	Node &node = mNodes[unicastAddress];
+	node.uuid = uuid;
+	node.count = count;
+	node.netKeyIndex = 0;
+	node.appKeyIndexes.clear();
+
+	markNodeDirty(unicastAddress);
+}
+
+void BluetoothMeshStore::removeNode(uint16_t unicastAddress)
+{
+	if (deferChange(std::bind(&BluetoothMeshStore::removeNode, this, unicastAddress)))
+		return;
+
+	auto nodeIter = mNodes.find(unicastAddress);
+	if (nodeIter == mNodes.end())
+	{
+		BT_INFO("MESH", 0, "unicastAddress is not present in db: %d", unicastAddress);
+		return;
+	}
+
+	if (!nodeIter->second.id.empty())
+		mDeletedIds.push_back(nodeIter->second.id);
+
+	mNodes.erase(nodeIter);
+	mDirtyNodes.erase(unicastAddress);
+
+	scheduleFlush(MESH_STORE_FLUSH_DELAY);
+}
+
+void BluetoothMeshStore::setNodeAppKeyIndexes(uint16_t unicastAddress, const std::vector<uint16_t> &appKeyIndexes)
+{
+	if (deferChange(std::bind(&BluetoothMeshStore::setNodeAppKeyIndexes, this, unicastAddress, appKeyIndexes)))
+		return;
+
+	auto nodeIter = mNodes.find(unicastAddress);
+	if (nodeIter == mNodes.end())
+	{
+		BT_INFO("MESH", 0, "unicastAddress is not present in db: %d", unicastAddress);
+		return;
+	}
+
+	nodeIter->second.appKeyIndexes = appKeyIndexes;
+	markNodeDirty(unicastAddress);
+}
+
+void BluetoothMeshStore::updateNodeAppKeyIndex(uint16_t unicastAddress, uint16_t appKeyIndex, bool remove)
+{
+	if (deferChange(std::bind(&BluetoothMeshStore::updateNodeAppKeyIndex, this, unicastAddress, appKeyIndex, remove)))
+		return;
+
+	auto nodeIter = mNodes.find(unicastAddress);
+	if (nodeIter == mNodes.end())
+		return;
+
+	std::vector<uint16_t> &appKeyIndexes = nodeIter->second.appKeyIndexes;
+	auto findIter = std::find(appKeyIndexes.begin(), appKeyIndexes.end(), appKeyIndex);
+	if (remove)
+	{
+		if (findIter == appKeyIndexes.end())
+			return;
+		appKeyIndexes.erase(findIter);
+	}
+	else
+	{
+		if (findIter != appKeyIndexes.end())
+			return;
+		appKeyIndexes.push_back(appKeyIndex);
+	}
+
+	markNodeDirty(unicastAddress);
+}
+
+bool BluetoothMeshStore::hasAppKey(uint16_t appKeyIndex) const
+{
+	return mAppKeys.find(appKeyIndex) != mAppKeys.end();
+}
+
+void BluetoothMeshStore::putAppKey(uint16_t appKeyIndex, const std::string &appName)
+{
+	if (deferChange(std::bind(&BluetoothMeshStore::putAppKey, this, appKeyIndex, appName)))
+		return;
+
+	BT_INFO("MESH", 0, "appKeyInex: %d, appName: %s", appKeyIndex, appName.c_str());
+
+	mAppKeys[appKeyIndex].appName = appName;
+	mDirtyAppKeys.insert(appKeyIndex);
+	scheduleFlush(MESH_STORE_FLUSH_DELAY);
+}
+
+void BluetoothMeshStore::setToken(const std::string &token)
+{
+	if (deferChange(std::bind(&BluetoothMeshStore::setToken, this, token)))
+		return;
+
+	mToken = token;
+	mTokenDirty = true;
+	scheduleFlush(MESH_STORE_FLUSH_DELAY);
+}
+
+void BluetoothMeshStore::markNodeDirty(uint16_t unicastAddress)
+{
+	mDirtyNodes.insert(unicastAddress);
+	scheduleFlush(MESH_STORE_FLUSH_DELAY);
+}
+
+void BluetoothMeshStore::scheduleFlush(guint delay)
+{
+	// A flush in flight picks up whatever changed meanwhile once it returns
+	if (mFlushSource || mFlushInFlight)
+		return;
+
+	mFlushSource = MainLoopWatchdog::addTimeout("BluetoothMeshStore::flush", delay, handleFlushTimeout, this);
+}
+
+gboolean BluetoothMeshStore::handleFlushTimeout(gpointer userData)
+{
+	BluetoothMeshStore *store = static_cast<BluetoothMeshStore*>(userData);
+
+	store->mFlushSource = 0;
+	store->flush();
+
+	return FALSE;
+}
+
+void BluetoothMeshStore::flush()
+{
+	if (!mLoaded || mFlushInFlight)
+		return;
+
+	if (mFlushSource)
+	{
+		g_source_remove(mFlushSource);
+		mFlushSource = 0;
+	}
+
+	std::string payload = buildBatch(mInFlightPuts, mInFlightDeletedIds, MESH_STORE_MAX_BATCH_OBJECTS);
+	if (payload.empty())
+		return;
+
+	BT_DEBUG("Flushing mesh store: %zu puts, %zu deletes", mInFlightPuts.size(), mInFlightDeletedIds.size());
+
+	mFlushInFlight = true;
+
+	std::weak_ptr<bool> alive = mAlive;
+	callDb8("luna://com.webos.service.db/batch", payload,
+		[this, alive](bool success, pbnjson::JValue &replyObj) {
+			if (alive.expired())
+				return;
+
+			handleBatchReply(success, replyObj);
+		});
+}
+
+std::string BluetoothMeshStore::buildBatch(std::vector<PendingPut> &puts, std::vector<std::string> &deletedIds,
+										   size_t maxObjects)
+{
+	pbnjson::JValue operationsObj = pbnjson::Array();
+
+	if (!mDeletedIds.empty())
+	{
+		deletedIds.swap(mDeletedIds);
+
+		pbnjson::JValue idsObj = pbnjson::Array();
+		for (auto &id : deletedIds)
+			idsObj.append(id);
+
+		pbnjson::JValue paramsObj = pbnjson::Object();
+		paramsObj.put("ids", idsObj);
+
+		pbnjson::JValue operationObj = pbnjson::Object();
+		operationObj.put("method", "del");
+		operationObj.put("params", paramsObj);
+		operationsObj.append(operationObj);
+	}
+
+	pbnjson::JValue objectsObj = pbnjson::Array();
+
+	if (mTokenDirty)
+	{
+		pbnjson::JValue tokenObj = pbnjson::Object();
+		if (!mTokenId.empty())
+			tokenObj.put("_id", mTokenId);
+		tokenObj.put("_kind", MESH_TOKEN_KIND);
+		tokenObj.put("meshToken", mToken);
+		objectsObj.append(tokenObj);
+
+		puts.push_back({RECORD_TOKEN, 0, mTokenId.empty()});
+		mTokenDirty = false;
+	}
+
+	while (!mDirtyAppKeys.empty() && puts.size() < maxObjects)
+	{
+		uint16_t appKeyIndex = *mDirtyAppKeys.begin();
+		mDirtyAppKeys.erase(mDirtyAppKeys.begin());
+
+		const AppKey &appKey = mAppKeys[appKeyIndex];
+
+		pbnjson::JValue appKeyObj = pbnjson::Object();
+		if (!appKey.id.empty())
+			appKeyObj.put("_id", appKey.id);
+		appKeyObj.put("_kind", MESH_APPKEY_KIND);
+		appKeyObj.put("appKey", appKeyIndex);
+		appKeyObj.put("appName", appKey.appName);
+		objectsObj.append(appKeyObj);
+
+		puts.push_back({RECORD_APPKEY, appKeyIndex, appKey.id.empty()});
+	}
+
+	while (!mDirtyNodes.empty() && puts.size() < maxObjects)
+	{
+		uint16_t unicastAddress = *mDirtyNodes.begin();
+		mDirtyNodes.erase(mDirtyNodes.begin());
+
+		auto nodeIter = mNodes.find(unicastAddress);
+		if (nodeIter == mNodes.end())
+			continue;
+
+		const Node &node = nodeIter->second;
+
+		pbnjson::JValue appKeyIndexesObj = pbnjson::Array();
+		for (auto appKeyIndex : node.appKeyIndexes)
+			appKeyIndexesObj.append(appKeyIndex);
+
+		pbnjson::JValue nodeObj = pbnjson::Object();
+		if (!node.id.empty())
+			nodeObj.put("_id", node.id);
+		nodeObj.put("_kind", MESH_NODE_KIND);
+		nodeObj.put("unicastAddress", unicastAddress);
+		nodeObj.put("uuid", node.uuid);
+		nodeObj.put("count", node.count);
+		nodeObj.put("netKeyIndex", node.netKeyIndex);
+		nodeObj.put("appKeyIndexes", appKeyIndexesObj);
+		objectsObj.append(nodeObj);
+
+		puts.push_back({RECORD_NODE, unicastAddress, node.id.empty()});
+	}
+
+	if (objectsObj.arraySize() > 0)
+	{
+		pbnjson::JValue paramsObj = pbnjson::Object();
+		paramsObj.put("objects", objectsObj);
+
+		pbnjson::JValue operationObj = pbnjson::Object();
+		operationObj.put("method", "put");
+		operationObj.put("params", paramsObj);
+		operationsObj.append(operationObj);
+	}
+
+	if (0 == operationsObj.arraySize())
+		return std::string();
+
+	pbnjson::JValue reqObj = pbnjson::Object();
+	reqObj.put("operations", operationsObj);
+
+	return reqObj.stringify();
+}
+
+void BluetoothMeshStore::handleBatchReply(bool success, pbnjson::JValue &replyObj)
+{
+	mFlushInFlight = false;
+
+	if (!success)
+	{
+		BT_ERROR("MESH", 0, "Failed to write mesh store to db8, retrying in %d ms", MESH_STORE_RETRY_DELAY);
+		restorePending();
+		scheduleFlush(MESH_STORE_RETRY_DELAY);
+		return;
+	}
+
+	// The put operation always comes last, its results follow the order of
+	// the objects written
+	pbnjson::JValue responsesObj = replyObj["responses"];
+	pbnjson::JValue resultsObj = pbnjson::Array();
+	if (!mInFlightPuts.empty() && responsesObj.isArray() && responsesObj.arraySize() > 0)
+		resultsObj = responsesObj[responsesObj.arraySize() - 1]["results"];
+
+	for (size_t i = 0; i < mInFlightPuts.size(); ++i)
+	{
+		const PendingPut &put = mInFlightPuts[i];
+		if (!put.created || !resultsObj.isArray() || (int) i >= resultsObj.arraySize())
+			continue;
+
+		std::string id = resultsObj[i]["id"].asString();
+
+		if (RECORD_NODE == put.type)
+		{
+			auto nodeIter = mNodes.find(put.key);
+			if (nodeIter != mNodes.end() && nodeIter->second.id.empty())
+				nodeIter->second.id = id;
+			else
+				// Removed while the write was in flight
+				mDeletedIds.push_back(id);
+		}
+		else if (RECORD_APPKEY == put.type)
+		{
+			auto appKeyIter = mAppKeys.find(put.key);
+			if (appKeyIter != mAppKeys.end() && appKeyIter->second.id.empty())
+				appKeyIter->second.id = id;
+		}
+		else if (mTokenId.empty())
+		{
+			mTokenId = id;
+		}
+	}
+
+	mInFlightPuts.clear();
+	mInFlightDeletedIds.clear();
+
+	if (mTokenDirty || !mDirtyNodes.empty() || !mDirtyAppKeys.empty() || !mDeletedIds.empty())
+		flush();
+}
+
+void BluetoothMeshStore::restorePending()
+{
+	for (auto &put : mInFlightPuts)
+	{
+		if (RECORD_NODE == put.type && mNodes.find(put.key) != mNodes.end())
+			mDirtyNodes.insert(put.key);
+		else if (RECORD_APPKEY == put.type && hasAppKey(put.key))
+			mDirtyAppKeys.insert(put.key);
+		else if (RECORD_TOKEN == put.type)
+			mTokenDirty = true;
+	}
+
+	mDeletedIds.insert(mDeletedIds.end(), mInFlightDeletedIds.begin(), mInFlightDeletedIds.end());
+
+	mInFlightPuts.clear();
+	mInFlightDeletedIds.clear();
+}
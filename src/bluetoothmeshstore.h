@@ -0,0 +1,174 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef BLUETOOTH_MESH_STORE_H
+#define BLUETOOTH_MESH_STORE_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+#include <pbnjson.hpp>
+
+namespace LS
+{
+	class Handle;
+}
+
+struct LSHandle;
+struct LSMessage;
+
+/*
+ * In-memory copy of the mesh state kept in db8 (provisioned nodes, app keys
+ * and the network token). It is loaded once and is authoritative afterwards:
+ * reads never go to db8, and changes are written behind in batches through
+ * db8 "batch", so provisioning many nodes costs a few bus round trips instead
+ * of one or two per node.
+ *
+ * Failed reads are retried with backoff. Should they keep failing the load
+ * fails as a whole: the store is never taken as authoritative on partial or
+ * missing data, changes are dropped instead of being written over what db8
+ * holds, and load() has to be called again.
+ */
+class BluetoothMeshStore
+{
+public:
+	typedef struct
+	{
+		std::string id; // db8 _id, empty until the record was first written
+		std::string uuid;
+		uint8_t count;
+		uint16_t netKeyIndex;
+		std::vector<uint16_t> appKeyIndexes;
+	} Node;
+
+	typedef struct
+	{
+		std::string id;
+		std::string appName;
+	} AppKey;
+
+	BluetoothMeshStore(LS::Handle *serviceHandle);
+	~BluetoothMeshStore();
+
+	BluetoothMeshStore(const BluetoothMeshStore&) = delete;
+	BluetoothMeshStore& operator = (const BluetoothMeshStore&) = delete;
+
+	void load();
+	bool isLoaded() const { return mLoaded; }
+	bool hasLoadFailed() const { return mLoadFailed; }
+	// Runs callback once the initial load succeeded or failed, right away if
+	// it already did
+	void whenLoaded(std::function<void()> callback);
+
+	const std::map<uint16_t, Node> &getNodes() const { return mNodes; }
+	const Node *findNode(uint16_t unicastAddress) const;
+	// Replaces any node previously provisioned with the same uuid
+	void putNode(uint16_t unicastAddress, const std::string &uuid, uint8_t count);
+	void removeNode(uint16_t unicastAddress);
+	void setNodeAppKeyIndexes(uint16_t unicastAddress, const std::vector<uint16_t> &appKeyIndexes);
+	void updateNodeAppKeyIndex(uint16_t unicastAddress, uint16_t appKeyIndex, bool remove);
+
+	const std::map<uint16_t, AppKey> &getAppKeys() const { return mAppKeys; }
+	bool hasAppKey(uint16_t appKeyIndex) const;
+	void putAppKey(uint16_t appKeyIndex, const std::string &appName);
+
+	bool hasToken() const { return !mToken.empty(); }
+	const std::string &getToken() const { return mToken; }
+	void setToken(const std::string &token);
+
+	// Writes pending changes now instead of waiting for the flush timer
+	void flush();
+
+private:
+	typedef enum
+	{
+		RECORD_NODE,
+		RECORD_APPKEY,
+		RECORD_TOKEN
+	} RecordType;
+
+	typedef struct
+	{
+		RecordType type;
+		uint16_t key;
+		bool created;
+	} PendingPut;
+
+	typedef std::function<void(bool success, pbnjson::JValue &reply)> Db8Callback;
+
+	typedef struct
+	{
+		BluetoothMeshStore *store;
+		std::weak_ptr<bool> alive;
+		const char *kind;
+		std::string page;
+	} FindRetry;
+
+	// Asynchronous db8 call, the callback runs from the main loop and may be
+	// left empty for fire-and-forget writes
+	bool callDb8(const char *uri, const std::string &payload, Db8Callback callback);
+	static bool handleDb8Reply(LSHandle *handle, LSMessage *reply, void *context);
+
+	void find(const char *kind, const std::string &page);
+	static gboolean handleFindRetry(gpointer userData);
+	void loadRecords(const char *kind, const pbnjson::JValue &results);
+	void finishLoad();
+	// Queues a change made before the load completed, drops it if the load failed
+	bool deferChange(std::function<void()> change);
+
+	void markNodeDirty(uint16_t unicastAddress);
+	void scheduleFlush(guint delay);
+	static gboolean handleFlushTimeout(gpointer userData);
+	std::string buildBatch(std::vector<PendingPut> &puts, std::vector<std::string> &deletedIds, size_t maxObjects);
+	void handleBatchReply(bool success, pbnjson::JValue &replyObj);
+	void restorePending();
+
+	LS::Handle *mServiceHandle;
+	// Callbacks hold a weak reference, db8 replies arriving after the store
+	// is gone are dropped
+	std::shared_ptr<bool> mAlive;
+
+	bool mLoaded;
+	bool mLoadFailed;
+	int mPendingFinds;
+	unsigned int mFindRetries;
+	bool mFindFailed;
+	std::vector<std::function<void()>> mLoadedCallbacks;
+
+	std::map<uint16_t, Node> mNodes;
+	std::map<uint16_t, AppKey> mAppKeys;
+	std::string mToken;
+	std::string mTokenId;
+
+	std::set<uint16_t> mDirtyNodes;
+	std::set<uint16_t> mDirtyAppKeys;
+	bool mTokenDirty;
+	std::vector<std::string> mDeletedIds;
+
+	guint mFlushSource;
+	bool mFlushInFlight;
+	std::vector<PendingPut> mInFlightPuts;
+	std::vector<std::string> mInFlightDeletedIds;
+};
+
+#endif // BLUETOOTH_MESH_STORE_H
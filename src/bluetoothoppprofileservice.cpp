@@ -262,7 +262,7 @@ bool BluetoothOppProfileService::prepareFileTransfer(LS::Message &request, pbnjs
 {
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(sourceFile, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(sourceFile, string),
                                               PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string))
                                               REQUIRED_2(address, sourceFile));
 
@@ -423,7 +423,7 @@ bool BluetoothOppProfileService::awaitTransferRequest(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -542,7 +542,7 @@ bool BluetoothOppProfileService::monitorTransfer(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
 		if (parseError != JSON_PARSE_SCHEMA_ERROR)
@@ -892,7 +892,7 @@ bool BluetoothOppProfileService::prepareConfirmationRequest(LS::Message &request
 {
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(requestId, string), PROP(adapterAddress, string)) REQUIRED_1(requestId));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(requestId, string), PROP(adapterAddress, string)) REQUIRED_1(requestId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -994,7 +994,7 @@ bool BluetoothOppProfileService::cancelTransfer(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(requestId, string), PROP(adapterAddress, string)) REQUIRED_1(requestId));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(requestId, string), PROP(adapterAddress, string)) REQUIRED_1(requestId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -75,7 +75,7 @@ bool BluetoothPanProfileService::setTethering(LSMessage &message)
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(tethering, boolean), PROP(adapterAddress, string)) REQUIRED_1(tethering));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(tethering, boolean), PROP(adapterAddress, string)) REQUIRED_1(tethering));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
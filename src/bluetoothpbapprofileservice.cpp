@@ -20,6 +20,7 @@
 #include "bluetootherrors.h"
 #include "ls2utils.h"
 #include "clientwatch.h"
+#include "responseworkerpool.h"
 #include "logging.h"
 #include "utils.h"
 #include "config.h"
@@ -83,7 +84,7 @@ bool BluetoothPbapProfileService::awaitAccessRequest(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP_WITH_VAL_1(subscribe, boolean, true), PROP(adapterAddress, string)) REQUIRED_1(subscribe));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -217,7 +218,7 @@ bool BluetoothPbapProfileService::prepareConfirmationRequest(LS::Message &reques
 		return true;
 	}
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(requestId, string), PROP(adapterAddress, string)) REQUIRED_1(requestId));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(requestId, string), PROP(adapterAddress, string)) REQUIRED_1(requestId));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -283,7 +284,7 @@ bool BluetoothPbapProfileService::prepareSetPhoneBook(LS::Message &request, pbnj
 {
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(adapterAddress, string),
 												PROP(repository, string), PROP(object, string))
 												REQUIRED_3(address, repository, object));
 
@@ -332,7 +333,7 @@ bool BluetoothPbapProfileService::prepareGetSize(LS::Message &request, pbnjson::
 
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
                                               REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -373,7 +374,7 @@ bool BluetoothPbapProfileService::prepareGetvCardFilters(LS::Message &request, p
 
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))
                                               REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -739,7 +740,7 @@ bool BluetoothPbapProfileService::rejectAccessRequest(LSMessage &message)
 bool BluetoothPbapProfileService::prepareVCardListing(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(address, string)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(address, string)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -806,7 +807,7 @@ bool BluetoothPbapProfileService::vCardListing(LSMessage &message)
 bool BluetoothPbapProfileService::prepareSearchPhoneBook(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string), PROP(address, string), PROP(order, string), OBJECT(filter, OBJSCHEMA_2(PROP(key, string), PROP(value, string)))) REQUIRED_2(address, filter));
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(adapterAddress, string), PROP(address, string), PROP(order, string), OBJECT(filter, OBJSCHEMA_2(PROP(key, string), PROP(value, string)))) REQUIRED_2(address, filter));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -893,41 +894,43 @@ bool BluetoothPbapProfileService::searchPhoneBook(LSMessage &message)
 
 void BluetoothPbapProfileService::notifyVCardListingRequest(LS::Message &request, BluetoothError error, const std::string &adapterAddress, const std::string &address, BluetoothPbapVCardList &list, bool success)
 {
-	pbnjson::JValue responseObj = pbnjson::Object();
-
 	if (!success)
 	{
 		LSUtils::respondWithError(request, error);
 		return;
 	}
 
-	responseObj.put("adapterAddress", adapterAddress);
-	responseObj.put("address", address);
-	responseObj.put("returnValue", success);
-	responseObj.put("vcfHandles", createJsonVCardListing(list));
-	LSUtils::postToClient(request, responseObj);
+	ResponseWorkerPool::respond(request.get(), list.size(), [adapterAddress, address, list]() -> std::string {
+		pbnjson::JValue responseObj = pbnjson::Object();
+		responseObj.put("adapterAddress", adapterAddress);
+		responseObj.put("address", address);
+		responseObj.put("returnValue", true);
+		responseObj.put("vcfHandles", createJsonVCardListing(list));
+		return responseObj.stringify();
+	});
 	LSMessageUnref(request.get());
 }
 
 void BluetoothPbapProfileService::notifySearchPhoneBookRequest(LS::Message &request, BluetoothError error, const std::string &adapterAddress, const std::string &address, BluetoothPbapVCardList &list, bool success)
 {
-	pbnjson::JValue responseObj = pbnjson::Object();
-
 	if (!success)
 	{
 		LSUtils::respondWithError(request, error);
 		return;
 	}
 
-	responseObj.put("adapterAddress", adapterAddress);
-	responseObj.put("address", address);
-	responseObj.put("returnValue", success);
-	responseObj.put("vcfHandles", createJsonVCardListing(list));
-	LSUtils::postToClient(request, responseObj);
+	ResponseWorkerPool::respond(request.get(), list.size(), [adapterAddress, address, list]() -> std::string {
+		pbnjson::JValue responseObj = pbnjson::Object();
+		responseObj.put("adapterAddress", adapterAddress);
+		responseObj.put("address", address);
+		responseObj.put("returnValue", true);
+		responseObj.put("vcfHandles", createJsonVCardListing(list));
+		return responseObj.stringify();
+	});
 	LSMessageUnref(request.get());
 }
 
-pbnjson::JValue BluetoothPbapProfileService::createJsonVCardListing(BluetoothPbapVCardList &list)
+pbnjson::JValue BluetoothPbapProfileService::createJsonVCardListing(const BluetoothPbapVCardList &list)
 {
 	pbnjson::JValue platformObjArr = pbnjson::Array();
 	for (auto data = list.begin(); data != list.end(); data++)
@@ -943,7 +946,7 @@ pbnjson::JValue BluetoothPbapProfileService::createJsonVCardListing(BluetoothPba
 bool BluetoothPbapProfileService::prepareGetPhoneBookProperties(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),PROP(subscribe, boolean)) REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(adapterAddress, string), PROP(address, string),PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -1261,7 +1264,7 @@ bool BluetoothPbapProfileService::pullPhoneBook(LSMessage &message)
 bool BluetoothPbapProfileService::parseGetPhoneBookParam(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_8(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_8(PROP(address, string), PROP(adapterAddress, string),
 												PROP(destinationFile, string), PROP(startOffset, integer),
 												PROP(vCardVersion, string),ARRAY(filterFields,string),
 												PROP(maxListCount, integer),PROP_WITH_VAL_1(subscribe, boolean, true))
@@ -1307,7 +1310,7 @@ bool BluetoothPbapProfileService::preparePullVcard(LS::Message &request, pbnjson
 {
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_6(PROP(address, string), PROP(adapterAddress, string),
 												PROP(destinationFile, string), PROP(vCardHandle, string), PROP(vCardVersion, string), ARRAY(filterFields, string))
 												REQUIRED_2(address, vCardHandle));
 
@@ -82,7 +82,7 @@ private:
 	void createAccessRequest(BluetoothPbapAccessRequestId accessRequestId, const std::string &address, const std::string &deviceName);
 	void notifyVCardListingRequest(LS::Message &request, BluetoothError error, const std::string &adapterAddress, const std::string &address, BluetoothPbapVCardList &list, bool success);
 	void notifySearchPhoneBookRequest(LS::Message &request, BluetoothError error, const std::string &adapterAddress, const std::string &address, BluetoothPbapVCardList &list, bool success);
-	pbnjson::JValue createJsonVCardListing(BluetoothPbapVCardList &list);
+	static pbnjson::JValue createJsonVCardListing(const BluetoothPbapVCardList &list);
 	void notifySubscribersAboutPropertiesChange(const std::string &adapterAddress, const std::string &address);
 	void notifyGetPhoneBookPropertiesRequest (LS::Message &request, BluetoothError error, const std::string &adapterAddress, const std::string &address, bool subscribed, bool success);
 	void notifyPullVcardRequest(LS::Message &request, BluetoothError error, const std::string &adapterAddress, const std::string &address, const std::string &destinationFile, bool success);
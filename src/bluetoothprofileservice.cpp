@@ -25,30 +25,46 @@
 #include "bluetoothmanageradapter.h"
 #include "ls2utils.h"
 #include "clientwatch.h"
+#include "eventqueue.h"
+#include "firstcallhook.h"
 #include "logging.h"
 #include "utils.h"
 
 BluetoothProfileService::BluetoothProfileService(BluetoothManagerService *manager, const std::string &name,
                                                  const std::string &uuid) :
 	mImpl(0),
+	mAlive(std::make_shared<bool>(true)),
 	mManager(manager),
-	mName(name)
+	mName(name),
+	mLazy(false)
 {
 	mUuids.push_back(uuid);
+	mConnections.setChangedCallback([this](const std::string &adapterAddress, const std::string &address,
+	                                       uint8_t previousState, uint8_t state) {
+		connectionStateChanged(adapterAddress, address, previousState, state);
+	});
 }
 
 BluetoothProfileService::BluetoothProfileService(BluetoothManagerService *manager, const std::string &name,
                                                  const std::string &uuid1, const std::string &uuid2) :
 	mImpl(0),
+	mAlive(std::make_shared<bool>(true)),
 	mManager(manager),
-	mName(name)
+	mName(name),
+	mLazy(false)
 {
 	mUuids.push_back(uuid1);
 	mUuids.push_back(uuid2);
+	mConnections.setChangedCallback([this](const std::string &adapterAddress, const std::string &address,
+	                                       uint8_t previousState, uint8_t state) {
+		connectionStateChanged(adapterAddress, address, previousState, state);
+	});
 }
 
 BluetoothProfileService::~BluetoothProfileService()
 {
+	if (!mDeferredAdapters.empty())
+		LSUtils::clearFirstCallHook(this);
 }
 
 void BluetoothProfileService::initialize()
@@ -59,7 +75,7 @@ void BluetoothProfileService::initialize()
 
 	mImpl = defaultAdapter->getProfile(mName);
 
-	mImpls.insert(std::pair<std::string, BluetoothProfile*>(getManager()->getAddress(), mImpl));
+	setImpl(getManager()->getAddress(), mImpl);
 
 	if (mImpl)
 		mImpl->registerObserver(this);
@@ -75,10 +91,44 @@ void BluetoothProfileService::initialize(const std::string  &adapterAddress)
 	if (impl)
 		impl->registerObserver(this);
 
-	mImpls.insert(std::pair<std::string, BluetoothProfile*>(adapterAddress, impl));
+	setImpl(adapterAddress, impl);
 }
 
 
+void BluetoothProfileService::deferInitialize(const std::string &adapterAddress)
+{
+	mDeferredAdapters.insert(adapterAddress);
+
+	// Our categories are registered with this as their data
+	LSUtils::setFirstCallHook(this, [this]() {
+		bindDeferred("first call");
+	});
+}
+
+void BluetoothProfileService::cancelDeferredInitialize(const std::string &adapterAddress)
+{
+	if (!mDeferredAdapters.erase(adapterAddress))
+		return;
+
+	if (mDeferredAdapters.empty())
+		LSUtils::clearFirstCallHook(this);
+}
+
+void BluetoothProfileService::bindDeferred(const char *reason)
+{
+	std::set<std::string> adapters;
+	adapters.swap(mDeferredAdapters);
+	LSUtils::clearFirstCallHook(this);
+
+	for (auto &adapterAddress : adapters)
+	{
+		int64_t start = g_get_monotonic_time();
+		initialize(adapterAddress);
+		BT_INFO(MSGID_PROFILE_STARTUP, 0, "%s profile bound to %s on %s in %lld us", mName.c_str(),
+				adapterAddress.c_str(), reason, (long long) (g_get_monotonic_time() - start));
+	}
+}
+
 void BluetoothProfileService::reset()
 {
 	// Our backend is gone so reset everything
@@ -89,11 +139,14 @@ void BluetoothProfileService::reset(const std::string &adapterAddress)
 {
 	// Our backend is gone so reset everything
 
-	auto implIter = mImpls.find(adapterAddress);
-	if (implIter == mImpls.end())
+	ImplSlot *slot = findImplSlot(adapterAddress);
+	if (!slot)
 		return;
 
-	mImpls.erase(implIter);
+	slot->adapterAddress.clear();
+	slot->impl = 0;
+	slot->typeKey = 0;
+	slot->typedImpl = 0;
 }
 
 BluetoothManagerService* BluetoothProfileService::getManager() const
@@ -125,185 +178,123 @@ void BluetoothProfileService::notifyStatusSubscribers(const std::string &adapter
 
 	LS::SubscriptionPoint *subscriptionPoint = subscriptionIter->second;
 
+	// Every subscriber of the device is gone, the next getStatus subscription
+	// starts over with a new subscription point
+	if (subscriptionPoint->getSubscribersCount() == 0)
+	{
+		mLastStatusPayloads.erase(subscriptionPoint);
+		delete subscriptionPoint;
+		(subscriptionsIter->second).erase(subscriptionIter);
+		if ((subscriptionsIter->second).empty())
+			mGetStatusSubscriptionsForMultipleAdapters.erase(subscriptionsIter);
+		return;
+	}
+
 	pbnjson::JValue responseObj = buildGetStatusResp(connected, isDeviceConnecting(adapterAddress, address), true,
 	                                                 true, adapterAddress, address);
 
-	LSUtils::postToSubscriptionPoint(subscriptionPoint, responseObj);
+	std::string payload = responseObj.stringify();
+	std::string &lastPayload = mLastStatusPayloads[subscriptionPoint];
+	if (payload == lastPayload)
+		return;
+
+	lastPayload = payload;
+	LSUtils::postToSubscriptionPoint(subscriptionPoint, payload);
 }
 
+// The single adapter variants keep their state under an empty adapter address
+
 bool BluetoothProfileService::isDeviceConnecting(const std::string &address)
 {
-	return (std::find(mConnectingDevices.begin(), mConnectingDevices.end(), address) != mConnectingDevices.end());
+	return mConnections.hasState(std::string(), address, BluetoothConnectionTable::STATE_CONNECTING);
 }
 
 bool BluetoothProfileService::isDeviceConnecting(const std::string &adapterAddress, const std::string &address)
 {
-	auto connectingDevicesiter = mConnectingDevicesForMultipleAdapters.find(adapterAddress);
-	if (connectingDevicesiter == mConnectingDevicesForMultipleAdapters.end())
-		return false;
-
-	return (std::find((connectingDevicesiter->second).begin(), (connectingDevicesiter->second).end(), address) != (connectingDevicesiter->second).end());
+	return mConnections.hasState(adapterAddress, address, BluetoothConnectionTable::STATE_CONNECTING);
 }
 
 void BluetoothProfileService::markDeviceAsConnecting(const std::string &address)
 {
-	if (isDeviceConnecting(address))
-		return;
-
-	mConnectingDevices.push_back(address);
+	mConnections.setState(std::string(), address, BluetoothConnectionTable::STATE_CONNECTING, true);
 }
 
 void BluetoothProfileService::markDeviceAsConnecting(const std::string &adapterAddress, const std::string &address)
 {
-	auto connectingDevicesiter = mConnectingDevicesForMultipleAdapters.find(adapterAddress);
-	if (connectingDevicesiter == mConnectingDevicesForMultipleAdapters.end())
-	{
-		std::vector<std::string> connectingDevices;
-		connectingDevices.push_back(address);
-
-		mConnectingDevicesForMultipleAdapters.insert(std::pair<std::string, std::vector<std::string>>(adapterAddress, connectingDevices));
-		return;
-	}
-
-	if (!isDeviceConnecting(adapterAddress, address))
-		(connectingDevicesiter->second).push_back(address);
+	mConnections.setState(adapterAddress, address, BluetoothConnectionTable::STATE_CONNECTING, true);
 }
 
 void BluetoothProfileService::markDeviceAsNotConnecting(const std::string &address)
 {
-	auto deviceIter = std::find(mConnectingDevices.begin(), mConnectingDevices.end(), address);
-
-	if (deviceIter == mConnectingDevices.end())
-		return;
-
-	mConnectingDevices.erase(deviceIter);
+	mConnections.setState(std::string(), address, BluetoothConnectionTable::STATE_CONNECTING, false);
 }
 
 void BluetoothProfileService::markDeviceAsNotConnecting(const std::string &adapterAddress, const std::string &address)
 {
-	auto connectingDevicesiter = mConnectingDevicesForMultipleAdapters.find(adapterAddress);
-	if (connectingDevicesiter == mConnectingDevicesForMultipleAdapters.end())
-		return;
-
-	auto deviceIter = std::find((connectingDevicesiter->second).begin(), (connectingDevicesiter->second).end(), address);
-
-	if (deviceIter == (connectingDevicesiter->second).end())
-		return;
-
-	(connectingDevicesiter->second).erase(deviceIter);
+	mConnections.setState(adapterAddress, address, BluetoothConnectionTable::STATE_CONNECTING, false);
 }
 
 bool BluetoothProfileService::isDeviceConnected(const std::string &address)
 {
-	return (std::find(mConnectedDevices.begin(), mConnectedDevices.end(),
-				convertToLower(address)) != mConnectedDevices.end());
+	return mConnections.hasState(std::string(), address, BluetoothConnectionTable::STATE_CONNECTED);
 }
 
 bool BluetoothProfileService::isDeviceConnected(const std::string &adapterAddress, const std::string &address)
 {
-	auto connectedDevicesiter = mConnectedDevicesForMultipleAdapters.find(convertToLower(adapterAddress));
-	if (connectedDevicesiter == mConnectedDevicesForMultipleAdapters.end())
-		return false;
-
-	return (std::find((connectedDevicesiter->second).begin(), (connectedDevicesiter->second).end(),
-				convertToLower(address)) != (connectedDevicesiter->second).end());
+	return mConnections.hasState(adapterAddress, address, BluetoothConnectionTable::STATE_CONNECTED);
 }
 
 bool BluetoothProfileService::isDeviceMarkedForLocalDisconnect(const std::string &adapterAddress, const std::string &address)
 {
-	auto disconnectedDevicesiter = mLocalDisconnectingDevicesForMultipleAdapters.find(convertToLower(adapterAddress));
-	if (disconnectedDevicesiter == mLocalDisconnectingDevicesForMultipleAdapters.end())
-		return false;
-
-	return (std::find((disconnectedDevicesiter->second).begin(), (disconnectedDevicesiter->second).end(),
-				convertToLower(address)) != (disconnectedDevicesiter->second).end());
+	return mConnections.hasState(adapterAddress, address, BluetoothConnectionTable::STATE_LOCAL_DISCONNECT);
 }
 
 void BluetoothProfileService::markDeviceAsConnected(const std::string &address)
 {
-	if (isDeviceConnected(address))
-		return;
-
-	mConnectedDevices.push_back(convertToLower(address));
+	mConnections.setState(std::string(), address, BluetoothConnectionTable::STATE_CONNECTED, true);
 }
 
 void BluetoothProfileService::markDeviceAsConnected(const std::string &adapterAddress, const std::string &address)
 {
-	auto connectedDevicesiter = mConnectedDevicesForMultipleAdapters.find(convertToLower(adapterAddress));
-	if (connectedDevicesiter == mConnectedDevicesForMultipleAdapters.end())
-	{
-		std::vector<std::string> connectedDevices;
-		connectedDevices.push_back(convertToLower(address));
-
-		mConnectedDevicesForMultipleAdapters.insert(std::pair<std::string, std::vector<std::string>>
-				(convertToLower(adapterAddress), connectedDevices));
-		return;
-	}
-
-	if (!isDeviceConnected(adapterAddress, address))
-		(connectedDevicesiter->second).push_back(convertToLower(address));
+	mConnections.setState(adapterAddress, address, BluetoothConnectionTable::STATE_CONNECTED, true);
 }
 
 void BluetoothProfileService::markDeviceAsNotConnected(const std::string &address)
 {
-	auto deviceIter = std::find(mConnectedDevices.begin(), mConnectedDevices.end(), convertToLower(address));
-
-	if (deviceIter == mConnectedDevices.end())
-		return;
-
-	mConnectedDevices.erase(deviceIter);
+	mConnections.setState(std::string(), address, BluetoothConnectionTable::STATE_CONNECTED, false);
 }
 
 void BluetoothProfileService::markDeviceAsNotConnected(const std::string &adapterAddress, const std::string &address)
 {
-	auto connectedDevicesiter = mConnectedDevicesForMultipleAdapters.find(convertToLower(adapterAddress));
-	if (connectedDevicesiter == mConnectedDevicesForMultipleAdapters.end())
-		return;
-
-	auto deviceIter = std::find((connectedDevicesiter->second).begin(), (connectedDevicesiter->second).end(), convertToLower(address));
-
-	if (deviceIter == (connectedDevicesiter->second).end())
-		return;
-
-	(connectedDevicesiter->second).erase(deviceIter);
+	mConnections.setState(adapterAddress, address, BluetoothConnectionTable::STATE_CONNECTED, false);
 }
 
 void BluetoothProfileService::markDeviceAsLocalDisconnecting(const std::string &adapterAddress, const std::string &address)
 {
-	auto disconnectingDevicesiter = mLocalDisconnectingDevicesForMultipleAdapters.find(convertToLower(adapterAddress));
-	if (disconnectingDevicesiter == mLocalDisconnectingDevicesForMultipleAdapters.end())
-	{
-		std::vector<std::string> disconnectingDevices;
-		disconnectingDevices.push_back(convertToLower(address));
-
-		mLocalDisconnectingDevicesForMultipleAdapters.insert(std::pair<std::string, std::vector<std::string>>
-				(convertToLower(adapterAddress), disconnectingDevices));
-		return;
-	}
-
-	if (!isDeviceMarkedForLocalDisconnect(adapterAddress, address))
-		(disconnectingDevicesiter->second).push_back(convertToLower(address));
+	mConnections.setState(adapterAddress, address, BluetoothConnectionTable::STATE_LOCAL_DISCONNECT, true);
 }
 
 void BluetoothProfileService::removeDeviceFromLocalDisconnecting(const std::string &adapterAddress, const std::string &address)
 {
-	auto disconnectingDevicesiter = mLocalDisconnectingDevicesForMultipleAdapters.find(convertToLower(adapterAddress));
-	if (disconnectingDevicesiter == mLocalDisconnectingDevicesForMultipleAdapters.end())
-		return;
-
-	auto deviceIter = std::find((disconnectingDevicesiter->second).begin(), (disconnectingDevicesiter->second).end(), convertToLower(address));
-
-	if (deviceIter == (disconnectingDevicesiter->second).end())
-		return;
+	mConnections.setState(adapterAddress, address, BluetoothConnectionTable::STATE_LOCAL_DISCONNECT, false);
+}
 
-	(disconnectingDevicesiter->second).erase(deviceIter);
+void BluetoothProfileService::connectionStateChanged(const std::string &adapterAddress, const std::string &address,
+                                                     uint8_t previousState, uint8_t state)
+{
+	bool wasConnected = previousState & BluetoothConnectionTable::STATE_CONNECTED;
+	bool connected = state & BluetoothConnectionTable::STATE_CONNECTED;
 
-	if((disconnectingDevicesiter->second).empty())
-		mLocalDisconnectingDevicesForMultipleAdapters.erase(disconnectingDevicesiter);
+	if (wasConnected != connected && !adapterAddress.empty())
+		mManager->profileConnectionChanged(this, adapterAddress, address, connected);
 }
 
 void BluetoothProfileService::propertiesChanged(const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothProfileService::propertiesChanged", mAlive,
+			[=] { BluetoothProfileService::propertiesChanged(address, properties); }))
+		return;
+
 	bool connected = false;
 
 	for (auto prop : properties)
@@ -338,6 +329,9 @@ void BluetoothProfileService::propertiesChanged(const std::string &address, Blue
 
 void BluetoothProfileService::propertiesChanged(const std::string &adapterAddress, const std::string &address, BluetoothPropertiesList properties)
 {
+	if (EventQueue::deferToMainLoop("BluetoothProfileService::propertiesChanged", mAlive,
+			[=] { BluetoothProfileService::propertiesChanged(adapterAddress, address, properties); }))
+		return;
 
 	BT_INFO("PROFILE", 0, "Observer is called : [%s : %d]", __FUNCTION__, __LINE__);
 
@@ -406,7 +400,7 @@ bool BluetoothProfileService::isDevicePaired(const std::string &adapterAddress,
 bool BluetoothProfileService::isConnectSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
 			                         PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -665,7 +659,7 @@ void BluetoothProfileService::removeConnectWatchForDevice(const std::string &ada
 bool BluetoothProfileService::isDisconnectSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))  REQUIRED_1(address));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(address, string), PROP(adapterAddress, string))  REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -803,7 +797,7 @@ bool BluetoothProfileService::enable(LSMessage &message)
 	int parseError = 0;
 	std::string adapterAddress;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(role, string)));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(role, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -897,7 +891,7 @@ bool BluetoothProfileService::disable(LSMessage &message)
 	std::string adapterAddress;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(role, string)));
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(adapterAddress, string), PROP(role, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
 	{
@@ -975,7 +969,7 @@ bool BluetoothProfileService::disable(LSMessage &message)
 bool BluetoothProfileService::isGetStatusSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
 	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(address, string), PROP(adapterAddress, string),
 			                                  PROP(subscribe, boolean)) REQUIRED_1(address));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -1109,15 +1103,62 @@ pbnjson::JValue BluetoothProfileService::buildGetStatusResp(bool connected, bool
 
 BluetoothProfile* BluetoothProfileService::findImpl (const std::string &adapterAddress)
 {
-	std::string convertedAddress = convertToLower(adapterAddress);
-	auto implIter = mImpls.find(convertedAddress);
-	if (implIter == mImpls.end())
+	ImplSlot *slot = findImplSlot(adapterAddress);
+	if (!slot)
+		return 0;
+
+	return slot->impl;
+}
+
+BluetoothProfileService::ImplSlot* BluetoothProfileService::findImplSlot(const std::string &adapterAddress)
+{
+	// Handlers nearly always ask for the adapter the request was just
+	// resolved to, which gives the slot without comparing addresses
+	int id = mManager->getRequestedAdapterId(adapterAddress);
+	if (id >= 0 && (size_t) id < mImplSlots.size() && mImplSlots[id].adapterAddress == adapterAddress)
+		return &mImplSlots[id];
+
+	for (auto &slot : mImplSlots)
+	{
+		if (!slot.adapterAddress.empty() &&
+			0 == g_ascii_strcasecmp(slot.adapterAddress.c_str(), adapterAddress.c_str()))
+			return &slot;
+	}
+
+	return 0;
+}
+
+void BluetoothProfileService::setImpl(const std::string &adapterAddress, BluetoothProfile *impl)
+{
+	// Like the map this replaces, the first impl set for an adapter stays
+	if (findImplSlot(adapterAddress))
+		return;
+
+	size_t index = mImplSlots.size();
+	auto adapter = mManager->findAdapterInfo(adapterAddress);
+	if (adapter)
+		index = adapter->getId();
+	else
+	{
+		for (size_t n = 0; n < mImplSlots.size(); n++)
+		{
+			if (mImplSlots[n].adapterAddress.empty())
+			{
+				index = n;
+				break;
+			}
+		}
+	}
+
+	if (index >= mImplSlots.size())
 	{
-		convertedAddress = convertToUpper(adapterAddress);
-		implIter = mImpls.find(convertedAddress);
-		if (implIter == mImpls.end())
-			return 0;
+		ImplSlot emptySlot = { std::string(), 0, 0, 0 };
+		mImplSlots.resize(index + 1, emptySlot);
 	}
 
-	return implIter->second;
+	ImplSlot &slot = mImplSlots[index];
+	slot.adapterAddress = convertToLower(adapterAddress);
+	slot.impl = impl;
+	slot.typeKey = 0;
+	slot.typedImpl = 0;
 }
@@ -18,14 +18,18 @@
 #ifndef BLUETOOTH_PROFILE_SERVICE_H_
 #define BLUETOOTH_PROFILE_SERVICE_H_
 
+#include <memory>
 #include <string>
 #include <map>
+#include <set>
 #include <vector>
 
 #include <bluetooth-sil-api.h>
 #include <luna-service2/lunaservice.h>
 #include <pbnjson.hpp>
 
+#include "bluetoothconnectiontable.h"
+
 class BluetoothManagerService;
 class BluetoothProfile;
 class BluetoothDevice;
@@ -59,6 +63,17 @@ public:
 	std::string getName() const;
 	std::vector<std::string> getUuids() const;
 
+	// A lazy profile is not bound to the SIL when an adapter comes up but on
+	// its first luna call, or when a device with one of its uuids connects.
+	// It misses SIL events until then, so profiles that have to accept
+	// incoming connections should not be lazy.
+	void setLazy(bool lazy) { mLazy = lazy; }
+	bool isLazy() const { return mLazy; }
+	void deferInitialize(const std::string &adapterAddress);
+	void cancelDeferredInitialize(const std::string &adapterAddress);
+	bool hasDeferredInitialize() const { return !mDeferredAdapters.empty(); }
+	void bindDeferred(const char *reason);
+
 	void propertiesChanged(const std::string &address, BluetoothPropertiesList properties);
 	void propertiesChanged(const std::string &adapterAddress, const std::string &address, BluetoothPropertiesList properties);
 	bool isDeviceConnected(const std::string &address);
@@ -80,16 +95,47 @@ protected:
 	template<typename T>
 	inline T* getImpl() { return dynamic_cast<T*>(mImpl); }
 
+	// Impls are kept in a slot per adapter id, the slot also caches the impl
+	// cast to the type the handlers of the profile ask for
+	typedef struct
+	{
+		std::string adapterAddress;
+		BluetoothProfile *impl;
+		const void *typeKey;
+		void *typedImpl;
+	} ImplSlot;
+
+	template<typename T>
+	static const void *implTypeKey() { static const char key = 0; return &key; }
+
 	template<typename T>
-	inline T* getImpl(const std::string &adapterAddress) { return dynamic_cast<T*>(findImpl(adapterAddress)); }
+	inline T* getImpl(const std::string &adapterAddress)
+	{
+		ImplSlot *slot = findImplSlot(adapterAddress);
+		if (!slot)
+			return 0;
+
+		if (slot->typeKey != implTypeKey<T>())
+		{
+			slot->typedImpl = dynamic_cast<T*>(slot->impl);
+			slot->typeKey = implTypeKey<T>();
+		}
+
+		return static_cast<T*>(slot->typedImpl);
+	}
 
 	BluetoothProfile *mImpl;
 	std::map<std::string, LSUtils::ClientWatch*> mConnectWatches;
 	std::map<std::string, LS::SubscriptionPoint*> mGetStatusSubscriptions;
 	std::map<std::string, std::map<std::string, LSUtils::ClientWatch*>> mConnectWatchesForMultipleAdapters;
 	std::map<std::string, std::map<std::string, LS::SubscriptionPoint*>> mGetStatusSubscriptionsForMultipleAdapters;
+	// Last status posted to each subscription point, repeats are not posted
+	// again. Dropped with the subscription point once it has no subscribers.
+	std::map<LS::SubscriptionPoint*, std::string> mLastStatusPayloads;
 
-	std::map<std::string, BluetoothProfile*> mImpls;
+	std::vector<ImplSlot> mImplSlots;
+	// Observer events queued from SIL threads are dropped once this is gone
+	std::shared_ptr<bool> mAlive;
 
 	virtual bool isDevicePaired(const std::string &address);
 	virtual bool isDevicePaired(const std::string &adapterAddress, const std::string &address);
@@ -119,21 +165,22 @@ protected:
 	void handleConnectClientDisappeared(const std::string &adapterAddress, const std::string &address);
 
 	BluetoothProfile* findImpl (const std::string &adapterAddress);
+	ImplSlot* findImplSlot(const std::string &adapterAddress);
+	void setImpl(const std::string &adapterAddress, BluetoothProfile *impl);
 
 private:
 	std::vector<std::string> strToProfileRole(const std::string & input);
+	void connectionStateChanged(const std::string &adapterAddress, const std::string &address,
+	                            uint8_t previousState, uint8_t state);
 
 	BluetoothManagerService *mManager;
 	std::string mName;
 	std::vector<std::string> mUuids;
-	std::vector<std::string> mConnectingDevices;
-	std::vector<std::string> mConnectedDevices;
 	std::vector<std::string> mEnabledRoles;
 	BluetoothResultCallback mCallback;
-
-	std::map<std::string, std::vector<std::string>> mConnectedDevicesForMultipleAdapters;
-	std::map<std::string, std::vector<std::string>> mConnectingDevicesForMultipleAdapters;
-	std::map<std::string, std::vector<std::string>> mLocalDisconnectingDevicesForMultipleAdapters;
+	bool mLazy;
+	std::set<std::string> mDeferredAdapters;
+	BluetoothConnectionTable mConnections;
 };
 
 #endif
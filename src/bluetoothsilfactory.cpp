@@ -23,6 +23,7 @@
 #include "config.h"
 #include "logging.h"
 #include "bluetoothsilfactory.h"
+#include "startuptimeline.h"
 #include "utils.h"
 
 typedef BluetoothSIL *(*CreateSILFunc)(unsigned int version, BluetoothPairingIOCapability capability);
@@ -58,7 +59,9 @@ BluetoothSIL *BluetoothSILFactory::create(unsigned int version, BluetoothPairing
 
 	BT_INFO("SILFACTORY", 0, "Trying to load SIL from path %s\n", path);
 
+	int64_t loadStart = g_get_monotonic_time();
 	SILHandle = dlopen(path, RTLD_NOW);
+	StartupTimeline::record("silLoad", loadStart, name);
 
 	if (!SILHandle)
 	{
@@ -77,7 +80,9 @@ BluetoothSIL *BluetoothSILFactory::create(unsigned int version, BluetoothPairing
 		return 0;
 	}
 
+	int64_t createStart = g_get_monotonic_time();
 	BluetoothSIL *sil = createSIL(version, capability);
+	StartupTimeline::record("silCreate", createStart, name);
 
 	if (!sil)
 	{
@@ -22,6 +22,7 @@
 #include "ls2utils.h"
 #include "clientwatch.h"
 #include "utils.h"
+#include "base64codec.h"
 
 using namespace std::placeholders;
 
@@ -239,17 +240,17 @@ void BluetoothSppProfileService::connectToStack(LS::Message &request, pbnjson::J
 
 bool BluetoothSppProfileService::isConnectSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
-	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(uuid, string),
+	PayloadValidation validation;
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(address, string), PROP(uuid, string),
 	        PROP(adapterAddress, string), PROP(subscribe, boolean)) REQUIRED_2(address, uuid));
 
-	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
+	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, validation))
 	{
-		if (parseError != JSON_PARSE_SCHEMA_ERROR)
+		if (PAYLOAD_SYNTAX_ERROR == validation.status)
 			LSUtils::respondWithError(request, BT_ERR_BAD_JSON);
-		else if (!requestObj.hasKey("address"))
+		else if (PAYLOAD_MISSING_KEY == validation.status && "address" == validation.path)
 			LSUtils::respondWithError(request, BT_ERR_ADDR_PARAM_MISSING);
-		else if (!requestObj.hasKey("uuid"))
+		else if (PAYLOAD_MISSING_KEY == validation.status && "uuid" == validation.path)
 			LSUtils::respondWithError(request, BT_ERR_SPP_UUID_PARAM_MISSING);
 		else
 			LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
@@ -262,14 +263,14 @@ bool BluetoothSppProfileService::isConnectSchemaAvailable(LS::Message &request,
 
 bool BluetoothSppProfileService::isDisconnectSchemaAvailable(LS::Message &request, pbnjson::JValue &requestObj)
 {
-	int parseError = 0;
-	const std::string schema = STRICT_SCHEMA(PROPS_2(PROP(channelId, string), PROP(adapterAddress, string))  REQUIRED_1(channelId));
+	PayloadValidation validation;
+	const char *schema = STRICT_SCHEMA(PROPS_2(PROP(channelId, string), PROP(adapterAddress, string))  REQUIRED_1(channelId));
 
-	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
+	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, validation))
 	{
-		if (parseError != JSON_PARSE_SCHEMA_ERROR)
+		if (PAYLOAD_SYNTAX_ERROR == validation.status)
 			LSUtils::respondWithError(request, BT_ERR_BAD_JSON);
-		else if (!requestObj.hasKey("channelId"))
+		else if (PAYLOAD_MISSING_KEY == validation.status && "channelId" == validation.path)
 			LSUtils::respondWithError(request, BT_ERR_SPP_CHANNELID_PARAM_MISSING);
 		else
 			LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
@@ -380,18 +381,18 @@ bool BluetoothSppProfileService::createChannel(LSMessage &message)
 {
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
-	int parseError = 0;
+	PayloadValidation validation;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(name, string), PROP(uuid, string),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(name, string), PROP(uuid, string),
 	        PROP(adapterAddress, string), PROP_WITH_VAL_1(subscribe, boolean, true)) REQUIRED_3(name, uuid, subscribe));
 
-	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
+	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, validation))
 	{
-		if (JSON_PARSE_SCHEMA_ERROR != parseError)
+		if (PAYLOAD_SYNTAX_ERROR == validation.status)
 			LSUtils::respondWithError(request, BT_ERR_BAD_JSON);
-		else if (!requestObj.hasKey("name"))
+		else if (PAYLOAD_MISSING_KEY == validation.status && "name" == validation.path)
 			LSUtils::respondWithError(request, BT_ERR_SPP_NAME_PARAM_MISSING, true);
-		else if (!requestObj.hasKey("uuid"))
+		else if (PAYLOAD_MISSING_KEY == validation.status && "uuid" == validation.path)
 			LSUtils::respondWithError(request, BT_ERR_SPP_UUID_PARAM_MISSING, true);
 		else if (!request.isSubscription())
 			LSUtils::respondWithError(request, BT_ERR_MTHD_NOT_SUBSCRIBED, true);
@@ -511,18 +512,18 @@ bool BluetoothSppProfileService::writeData(LSMessage &message)
 {
 	LS::Message request(&message);
 	pbnjson::JValue requestObj;
-	int parseError = 0;
+	PayloadValidation validation;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_3(PROP(channelId, string), PROP(data, string),
+	const char *schema = STRICT_SCHEMA(PROPS_3(PROP(channelId, string), PROP(data, string),
 	        PROP(adapterAddress, string)) REQUIRED_2(channelId, data));
 
-	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
+	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, validation))
 	{
-		if (JSON_PARSE_SCHEMA_ERROR != parseError)
+		if (PAYLOAD_SYNTAX_ERROR == validation.status)
 			LSUtils::respondWithError(request, BT_ERR_BAD_JSON);
-		else if (!requestObj.hasKey("channelId"))
+		else if (PAYLOAD_MISSING_KEY == validation.status && "channelId" == validation.path)
 			LSUtils::respondWithError(request, BT_ERR_SPP_CHANNELID_PARAM_MISSING);
-		else if (!requestObj.hasKey("data"))
+		else if (PAYLOAD_MISSING_KEY == validation.status && "data" == validation.path)
 			LSUtils::respondWithError(request, BT_ERR_SPP_DATA_PARAM_MISSING);
 		else
 			LSUtils::respondWithError(request, BT_ERR_SCHEMA_VALIDATION_FAIL);
@@ -568,17 +569,12 @@ bool BluetoothSppProfileService::writeData(LSMessage &message)
 	}
 
 	std::string data = requestObj["data"].asString();
-	gsize outLen = 0;
-	guchar *gdata = g_base64_decode(data.c_str(), &outLen);
-	if (NULL == gdata)
-	{
-		LSUtils::respondWithError(request, BT_ERR_SPP_WRITE_DATA_FAILED);
-		return true;
-	}
+	Base64::decode(data, mWriteBuffer);
 
 	LSMessage *requestMessage = request.get();
 	LSMessageRef(requestMessage);
-	auto writeDataCallback = [this, requestMessage, adapterAddress](BluetoothError error) {
+	uint32_t writeSize = mWriteBuffer.size();
+	auto writeDataCallback = [this, requestMessage, adapterAddress, channelManager, stackChannelId, writeSize](BluetoothError error) {
 		LS::Message request(requestMessage);
 
 		if (error != BLUETOOTH_ERROR_NONE)
@@ -588,14 +584,15 @@ bool BluetoothSppProfileService::writeData(LSMessage &message)
 			return;
 		}
 
+		channelManager->recordTransmittedData(stackChannelId, writeSize);
+
 		pbnjson::JValue responseObj = pbnjson::Object();
 		responseObj.put("returnValue", true);
 		responseObj.put("adapterAddress", adapterAddress);
 		LSUtils::postToClient(request, responseObj);
 		LSMessageUnref(request.get());
 	};
-	getImpl<BluetoothSppProfile>(adapterAddress)->writeData(stackChannelId, gdata, outLen, writeDataCallback);
-	g_free(gdata);
+	getImpl<BluetoothSppProfile>(adapterAddress)->writeData(stackChannelId, mWriteBuffer.data(), mWriteBuffer.size(), writeDataCallback);
 
 	return true;
 }
@@ -634,7 +631,7 @@ bool BluetoothSppProfileService::readData(LSMessage &message)
 	pbnjson::JValue requestObj;
 	int parseError = 0;
 
-	const std::string schema = STRICT_SCHEMA(PROPS_4(PROP(channelId, string), PROP(subscribe, boolean),
+	const char *schema = STRICT_SCHEMA(PROPS_4(PROP(channelId, string), PROP(subscribe, boolean),
 	        PROP(timeout, integer), PROP(adapterAddress, string)));
 
 	if (!LSUtils::parsePayload(request.getPayload(), requestObj, schema, &parseError))
@@ -708,17 +705,14 @@ bool BluetoothSppProfileService::readData(LSMessage &message)
 	responseObj.put("channelId", channelId);
 
 	int size = 0;
-	gchar *gdata = NULL;
 	const ChannelManager::DataBuffer *dataBuffer = channelManager->getChannelBufferData(channelId, appName);
 	if (dataBuffer)
 	{
-		gdata = g_base64_encode(dataBuffer->buffer, dataBuffer->size);
-		if (gdata)
-		{
-			size = strlen(gdata);
-			responseObj.put("channelId", channelId);
-			responseObj.put("data", gdata);
-		}
+		std::string encodedData;
+		Base64::encode(dataBuffer->buffer, dataBuffer->size, encodedData);
+		size = encodedData.size();
+		responseObj.put("channelId", channelId);
+		responseObj.put("data", encodedData);
 
 		delete dataBuffer;
 	}
@@ -740,8 +734,6 @@ bool BluetoothSppProfileService::readData(LSMessage &message)
 		LSUtils::postToClient(request, responseObj);
 	}
 
-	g_free(gdata);
-
 	return true;
 }
 
@@ -749,9 +741,9 @@ void BluetoothSppProfileService::addReadDataSubscription(LS::Message &request, C
 {
 	LSUtils::ClientWatch *watch = new LSUtils::ClientWatch(getManager()->get(), request.get(), NULL);
 	std::string appName = channelManager->getMessageOwner(request.get());
-	void *readDataInfo = channelManager->addReadDataSubscription(channelId, timeout, watch, appName);
+	ChannelManager::ReadDataSubscriptionId readDataId = channelManager->addReadDataSubscription(channelId, timeout, watch, appName);
 
-	auto func = std::bind(&ChannelManager::deleteReadDataSubscription, channelManager, readDataInfo);
+	auto func = std::bind(&ChannelManager::readDataClientDropped, channelManager, readDataId);
 	watch->setCallback(func);
 }
 
@@ -793,6 +785,7 @@ void BluetoothSppProfileService::channelStateChanged(const std::string &adapterA
 
 void BluetoothSppProfileService::dataReceived(const BluetoothSppChannelId channelId, const std::string &adapterAddress, const uint8_t *data, const uint32_t size)
 {
+	gint64 receivedTime = g_get_monotonic_time();
 	ChannelManager *channelManager = findChannelImpl(adapterAddress);
 
 	if (channelManager == nullptr)
@@ -805,7 +798,10 @@ void BluetoothSppProfileService::dataReceived(const BluetoothSppChannelId channe
 	{
 		auto binarySocket = findBinarySocket(userChannelId);
 		if (binarySocket)
+		{
 			binarySocket->sendData(data, size);
+			channelManager->recordBinarySocketData(channelId, size, receivedTime);
+		}
 	}
 	else
 		channelManager->addReceiveQueue(adapterAddress, channelId, data, size);
@@ -895,12 +891,13 @@ void BluetoothSppProfileService::sendDataToStack(const std::string &channelId, c
 		return;
 	}
 
-	auto writeDataCallback = [binarySocket](BluetoothError error) {
+	auto writeDataCallback = [binarySocket, channelManager, stackChannelId, outLen](BluetoothError error) {
 		if (error != BLUETOOTH_ERROR_NONE)
 		{
 			BT_DEBUG("Failed to write the binary socket data to stack");
 			return;
 		}
+		channelManager->recordTransmittedData(stackChannelId, outLen);
 		binarySocket->setWriting(false);
 	};
 
@@ -921,6 +918,7 @@ pbnjson::JValue BluetoothSppProfileService::buildGetStatusResp(bool connected, b
 	appendCommonProfileStatus(responseObj, connected, connecting, subscribed,
 	                          returnValue, adapterAddress, deviceAddress);
 	responseObj.put("connectedChannels", channelManager->getConnectedChannels(deviceAddress));
+	responseObj.put("channels", channelManager->getChannelStatus(deviceAddress));
 
 	return responseObj;
 }
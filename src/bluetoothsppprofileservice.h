@@ -70,14 +70,16 @@ public:
 	void channelStateChanged(const std::string &adapterAddress, const std::string &address, const std::string &uuid, BluetoothSppChannelId channelId, bool state);
 	void dataReceived(const BluetoothSppChannelId channelId, const std::string &adapterAddress, const uint8_t *data, const uint32_t size);
 
+	ChannelManager* findChannelImpl (const std::string &adapterAddress);
+
 protected:
 	std::map<std::string, ChannelManager*> mChannelImpls;
 
-	ChannelManager* findChannelImpl (const std::string &adapterAddress);
 	void createChannelManager(const std::string &adapterAddress);
 
 private:
 	std::unordered_map<std::string, BluetoothBinarySocket*> mBinarySockets;
+	std::vector<uint8_t> mWriteBuffer;
 
 private:
 	void handleConnectClientDisappeared(const std::string &adapterAddress, const std::string &address,
@@ -0,0 +1,369 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <cerrno>
+#include <cstring>
+
+#include <glib.h>
+
+#include "bluetoothwarmstartsnapshot.h"
+#include "bluetoothmanageradapter.h"
+#include "bluetoothdevice.h"
+#include "logging.h"
+#include "utils.h"
+
+#define MSGID_WARM_START				"WARM_START"
+
+#define SNAPSHOT_MAGIC					"BTWS"
+// Bumped whenever the layout below changes, older files are then ignored
+#define SNAPSHOT_VERSION				1
+
+#define FLAG_DEFAULT					0x01
+#define FLAG_POWERED					0x02
+#define FLAG_DISCOVERABLE				0x04
+#define FLAG_PAIRABLE					0x08
+
+#define FLAG_TRUSTED					0x01
+#define FLAG_BLOCKED					0x02
+#define FLAG_LINK_KEY					0x04
+
+/*
+ * All integers are little endian, strings are prefixed with a 16 bit length
+ * and lists with a 16 bit count.
+ */
+typedef struct
+{
+	const uint8_t *data;
+	size_t size;
+	size_t offset;
+	bool valid;
+} Reader;
+
+static void putU8(std::string &buffer, uint8_t value)
+{
+	buffer.push_back((char) value);
+}
+
+static void putU16(std::string &buffer, uint16_t value)
+{
+	putU8(buffer, value & 0xff);
+	putU8(buffer, value >> 8);
+}
+
+static void putU32(std::string &buffer, uint32_t value)
+{
+	putU16(buffer, value & 0xffff);
+	putU16(buffer, value >> 16);
+}
+
+static void putString(std::string &buffer, const std::string &value)
+{
+	uint16_t length = value.size() > UINT16_MAX ? UINT16_MAX : value.size();
+	putU16(buffer, length);
+	buffer.append(value, 0, length);
+}
+
+static void putServiceClasses(std::string &buffer, const std::vector<BluetoothServiceClassInfo> &serviceClasses)
+{
+	putU16(buffer, serviceClasses.size());
+	for (auto &serviceClass : serviceClasses)
+	{
+		putString(buffer, serviceClass.getMnemonic());
+		putString(buffer, serviceClass.getMethodCategory());
+	}
+}
+
+static bool take(Reader &reader, size_t length)
+{
+	if (!reader.valid || reader.size - reader.offset < length)
+	{
+		reader.valid = false;
+		return false;
+	}
+
+	return true;
+}
+
+static uint8_t getU8(Reader &reader)
+{
+	if (!take(reader, 1))
+		return 0;
+
+	return reader.data[reader.offset++];
+}
+
+static uint16_t getU16(Reader &reader)
+{
+	uint16_t low = getU8(reader);
+	return low | (getU8(reader) << 8);
+}
+
+static uint32_t getU32(Reader &reader)
+{
+	uint32_t low = getU16(reader);
+	return low | ((uint32_t) getU16(reader) << 16);
+}
+
+static std::string getString(Reader &reader)
+{
+	uint16_t length = getU16(reader);
+	if (!take(reader, length))
+		return std::string();
+
+	std::string value((const char*) reader.data + reader.offset, length);
+	reader.offset += length;
+
+	return value;
+}
+
+static std::vector<BluetoothServiceClassInfo> getServiceClasses(Reader &reader)
+{
+	std::vector<BluetoothServiceClassInfo> serviceClasses;
+
+	uint16_t count = getU16(reader);
+	for (uint16_t n = 0; n < count && reader.valid; n++)
+	{
+		std::string mnemonic = getString(reader);
+		serviceClasses.push_back(BluetoothServiceClassInfo(mnemonic, getString(reader)));
+	}
+
+	return serviceClasses;
+}
+
+BluetoothWarmStartSnapshot::BluetoothWarmStartSnapshot(const std::string &path) :
+	mPath(path)
+{
+}
+
+bool BluetoothWarmStartSnapshot::load()
+{
+	gchar *contents = NULL;
+	gsize length = 0;
+
+	if (!g_file_get_contents(mPath.c_str(), &contents, &length, NULL))
+		return false;
+
+	Reader reader = { (const uint8_t*) contents, length, 0, true };
+	std::vector<Adapter> adapters;
+	size_t pairedDevices = 0;
+	size_t linkKeys = 0;
+
+	if (length < strlen(SNAPSHOT_MAGIC) || memcmp(contents, SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC)) != 0)
+		reader.valid = false;
+	else
+		reader.offset = strlen(SNAPSHOT_MAGIC);
+
+	if (getU8(reader) != SNAPSHOT_VERSION)
+		reader.valid = false;
+
+	uint16_t adapterCount = getU16(reader);
+	for (uint16_t n = 0; n < adapterCount && reader.valid; n++)
+	{
+		Adapter adapter;
+		adapter.address = getString(reader);
+		adapter.name = getString(reader);
+		adapter.interfaceName = getString(reader);
+		adapter.stackName = getString(reader);
+		adapter.stackVersion = getString(reader);
+		adapter.firmwareVersion = getString(reader);
+		adapter.classOfDevice = getU32(reader);
+		adapter.discoveryTimeout = getU32(reader);
+		adapter.discoverableTimeout = getU32(reader);
+		adapter.pairableTimeout = getU32(reader);
+
+		uint8_t flags = getU8(reader);
+		adapter.isDefault = flags & FLAG_DEFAULT;
+		adapter.powered = flags & FLAG_POWERED;
+		adapter.discoverable = flags & FLAG_DISCOVERABLE;
+		adapter.pairable = flags & FLAG_PAIRABLE;
+
+		adapter.serviceClasses = getServiceClasses(reader);
+
+		uint16_t deviceCount = getU16(reader);
+		for (uint16_t d = 0; d < deviceCount && reader.valid; d++)
+		{
+			Device device;
+			device.address = getString(reader);
+			device.name = getString(reader);
+			device.typeOfDevice = getString(reader);
+			device.classOfDevice = getU32(reader);
+
+			uint8_t deviceFlags = getU8(reader);
+			device.trusted = deviceFlags & FLAG_TRUSTED;
+			device.blocked = deviceFlags & FLAG_BLOCKED;
+			device.hasLinkKey = deviceFlags & FLAG_LINK_KEY;
+
+			device.serviceClasses = getServiceClasses(reader);
+
+			if (device.hasLinkKey)
+				linkKeys++;
+
+			adapter.pairedDevices.push_back(device);
+		}
+
+		pairedDevices += adapter.pairedDevices.size();
+		adapters.push_back(adapter);
+	}
+
+	g_free(contents);
+
+	if (!reader.valid || reader.offset != reader.size)
+	{
+		BT_WARNING(MSGID_WARM_START, 0, "Ignoring invalid warm start snapshot %s", mPath.c_str());
+		return false;
+	}
+
+	mAdapters.swap(adapters);
+
+	BT_INFO(MSGID_WARM_START, 0, "Loaded warm start snapshot with %zu adapters and %zu paired devices (%zu with link key)",
+			mAdapters.size(), pairedDevices, linkKeys);
+
+	return true;
+}
+
+void BluetoothWarmStartSnapshot::discard()
+{
+	mAdapters.clear();
+}
+
+const BluetoothWarmStartSnapshot::Adapter *BluetoothWarmStartSnapshot::findAdapter(const std::string &address) const
+{
+	std::string convertedAddress = convertToLower(address);
+	for (auto &adapter : mAdapters)
+	{
+		if (adapter.address == convertedAddress)
+			return &adapter;
+	}
+
+	return NULL;
+}
+
+const BluetoothWarmStartSnapshot::Adapter *BluetoothWarmStartSnapshot::findDefaultAdapter() const
+{
+	for (auto &adapter : mAdapters)
+	{
+		if (adapter.isDefault)
+			return &adapter;
+	}
+
+	return NULL;
+}
+
+BluetoothWarmStartSnapshot::Adapter BluetoothWarmStartSnapshot::capture(BluetoothManagerAdapter *managerAdapter)
+{
+	Adapter adapter;
+	adapter.address = convertToLower(managerAdapter->getAddress());
+	adapter.name = managerAdapter->getName();
+	adapter.interfaceName = managerAdapter->getInterface();
+	adapter.stackName = managerAdapter->getStackName();
+	adapter.stackVersion = managerAdapter->getStackVersion();
+	adapter.firmwareVersion = managerAdapter->getFirmwareVersion();
+	adapter.classOfDevice = managerAdapter->getClassOfDevice();
+	adapter.discoveryTimeout = managerAdapter->getDisoveryTimeout();
+	adapter.discoverableTimeout = managerAdapter->getDiscoverableTimeout();
+	adapter.pairableTimeout = managerAdapter->getPairState().getPairableTimeout();
+	adapter.isDefault = managerAdapter->isDefaultAdapter();
+	adapter.powered = managerAdapter->getPowerState();
+	adapter.discoverable = managerAdapter->getDiscoverable();
+	adapter.pairable = managerAdapter->getPairState().isPairable();
+	adapter.serviceClasses = managerAdapter->getSupportedServiceClasses();
+
+	for (auto deviceIter : managerAdapter->getDevices())
+	{
+		BluetoothDevice *managerDevice = deviceIter.second;
+		if (!managerDevice->getPaired())
+			continue;
+
+		Device device;
+		device.address = managerDevice->getAddress();
+		device.name = managerDevice->getName();
+		device.typeOfDevice = managerDevice->getTypeAsString();
+		device.classOfDevice = managerDevice->getClassOfDevice();
+		device.trusted = managerDevice->getTrusted();
+		device.blocked = managerDevice->getBlocked();
+		device.hasLinkKey = !managerAdapter->findLinkKey(managerDevice->getAddress()).empty();
+		device.serviceClasses = managerDevice->getSupportedServiceClasses();
+		adapter.pairedDevices.push_back(device);
+	}
+
+	return adapter;
+}
+
+bool BluetoothWarmStartSnapshot::save(const std::vector<BluetoothManagerAdapter*> &managerAdapters)
+{
+	std::string buffer = SNAPSHOT_MAGIC;
+	putU8(buffer, SNAPSHOT_VERSION);
+	putU16(buffer, managerAdapters.size());
+
+	for (auto managerAdapter : managerAdapters)
+	{
+		Adapter adapter = capture(managerAdapter);
+
+		putString(buffer, adapter.address);
+		putString(buffer, adapter.name);
+		putString(buffer, adapter.interfaceName);
+		putString(buffer, adapter.stackName);
+		putString(buffer, adapter.stackVersion);
+		putString(buffer, adapter.firmwareVersion);
+		putU32(buffer, adapter.classOfDevice);
+		putU32(buffer, adapter.discoveryTimeout);
+		putU32(buffer, adapter.discoverableTimeout);
+		putU32(buffer, adapter.pairableTimeout);
+		putU8(buffer, (adapter.isDefault ? FLAG_DEFAULT : 0) |
+					  (adapter.powered ? FLAG_POWERED : 0) |
+					  (adapter.discoverable ? FLAG_DISCOVERABLE : 0) |
+					  (adapter.pairable ? FLAG_PAIRABLE : 0));
+		putServiceClasses(buffer, adapter.serviceClasses);
+
+		putU16(buffer, adapter.pairedDevices.size());
+		for (auto &device : adapter.pairedDevices)
+		{
+			putString(buffer, device.address);
+			putString(buffer, device.name);
+			putString(buffer, device.typeOfDevice);
+			putU32(buffer, device.classOfDevice);
+			putU8(buffer, (device.trusted ? FLAG_TRUSTED : 0) |
+						  (device.blocked ? FLAG_BLOCKED : 0) |
+						  (device.hasLinkKey ? FLAG_LINK_KEY : 0));
+			putServiceClasses(buffer, device.serviceClasses);
+		}
+	}
+
+	// Nothing else creates the directory on a fresh device
+	gchar *directory = g_path_get_dirname(mPath.c_str());
+	int result = g_mkdir_with_parents(directory, 0700);
+	g_free(directory);
+	if (result < 0)
+	{
+		BT_WARNING(MSGID_WARM_START, 0, "Failed to create the directory of warm start snapshot %s: %s", mPath.c_str(), strerror(errno));
+		return false;
+	}
+
+	// g_file_set_contents writes a temporary file and renames it, so a crash
+	// never leaves a half written snapshot behind
+	GError *error = NULL;
+	if (!g_file_set_contents(mPath.c_str(), buffer.data(), buffer.size(), &error))
+	{
+		BT_WARNING(MSGID_WARM_START, 0, "Failed to write warm start snapshot %s: %s", mPath.c_str(), error->message);
+		g_error_free(error);
+		return false;
+	}
+
+	BT_DEBUG("Wrote warm start snapshot of %zu bytes", buffer.size());
+
+	return true;
+}
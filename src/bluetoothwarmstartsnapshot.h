@@ -0,0 +1,94 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef BLUETOOTH_WARM_START_SNAPSHOT_H
+#define BLUETOOTH_WARM_START_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bluetoothserviceclasses.h"
+
+class BluetoothManagerAdapter;
+
+/*
+ * Adapter and paired device state as last seen, kept in a small binary file
+ * so that getStatus, queryAvailable and getPairedDevices can answer right
+ * after startup instead of waiting for the SIL to report everything again.
+ *
+ * A loaded snapshot is stale: it is only served, marked as such, for adapters
+ * the SIL has not reported yet, and is discarded once the default adapter is
+ * up. It is written again, coalesced, whenever that state changes.
+ */
+class BluetoothWarmStartSnapshot
+{
+public:
+	typedef struct
+	{
+		std::string address;
+		std::string name;
+		std::string typeOfDevice;
+		uint32_t classOfDevice;
+		bool trusted;
+		bool blocked;
+		bool hasLinkKey;
+		std::vector<BluetoothServiceClassInfo> serviceClasses;
+	} Device;
+
+	typedef struct
+	{
+		std::string address;
+		std::string name;
+		std::string interfaceName;
+		std::string stackName;
+		std::string stackVersion;
+		std::string firmwareVersion;
+		uint32_t classOfDevice;
+		uint32_t discoveryTimeout;
+		uint32_t discoverableTimeout;
+		uint32_t pairableTimeout;
+		bool isDefault;
+		bool powered;
+		bool discoverable;
+		bool pairable;
+		std::vector<BluetoothServiceClassInfo> serviceClasses;
+		std::vector<Device> pairedDevices;
+	} Adapter;
+
+	BluetoothWarmStartSnapshot(const std::string &path);
+
+	bool load();
+	// Writes the state of the given adapters, replacing the previous snapshot
+	bool save(const std::vector<BluetoothManagerAdapter*> &adapters);
+
+	// True while a loaded snapshot has not been reconciled with the SIL
+	bool isStale() const { return !mAdapters.empty(); }
+	void discard();
+
+	const std::vector<Adapter> &getAdapters() const { return mAdapters; }
+	const Adapter *findAdapter(const std::string &address) const;
+	const Adapter *findDefaultAdapter() const;
+
+private:
+	static Adapter capture(BluetoothManagerAdapter *adapter);
+
+	std::string mPath;
+	std::vector<Adapter> mAdapters;
+};
+
+#endif // BLUETOOTH_WARM_START_SNAPSHOT_H
@@ -20,24 +20,25 @@
 #include "ls2utils.h"
 #include "logging.h"
 #include "clientwatch.h"
+#include "base64codec.h"
+#include "config.h"
+#include "eventqueue.h"
+#include "mainloopwatchdog.h"
 
 #define BLUETOOTH_PROFILE_SPP_MAX_CHANNEL_ID 999
-
-typedef struct {
-	BluetoothSppChannelId channelId;
-	guint eventSourceId;
-	ChannelManager *manager;
-	std::string adapterAddress;
-} DataReceivedInfo;
-
-typedef struct {
-	guint eventSourceId;
-	ChannelManager *manager;
-	void *readDataInfo;
-} TimeoutInfo;
+// Longest the stack is held back on a full receive window under the pause
+// policy before the chunk is dropped
+#define RECEIVE_WINDOW_MAX_PAUSE_MS 500
 
 ChannelManager::ChannelManager() :
-        mNextChannelId(1)
+        mNextChannelId(1),
+        mReceiveWindow(WEBOS_BLUETOOTH_SPP_RECEIVE_WINDOW),
+        mOverflowPolicy(parseOverflowPolicy(WEBOS_BLUETOOTH_SPP_OVERFLOW_POLICY)),
+        mNextReadDataId(1),
+        mTimerWheelCursor(0),
+        mTimerWheelEntries(0),
+        mTimerWheelSource(0),
+        mAlive(std::make_shared<bool>(true))
 {
 
 }
@@ -62,14 +63,11 @@ ChannelManager::~ChannelManager()
 	}
 	mChannelInfo.clear();
 
-	for (auto itMap = mReadDataSubscriptions.begin(); itMap != mReadDataSubscriptions.end(); itMap++)
-	{
-		ReadDataInfo *dataInfo = *itMap;
-		if (NULL == dataInfo)
-			continue;
+	if (mTimerWheelSource)
+		g_source_remove(mTimerWheelSource);
 
-		delete dataInfo;
-	}
+	mChannelReadDataSubscriptions.clear();
+	mAppReadDataSubscriptions.clear();
 	mReadDataSubscriptions.clear();
 
 	for (auto itMap = mCreateChannelSubscriptons.begin(); itMap != mCreateChannelSubscriptons.end(); itMap++)
@@ -93,25 +91,41 @@ void ChannelManager::notifyReceivedData(const std::string &adapterAddress, const
 		return;
 
 	std::lock_guard<std::mutex> guard(cmMutex);
-	bool found = false;
-	for (auto itMap = mReadDataSubscriptions.begin(); itMap != mReadDataSubscriptions.end(); itMap++)
+
+	// Anything queued from here on needs a new dispatch, everything queued
+	// before is drained below.
+	channelInfo->dispatchScheduled = false;
+
+	ReadDataSet *channelSubscribers = findReadDataSet(channelId);
+	ReadDataSet *appSubscribers = findReadDataSet(channelInfo->appName);
+	channelInfo->readerAttached = (channelSubscribers || appSubscribers);
+	if (!channelInfo->readerAttached)
 	{
-		ReadDataInfo *dataInfo = *itMap;
-		if (NULL == dataInfo)
-			continue;
+		// Nothing drains the queue, a paused stack must not wait for it
+		mReceiveWindowCondition.notify_all();
+		return;
+	}
+
+	while (true)
+	{
+		makeDataBuffer(channelInfo);
+		if (channelInfo->dataBuffer.size == 0)
+			break;
+
+		updateTransferStatistics(channelInfo->lunaStatistics, channelInfo->dataBuffer.size, channelInfo->dataBufferReceivedTime);
 
-		if ((dataInfo->stackChannelId == channelId) || ((dataInfo->userChannelId == EMPTY_STRING) &&
-		        (dataInfo->appName != EMPTY_STRING) && (dataInfo->appName == channelInfo->appName)))
+		for (ReadDataSet *subscribers : { channelSubscribers, appSubscribers })
 		{
-			found = true;
-			makeDataBuffer(channelInfo);
-			postToReadDataSubscriber(channelInfo->dataBuffer.buffer, channelInfo->dataBuffer.size, dataInfo->watch, adapterAddress,
-			        channelInfo->userChannelId);
+			if (NULL == subscribers)
+				continue;
+
+			for (auto dataInfo : *subscribers)
+				postToReadDataSubscriber(channelInfo->dataBuffer.buffer, channelInfo->dataBuffer.size, dataInfo->watch.get(),
+				        adapterAddress, channelInfo->userChannelId);
 		}
-	}
 
-	if (found)
 		channelInfo->dataBuffer.size = 0;
+	}
 }
 
 void ChannelManager::makeDataBuffer(ChannelInfo *channelInfo)
@@ -132,15 +146,166 @@ void ChannelManager::makeDataBuffer(ChannelInfo *channelInfo)
 
 			if (queue->data)
 			{
+				if (0 == channelInfo->dataBuffer.size)
+					channelInfo->dataBufferReceivedTime = queue->receivedTime;
+
 				memcpy(channelInfo->dataBuffer.buffer + channelInfo->dataBuffer.size, queue->data, queue->size);
 				channelInfo->dataBuffer.size += queue->size;
 
-				delete queue->data;
+				delete[] queue->data;
 			}
+			channelInfo->queuedBytes -= queue->size;
 			delete queue;
 		}
 		channelInfo->receiveQueue.pop();
 	}
+
+	mReceiveWindowCondition.notify_all();
+}
+
+ChannelManager::OverflowPolicy ChannelManager::parseOverflowPolicy(const char *policy)
+{
+	if (strcmp(policy, "pause") == 0)
+		return OVERFLOW_PAUSE;
+	if (strcmp(policy, "dropNewest") == 0)
+		return OVERFLOW_DROP_NEWEST;
+
+	return OVERFLOW_DROP_OLDEST;
+}
+
+bool ChannelManager::makeReceiveWindowSpace(ChannelInfo *channelInfo, const uint32_t size)
+{
+	if (channelInfo->queuedBytes + size <= mReceiveWindow)
+		return true;
+
+	if (OVERFLOW_DROP_OLDEST != mOverflowPolicy || size > mReceiveWindow)
+		return false;
+
+	while (channelInfo->queuedBytes + size > mReceiveWindow && !channelInfo->receiveQueue.empty())
+	{
+		QueueData *queue = channelInfo->receiveQueue.front();
+		channelInfo->receiveQueue.pop();
+
+		channelInfo->queuedBytes -= queue->size;
+		channelInfo->droppedBytes += queue->size;
+		channelInfo->droppedChunks++;
+
+		delete[] queue->data;
+		delete queue;
+	}
+
+	return true;
+}
+
+ChannelManager::ChannelInfo *ChannelManager::waitForReceiveWindow(std::unique_lock<std::mutex> &lock,
+        const BluetoothSppChannelId channelId, const uint32_t size)
+{
+	ChannelInfo *channelInfo = getChannelInfo(channelId);
+	if (NULL == channelInfo || channelInfo->queuedBytes + size <= mReceiveWindow)
+		return channelInfo;
+
+	// Data handed over on the main loop can not wait for the main loop to
+	// drain the channel
+	if (g_main_context_is_owner(g_main_context_default()))
+		return channelInfo;
+
+	// Only a pending dispatch to a readData subscriber is sure to drain the
+	// queue and signal us. Clients polling readData do not count, the
+	// window is capped for them right away.
+	if (!channelInfo->dispatchScheduled || !channelInfo->readerAttached)
+		return channelInfo;
+
+	// Holding back the stack's reader holds back the remote through RFCOMM
+	// flow control. The channel may go away while waiting, look it up again.
+	gint64 pauseStart = g_get_monotonic_time();
+	mReceiveWindowCondition.wait_for(lock, std::chrono::milliseconds(RECEIVE_WINDOW_MAX_PAUSE_MS), [this, channelId, size]() {
+		ChannelInfo *channelInfo = getChannelInfo(channelId);
+		return NULL == channelInfo || channelInfo->queuedBytes + size <= mReceiveWindow ||
+		       !channelInfo->readerAttached;
+	});
+
+	channelInfo = getChannelInfo(channelId);
+	if (channelInfo)
+	{
+		channelInfo->pauses++;
+		channelInfo->pausedUs += g_get_monotonic_time() - pauseStart;
+	}
+
+	return channelInfo;
+}
+
+void ChannelManager::updateTransferStatistics(TransferStatistics &statistics, const uint32_t size, const gint64 receivedTime)
+{
+	gint64 now = g_get_monotonic_time();
+
+	if (0 == statistics.chunks)
+		statistics.firstTime = receivedTime;
+
+	statistics.bytes += size;
+	statistics.chunks++;
+	statistics.lastTime = now;
+	statistics.latency.record(now - receivedTime);
+}
+
+void ChannelManager::recordBinarySocketData(const BluetoothSppChannelId channelId, const uint32_t size, const gint64 receivedTime)
+{
+	std::lock_guard<std::mutex> guard(cmMutex);
+	ChannelInfo *channelInfo = getChannelInfo(channelId);
+	if (NULL == channelInfo)
+		return;
+
+	updateTransferStatistics(channelInfo->binarySocketStatistics, size, receivedTime);
+}
+
+void ChannelManager::recordTransmittedData(const BluetoothSppChannelId channelId, const uint32_t size)
+{
+	std::lock_guard<std::mutex> guard(cmMutex);
+	ChannelInfo *channelInfo = getChannelInfo(channelId);
+	if (NULL == channelInfo)
+		return;
+
+	channelInfo->txBytes += size;
+}
+
+pbnjson::JValue ChannelManager::getChannelStatus(const std::string &address)
+{
+	pbnjson::JValue channels = pbnjson::Array();
+
+	std::lock_guard<std::mutex> guard(cmMutex);
+	for (auto itMap = mChannelInfo.begin(); itMap != mChannelInfo.end(); itMap++)
+	{
+		ChannelInfo *channelInfo = itMap->second;
+		if (NULL == channelInfo || channelInfo->address != address)
+			continue;
+
+		pbnjson::JValue channelObj = pbnjson::Object();
+		channelObj.put("channelId", channelInfo->userChannelId);
+		channelObj.put("rxBytes", (int64_t) channelInfo->rxBytes);
+		channelObj.put("txBytes", (int64_t) channelInfo->txBytes);
+		channelObj.put("queuedBytes", (int64_t) channelInfo->queuedBytes);
+		channelObj.put("receiveWindow", (int64_t) mReceiveWindow);
+		channelObj.put("droppedBytes", (int64_t) channelInfo->droppedBytes);
+		channelObj.put("droppedChunks", (int64_t) channelInfo->droppedChunks);
+		channelObj.put("pauses", (int64_t) channelInfo->pauses);
+		channelObj.put("pausedMs", (int64_t) (channelInfo->pausedUs / 1000));
+		channels.append(channelObj);
+	}
+
+	return channels;
+}
+
+void ChannelManager::logTransferStatistics(const ChannelInfo *channelInfo, const TransferStatistics &statistics, const char *path)
+{
+	if (0 == statistics.chunks)
+		return;
+
+	double megaBytes = statistics.bytes / (1024.0 * 1024.0);
+	double seconds = (statistics.lastTime - statistics.firstTime) / 1000000.0;
+
+	BT_INFO("SPP", 0, "channel %s %s rx: %llu bytes in %llu chunks, %.3f MB/s, latency p50 %lld us p99 %lld us max %lld us",
+	        channelInfo->userChannelId.c_str(), path, (unsigned long long) statistics.bytes, (unsigned long long) statistics.chunks,
+	        seconds > 0 ? megaBytes / seconds : 0.0, (long long) statistics.latency.getPercentile(50),
+	        (long long) statistics.latency.getPercentile(99), (long long) statistics.latency.getMax());
 }
 
 void ChannelManager::postToReadDataSubscriber(const uint8_t *data, const uint32_t size, const LSUtils::ClientWatch *watch,
@@ -149,33 +314,90 @@ void ChannelManager::postToReadDataSubscriber(const uint8_t *data, const uint32_
 	if (NULL == data || 0 == size)
 		return;
 
-	gchar *gdata = g_base64_encode(data, size);
-	if (NULL == gdata)
+	Base64::encode(data, size, mEncodeBuffer);
+
+	mResponseWriter.reset();
+	mResponseWriter.beginObject();
+	mResponseWriter.put("returnValue", true);
+	mResponseWriter.put("adapterAddress", adapterAddress);
+	mResponseWriter.put("subscribed", true);
+	mResponseWriter.put("channelId", channelId);
+	mResponseWriter.put("data", mEncodeBuffer);
+	mResponseWriter.endObject();
+	LSUtils::postToClient(watch->getMessage(), mResponseWriter.getPayload());
+}
+
+void ChannelManager::deleteReadDataSubscription(ReadDataSubscriptionId id)
+{
+	auto findIter = mReadDataSubscriptions.find(id);
+	if (findIter == mReadDataSubscriptions.end())
+		return;
+
+	BT_DEBUG("[deleteReadDataSubscription] channelId:%s", findIter->second->userChannelId.c_str());
+
+	unlinkReadDataSubscription(findIter->second.get());
+	mReadDataSubscriptions.erase(findIter);
+}
+
+void ChannelManager::readDataClientDropped(ReadDataSubscriptionId id)
+{
+	auto findIter = mReadDataSubscriptions.find(id);
+	if (findIter == mReadDataSubscriptions.end())
 		return;
 
-	pbnjson::JValue responseObj = pbnjson::Object();
-	responseObj.put("returnValue", true);
-	responseObj.put("adapterAddress", adapterAddress);
-	responseObj.put("subscribed", true);
-	responseObj.put("channelId", channelId);
-	responseObj.put("data", gdata);
-	LSUtils::postToClient(watch->getMessage(), responseObj);
-	g_free(gdata);
+	// Called by the subscription's own watch, so stop posting to the client
+	// now and destroy the watch once its callback has returned
+	unlinkReadDataSubscription(findIter->second.get());
+
+	std::weak_ptr<bool> alive = mAlive;
+	EventQueue::post("ChannelManager::readDataClientDropped", [this, alive, id]() {
+		if (!alive.expired())
+			deleteReadDataSubscription(id);
+	});
+}
+
+ChannelManager::ReadDataSet *ChannelManager::findReadDataSet(const BluetoothSppChannelId channelId)
+{
+	auto findIter = mChannelReadDataSubscriptions.find(channelId);
+	if (findIter == mChannelReadDataSubscriptions.end())
+		return NULL;
+
+	return &findIter->second;
 }
 
-void ChannelManager::deleteReadDataSubscription(const void *readData)
+ChannelManager::ReadDataSet *ChannelManager::findReadDataSet(const std::string &appName)
 {
-	for (auto itMap = mReadDataSubscriptions.begin(); itMap != mReadDataSubscriptions.end(); itMap++)
+	if (EMPTY_STRING == appName)
+		return NULL;
+
+	auto findIter = mAppReadDataSubscriptions.find(appName);
+	if (findIter == mAppReadDataSubscriptions.end())
+		return NULL;
+
+	return &findIter->second;
+}
+
+void ChannelManager::unlinkReadDataSubscription(ReadDataInfo *dataInfo)
+{
+	if (EMPTY_STRING == dataInfo->userChannelId)
 	{
-		ReadDataInfo *dataInfo = *itMap;
-		if ((dataInfo != NULL) && (readData == dataInfo))
-		{
-			BT_DEBUG("[deleteReadDataSubscription] channelId:%s", dataInfo->userChannelId.c_str());
+		auto findIter = mAppReadDataSubscriptions.find(dataInfo->appName);
+		if (findIter == mAppReadDataSubscriptions.end())
+			return;
 
-			delete dataInfo;
-			mReadDataSubscriptions.erase(itMap);
-			break;
-		}
+		findIter->second.erase(dataInfo);
+		if (findIter->second.empty())
+			mAppReadDataSubscriptions.erase(findIter);
+	}
+	else
+	{
+		auto findIter = mChannelReadDataSubscriptions.find(dataInfo->stackChannelId);
+		if (findIter == mChannelReadDataSubscriptions.end())
+			return;
+
+		findIter->second.erase(dataInfo);
+		if (findIter->second.empty())
+			mChannelReadDataSubscriptions.erase(findIter);
 	}
 }
 
@@ -342,6 +564,8 @@ std::string ChannelManager::markChannelAsConnected(const BluetoothSppChannelId c
 	channelInfo->userChannelId = userChannelIdStr;
 	channelInfo->address = address;
 	channelInfo->appName = (EMPTY_STRING == appName) ? getCreateChannelAppName(uuid) : appName;
+	channelInfo->dispatchScheduled = false;
+	channelInfo->readerAttached = false;
 
 	BT_DEBUG("[markChannelAsConnected] create channel(channelId:%s, appName:%s, address:%s)",
 	        userChannelIdStr.c_str(), channelInfo->appName.c_str(), address.c_str());
@@ -370,22 +594,34 @@ std::string ChannelManager::markChannelAsNotConnected(const BluetoothSppChannelI
 			BT_DEBUG("[markChannelAsNotConnected] delete channel(channelId:%s, appName:%s, address:%s)",
 			        channelInfo->userChannelId.c_str(), appName.c_str(), address.c_str());
 
-			delete channelInfo;
-			mChannelInfo.erase(itMap);
+			logTransferStatistics(channelInfo, channelInfo->lunaStatistics, "luna");
+			logTransferStatistics(channelInfo, channelInfo->binarySocketStatistics, "binarySocket");
+			if (channelInfo->droppedChunks > 0)
+				BT_WARNING("SPP", 0, "channel %s dropped %llu bytes in %llu chunks (rx %llu bytes, window %u bytes)",
+				        channelInfo->userChannelId.c_str(), (unsigned long long) channelInfo->droppedBytes,
+				        (unsigned long long) channelInfo->droppedChunks, (unsigned long long) channelInfo->rxBytes, mReceiveWindow);
+			if (channelInfo->pauses > 0)
+				BT_INFO("SPP", 0, "channel %s held the stack back %llu times for %lld ms in total",
+				        channelInfo->userChannelId.c_str(), (unsigned long long) channelInfo->pauses,
+				        (long long) (channelInfo->pausedUs / 1000));
+
+			{
+				std::lock_guard<std::mutex> guard(cmMutex);
+				delete channelInfo;
+				mChannelInfo.erase(itMap);
+			}
+			// Nothing is drained from a channel that is gone, stop waiting for it
+			mReceiveWindowCondition.notify_all();
 			break;
 		}
 	}
 
-	for (auto itMap = mReadDataSubscriptions.begin(); itMap != mReadDataSubscriptions.end();)
+	ReadDataSet *channelSubscribers = findReadDataSet(channelId);
+	if (channelSubscribers)
 	{
-		ReadDataInfo *dataInfo = *itMap;
-		if (NULL == dataInfo)
-		{
-			itMap++;
-			continue;
-		}
-
-		if (dataInfo->stackChannelId == channelId)
+		// Unlinking modifies the index, so work on a copy of it
+		ReadDataSet subscribers = *channelSubscribers;
+		for (auto dataInfo : subscribers)
 		{
 			pbnjson::JValue responseObj = pbnjson::Object();
 			responseObj.put("returnValue", false);
@@ -395,16 +631,12 @@ std::string ChannelManager::markChannelAsNotConnected(const BluetoothSppChannelI
 			LSUtils::postToClient(dataInfo->watch->getMessage(), responseObj);
 
 			appName = dataInfo->appName;
-			mReadDataSubscriptions.erase(itMap);
 
 			BT_DEBUG("[markChannelAsNotConnected] delete readsubscription(appName:%s, channelId:%s)",
 			        appName.c_str(), dataInfo->userChannelId.c_str());
 
-			delete dataInfo;
-			continue;
+			deleteReadDataSubscription(dataInfo->id);
 		}
-
-		itMap++;
 	}
 
 	if (EMPTY_STRING == appName)
@@ -426,16 +658,11 @@ std::string ChannelManager::markChannelAsNotConnected(const BluetoothSppChannelI
 		return address;
 
 	// delete app read subcription(channelId is "")
-	for (auto itMap = mReadDataSubscriptions.begin(); itMap != mReadDataSubscriptions.end();)
+	ReadDataSet *appSubscribers = findReadDataSet(appName);
+	if (appSubscribers)
 	{
-		ReadDataInfo *dataInfo = *itMap;
-		if (NULL == dataInfo)
-		{
-			itMap++;
-			continue;
-		}
-
-		if ((EMPTY_STRING == dataInfo->userChannelId) && (appName == dataInfo->appName))
+		ReadDataSet subscribers = *appSubscribers;
+		for (auto dataInfo : subscribers)
 		{
 			BT_DEBUG("[markChannelAsNotConnected] delete readsubscription(appName:%s)", appName.c_str());
 
@@ -445,12 +672,8 @@ std::string ChannelManager::markChannelAsNotConnected(const BluetoothSppChannelI
 			responseObj.put("subscribed", false);
 			LSUtils::postToClient(dataInfo->watch->getMessage(), responseObj);
 
-			mReadDataSubscriptions.erase(itMap);
-			delete dataInfo;
-			continue;
+			deleteReadDataSubscription(dataInfo->id);
 		}
-
-		itMap++;
 	}
 
 	return address;
@@ -540,6 +763,9 @@ const ChannelManager::DataBuffer *ChannelManager::getChannelBufferData(std::stri
 				std::lock_guard<std::mutex> guard(cmMutex);
 				if (channelInfo->dataBuffer.size == 0)
 					makeDataBuffer(channelInfo);
+				if (channelInfo->dataBuffer.size > 0)
+					updateTransferStatistics(channelInfo->lunaStatistics, channelInfo->dataBuffer.size,
+					        channelInfo->dataBufferReceivedTime);
 				dataBuffer->size = channelInfo->dataBuffer.size;
 				memcpy(dataBuffer->buffer, channelInfo->dataBuffer.buffer, channelInfo->dataBuffer.size);
 				channelInfo->dataBuffer.size = 0;
@@ -554,6 +780,9 @@ const ChannelManager::DataBuffer *ChannelManager::getChannelBufferData(std::stri
 				std::lock_guard<std::mutex> guard(cmMutex);
 				if (channelInfo->dataBuffer.size == 0)
 					makeDataBuffer(channelInfo);
+				if (channelInfo->dataBuffer.size > 0)
+					updateTransferStatistics(channelInfo->lunaStatistics, channelInfo->dataBuffer.size,
+					        channelInfo->dataBufferReceivedTime);
 				dataBuffer->size = channelInfo->dataBuffer.size;
 				memcpy(dataBuffer->buffer, channelInfo->dataBuffer.buffer, channelInfo->dataBuffer.size);
 				channelInfo->dataBuffer.size = 0;
@@ -571,7 +800,7 @@ void ChannelManager::addReceiveQueue(const std::string &adapterAddress, const Bl
 	if (0 == size)
 		return;
 
-	std::string userChannelId = EMPTY_STRING;
+	bool dispatchPending = true;
 	for (auto itMap = mChannelInfo.begin(); itMap != mChannelInfo.end(); itMap++)
 	{
 		ChannelInfo *channelInfo = itMap->second;
@@ -580,81 +809,139 @@ void ChannelManager::addReceiveQueue(const std::string &adapterAddress, const Bl
 
 		if (channelInfo->stackChannelId == channelId)
 		{
-			userChannelId = channelInfo->userChannelId;
+			std::unique_lock<std::mutex> lock(cmMutex);
+			channelInfo->rxBytes += size;
+
+			// Nobody drained the channel for a while, apply the overflow policy
+			if (OVERFLOW_PAUSE == mOverflowPolicy)
+			{
+				channelInfo = waitForReceiveWindow(lock, channelId, size);
+				if (NULL == channelInfo)
+					return;
+			}
+
+			// Whatever the policy, the queue never grows beyond the window
+			if (!makeReceiveWindowSpace(channelInfo, size))
+			{
+				BT_DEBUG("[addReceiveQueue] receive window full, drop %u bytes on channel %s", size,
+				        channelInfo->userChannelId.c_str());
+				channelInfo->droppedBytes += size;
+				channelInfo->droppedChunks++;
+				return;
+			}
+
 			QueueData *queue = new QueueData();
 			queue->data = new uint8_t[size];
 			queue->size = size;
+			queue->receivedTime = g_get_monotonic_time();
 			memcpy(queue->data, data, size);
-			std::lock_guard<std::mutex> guard(cmMutex);
 			channelInfo->receiveQueue.push(queue);
+			channelInfo->queuedBytes += size;
+			dispatchPending = channelInfo->dispatchScheduled.exchange(true);
 			break;
 		}
 	}
 
-	auto dataReceivedCallback = [] (gpointer user_data) -> gboolean {
-		DataReceivedInfo *userData = (DataReceivedInfo *)user_data;
-		if (NULL == userData)
-			return FALSE;
-
-		ChannelManager *manager = userData->manager;
-		BluetoothSppChannelId channelId = userData->channelId;
-		std::string adapterAddress = userData->adapterAddress;
-		g_source_remove(userData->eventSourceId);
-		delete userData;
-
-		manager->notifyReceivedData(adapterAddress, channelId);
-
-		return FALSE;
-	};
+	// Only one dispatch per channel is kept in the main loop at a time, it
+	// drains whatever has been queued until it runs.
+	if (dispatchPending)
+		return;
 
-	DataReceivedInfo *userData = new DataReceivedInfo();
-	userData->channelId = channelId;
-	userData->manager = this;
-	userData->adapterAddress = adapterAddress;
-	guint eventSourceId = g_idle_add(dataReceivedCallback, (gpointer)userData);
-	userData->eventSourceId = eventSourceId;
+	std::weak_ptr<bool> alive = mAlive;
+	EventQueue::post("ChannelManager::dataReceived", [this, alive, adapterAddress, channelId]() {
+		if (!alive.expired())
+			notifyReceivedData(adapterAddress, channelId);
+	});
 }
 
-void *ChannelManager::addReadDataSubscription(const std::string &channelId, const int timeout, LSUtils::ClientWatch *watch,
-        const std::string &appName)
+ChannelManager::ReadDataSubscriptionId ChannelManager::addReadDataSubscription(const std::string &channelId, const int timeout,
+        LSUtils::ClientWatch *watch, const std::string &appName)
 {
-	ReadDataInfo *readDataInfo = new ReadDataInfo();
-	readDataInfo->timeout = timeout;
-	readDataInfo->watch = watch;
+	std::unique_ptr<ReadDataInfo> readDataInfo(new ReadDataInfo());
+	readDataInfo->id = mNextReadDataId++;
+	readDataInfo->watch.reset(watch);
 	readDataInfo->userChannelId = channelId;
 	readDataInfo->stackChannelId = getStackChannelId(channelId);
 	readDataInfo->appName = appName;
 
 	BT_DEBUG("[addReadDataSubscription] channelId:%s, appName:%s, timeout:%d", channelId.c_str(), appName.c_str(), timeout);
-	mReadDataSubscriptions.push_back(readDataInfo);
 
-	auto timeoutExpiredCallback = [] (gpointer user_data) -> gboolean {
-		TimeoutInfo *userData = (TimeoutInfo *)user_data;
-		if (NULL == userData)
-			return FALSE;
+	if (EMPTY_STRING == channelId)
+		mAppReadDataSubscriptions[appName].insert(readDataInfo.get());
+	else
+		mChannelReadDataSubscriptions[readDataInfo->stackChannelId].insert(readDataInfo.get());
+
+	ReadDataSubscriptionId id = readDataInfo->id;
+	mReadDataSubscriptions.insert(std::make_pair(id, std::move(readDataInfo)));
+
+	if (timeout > 0)
+		scheduleReadDataTimeout(id, timeout);
 
-		ChannelManager *manager = userData->manager;
-		g_source_remove(userData->eventSourceId);
-		void *readDataInfo = userData->readDataInfo;
-		delete userData;
+	return id;
+}
 
-		BT_DEBUG("[timeoutExpired] readDataInfo:%p", readDataInfo);
+void ChannelManager::scheduleReadDataTimeout(ReadDataSubscriptionId id, uint32_t seconds)
+{
+	// The entry is visited once per revolution and expires on the visit
+	// which happens exactly 'ticks' ticks from now. A running wheel is
+	// already part way into its current tick, so one more tick is waited
+	// for to never expire before 'seconds' have passed.
+	uint32_t ticks = seconds;
+	if (mTimerWheelSource)
+		ticks++;
+
+	TimerWheelEntry entry;
+	entry.id = id;
+	entry.rounds = (ticks - 1) / READ_DATA_TIMER_WHEEL_SLOTS;
+	mTimerWheel[(mTimerWheelCursor + ticks) % READ_DATA_TIMER_WHEEL_SLOTS].push_back(entry);
+	mTimerWheelEntries++;
+
+	if (0 == mTimerWheelSource)
+		mTimerWheelSource = MainLoopWatchdog::addTimeoutSeconds("ChannelManager::timerWheelTick", 1,
+				&ChannelManager::handleTimerWheelTick, this);
+}
 
-		manager->deleteReadDataSubscription(readDataInfo);
+void ChannelManager::advanceTimerWheel()
+{
+	mTimerWheelCursor = (mTimerWheelCursor + 1) % READ_DATA_TIMER_WHEEL_SLOTS;
 
-		return FALSE;
-	};
+	std::vector<TimerWheelEntry> &slot = mTimerWheel[mTimerWheelCursor];
+	std::vector<ReadDataSubscriptionId> expired;
 
-	if (timeout > 0)
+	for (auto entry = slot.begin(); entry != slot.end();)
 	{
-		TimeoutInfo *userData = new TimeoutInfo();
-		userData->manager = this;
-		userData->readDataInfo = (void *)readDataInfo;
-		guint eventSourceId = g_timeout_add_seconds(timeout, timeoutExpiredCallback, (gpointer)userData);
-		userData->eventSourceId = eventSourceId;
+		if (entry->rounds > 0)
+		{
+			entry->rounds--;
+			entry++;
+			continue;
+		}
+
+		expired.push_back(entry->id);
+		entry = slot.erase(entry);
+		mTimerWheelEntries--;
 	}
 
-	return readDataInfo;
+	for (auto id : expired)
+	{
+		BT_DEBUG("[timeoutExpired] readDataSubscription:%u", id);
+		deleteReadDataSubscription(id);
+	}
+}
+
+gboolean ChannelManager::handleTimerWheelTick(gpointer userData)
+{
+	ChannelManager *manager = static_cast<ChannelManager *>(userData);
+	if (NULL == manager)
+		return FALSE;
+
+	manager->advanceTimerWheel();
+
+	if (manager->mTimerWheelEntries > 0)
+		return TRUE;
+
+	manager->mTimerWheelSource = 0;
+	return FALSE;
 }
 
 std::string ChannelManager::getMessageOwner(LSMessage *message)
@@ -21,14 +21,22 @@
 #include <string>
 #include <unordered_map>
 #include <map>
+#include <memory>
+#include <unordered_set>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include <pbnjson.hpp>
 #include <bluetooth-sil-api.h>
 #include <luna-service2/lunaservice.hpp>
 
+#include "jsonwriter.h"
+#include "latencyhistogram.h"
+
 #define MAX_BUFFER_SIZE (1024*5)
 #define EMPTY_STRING ""
+#define READ_DATA_TIMER_WHEEL_SLOTS 60
 
 namespace pbnjson
 {
@@ -56,6 +64,8 @@ public:
 		uint8_t buffer[MAX_BUFFER_SIZE];
 	} DataBuffer;
 
+	typedef uint32_t ReadDataSubscriptionId;
+
 	std::string getUserChannelId(const BluetoothSppChannelId channelId);
 	std::string getUserChannelId(const std::string &uuid);
 	BluetoothSppChannelId getStackChannelId(const std::string &channelId);
@@ -73,11 +83,16 @@ public:
 	        const uint32_t size);
 	const DataBuffer *getChannelBufferData(std::string &channelId, const std::string &appName);
 	void notifyReceivedData(const std::string &adapterAddress, const BluetoothSppChannelId channelId);
+	void recordBinarySocketData(const BluetoothSppChannelId channelId, const uint32_t size, const gint64 receivedTime);
+	void recordTransmittedData(const BluetoothSppChannelId channelId, const uint32_t size);
+	pbnjson::JValue getChannelStatus(const std::string &address);
 	std::string getMessageOwner(LSMessage *message);
 	std::string getChannelAppName(const std::string &channelId);
 	void setChannelAppName(const std::string &channelId, std::string appName);
-	void *addReadDataSubscription(const std::string &channelId, const int timeout, LSUtils::ClientWatch *watch, const std::string &appName);
-	void deleteReadDataSubscription(const void *readData);
+	ReadDataSubscriptionId addReadDataSubscription(const std::string &channelId, const int timeout, LSUtils::ClientWatch *watch,
+	        const std::string &appName);
+	void deleteReadDataSubscription(ReadDataSubscriptionId id);
+	void readDataClientDropped(ReadDataSubscriptionId id);
 	LSUtils::ClientWatch *getCreateChannelSubscription(const std::string &uuid);
 	void addCreateChannelSubscripton(const std::string &uuid, LSUtils::ClientWatch *watch, LSMessage *message);
 	std::string getCreateChannelAppName(const std::string &uuid);
@@ -87,42 +102,114 @@ private:
 	typedef struct {
 		uint32_t size;
 		uint8_t *data;
+		gint64 receivedTime;
 	} QueueData;
 
+	// Receive path measurements inside the service, from the stack handing
+	// over the data to it being posted to a client or written to the binary
+	// socket. tests/bench_spp_throughput compares the paths end to end.
+	typedef struct {
+		uint64_t bytes;
+		uint64_t chunks;
+		gint64 firstTime;
+		gint64 lastTime;
+		LatencyHistogram latency;
+	} TransferStatistics;
+
 	typedef struct {
 		BluetoothSppChannelId stackChannelId;
 		std::string userChannelId;
 		std::string address;
 		std::string appName;
 		DataBuffer dataBuffer;
+		gint64 dataBufferReceivedTime;
 		std::queue<QueueData *> receiveQueue;
+		uint32_t queuedBytes;
+		uint64_t rxBytes;
+		uint64_t txBytes;
+		uint64_t droppedBytes;
+		uint64_t droppedChunks;
+		// Times the stack was held back on a full receive window, and for how long
+		uint64_t pauses;
+		gint64 pausedUs;
+		std::atomic<bool> dispatchScheduled;
+		// Set by the last dispatch when it had a readData subscriber to drain
+		// the queue into, only then is a paused stack sure to be signalled
+		bool readerAttached;
+		TransferStatistics lunaStatistics;
+		TransferStatistics binarySocketStatistics;
 	} ChannelInfo;
 
 	typedef struct {
-		int32_t timeout;
-		LSUtils::ClientWatch *watch;
+		ReadDataSubscriptionId id;
+		std::unique_ptr<LSUtils::ClientWatch> watch;
 		BluetoothSppChannelId stackChannelId;
 		std::string userChannelId;
 		std::string appName;
 	} ReadDataInfo;
 
+	typedef std::unordered_set<ReadDataInfo *> ReadDataSet;
+
+	typedef struct {
+		ReadDataSubscriptionId id;
+		uint32_t rounds;
+	} TimerWheelEntry;
+
 	typedef struct {
 		std::string appName;
 		LSUtils::ClientWatch *watch;
 	} CreateChannelInfo;
 
 	uint32_t mNextChannelId;
+	typedef enum {
+		OVERFLOW_PAUSE,
+		OVERFLOW_DROP_NEWEST,
+		OVERFLOW_DROP_OLDEST
+	} OverflowPolicy;
+
+	uint32_t mReceiveWindow;
+	OverflowPolicy mOverflowPolicy;
 	std::map<std::string, ChannelInfo *> mChannelInfo;
 	std::unordered_map<std::string, CreateChannelInfo *> mCreateChannelSubscriptons;
-	std::vector<ReadDataInfo *> mReadDataSubscriptions;
+	ReadDataSubscriptionId mNextReadDataId;
+	std::unordered_map<ReadDataSubscriptionId, std::unique_ptr<ReadDataInfo>> mReadDataSubscriptions;
+	// Lookup indexes over mReadDataSubscriptions: subscriptions for a specific
+	// channel and subscriptions for any channel of an application.
+	std::map<BluetoothSppChannelId, ReadDataSet> mChannelReadDataSubscriptions;
+	std::unordered_map<std::string, ReadDataSet> mAppReadDataSubscriptions;
+	// One-second timer wheel shared by all readData timeouts. Entries of
+	// deleted subscriptions are dropped lazily when their slot comes up.
+	std::vector<TimerWheelEntry> mTimerWheel[READ_DATA_TIMER_WHEEL_SLOTS];
+	uint32_t mTimerWheelCursor;
+	uint32_t mTimerWheelEntries;
+	guint mTimerWheelSource;
+	// Receive events queued from SIL threads are dropped once this is gone
+	std::shared_ptr<bool> mAlive;
 	std::vector<std::string> mConnectingChannels;
 	std::mutex cmMutex;
+	// Signalled whenever the main loop drains a receive queue or a channel goes
+	std::condition_variable mReceiveWindowCondition;
+	std::string mEncodeBuffer;
+	JsonWriter mResponseWriter;
 
 	void postToReadDataSubscriber(const uint8_t *data, const uint32_t size, const LSUtils::ClientWatch *watch,
 	        const std::string &adapterAddress, const std::string &channelId);
 	ChannelInfo *getChannelInfo(const std::string &uuid);
 	ChannelInfo *getChannelInfo(const BluetoothSppChannelId channelId);
 	void makeDataBuffer(ChannelInfo *channelInfo);
+	static OverflowPolicy parseOverflowPolicy(const char *policy);
+	bool makeReceiveWindowSpace(ChannelInfo *channelInfo, const uint32_t size);
+	ChannelInfo *waitForReceiveWindow(std::unique_lock<std::mutex> &lock, const BluetoothSppChannelId channelId,
+	        const uint32_t size);
+	void updateTransferStatistics(TransferStatistics &statistics, const uint32_t size, const gint64 receivedTime);
+	void logTransferStatistics(const ChannelInfo *channelInfo, const TransferStatistics &statistics, const char *path);
+	ReadDataSet *findReadDataSet(const BluetoothSppChannelId channelId);
+	ReadDataSet *findReadDataSet(const std::string &appName);
+	void unlinkReadDataSubscription(ReadDataInfo *dataInfo);
+	void scheduleReadDataTimeout(ReadDataSubscriptionId id, uint32_t seconds);
+	void advanceTimerWheel();
+
+	static gboolean handleTimerWheelTick(gpointer userData);
 };
 
 #endif // CHANNELMANAGER_H
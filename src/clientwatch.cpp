@@ -17,6 +17,7 @@
 
 #include "clientwatch.h"
 #include "logging.h"
+#include "mainloopwatchdog.h"
 
 namespace LSUtils
 {
@@ -127,7 +128,8 @@ void ClientWatch::triggerClientDroppedNotification()
 	// We have to offload the actual callback here as otherwise we risk
 	// a deadlock when someone tries to destroy us while stilling being
 	// in the callback from ls2
-	mNotificationTimeout = g_timeout_add(0, &ClientWatch::sendClientDroppedNotification, this);
+	mNotificationTimeout = MainLoopWatchdog::addTimeout("ClientWatch::sendClientDroppedNotification", 0,
+			&ClientWatch::sendClientDroppedNotification, this);
 }
 
 void ClientWatch::notifyClientDisconnected()
@@ -0,0 +1,417 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <glib.h>
+
+#include "eventqueue.h"
+#include "latencyhistogram.h"
+#include "mainloopwatchdog.h"
+#include "logging.h"
+
+#define MSGID_EVENT_QUEUE		"EVENT_QUEUE"
+
+// Must be a power of two
+#define EVENT_QUEUE_SIZE		1024
+#define EVENT_QUEUE_MASK		(EVENT_QUEUE_SIZE - 1)
+// Events dispatched per main loop iteration before other sources get a turn
+#define EVENT_QUEUE_BATCH		64
+// Events held in the overflow list before producers other than the main
+// thread have to wait for the main loop
+#define EVENT_QUEUE_OVERFLOW_LIMIT	(4 * EVENT_QUEUE_SIZE)
+
+typedef struct
+{
+	// Equals the position when free, position + 1 once an event is published
+	std::atomic<size_t> sequence;
+	const char *type;
+	EventQueue::Handler handler;
+	int64_t postedTime;
+} Cell;
+
+typedef struct
+{
+	const char *type;
+	EventQueue::Handler handler;
+	int64_t postedTime;
+} OverflowEvent;
+
+typedef struct
+{
+	uint64_t count;
+	int64_t maxLatencyUs;
+} EventTypeStatistics;
+
+static Cell cells[EVENT_QUEUE_SIZE];
+static std::atomic<size_t> enqueuePosition(0);
+// Only advanced by the consumer, producers read it for the depth statistics
+static std::atomic<size_t> dequeuePosition(0);
+
+// Set while events go to the overflow list, keeps them behind the ring
+static std::atomic<bool> overflowing(false);
+static std::mutex overflowMutex;
+static std::deque<OverflowEvent> overflowEvents;
+// Signalled whenever the overflow list shrinks, wakes blocked producers
+static std::condition_variable overflowDrained;
+static std::atomic<bool> running(false);
+
+static std::atomic<bool> wakeupPending(false);
+static GSource *queueSource = NULL;
+static std::thread::id mainThread;
+
+static std::atomic<uint64_t> postedCount(0);
+static std::atomic<uint64_t> overflowCount(0);
+static std::atomic<uint64_t> blockedCount(0);
+static std::atomic<int64_t> blockedUs(0);
+static std::atomic<size_t> maxDepth(0);
+static uint64_t batchCount = 0;
+static LatencyHistogram queueLatency;
+static std::map<std::string, EventTypeStatistics> eventTypes;
+
+static bool hasRingEvent()
+{
+	size_t position = dequeuePosition.load(std::memory_order_relaxed);
+
+	return cells[position & EVENT_QUEUE_MASK].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+static void recordDepth(size_t depth)
+{
+	size_t current = maxDepth.load(std::memory_order_relaxed);
+	while (depth > current && !maxDepth.compare_exchange_weak(current, depth, std::memory_order_relaxed))
+		;
+}
+
+static bool pushRing(const char *type, EventQueue::Handler &handler, int64_t postedTime)
+{
+	size_t position = enqueuePosition.load(std::memory_order_relaxed);
+	Cell *cell;
+
+	while (true)
+	{
+		cell = &cells[position & EVENT_QUEUE_MASK];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+		if (difference == 0)
+		{
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			return false;
+		}
+		else
+		{
+			position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->type = type;
+	cell->handler = std::move(handler);
+	cell->postedTime = postedTime;
+	cell->sequence.store(position + 1, std::memory_order_release);
+
+	return true;
+}
+
+// Called with overflowMutex held by lock
+static void pushOverflow(std::unique_lock<std::mutex> &lock, const char *type, EventQueue::Handler &handler, int64_t postedTime)
+{
+	// Holding the producer back is safer than losing the event, nothing
+	// else would ever redo what it stood for. The main thread drains the
+	// list itself and must not wait for it.
+	if (overflowEvents.size() >= EVENT_QUEUE_OVERFLOW_LIMIT && running.load() && !EventQueue::isMainThread())
+	{
+		if (0 == blockedCount++)
+			BT_WARNING(MSGID_EVENT_QUEUE, 0, "Event queue full, holding back %s until the main loop catches up, further waits are only counted", type);
+
+		int64_t waitStart = g_get_monotonic_time();
+		overflowDrained.wait(lock, [] {
+			return overflowEvents.size() < EVENT_QUEUE_OVERFLOW_LIMIT || !running.load();
+		});
+		blockedUs += g_get_monotonic_time() - waitStart;
+
+		if (!running.load())
+			return;
+
+		// The main loop may have emptied the list and left overflow mode
+		overflowing.store(true);
+	}
+
+	overflowEvents.push_back({type, std::move(handler), postedTime});
+	overflowCount++;
+}
+
+static void dispatchEvent(const char *type, EventQueue::Handler &handler, int64_t postedTime)
+{
+	int64_t start = g_get_monotonic_time();
+	int64_t latency = start - postedTime;
+
+	queueLatency.record(latency);
+	EventTypeStatistics &statistics = eventTypes[type];
+	statistics.count++;
+	if (latency > statistics.maxLatencyUs)
+		statistics.maxLatencyUs = latency;
+
+	handler();
+
+	MainLoopWatchdog::recordDispatch(type, g_get_monotonic_time() - start);
+}
+
+static bool hasEvents()
+{
+	return hasRingEvent() || overflowing.load();
+}
+
+static bool isQueueReady()
+{
+	if (hasEvents())
+		return true;
+
+	// About to sleep. The head may be a slot claimed but not yet published
+	// while a later producer already used up the wakeup, so the next publish
+	// has to wake us again. Clear first, then look once more.
+	wakeupPending.store(false);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	return hasEvents();
+}
+
+static gboolean prepareQueue(GSource *source, gint *timeout)
+{
+	*timeout = -1;
+
+	return isQueueReady();
+}
+
+static gboolean checkQueue(GSource *source)
+{
+	return isQueueReady();
+}
+
+static gboolean dispatchQueue(GSource *source, GSourceFunc callback, gpointer userData)
+{
+	// Reset before draining so a producer publishing after this point wakes us again
+	wakeupPending.store(false);
+	batchCount++;
+
+	int dispatched = 0;
+	while (dispatched < EVENT_QUEUE_BATCH && hasRingEvent())
+	{
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		Cell &cell = cells[position & EVENT_QUEUE_MASK];
+		const char *type = cell.type;
+		EventQueue::Handler handler = std::move(cell.handler);
+		int64_t postedTime = cell.postedTime;
+
+		cell.handler = nullptr;
+		cell.sequence.store(position + EVENT_QUEUE_SIZE, std::memory_order_release);
+		dequeuePosition.store(position + 1, std::memory_order_relaxed);
+
+		dispatchEvent(type, handler, postedTime);
+		dispatched++;
+	}
+
+	// Overflowed events are newer than anything still in the ring
+	while (dispatched < EVENT_QUEUE_BATCH && !hasRingEvent() && overflowing.load())
+	{
+		OverflowEvent event;
+		{
+			std::lock_guard<std::mutex> lock(overflowMutex);
+			if (overflowEvents.empty())
+			{
+				overflowing.store(false);
+				break;
+			}
+
+			event = std::move(overflowEvents.front());
+			overflowEvents.pop_front();
+		}
+		overflowDrained.notify_all();
+
+		dispatchEvent(event.type, event.handler, event.postedTime);
+		dispatched++;
+	}
+
+	return TRUE;
+}
+
+static GSourceFuncs queueSourceFuncs = {
+	prepareQueue,
+	checkQueue,
+	dispatchQueue,
+	NULL
+};
+
+static gboolean dispatchUnqueued(gpointer userData)
+{
+	EventQueue::Handler *handler = static_cast<EventQueue::Handler*>(userData);
+	(*handler)();
+	delete handler;
+
+	return FALSE;
+}
+
+void EventQueue::start()
+{
+	if (queueSource)
+		return;
+
+	for (size_t i = 0; i < EVENT_QUEUE_SIZE; i++)
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+	enqueuePosition.store(0);
+	dequeuePosition = 0;
+	mainThread = std::this_thread::get_id();
+	running.store(true);
+
+	queueSource = g_source_new(&queueSourceFuncs, sizeof(GSource));
+	g_source_set_priority(queueSource, G_PRIORITY_DEFAULT);
+	g_source_attach(queueSource, NULL);
+}
+
+void EventQueue::stop()
+{
+	if (!queueSource)
+		return;
+
+	g_source_destroy(queueSource);
+	g_source_unref(queueSource);
+	queueSource = NULL;
+
+	while (hasRingEvent())
+	{
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		cells[position & EVENT_QUEUE_MASK].handler = nullptr;
+		dequeuePosition.store(position + 1, std::memory_order_relaxed);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(overflowMutex);
+		running.store(false);
+		overflowEvents.clear();
+		overflowing.store(false);
+	}
+	overflowDrained.notify_all();
+}
+
+bool EventQueue::isMainThread()
+{
+	return !queueSource || std::this_thread::get_id() == mainThread;
+}
+
+void EventQueue::post(const char *type, Handler handler)
+{
+	if (!queueSource)
+	{
+		g_idle_add(dispatchUnqueued, new Handler(std::move(handler)));
+		return;
+	}
+
+	int64_t postedTime = g_get_monotonic_time();
+	postedCount++;
+
+	bool queued = false;
+	if (overflowing.load())
+	{
+		std::unique_lock<std::mutex> lock(overflowMutex);
+		if (overflowing.load())
+		{
+			pushOverflow(lock, type, handler, postedTime);
+			queued = true;
+		}
+	}
+
+	if (!queued && !pushRing(type, handler, postedTime))
+	{
+		std::unique_lock<std::mutex> lock(overflowMutex);
+		overflowing.store(true);
+		pushOverflow(lock, type, handler, postedTime);
+	}
+
+	size_t dequeued = dequeuePosition.load(std::memory_order_relaxed);
+	recordDepth(enqueuePosition.load(std::memory_order_relaxed) - dequeued);
+
+	// One wakeup per drain is enough, the dispatch picks up everything queued
+	// since. Pairs with the fence in isQueueReady().
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!wakeupPending.exchange(true))
+		g_main_context_wakeup(NULL);
+}
+
+bool EventQueue::deferToMainLoop(const char *type, const std::weak_ptr<bool> &owner, Handler handler)
+{
+	if (isMainThread())
+		return false;
+
+	post(type, [owner, handler]() {
+		if (!owner.expired())
+			handler();
+	});
+
+	return true;
+}
+
+pbnjson::JValue EventQueue::getStatistics()
+{
+	pbnjson::JValue typesObj = pbnjson::Array();
+	for (auto &eventType : eventTypes)
+	{
+		pbnjson::JValue typeObj = pbnjson::Object();
+		typeObj.put("type", eventType.first);
+		typeObj.put("count", (int64_t) eventType.second.count);
+		typeObj.put("maxLatencyUs", (int64_t) eventType.second.maxLatencyUs);
+		typesObj.append(typeObj);
+	}
+
+	pbnjson::JValue statisticsObj = pbnjson::Object();
+	statisticsObj.put("size", (int32_t) EVENT_QUEUE_SIZE);
+	statisticsObj.put("posted", (int64_t) postedCount.load());
+	statisticsObj.put("overflows", (int64_t) overflowCount.load());
+	statisticsObj.put("blocked", (int64_t) blockedCount.load());
+	statisticsObj.put("blockedUs", (int64_t) blockedUs.load());
+	statisticsObj.put("maxDepth", (int64_t) maxDepth.load());
+	statisticsObj.put("batches", (int64_t) batchCount);
+	statisticsObj.put("latency", queueLatency.toJValue());
+	statisticsObj.put("types", typesObj);
+
+	return statisticsObj;
+}
+
+void EventQueue::logStatistics()
+{
+	if (0 == postedCount.load())
+		return;
+
+	BT_INFO(MSGID_EVENT_QUEUE, 0, "posted %llu overflows %llu blocked %llu (%lld us) max depth %llu latency p50 %lldus p99 %lldus max %lldus",
+			(unsigned long long) postedCount.load(),
+			(unsigned long long) overflowCount.load(),
+			(unsigned long long) blockedCount.load(),
+			(long long) blockedUs.load(),
+			(unsigned long long) maxDepth.load(),
+			(long long) queueLatency.getPercentile(50),
+			(long long) queueLatency.getPercentile(99),
+			(long long) queueLatency.getMax());
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <functional>
+#include <memory>
+
+#include <pbnjson.hpp>
+
+/*
+ * Hands events from SIL threads over to the main loop.
+ *
+ * Producers on any thread push into a fixed size lock-free ring, a single
+ * GSource on the main loop drains it in batches. Should the ring fill up,
+ * events spill into a locked overflow list and are counted, so a stuck main
+ * loop shows up in the statistics. No event is ever dropped: once the
+ * overflow list is full as well, a posting SIL thread blocks until the main
+ * loop has drained it, which holds the stack back instead of losing state
+ * changes. Posts from the main thread itself never block. Every event
+ * records how long it waited between the callback and its dispatch.
+ *
+ * Until start() is called everything runs as if posted from the main thread.
+ */
+namespace EventQueue
+{
+
+typedef std::function<void()> Handler;
+
+void start();
+void stop();
+
+bool isMainThread();
+
+// Callable from any thread, type names the event and must be a literal
+void post(const char *type, Handler handler);
+
+// For observer callbacks: on the main thread returns false and the caller
+// handles the event inline. Elsewhere queues handler, which is skipped if
+// owner is gone by the time it is dispatched, and returns true.
+bool deferToMainLoop(const char *type, const std::weak_ptr<bool> &owner, Handler handler);
+
+pbnjson::JValue getStatistics();
+void logStatistics();
+
+} // namespace EventQueue
+
+#endif // EVENTQUEUE_H
@@ -0,0 +1,64 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <unordered_map>
+
+#include "firstcallhook.h"
+
+bool LSUtils::firstCallHooksPending = false;
+
+static std::unordered_map<void*, std::function<void()>> firstCallHooks;
+static std::unordered_map<void*, void*> firstCallHookOwners;
+
+void LSUtils::setFirstCallHook(void *context, std::function<void()> hook)
+{
+	firstCallHooks[context] = hook;
+	firstCallHooksPending = true;
+}
+
+void LSUtils::clearFirstCallHook(void *context)
+{
+	firstCallHooks.erase(context);
+	firstCallHooksPending = !firstCallHooks.empty();
+}
+
+void LSUtils::setFirstCallHookOwner(void *context, void *owner)
+{
+	firstCallHookOwners[context] = owner;
+}
+
+void LSUtils::clearFirstCallHookOwner(void *context)
+{
+	firstCallHookOwners.erase(context);
+}
+
+void LSUtils::runFirstCallHook(void *context)
+{
+	auto ownerIter = firstCallHookOwners.find(context);
+	if (ownerIter != firstCallHookOwners.end())
+		context = ownerIter->second;
+
+	auto hookIter = firstCallHooks.find(context);
+	if (hookIter == firstCallHooks.end())
+		return;
+
+	// The hook may set up further hooks, take it out first
+	std::function<void()> hook = hookIter->second;
+	clearFirstCallHook(context);
+
+	hook();
+}
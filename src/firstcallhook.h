@@ -0,0 +1,40 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef FIRSTCALLHOOK_H
+#define FIRSTCALLHOOK_H
+
+#include <functional>
+
+namespace LSUtils
+{
+
+// Runs hook once, right before the first method dispatched to a category
+// whose data is context. Lets services defer their setup until first use.
+void setFirstCallHook(void *context, std::function<void()> hook);
+void clearFirstCallHook(void *context);
+// Calls to categories whose data is context run the hook set for owner, for
+// objects that register their own categories on behalf of a profile service
+void setFirstCallHookOwner(void *context, void *owner);
+void clearFirstCallHookOwner(void *context);
+void runFirstCallHook(void *context);
+// Lets the method wrapper skip the lookup once no hook is left
+extern bool firstCallHooksPending;
+
+} // namespace LSUtils
+
+#endif // FIRSTCALLHOOK_H
@@ -0,0 +1,191 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <cstring>
+
+#include "jsonwriter.h"
+
+JsonWriter::JsonWriter()
+{
+	mBuffer.reserve(256);
+}
+
+void JsonWriter::reset()
+{
+	mBuffer.clear();
+	mScopes.clear();
+}
+
+void JsonWriter::beginValue()
+{
+	if (mScopes.empty())
+		return;
+
+	if (mScopes.back())
+		mScopes.back() = false;
+	else
+		mBuffer += ',';
+}
+
+void JsonWriter::writeKey(const char *key)
+{
+	beginValue();
+	writeString(key, strlen(key));
+	mBuffer += ':';
+}
+
+void JsonWriter::beginObject()
+{
+	beginValue();
+	mBuffer += '{';
+	mScopes.push_back(true);
+}
+
+void JsonWriter::beginObject(const char *key)
+{
+	writeKey(key);
+	mBuffer += '{';
+	mScopes.push_back(true);
+}
+
+void JsonWriter::endObject()
+{
+	mBuffer += '}';
+	mScopes.pop_back();
+}
+
+void JsonWriter::beginArray(const char *key)
+{
+	writeKey(key);
+	mBuffer += '[';
+	mScopes.push_back(true);
+}
+
+void JsonWriter::endArray()
+{
+	mBuffer += ']';
+	mScopes.pop_back();
+}
+
+void JsonWriter::put(const char *key, const std::string &value)
+{
+	writeKey(key);
+	writeString(value.c_str(), value.length());
+}
+
+void JsonWriter::put(const char *key, const char *value)
+{
+	writeKey(key);
+	writeString(value, strlen(value));
+}
+
+void JsonWriter::put(const char *key, bool value)
+{
+	writeKey(key);
+	mBuffer += value ? "true" : "false";
+}
+
+void JsonWriter::put(const char *key, int32_t value)
+{
+	writeKey(key);
+	writeInteger(value);
+}
+
+void JsonWriter::put(const char *key, int64_t value)
+{
+	writeKey(key);
+	writeInteger(value);
+}
+
+void JsonWriter::append(int32_t value)
+{
+	beginValue();
+	writeInteger(value);
+}
+
+void JsonWriter::append(int64_t value)
+{
+	beginValue();
+	writeInteger(value);
+}
+
+void JsonWriter::writeInteger(int64_t value)
+{
+	char digits[21];
+	char *end = digits + sizeof(digits);
+	char *pos = end;
+	uint64_t magnitude = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+
+	do
+	{
+		*--pos = '0' + (magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude);
+
+	if (value < 0)
+		*--pos = '-';
+
+	mBuffer.append(pos, end - pos);
+}
+
+void JsonWriter::writeString(const char *value, size_t length)
+{
+	static const char hexDigits[] = "0123456789ABCDEF";
+
+	mBuffer += '"';
+
+	// Copy runs of plain characters in one go, escape the rest the way
+	// JGenerator does (short escapes where defined, \u00XX otherwise).
+	size_t runStart = 0;
+	for (size_t i = 0; i < length; i++)
+	{
+		unsigned char c = value[i];
+		const char *escape = NULL;
+
+		switch (c)
+		{
+		case '"': escape = "\\\""; break;
+		case '\\': escape = "\\\\"; break;
+		case '\b': escape = "\\b"; break;
+		case '\f': escape = "\\f"; break;
+		case '\n': escape = "\\n"; break;
+		case '\r': escape = "\\r"; break;
+		case '\t': escape = "\\t"; break;
+		default:
+			if (c >= 0x20)
+				continue;
+			break;
+		}
+
+		mBuffer.append(value + runStart, i - runStart);
+		runStart = i + 1;
+
+		if (escape)
+		{
+			mBuffer += escape;
+		}
+		else
+		{
+			mBuffer += "\\u00";
+			mBuffer += hexDigits[c >> 4];
+			mBuffer += hexDigits[c & 0x0f];
+		}
+	}
+	mBuffer.append(value + runStart, length - runStart);
+
+	mBuffer += '"';
+}
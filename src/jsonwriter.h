@@ -0,0 +1,73 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Append-only JSON writer for notifications sent at high rate (SPP data,
+ * play status, mesh receive, GATT characteristic changes). It writes
+ * straight into a buffer that is kept across messages, instead of building
+ * a pbnjson DOM and serializing it.
+ *
+ * Output matches LSUtils::generatePayload for the same sequence of puts:
+ * compact, members in insertion order, strings escaped like JGenerator.
+ * tests/bench_json_writer checks this byte for byte for every notification
+ * written with it.
+ */
+class JsonWriter
+{
+public:
+	JsonWriter();
+
+	// Drops the previous message but keeps the allocated buffer
+	void reset();
+
+	void beginObject();
+	void beginObject(const char *key);
+	void endObject();
+	void beginArray(const char *key);
+	void endArray();
+
+	void put(const char *key, const std::string &value);
+	void put(const char *key, const char *value);
+	void put(const char *key, bool value);
+	void put(const char *key, int32_t value);
+	void put(const char *key, int64_t value);
+
+	void append(int32_t value);
+	void append(int64_t value);
+
+	const std::string &getPayload() const { return mBuffer; }
+
+private:
+	void beginValue();
+	void writeKey(const char *key);
+	void writeString(const char *value, size_t length);
+	void writeInteger(int64_t value);
+
+	std::string mBuffer;
+	// One entry per open object/array, true until its first member is written
+	std::vector<bool> mScopes;
+};
+
+#endif // JSONWRITER_H
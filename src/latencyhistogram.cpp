@@ -0,0 +1,99 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <cstring>
+
+#include "latencyhistogram.h"
+
+static inline unsigned int bucketIndex(int64_t latencyUs)
+{
+	unsigned int index = 0;
+	while (latencyUs > 0 && index < LATENCY_HISTOGRAM_BUCKETS - 1)
+	{
+		latencyUs >>= 1;
+		index++;
+	}
+
+	return index;
+}
+
+static inline int64_t bucketUpperBound(unsigned int index)
+{
+	return ((int64_t) 1) << index;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+void LatencyHistogram::reset()
+{
+	memset(mBuckets, 0, sizeof(mBuckets));
+	mCount = 0;
+	mTotal = 0;
+	mMax = 0;
+}
+
+void LatencyHistogram::record(int64_t latencyUs)
+{
+	if (latencyUs < 0)
+		latencyUs = 0;
+
+	mBuckets[bucketIndex(latencyUs)]++;
+	mCount++;
+	mTotal += latencyUs;
+	if (latencyUs > mMax)
+		mMax = latencyUs;
+}
+
+int64_t LatencyHistogram::getPercentile(unsigned int percentile) const
+{
+	if (0 == mCount)
+		return 0;
+
+	uint64_t rank = (mCount * percentile + 99) / 100;
+	if (0 == rank)
+		rank = 1;
+
+	uint64_t seen = 0;
+	for (unsigned int i = 0; i < LATENCY_HISTOGRAM_BUCKETS - 1; i++)
+	{
+		seen += mBuckets[i];
+		if (seen >= rank)
+			return bucketUpperBound(i) < mMax ? bucketUpperBound(i) : mMax;
+	}
+
+	return mMax;
+}
+
+pbnjson::JValue LatencyHistogram::toJValue() const
+{
+	pbnjson::JValue histogramObj = pbnjson::Object();
+	histogramObj.put("count", (int64_t) mCount);
+	histogramObj.put("averageUs", getAverage());
+	histogramObj.put("p50Us", getPercentile(50));
+	histogramObj.put("p99Us", getPercentile(99));
+	histogramObj.put("maxUs", mMax);
+
+	pbnjson::JValue bucketsObj = pbnjson::Array();
+	for (unsigned int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+		bucketsObj.append((int64_t) mBuckets[i]);
+	histogramObj.put("bucketsLog2Us", bucketsObj);
+
+	return histogramObj;
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cstdint>
+
+#include <pbnjson.hpp>
+
+#define LATENCY_HISTOGRAM_BUCKETS 24
+
+/*
+ * Fixed size latency histogram with power-of-two microsecond buckets.
+ * Bucket 0 counts samples below 1us, bucket n samples in [2^(n-1), 2^n) us
+ * and the last bucket everything above. Recording is a handful of integer
+ * operations, so it can sit on hot paths.
+ */
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void record(int64_t latencyUs);
+	void reset();
+
+	uint64_t getCount() const { return mCount; }
+	int64_t getMax() const { return mMax; }
+	int64_t getAverage() const { return mCount ? mTotal / (int64_t) mCount : 0; }
+	// Upper bound of the bucket holding the requested percentile (0-100)
+	int64_t getPercentile(unsigned int percentile) const;
+
+	pbnjson::JValue toJValue() const;
+
+private:
+	uint64_t mBuckets[LATENCY_HISTOGRAM_BUCKETS];
+	uint64_t mCount;
+	int64_t mTotal;
+	int64_t mMax;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -48,5 +48,7 @@ extern PmLogContext logContext;
 #define MSGID_SUBSCRIPTION_CLIENT_DROPPED           "SUBSCRIPTION_CLIENT_DROPPED"
 #define MSGID_INCOMING_PAIR_REQ_FAIL                "INCOMING_PAIR_REQ_FAIL"
 #define MSGID_UNPAIR_FROM_ANCS_FAILED               "OUTGOING_UNPAIR_FROM_ANCS_FAIL"
+#define MSGID_PROFILE_STARTUP                       "PROFILE_STARTUP"
+#define MSGID_INVALID_SCHEMA                        "INVALID_SCHEMA"
 
 #endif // LOGGING_H
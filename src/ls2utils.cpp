@@ -1,3 +1,8 @@
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include <pbnjson.hpp>
 #include <luna-service2/lunaservice.hpp>
 #include "logging.h"
@@ -5,9 +10,18 @@
 
 void LSUtils::postToClient(LS::Message &message, pbnjson::JValue &object)
 {
+	// Failures reported from result callbacks count as well
+	if (object.hasKey("returnValue") && !object["returnValue"].asBool())
+		countErrorResponse(message.get());
+
 	std::string payload;
 	LSUtils::generatePayload(object, payload);
 
+	postToClient(message, payload);
+}
+
+void LSUtils::postToClient(LS::Message &message, const std::string &payload)
+{
 	try
 	{
 		message.respond(payload.c_str());
@@ -18,406 +32,258 @@ void LSUtils::postToClient(LS::Message &message, pbnjson::JValue &object)
 	}
 }
 
-#ifdef MULTI_SESSION_SUPPORT
+// Covers the SIL codes and ours, anything above is serialized every time
+#define MAX_CACHED_ERROR_CODE 1024
 
-#include <map>
-#include <string>
-
-std::map<std::string, std::string> sessionInfoMap;
+static_assert(LAST_ERROR_CODE < MAX_CACHED_ERROR_CODE, "MAX_CACHED_ERROR_CODE must cover every BluetoothErrorCode");
 
-LSUtils::DisplaySetId LSUtils::getDisplaySetIdIndex(LSMessage &message, LS::Handle *handle)
+typedef struct
 {
-	if (LSMessageGetSessionId(&message) != NULL)
-	{
-		std::string sessionId = LSMessageGetSessionId(&message);
-		BT_INFO("INFO_SESSION", 0, "session id is %s", sessionId.c_str());
+	const char *errorText;
+	// Without and with "subscribed": false
+	std::string payloads[2];
+} ConstantErrorResponse;
 
-		if (sessionId == "host")
-			return HOST;
+// Indexed by code. Filled once by buildConstantErrorResponses before any
+// responder thread starts and only read afterwards, so no locking.
+static std::vector<ConstantErrorResponse> constantErrorResponses;
 
-		pbnjson::JValue payload = pbnjson::Object();
-		payload.put("sessionId", sessionId.c_str());
-		pbnjson::JGenerator serializer(nullptr);
-		std::string payloadstr;
-		serializer.toString(payload, pbnjson::JSchema::AllSchema(), payloadstr);
+static std::string buildErrorPayload(const char *errorText, unsigned int errorCode, bool failedSubscription)
+{
+	pbnjson::JValue responseObj = pbnjson::Object();
 
-		auto it = sessionInfoMap.find(sessionId);
-		std::string deviceSetId;
-		if( it == sessionInfoMap.end())
-		{
-			auto reply = handle->callOneReply("luna://com.webos.service.account/getSession", payloadstr.c_str()).get();
-			pbnjson::JValue replyObj = pbnjson::Object();
-			LSUtils::parsePayload(reply.getPayload(), replyObj);
+	if (failedSubscription)
+		responseObj.put("subscribed", false);
+	responseObj.put("returnValue", false);
+	responseObj.put("errorText", errorText);
+	responseObj.put("errorCode", (int) errorCode);
 
-			bool returnValue = replyObj["returnValue"].asBool();
-			if (!returnValue) {
-				return HOST;
-			}
+	std::string payload;
+	LSUtils::generatePayload(responseObj, payload);
 
-			auto sessionInfo = replyObj["session"];
-			auto deviceInfo = sessionInfo["deviceSetInfo"];
-			deviceSetId = deviceInfo["deviceSetId"].asString();
+	return payload;
+}
 
-			sessionInfoMap[sessionId] = deviceSetId;
+static void addConstantErrorResponse(unsigned int errorCode, const char *errorText)
+{
+	ConstantErrorResponse &response = constantErrorResponses[errorCode];
+	if (response.errorText || !*errorText)
+		return;
 
-		}
-		else
-		{
-			deviceSetId = it->second;
-		}
+	response.errorText = errorText;
+	response.payloads[0] = buildErrorPayload(errorText, errorCode, false);
+	response.payloads[1] = buildErrorPayload(errorText, errorCode, true);
+}
 
-		BT_INFO("INFO_SESSION", 0, "deviceSetId %s", deviceSetId.c_str());
+void LSUtils::buildConstantErrorResponses()
+{
+	if (!constantErrorResponses.empty())
+		return;
 
-		return getDisplaySetIdIndex(deviceSetId);
-	}
+	constantErrorResponses.resize(MAX_CACHED_ERROR_CODE);
+	for (auto &response : constantErrorResponses)
+		response.errorText = NULL;
 
-	BT_INFO("INFO_SESSION", 0, "session is null");
+	// Unassigned numbers in our range have an empty text and are skipped
+	for (unsigned int errorCode = FIRST_ERROR_CODE; errorCode <= LAST_ERROR_CODE; errorCode++)
+		addConstantErrorResponse(errorCode, retrieveErrorText((BluetoothErrorCode) errorCode));
 
-	//failure
-	return HOST;
+	for (unsigned int errorCode = 0; errorCode < MAX_CACHED_ERROR_CODE; errorCode++)
+		addConstantErrorResponse(errorCode, retrieveErrorCodeText((BluetoothError) errorCode));
 }
 
-LSUtils::DisplaySetId LSUtils::getDisplaySetIdIndex(const std::string &deviceSetId)
+void LSUtils::respondWithConstantError(LS::Message &message, const char *errorText, unsigned int errorCode, bool failedSubscription)
 {
-	if ("RSE-L" == deviceSetId)
-	{
-		return RSE_L;
-	} else if ("RSE-R" == deviceSetId)
-	{
-		return RSE_R;
-	}
-	else if ("AVN" == deviceSetId)
+	countErrorResponse(message.get());
+
+	// The text tells which table the code came from, SIL and our codes are
+	// not guaranteed to stay apart
+	if (errorCode < constantErrorResponses.size() && constantErrorResponses[errorCode].errorText == errorText)
 	{
-		return AVN;
+		message.respond(constantErrorResponses[errorCode].payloads[failedSubscription ? 1 : 0].c_str());
+		return;
 	}
 
-	return HOST;
+	message.respond(buildErrorPayload(errorText, errorCode, failedSubscription).c_str());
 }
-#endif
 
-bool LSUtils::callDb8MeshFindToken(LS::Handle *serviceHandle, std::string &token)
-{
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/find",
-											"{\"query\":{ \"from\":\"com.webos.service.bluetooth2.meshtoken:1\"}}").get();
+static std::unordered_map<const char *, std::unique_ptr<PayloadSchema>> schemaCache;
+static std::unordered_map<std::string, std::unique_ptr<PayloadSchema>> dynamicSchemaCache;
+static uint64_t schemaCacheHits = 0;
+static uint64_t schemaCacheMisses = 0;
 
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
+static void logSchemaCompiled()
+{
+	schemaCacheMisses++;
+	BT_DEBUG("Compiled schema #%llu, cache hit rate %llu%%",
+			(unsigned long long) (schemaCache.size() + dynamicSchemaCache.size()),
+			(unsigned long long) (schemaCacheHits * 100 / (schemaCacheHits + schemaCacheMisses)));
+}
 
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
+static const PayloadSchema &lookupSchema(const char *schema)
+{
+	auto it = schemaCache.find(schema);
+	if (it != schemaCache.end())
 	{
-		BT_INFO("MESH", 0, "Db8 find API returned error: %d==%s : [%s : %d]",
-			replyObj["errorCode"].asNumber<int32_t>(), replyObj["errorText"].asString().c_str(),
-			__FUNCTION__, __LINE__);
-		return false;
+		schemaCacheHits++;
+		return *it->second;
 	}
 
-	BT_DEBUG("replyObj: %s", replyObj.stringify().c_str());
-	pbnjson::JValue results = replyObj["results"];
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
-		{
-			if (results[i].hasKey("meshToken"))
-			{
-				pbnjson::JValue meshEntry = results[i];
-				token = meshEntry["meshToken"].asString();
-				break;
-			}
-		}
+	it = schemaCache.insert(std::make_pair(schema,
+			std::unique_ptr<PayloadSchema>(new PayloadSchema(schema ? schema : "")))).first;
+	logSchemaCompiled();
 
-		BT_INFO("MESH", 0, "token received from db: %s", token.c_str());
-		return true;
-	}
-	return false;
+	return *it->second;
 }
 
-bool LSUtils::callDb8MeshSetToken(LS::Handle *serviceHandle, std::string &token)
+static const PayloadSchema &lookupSchema(const std::string &schema)
 {
-	pbnjson::JValue objArray = pbnjson::Array();
-	pbnjson::JValue tokenObj = pbnjson::Object();
-	pbnjson::JValue reqObj = pbnjson::Object();
+	auto it = dynamicSchemaCache.find(schema);
+	if (it != dynamicSchemaCache.end())
+	{
+		schemaCacheHits++;
+		return *it->second;
+	}
 
-	tokenObj.put("_kind", "com.webos.service.bluetooth2.meshtoken:1");
-	tokenObj.put("meshToken", token);
-	objArray.append(tokenObj);
-	reqObj.put("objects", objArray);
+	it = dynamicSchemaCache.insert(std::make_pair(schema,
+			std::unique_ptr<PayloadSchema>(new PayloadSchema(schema)))).first;
+	logSchemaCompiled();
 
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/put",
-											reqObj.stringify().c_str()).get();
+	return *it->second;
+}
 
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
+static bool parseWithSchema(const std::string &payload, pbnjson::JValue &object,
+                            const PayloadSchema &schema, PayloadValidation &validation)
+{
+	pbnjson::JDomParser parser;
 
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
+	if (!parser.parse(payload, pbnjson::JSchema::AllSchema()))
 	{
+		validation.status = PAYLOAD_SYNTAX_ERROR;
+		validation.path.clear();
 		return false;
 	}
-	return true;
-}
 
-bool LSUtils::callDb8MeshPutAppKey(LS::Handle *serviceHandle, uint16_t appKeyInex,
-									const std::string &appName)
-{
-	BT_INFO("MESH", 0, "appKeyInex: %d, appName: %s", appKeyInex, appName.c_str());
-
-	pbnjson::JValue objArray = pbnjson::Array();
-	pbnjson::JValue tokenObj = pbnjson::Object();
-	pbnjson::JValue reqObj = pbnjson::Object();
+	// The DOM is handed out even when validation fails so callers can
+	// still look at the members that were sent.
+	object = parser.getDom();
 
-	tokenObj.put("_kind", "com.webos.service.bluetooth2.meshappkey:1"); //kind for appkey:appname
-	tokenObj.put("appKey", appKeyInex);
-	tokenObj.put("appName", appName);
-	objArray.append(tokenObj);
-	reqObj.put("objects", objArray);
+	return schema.validate(object, validation);
+}
 
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/put",
-											reqObj.stringify().c_str()).get();
+static bool parseWithSchema(const std::string &payload, pbnjson::JValue &object,
+                            const PayloadSchema &schema, int *error)
+{
+	PayloadValidation validation;
 
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
+	if (parseWithSchema(payload, object, schema, validation))
+		return true;
 
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
+	if (validation.status != PAYLOAD_SYNTAX_ERROR)
 	{
-		return false;
+		// notify this is a schema error, so that caller can make further
+		// checks for throwing custom errors (particular key missing, etc)
+		*error = JSON_PARSE_SCHEMA_ERROR;
+		BT_DEBUG("Schema validation failed (%d) at '%s'", validation.status, validation.path.c_str());
 	}
-	return true;
+
+	return false;
 }
-bool LSUtils::callDb8MeshGetAppKeys(LS::Handle *serviceHandle, pbnjson::JValue &result)
-{
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/find",
-											"{\"query\":{ \"from\":\"com.webos.service.bluetooth2.meshappkey:1\"}}").get();
 
-	BT_INFO("MESH", 0, "After API is called : [%s : %d]", __FUNCTION__, __LINE__);
+bool LSUtils::parsePayload(const std::string &payload, pbnjson::JValue &object, const char *schema, int *error)
+{
+	return parseWithSchema(payload, object, lookupSchema(schema), error);
+}
 
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
+bool LSUtils::parsePayload(const std::string &payload, pbnjson::JValue &object, const std::string &schema, int *error)
+{
+	return parseWithSchema(payload, object, lookupSchema(schema), error);
+}
 
-	result = replyObj;
-	return true;
+bool LSUtils::parsePayload(const std::string &payload, pbnjson::JValue &object, const char *schema, PayloadValidation &validation)
+{
+	return parseWithSchema(payload, object, lookupSchema(schema), validation);
 }
 
-bool LSUtils::callDb8MeshGetNodeInfo(LS::Handle *serviceHandle, pbnjson::JValue &result)
+void LSUtils::getSchemaCacheStatistics(uint64_t &hits, uint64_t &misses)
 {
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/find",
-											"{\"query\":{ \"from\":\"com.webos.service.bluetooth2.meshnodeinfo:1\"}}").get();
+	hits = schemaCacheHits;
+	misses = schemaCacheMisses;
+}
 
-	BT_INFO("MESH", 0, "After API is called : [%s : %d]", __FUNCTION__, __LINE__);
+#ifdef MULTI_SESSION_SUPPORT
 
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
+#include <map>
+#include <string>
 
-	result = replyObj;
-	return true;
+std::map<std::string, std::string> sessionInfoMap;
 
-}
-bool LSUtils::callDb8MeshPutNodeInfo(LS::Handle *serviceHandle, uint16_t unicastAddress, const std::string &uuid, uint8_t count)
+LSUtils::DisplaySetId LSUtils::getDisplaySetIdIndex(LSMessage &message, LS::Handle *handle)
 {
-	pbnjson::JValue objArray = pbnjson::Array();
-	pbnjson::JValue nodeInfoObj = pbnjson::Object();
-	pbnjson::JValue reqObj = pbnjson::Object();
-	pbnjson::JValue appKeyIndexesObjArr = pbnjson::Array();
-
-	nodeInfoObj.put("_kind", "com.webos.service.bluetooth2.meshnodeinfo:1");
-	nodeInfoObj.put("unicastAddress", unicastAddress);
-	nodeInfoObj.put("uuid", uuid);
-	nodeInfoObj.put("count", count);
-	nodeInfoObj.put("netKeyIndex", 0);
-	nodeInfoObj.put("appKeyIndexes", appKeyIndexesObjArr);
-	objArray.append(nodeInfoObj);
-	reqObj.put("objects", objArray);
-
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/put",
-											reqObj.stringify().c_str()).get();
-
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
-
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
+	if (LSMessageGetSessionId(&message) != NULL)
 	{
-		return false;
-	}
-	return true;
-}
+		std::string sessionId = LSMessageGetSessionId(&message);
+		BT_INFO("INFO_SESSION", 0, "session id is %s", sessionId.c_str());
 
-std::string LSUtils::getObjectID(LS::Handle *serviceHandle, uint16_t unicastAddress)
-{
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/find",
-											"{\"query\":{ \"from\":\"com.webos.service.bluetooth2.meshnodeinfo:1\"}}").get();
-  std::string id;
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
-
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
-	{
-		BT_INFO("MESH", 0, "Db8 find API returned error: %d==%s : [%s : %d]",
-			replyObj["errorCode"].asNumber<int32_t>(), replyObj["errorText"].asString().c_str(),
-			__FUNCTION__, __LINE__);
-		return id;
-	}
+		if (sessionId == "host")
+			return HOST;
 
-	BT_DEBUG("replyObj: %s", replyObj.stringify().c_str());
-	pbnjson::JValue resultsObj = pbnjson::Array();
-	pbnjson::JValue results = replyObj["results"];
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
+		pbnjson::JValue payload = pbnjson::Object();
+		payload.put("sessionId", sessionId.c_str());
+		pbnjson::JGenerator serializer(nullptr);
+		std::string payloadstr;
+		serializer.toString(payload, pbnjson::JSchema::AllSchema(), payloadstr);
+
+		auto it = sessionInfoMap.find(sessionId);
+		std::string deviceSetId;
+		if( it == sessionInfoMap.end())
 		{
-			if (results[i].hasKey("unicastAddress"))
-			{
-				pbnjson::JValue meshEntry = results[i];
-				if(unicastAddress == meshEntry["unicastAddress"].asNumber<int32_t>())
-				{
-					return meshEntry["_id"].asString();
-				}
+			auto reply = handle->callOneReply("luna://com.webos.service.account/getSession", payloadstr.c_str()).get();
+			pbnjson::JValue replyObj = pbnjson::Object();
+			LSUtils::parsePayload(reply.getPayload(), replyObj);
+
+			bool returnValue = replyObj["returnValue"].asBool();
+			if (!returnValue) {
+				return HOST;
 			}
-		}
-	}
-	return id;
-}
 
-std::string LSUtils::getObjectIDByUUID(LS::Handle *serviceHandle, const std::string &uuid)
-{
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/find",
-											"{\"query\":{ \"from\":\"com.webos.service.bluetooth2.meshnodeinfo:1\"}}").get();
-  std::string id;
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
-
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
-	{
-		BT_INFO("MESH", 0, "Db8 find API returned error: %d==%s : [%s : %d]",
-			replyObj["errorCode"].asNumber<int32_t>(), replyObj["errorText"].asString().c_str(),
-			__FUNCTION__, __LINE__);
-		return id;
-	}
+			auto sessionInfo = replyObj["session"];
+			auto deviceInfo = sessionInfo["deviceSetInfo"];
+			deviceSetId = deviceInfo["deviceSetId"].asString();
 
-	BT_DEBUG("replyObj: %s", replyObj.stringify().c_str());
-	pbnjson::JValue resultsObj = pbnjson::Array();
-	pbnjson::JValue results = replyObj["results"];
-	if (results.isValid() && (results.arraySize() > 0))
-	{
-		for (int i = 0; i < results.arraySize(); ++i)
+			sessionInfoMap[sessionId] = deviceSetId;
+
+		}
+		else
 		{
-			if (results[i].hasKey("uuid"))
-			{
-				pbnjson::JValue meshEntry = results[i];
-				if(uuid == meshEntry["uuid"].asString())
-				{
-					return meshEntry["_id"].asString();
-				}
-			}
+			deviceSetId = it->second;
 		}
-	}
-	return id;
-}
 
-bool LSUtils::callDb8MeshDeleteNode(LS::Handle *serviceHandle, uint16_t unicastAddress)
-{
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
+		BT_INFO("INFO_SESSION", 0, "deviceSetId %s", deviceSetId.c_str());
 
-	std::string id =  getObjectID(serviceHandle, unicastAddress);
-	if(id.empty())
-	{
-		BT_INFO("MESH", 0, "unicastAddress is not present in db: %d", unicastAddress);
-		return true;
+		return getDisplaySetIdIndex(deviceSetId);
 	}
 
-	bool returnValue = callDb8DeleteId(serviceHandle, id);
-	if (!returnValue)
-	{
-		BT_INFO("MESH", 0, "delete id from db failed: %s", id.c_str());
-		return false;
-	}
+	BT_INFO("INFO_SESSION", 0, "session is null");
 
-	BT_INFO("MESH", 0, "delete id from db success: %s", id.c_str());
-	return true;
+	//failure
+	return HOST;
 }
 
-bool LSUtils::callDb8DeleteId(LS::Handle *serviceHandle, const std::string &id)
+LSUtils::DisplaySetId LSUtils::getDisplaySetIdIndex(const std::string &deviceSetId)
 {
-
-	pbnjson::JValue objArray = pbnjson::Array();
-	pbnjson::JValue nodeInfoObj = pbnjson::Object();
-	pbnjson::JValue reqObj = pbnjson::Object();
-
-	objArray.append(id);
-	reqObj.put("ids", objArray);
-
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/del",
-											reqObj.stringify().c_str()).get();
-
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
-
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
+	if ("RSE-L" == deviceSetId)
 	{
-		return false;
-	}
-	return true;
-}
-
-bool LSUtils::callDb8UpdateAppkey(LS::Handle *serviceHandle, uint16_t unicastAddress, std::vector<uint16_t> appKeyIndexes)
-{
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
-
-	std::string id =  getObjectID(serviceHandle, unicastAddress);
-	if(id.empty())
+		return RSE_L;
+	} else if ("RSE-R" == deviceSetId)
 	{
-		BT_INFO("MESH", 0, "unicastAddress is not present in db: %d", unicastAddress);
-		return true;
+		return RSE_R;
 	}
-	bool returnValue = callDb8UpdateId(serviceHandle, id, appKeyIndexes);
-	if (!returnValue)
+	else if ("AVN" == deviceSetId)
 	{
-		BT_INFO("MESH", 0, "Update appkeys for unicastAddress %d failed", unicastAddress);
-		return false;
+		return AVN;
 	}
 
-	BT_INFO("MESH", 0, "Update appkeys for unicastAddress %d success", unicastAddress);
-	return true;
+	return HOST;
 }
-
-bool LSUtils::callDb8UpdateId(LS::Handle *serviceHandle, const std::string &id, std::vector<uint16_t> appKeyIndexes)
-{
-	BT_INFO("MESH", 0, "API is called : [%s : %d]", __FUNCTION__, __LINE__);
-
-	pbnjson::JValue objArray = pbnjson::Array();
-	pbnjson::JValue tokenObj = pbnjson::Object();
-	pbnjson::JValue reqObj = pbnjson::Object();
-
-	pbnjson::JValue appKeyIndexesArray = pbnjson::Array();
-
-	for (unsigned int i = 0; i < appKeyIndexes.size(); i++)
-		appKeyIndexesArray.append(appKeyIndexes[i]);
-
-
-	tokenObj.put("_id", id);
-	tokenObj.put("appKeyIndexes", appKeyIndexesArray);
-	objArray.append(tokenObj);
-	reqObj.put("objects", objArray);
-
-	auto reply = serviceHandle->callOneReply("luna://com.webos.service.db/merge",
-											reqObj.stringify().c_str()).get();
-
-	pbnjson::JValue replyObj = pbnjson::Object();
-	LSUtils::parsePayload(reply.getPayload(), replyObj);
-
-	bool returnValue = replyObj["returnValue"].asBool();
-	if (!returnValue)
-	{
-		return false;
-	}
-	return true;
-}
\ No newline at end of file
+#endif
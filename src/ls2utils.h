@@ -22,7 +22,10 @@
 #include <pbnjson.hpp>
 #include <luna-service2/lunaservice.hpp>
 #include "bluetootherrors.h"
+#include "payloadschema.h"
+#include "lsmethodstatistics.h"
 #include <vector>
+#include <functional>
 
 #define LS_CATEGORY_TABLE_NAME(name) name##_table
 
@@ -33,12 +36,19 @@
 	typedef cl cl_t; \
 	constexpr static const LSMethod LS_CATEGORY_TABLE_NAME(name)[] = {
 
+// All category methods are dispatched through LSUtils::instrumentedMethodWrapper
+// so call counts and latencies are recorded per method
+#undef LS_CATEGORY_METHOD
+#define LS_CATEGORY_METHOD(name, ...) { #name, \
+	&LSUtils::instrumentedMethodWrapper<cl_t, &cl_t::name>, \
+	static_cast<LSMethodFlags>(__VA_ARGS__ + 0) },
+
 #define LS_CATEGORY_MAPPED_METHOD(name, func) { #name, \
-	&LS::Handle::methodWraper<cl_t, &cl_t::func>, \
+	&LSUtils::instrumentedMethodWrapper<cl_t, &cl_t::func>, \
 	static_cast<LSMethodFlags>(0) },
 
 #define LS_CATEGORY_CLASS_METHOD(cls, name) { #name, \
-	&LS::Handle::methodWraper<cls, &cls::name>, \
+	&LSUtils::instrumentedMethodWrapper<cls, &cls::name>, \
 	static_cast<LSMethodFlags>(0) },
 
 #define LS_CREATE_CATEGORY_END \
@@ -112,36 +122,22 @@ inline bool parsePayload(const std::string &payload, pbnjson::JValue &object)
 }
 
 
-inline bool parsePayload(const std::string &payload, pbnjson::JValue &object, const std::string &schema, int *error)
-{
-	pbnjson::JSchema parseSchema = pbnjson::JSchema::AllSchema();
-	if (schema.length() > 0)
-		parseSchema = pbnjson::JSchemaFragment(schema);
-
-	pbnjson::JDomParser parser;
+// Schemas are compiled once and cached for the process lifetime. The
+// const char * variant is keyed by the schema literal's address and is the
+// one every handler should use; the std::string variant is keyed by content.
+bool parsePayload(const std::string &payload, pbnjson::JValue &object, const char *schema, int *error);
+bool parsePayload(const std::string &payload, pbnjson::JValue &object, const std::string &schema, int *error);
 
-	if (!parser.parse(payload, parseSchema))
-	{
-		if (strstr(parser.getError(), "parse error") != NULL)
-		{
-			// notify this is a schema error, so that caller can make further
-			// checks for throwing custom errors (particular key missing, etc)
-			pbnjson::JSchema parseSchema = pbnjson::JSchema::AllSchema();
-			if (parser.parse(payload, parseSchema))
-			{
-				*error = JSON_PARSE_SCHEMA_ERROR;
-				object = parser.getDom();
-			}
-		}
-		return false;
-	}
+// Single parse that reports why a request was rejected. On a schema failure
+// object still holds the parsed request.
+bool parsePayload(const std::string &payload, pbnjson::JValue &object, const char *schema, PayloadValidation &validation);
 
-	object = parser.getDom();
-	return true;
-}
+void getSchemaCacheStatistics(uint64_t &hits, uint64_t &misses);
 
 inline void respondWithError(LS::Message &message, const std::string& errorText, unsigned int errorCode = -1, bool failedSubscription = false)
 {
+	countErrorResponse(message.get());
+
 	pbnjson::JValue responseObj = pbnjson::Object();
 
 	if (failedSubscription)
@@ -162,26 +158,33 @@ inline void respondWithError(LSMessage *message, const std::string& errorText, u
 	respondWithError(msg, errorText, errorCode);
 }
 
+// Errors carrying just the fixed text of their code are serialized once per
+// code and reused, a client hammering us with bad input costs no DOM builds.
+// The responses are built by buildConstantErrorResponses, which has to run
+// before anything can respond off the main thread.
+void buildConstantErrorResponses();
+void respondWithConstantError(LS::Message &message, const char *errorText, unsigned int errorCode, bool failedSubscription);
+
 inline void respondWithError(LS::Message &message, BluetoothErrorCode errorCode, bool failedSubscription = false)
 {
-	respondWithError(message, retrieveErrorText(errorCode), errorCode, failedSubscription);
+	respondWithConstantError(message, retrieveErrorText(errorCode), errorCode, failedSubscription);
 }
 
 inline void respondWithError(LSMessage *message, BluetoothErrorCode errorCode, bool failedSubscription = false)
 {
 	LS::Message msg(message);
-	respondWithError(msg, retrieveErrorText(errorCode), errorCode, failedSubscription);
+	respondWithConstantError(msg, retrieveErrorText(errorCode), errorCode, failedSubscription);
 }
 
 inline void respondWithError(LS::Message &message, BluetoothError error, bool failedSubscription = false)
 {
-	respondWithError(message, retrieveErrorCodeText(error), error, failedSubscription);
+	respondWithConstantError(message, retrieveErrorCodeText(error), error, failedSubscription);
 }
 
 inline void respondWithError(LSMessage *message, BluetoothError error, bool failedSubscription = false)
 {
 	LS::Message msg(message);
-	respondWithError(msg, retrieveErrorCodeText(error), error, failedSubscription);
+	respondWithConstantError(msg, retrieveErrorCodeText(error), error, failedSubscription);
 }
 
 inline void respondWithError(LSMessage *message, const std::string& errorText, BluetoothErrorCode errorCode, bool failedSubscription = false)
@@ -198,7 +201,13 @@ inline void postToSubscriptionPoint(LS::SubscriptionPoint *subscriptionPoint, pb
 	subscriptionPoint->post(payload.c_str());
 }
 
+inline void postToSubscriptionPoint(LS::SubscriptionPoint *subscriptionPoint, const std::string &payload)
+{
+	subscriptionPoint->post(payload.c_str());
+}
+
 void postToClient(LS::Message &message, pbnjson::JValue &object);
+void postToClient(LS::Message &message, const std::string &payload);
 
 inline void postToClient(LSMessage *message, pbnjson::JValue &object)
 {
@@ -209,6 +218,15 @@ inline void postToClient(LSMessage *message, pbnjson::JValue &object)
 	postToClient(request, object);
 }
 
+inline void postToClient(LSMessage *message, const std::string &payload)
+{
+	if (!message)
+		return;
+
+	LS::Message request(message);
+	postToClient(request, payload);
+}
+
 #ifdef MULTI_SESSION_SUPPORT
 enum DisplaySetId
 {
@@ -221,20 +239,6 @@ enum DisplaySetId
 DisplaySetId getDisplaySetIdIndex(LSMessage &message, LS::Handle *handle);
 DisplaySetId getDisplaySetIdIndex(const std::string &deviceSetId);
 #endif
-
-bool callDb8MeshFindToken(LS::Handle *serviceHandle, std::string &token);
-bool callDb8MeshSetToken(LS::Handle *serviceHandle, std::string &token);
-bool callDb8MeshPutAppKey(LS::Handle *serviceHandle, uint16_t appKeyInex,
-							const std::string &appName);
-bool callDb8MeshGetAppKeys(LS::Handle *serviceHandle, pbnjson::JValue &result);
-bool callDb8MeshGetNodeInfo(LS::Handle *serviceHandle, pbnjson::JValue &result);
-bool callDb8MeshPutNodeInfo(LS::Handle *serviceHandle, uint16_t unicastAddress, const std::string &uuid, uint8_t count);
-bool callDb8MeshDeleteNode(LS::Handle *serviceHandle, uint16_t unicastAddress);
-bool callDb8DeleteId(LS::Handle *serviceHandle, const std::string &id);
-bool callDb8UpdateAppkey(LS::Handle *serviceHandle, uint16_t unicastAddress, std::vector<uint16_t> appKeyIndexes);
-std::string getObjectID(LS::Handle *serviceHandle, uint16_t unicastAddress);
-std::string getObjectIDByUUID(LS::Handle *serviceHandle, const std::string &uuid);
-bool callDb8UpdateId(LS::Handle *serviceHandle, const std::string &id, std::vector<uint16_t> appKeyIndexes);
 } // namespace LSUtils
 
 #endif
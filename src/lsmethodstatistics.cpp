@@ -0,0 +1,92 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "lsmethodstatistics.h"
+#include "logging.h"
+
+static std::vector<std::unique_ptr<LSUtils::MethodStatistics>> methodStatistics;
+static std::unordered_map<std::string, LSUtils::MethodStatistics*> methodStatisticsByName;
+
+LSUtils::MethodStatistics *LSUtils::registerMethodStatistics(LSMessage *message)
+{
+	const char *category = LSMessageGetCategory(message);
+	const char *method = LSMessageGetMethod(message);
+
+	MethodStatistics *statistics = new MethodStatistics();
+	statistics->category = category ? category : "";
+	statistics->name = statistics->category + "/" + (method ? method : "");
+	statistics->calls = 0;
+	statistics->errors = 0;
+
+	methodStatistics.push_back(std::unique_ptr<MethodStatistics>(statistics));
+	methodStatisticsByName[statistics->name] = statistics;
+
+	return statistics;
+}
+
+void LSUtils::countErrorResponse(LSMessage *message)
+{
+	if (!message)
+		return;
+
+	const char *category = LSMessageGetCategory(message);
+	const char *method = LSMessageGetMethod(message);
+
+	// Errors are rare enough to afford building the name here
+	auto statisticsIter = methodStatisticsByName.find(std::string(category ? category : "") + "/" + (method ? method : ""));
+	if (statisticsIter != methodStatisticsByName.end())
+		statisticsIter->second->errors++;
+}
+
+pbnjson::JValue LSUtils::getMethodStatistics()
+{
+	pbnjson::JValue methodsObj = pbnjson::Array();
+
+	for (auto &statistics : methodStatistics)
+	{
+		pbnjson::JValue methodObj = pbnjson::Object();
+		methodObj.put("method", statistics->name);
+		methodObj.put("calls", (int64_t) statistics->calls);
+		methodObj.put("errors", (int64_t) statistics->errors);
+		methodObj.put("latency", statistics->latency.toJValue());
+		methodsObj.append(methodObj);
+	}
+
+	return methodsObj;
+}
+
+void LSUtils::logMethodStatistics()
+{
+	for (auto &statistics : methodStatistics)
+	{
+		if (0 == statistics->calls)
+			continue;
+
+		BT_INFO("LS2_METHOD_STATS", 0, "%s calls %llu errors %llu avg %lldus p50 %lldus p99 %lldus max %lldus",
+				statistics->name.c_str(),
+				(unsigned long long) statistics->calls,
+				(unsigned long long) statistics->errors,
+				(long long) statistics->latency.getAverage(),
+				(long long) statistics->latency.getPercentile(50),
+				(long long) statistics->latency.getPercentile(99),
+				(long long) statistics->latency.getMax());
+	}
+}
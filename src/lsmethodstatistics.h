@@ -0,0 +1,107 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef LSMETHODSTATISTICS_H
+#define LSMETHODSTATISTICS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <time.h>
+
+#include <pbnjson.hpp>
+#include <luna-service2/lunaservice.h>
+
+#include "firstcallhook.h"
+#include "latencyhistogram.h"
+#include "mainloopwatchdog.h"
+
+namespace LSUtils
+{
+
+typedef struct
+{
+	std::string category;
+	std::string name;
+	uint64_t calls;
+	uint64_t errors;
+	LatencyHistogram latency;
+} MethodStatistics;
+
+MethodStatistics *registerMethodStatistics(LSMessage *message);
+
+// Counts an error response against the method the request was sent to, no
+// matter whether the handler or a later callback responds
+void countErrorResponse(LSMessage *message);
+
+pbnjson::JValue getMethodStatistics();
+void logMethodStatistics();
+
+inline int64_t methodClockUs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// The slots of one handler, one per category it is registered in. Profile
+// handlers are shared by every profile category, so there are a few at most.
+inline MethodStatistics *findMethodStatistics(std::vector<MethodStatistics*> &slots, LSMessage *message)
+{
+	const char *category = LSMessageGetCategory(message);
+
+	for (auto slot : slots)
+	{
+		if (slot->category == (category ? category : ""))
+			return slot;
+	}
+
+	slots.push_back(registerMethodStatistics(message));
+
+	return slots.back();
+}
+
+/*
+ * Replacement for LS::Handle::methodWraper used by the LS_CATEGORY_*METHOD
+ * macros. Each (class, method) pair keeps its statistics slots per category,
+ * so the per call cost is a short lookup, two clock reads and a histogram
+ * update.
+ */
+template<typename ClassT, bool (ClassT::*MethT)(LSMessage&)>
+bool instrumentedMethodWrapper(LSHandle *handle, LSMessage *message, void *context)
+{
+	static std::vector<MethodStatistics*> slots;
+	MethodStatistics *statistics = findMethodStatistics(slots, message);
+
+	if (firstCallHooksPending)
+		runFirstCallHook(context);
+
+	int64_t start = methodClockUs();
+	bool result = (static_cast<ClassT*>(context)->*MethT)(*message);
+	int64_t duration = methodClockUs() - start;
+
+	statistics->calls++;
+	statistics->latency.record(duration);
+
+	MainLoopWatchdog::recordDispatch(statistics->name.c_str(), duration);
+
+	return result;
+}
+
+} // namespace LSUtils
+
+#endif // LSMETHODSTATISTICS_H
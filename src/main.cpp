@@ -17,7 +17,12 @@
 #include "bluetoothpairstate.h"
 #include "bluetoothmanagerservice.h"
 #include "config.h"
+#include "eventqueue.h"
 #include "logging.h"
+#include "ls2utils.h"
+#include "mainloopwatchdog.h"
+#include "responseworkerpool.h"
+#include "startuptimeline.h"
 #include "utils.h"
 
 
@@ -26,10 +31,13 @@ PmLogContext logContext;
 static const char* const logContextName = "webos-bluetooth-service";
 
 static gboolean option_version = FALSE;
+static gint option_stall_threshold = WEBOS_BLUETOOTH_STALL_THRESHOLD;
 
 static GOptionEntry options[] = {
 	{ "version", 'v', 0, G_OPTION_ARG_NONE, &option_version,
 	  "Show version information and exit" },
+	{ "stall-threshold", 's', 0, G_OPTION_ARG_INT, &option_stall_threshold,
+	  "Log main loop stalls longer than the given milliseconds (0 disables)" },
 	{ NULL },
 };
 
@@ -65,6 +73,7 @@ int main(int argc, char **argv)
 		GError *err = NULL;
 
 		write_kernel_log("[bt_time] execute main ");
+		StartupTimeline::start();
 
 		context = g_option_context_new(NULL);
 		g_option_context_add_main_entries(context, options, NULL);
@@ -96,13 +105,25 @@ int main(int argc, char **argv)
 		signal(SIGINT, term_handler);
 		mainLoop = g_main_loop_new(NULL, FALSE);
 
+		if (option_stall_threshold > 0)
+			MainLoopWatchdog::start(option_stall_threshold, WEBOS_BLUETOOTH_STALL_PROBE_INTERVAL);
+
+		LSUtils::buildConstantErrorResponses();
+		ResponseWorkerPool::start(WEBOS_BLUETOOTH_RESPONSE_WORKERS);
+		EventQueue::start();
+
 		BT_DEBUG("Starting bluetooth manager service");
 
+		int64_t managerStart = g_get_monotonic_time();
 		BluetoothManagerService manager; // manager creator throw the LS:Error but can't {}
+		StartupTimeline::record("managerService", managerStart);
         manager.attachToLoop(mainLoop);
 
 		g_main_loop_run(mainLoop);
 
+		EventQueue::stop();
+		ResponseWorkerPool::stop();
+		MainLoopWatchdog::stop();
 		g_main_loop_unref(mainLoop);
 
 	}
@@ -0,0 +1,252 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <map>
+#include <string>
+
+#include "mainloopwatchdog.h"
+#include "latencyhistogram.h"
+#include "logging.h"
+
+#define MSGID_MAIN_LOOP_STALL		"MAIN_LOOP_STALL"
+#define MSGID_SLOW_DISPATCH			"MAIN_LOOP_SLOW_DISPATCH"
+
+typedef struct
+{
+	uint64_t count;
+	int64_t maxUs;
+} SlowDispatch;
+
+typedef struct
+{
+	const char *name;
+	GSourceFunc function;
+	GIOFunc ioFunction;
+	gpointer data;
+} TimedSource;
+
+static GSource *probeSource = NULL;
+static int64_t thresholdUs = 0;
+static int64_t probeIntervalUs = 0;
+static int64_t nextProbeTime = 0;
+
+static uint64_t stallCount = 0;
+static LatencyHistogram probeDelay;
+static LatencyHistogram dispatchDuration;
+static std::map<std::string, SlowDispatch> slowDispatches;
+// Slowest dispatch since the last probe, blamed when the probe is late
+static const char *slowestRecentName = NULL;
+static int64_t slowestRecentUs = 0;
+
+static gboolean handleProbe(gpointer userData)
+{
+	int64_t now = g_get_monotonic_time();
+	int64_t delay = now - nextProbeTime;
+	if (delay < 0)
+		delay = 0;
+
+	probeDelay.record(delay);
+
+	if (delay > thresholdUs)
+	{
+		stallCount++;
+		if (slowestRecentName)
+			BT_WARNING(MSGID_MAIN_LOOP_STALL, 0, "Main loop blocked for %lld ms, slowest dispatch %s took %lld ms",
+					   (long long) delay / 1000, slowestRecentName, (long long) slowestRecentUs / 1000);
+		else
+			BT_WARNING(MSGID_MAIN_LOOP_STALL, 0, "Main loop blocked for %lld ms outside of our handlers",
+					   (long long) delay / 1000);
+	}
+
+	slowestRecentName = NULL;
+	slowestRecentUs = 0;
+	nextProbeTime = now + probeIntervalUs;
+
+	return TRUE;
+}
+
+void MainLoopWatchdog::start(unsigned int thresholdMs, unsigned int probeIntervalMs)
+{
+	if (probeSource || 0 == thresholdMs || 0 == probeIntervalMs)
+		return;
+
+	thresholdUs = (int64_t) thresholdMs * 1000;
+	probeIntervalUs = (int64_t) probeIntervalMs * 1000;
+	nextProbeTime = g_get_monotonic_time() + probeIntervalUs;
+
+	probeSource = g_timeout_source_new(probeIntervalMs);
+	g_source_set_priority(probeSource, G_PRIORITY_HIGH);
+	g_source_set_callback(probeSource, handleProbe, NULL, NULL);
+	g_source_attach(probeSource, NULL);
+
+	BT_INFO(MSGID_MAIN_LOOP_STALL, 0, "Main loop watchdog started, threshold %u ms, probe every %u ms",
+			thresholdMs, probeIntervalMs);
+}
+
+void MainLoopWatchdog::stop()
+{
+	if (!probeSource)
+		return;
+
+	g_source_destroy(probeSource);
+	g_source_unref(probeSource);
+	probeSource = NULL;
+}
+
+bool MainLoopWatchdog::isRunning()
+{
+	return probeSource != NULL;
+}
+
+void MainLoopWatchdog::recordDispatch(const char *name, int64_t durationUs)
+{
+	if (!probeSource)
+		return;
+
+	dispatchDuration.record(durationUs);
+
+	if (durationUs > slowestRecentUs)
+	{
+		slowestRecentName = name;
+		slowestRecentUs = durationUs;
+	}
+
+	if (durationUs <= thresholdUs)
+		return;
+
+	SlowDispatch &slowDispatch = slowDispatches[name];
+	slowDispatch.count++;
+	if (durationUs > slowDispatch.maxUs)
+		slowDispatch.maxUs = durationUs;
+
+	BT_WARNING(MSGID_SLOW_DISPATCH, 0, "%s took %lld ms", name, (long long) durationUs / 1000);
+}
+
+static gboolean dispatchTimedSource(gpointer userData)
+{
+	TimedSource *source = static_cast<TimedSource*>(userData);
+
+	int64_t start = g_get_monotonic_time();
+	gboolean result = source->function(source->data);
+	MainLoopWatchdog::recordDispatch(source->name, g_get_monotonic_time() - start);
+
+	return result;
+}
+
+static gboolean dispatchTimedIoWatch(GIOChannel *channel, GIOCondition condition, gpointer userData)
+{
+	TimedSource *source = static_cast<TimedSource*>(userData);
+
+	int64_t start = g_get_monotonic_time();
+	gboolean result = source->ioFunction(channel, condition, source->data);
+	MainLoopWatchdog::recordDispatch(source->name, g_get_monotonic_time() - start);
+
+	return result;
+}
+
+static void freeTimedSource(gpointer userData)
+{
+	delete static_cast<TimedSource*>(userData);
+}
+
+static TimedSource *newTimedSource(const char *name, GSourceFunc function, GIOFunc ioFunction, gpointer data)
+{
+	TimedSource *source = new TimedSource;
+	source->name = name;
+	source->function = function;
+	source->ioFunction = ioFunction;
+	source->data = data;
+
+	return source;
+}
+
+guint MainLoopWatchdog::addTimeout(const char *name, guint interval, GSourceFunc function, gpointer data)
+{
+	if (!probeSource)
+		return g_timeout_add(interval, function, data);
+
+	return g_timeout_add_full(G_PRIORITY_DEFAULT, interval, dispatchTimedSource,
+							  newTimedSource(name, function, NULL, data), freeTimedSource);
+}
+
+guint MainLoopWatchdog::addTimeoutSeconds(const char *name, guint interval, GSourceFunc function, gpointer data)
+{
+	if (!probeSource)
+		return g_timeout_add_seconds(interval, function, data);
+
+	return g_timeout_add_seconds_full(G_PRIORITY_DEFAULT, interval, dispatchTimedSource,
+									  newTimedSource(name, function, NULL, data), freeTimedSource);
+}
+
+guint MainLoopWatchdog::addIdle(const char *name, GSourceFunc function, gpointer data)
+{
+	if (!probeSource)
+		return g_idle_add(function, data);
+
+	return g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, dispatchTimedSource,
+						   newTimedSource(name, function, NULL, data), freeTimedSource);
+}
+
+guint MainLoopWatchdog::addIoWatch(const char *name, GIOChannel *channel, GIOCondition condition,
+								   GIOFunc function, gpointer data)
+{
+	if (!probeSource)
+		return g_io_add_watch(channel, condition, function, data);
+
+	return g_io_add_watch_full(channel, G_PRIORITY_DEFAULT, condition, dispatchTimedIoWatch,
+							   newTimedSource(name, NULL, function, data), freeTimedSource);
+}
+
+pbnjson::JValue MainLoopWatchdog::getStatistics()
+{
+	pbnjson::JValue statisticsObj = pbnjson::Object();
+	statisticsObj.put("enabled", isRunning());
+	if (!isRunning())
+		return statisticsObj;
+
+	pbnjson::JValue slowDispatchesObj = pbnjson::Array();
+	for (auto &slowDispatch : slowDispatches)
+	{
+		pbnjson::JValue slowDispatchObj = pbnjson::Object();
+		slowDispatchObj.put("name", slowDispatch.first);
+		slowDispatchObj.put("count", (int64_t) slowDispatch.second.count);
+		slowDispatchObj.put("maxUs", (int64_t) slowDispatch.second.maxUs);
+		slowDispatchesObj.append(slowDispatchObj);
+	}
+
+	statisticsObj.put("thresholdMs", (int64_t) (thresholdUs / 1000));
+	statisticsObj.put("stalls", (int64_t) stallCount);
+	statisticsObj.put("probeDelay", probeDelay.toJValue());
+	statisticsObj.put("dispatch", dispatchDuration.toJValue());
+	statisticsObj.put("slowDispatches", slowDispatchesObj);
+
+	return statisticsObj;
+}
+
+void MainLoopWatchdog::logStatistics()
+{
+	if (!isRunning())
+		return;
+
+	BT_INFO(MSGID_MAIN_LOOP_STALL, 0, "stalls %llu probe delay p50 %lldus p99 %lldus max %lldus dispatch p99 %lldus max %lldus",
+			(unsigned long long) stallCount,
+			(long long) probeDelay.getPercentile(50),
+			(long long) probeDelay.getPercentile(99),
+			(long long) probeDelay.getMax(),
+			(long long) dispatchDuration.getPercentile(99),
+			(long long) dispatchDuration.getMax());
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef MAINLOOPWATCHDOG_H
+#define MAINLOOPWATCHDOG_H
+
+#include <cstdint>
+
+#include <glib.h>
+#include <pbnjson.hpp>
+
+/*
+ * Opt-in stall detector for the single main loop everything runs on.
+ *
+ * A high priority probe fires every probe interval and records how late it
+ * was dispatched, which is how long the loop was busy with something else.
+ * Our own sources (luna handlers and the timers, idles and watches added
+ * through the helpers below) additionally time each dispatch, so a stall
+ * can be pinned to a handler. Either going above the threshold is logged.
+ *
+ * While the watchdog is not started the helpers add plain GLib sources.
+ */
+namespace MainLoopWatchdog
+{
+
+void start(unsigned int thresholdMs, unsigned int probeIntervalMs);
+void stop();
+bool isRunning();
+
+// Time spent dispatching one of our sources, name must outlive the call
+void recordDispatch(const char *name, int64_t durationUs);
+
+guint addTimeout(const char *name, guint interval, GSourceFunc function, gpointer data);
+guint addTimeoutSeconds(const char *name, guint interval, GSourceFunc function, gpointer data);
+guint addIdle(const char *name, GSourceFunc function, gpointer data);
+guint addIoWatch(const char *name, GIOChannel *channel, GIOCondition condition, GIOFunc function, gpointer data);
+
+pbnjson::JValue getStatistics();
+void logStatistics();
+
+} // namespace MainLoopWatchdog
+
+#endif // MAINLOOPWATCHDOG_H
@@ -0,0 +1,240 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <cmath>
+
+#include "payloadschema.h"
+#include "logging.h"
+
+PayloadSchema::Node::Node() :
+	type(TYPE_ANY),
+	additionalProperties(true)
+{
+}
+
+PayloadSchema::PayloadSchema(const std::string &schema) :
+	mValid(true)
+{
+	if (schema.empty())
+		return;
+
+	pbnjson::JDomParser parser;
+	if (!parser.parse(schema, pbnjson::JSchema::AllSchema()))
+	{
+		BT_ERROR(MSGID_INVALID_SCHEMA, 0, "Invalid schema %s: %s", schema.c_str(), parser.getError());
+		mValid = false;
+		return;
+	}
+
+	if (!compile(parser.getDom(), mRoot))
+	{
+		BT_ERROR(MSGID_INVALID_SCHEMA, 0, "Unsupported schema %s", schema.c_str());
+		mValid = false;
+	}
+}
+
+bool PayloadSchema::compile(const pbnjson::JValue &schemaObj, Node &node)
+{
+	if (!schemaObj.isObject())
+		return false;
+
+	if (schemaObj.hasKey("type"))
+	{
+		std::string type = schemaObj["type"].asString();
+
+		if (type == "object")
+			node.type = TYPE_OBJECT;
+		else if (type == "array")
+			node.type = TYPE_ARRAY;
+		else if (type == "string")
+			node.type = TYPE_STRING;
+		else if (type == "integer")
+			node.type = TYPE_INTEGER;
+		else if (type == "number")
+			node.type = TYPE_NUMBER;
+		else if (type == "boolean")
+			node.type = TYPE_BOOLEAN;
+		else if (type == "null")
+			node.type = TYPE_NULL;
+		else
+			return false;
+	}
+
+	if (schemaObj.hasKey("properties"))
+	{
+		for (const pbnjson::JValue::KeyValue &property : schemaObj["properties"].children())
+		{
+			Property rule;
+			rule.name = property.first.asString();
+			rule.node.reset(new Node());
+			if (!compile(property.second, *rule.node))
+				return false;
+			node.properties.push_back(std::move(rule));
+		}
+	}
+
+	if (schemaObj.hasKey("required"))
+	{
+		pbnjson::JValue requiredObj = schemaObj["required"];
+		for (int i = 0; i < requiredObj.arraySize(); i++)
+			node.required.push_back(requiredObj[i].asString());
+	}
+
+	if (schemaObj.hasKey("additionalProperties"))
+		node.additionalProperties = schemaObj["additionalProperties"].asBool();
+
+	if (schemaObj.hasKey("items"))
+	{
+		node.items.reset(new Node());
+		if (!compile(schemaObj["items"], *node.items))
+			return false;
+	}
+
+	if (schemaObj.hasKey("enum"))
+		node.enumValues = schemaObj["enum"];
+
+	return true;
+}
+
+bool PayloadSchema::matchesType(Type type, const pbnjson::JValue &value)
+{
+	switch (type)
+	{
+	case TYPE_ANY:
+		return true;
+	case TYPE_OBJECT:
+		return value.isObject();
+	case TYPE_ARRAY:
+		return value.isArray();
+	case TYPE_STRING:
+		return value.isString();
+	case TYPE_INTEGER:
+		if (!value.isNumber())
+			return false;
+		else
+		{
+			double number = value.asNumber<double>();
+			return std::floor(number) == number;
+		}
+	case TYPE_NUMBER:
+		return value.isNumber();
+	case TYPE_BOOLEAN:
+		return value.isBoolean();
+	case TYPE_NULL:
+		return value.isNull();
+	}
+
+	return false;
+}
+
+bool PayloadSchema::validate(const pbnjson::JValue &value, PayloadValidation &validation) const
+{
+	validation.path.clear();
+
+	if (!mValid)
+	{
+		validation.status = PAYLOAD_INVALID_SCHEMA;
+		return false;
+	}
+
+	validation.status = PAYLOAD_VALID;
+
+	return validateNode(mRoot, value, std::string(), validation);
+}
+
+bool PayloadSchema::validateNode(const Node &node, const pbnjson::JValue &value,
+                                 const std::string &path, PayloadValidation &validation)
+{
+	if (!matchesType(node.type, value))
+	{
+		validation.status = PAYLOAD_TYPE_MISMATCH;
+		validation.path = path;
+		return false;
+	}
+
+	if (node.enumValues.isArray())
+	{
+		bool allowed = false;
+		for (int i = 0; i < node.enumValues.arraySize() && !allowed; i++)
+			allowed = (node.enumValues[i] == value);
+
+		if (!allowed)
+		{
+			validation.status = PAYLOAD_VALUE_NOT_ALLOWED;
+			validation.path = path;
+			return false;
+		}
+	}
+
+	if (value.isObject())
+	{
+		std::string prefix = path.empty() ? path : path + ".";
+
+		// Required keys are reported first, so handlers can keep mapping a
+		// missing key to its dedicated error code.
+		for (const std::string &key : node.required)
+		{
+			if (!value.hasKey(key))
+			{
+				validation.status = PAYLOAD_MISSING_KEY;
+				validation.path = prefix + key;
+				return false;
+			}
+		}
+
+		for (const Property &property : node.properties)
+		{
+			if (value.hasKey(property.name) &&
+			    !validateNode(*property.node, value[property.name], prefix + property.name, validation))
+				return false;
+		}
+
+		if (!node.additionalProperties)
+		{
+			for (const pbnjson::JValue::KeyValue &member : value.children())
+			{
+				std::string key = member.first.asString();
+				bool known = false;
+				for (const Property &property : node.properties)
+				{
+					if (property.name == key)
+					{
+						known = true;
+						break;
+					}
+				}
+
+				if (!known)
+				{
+					validation.status = PAYLOAD_UNEXPECTED_KEY;
+					validation.path = prefix + key;
+					return false;
+				}
+			}
+		}
+	}
+	else if (value.isArray() && node.items)
+	{
+		for (int i = 0; i < value.arraySize(); i++)
+		{
+			if (!validateNode(*node.items, value[i], path + "[" + std::to_string(i) + "]", validation))
+				return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef PAYLOADSCHEMA_H
+#define PAYLOADSCHEMA_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pbnjson.hpp>
+
+enum PayloadStatus
+{
+	PAYLOAD_VALID,
+	PAYLOAD_SYNTAX_ERROR,
+	PAYLOAD_MISSING_KEY,
+	PAYLOAD_TYPE_MISMATCH,
+	PAYLOAD_VALUE_NOT_ALLOWED,
+	PAYLOAD_UNEXPECTED_KEY,
+	// The schema itself could not be compiled, nothing validates against it
+	PAYLOAD_INVALID_SCHEMA
+};
+
+typedef struct
+{
+	PayloadStatus status;
+	// Path of the offending member, e.g. "address" or "settings.txPower"
+	// or "characteristics[2].value". Empty for syntax errors.
+	std::string path;
+} PayloadValidation;
+
+/*
+ * Compiled form of the request schemas built with the STRICT_SCHEMA /
+ * RELAXED_SCHEMA macros from ls2utils.h. It covers the subset of JSON schema
+ * those macros produce (type, properties, required, additionalProperties,
+ * enum and items) and validates an already parsed DOM, so a request is
+ * parsed exactly once and a failure reports which member was wrong.
+ * A schema that does not compile rejects every payload.
+ */
+class PayloadSchema
+{
+public:
+	explicit PayloadSchema(const std::string &schema);
+
+	bool validate(const pbnjson::JValue &value, PayloadValidation &validation) const;
+
+private:
+	enum Type
+	{
+		TYPE_ANY,
+		TYPE_OBJECT,
+		TYPE_ARRAY,
+		TYPE_STRING,
+		TYPE_INTEGER,
+		TYPE_NUMBER,
+		TYPE_BOOLEAN,
+		TYPE_NULL
+	};
+
+	struct Node;
+
+	typedef struct
+	{
+		std::string name;
+		std::unique_ptr<Node> node;
+	} Property;
+
+	struct Node
+	{
+		Node();
+
+		Type type;
+		std::vector<Property> properties;
+		std::vector<std::string> required;
+		bool additionalProperties;
+		std::unique_ptr<Node> items;
+		pbnjson::JValue enumValues;
+	};
+
+	static bool compile(const pbnjson::JValue &schemaObj, Node &node);
+	static bool validateNode(const Node &node, const pbnjson::JValue &value,
+	                         const std::string &path, PayloadValidation &validation);
+	static bool matchesType(Type type, const pbnjson::JValue &value);
+
+	Node mRoot;
+	bool mValid;
+};
+
+#endif // PAYLOADSCHEMA_H
@@ -0,0 +1,142 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glib.h>
+
+#include "responseworkerpool.h"
+#include "ls2utils.h"
+#include "logging.h"
+
+#define MSGID_RESPONSE_WORKER_POOL	"RESPONSE_WORKER_POOL"
+
+// Below this many items the thread hop costs more than serializing inline
+#define INLINE_SERIALIZE_MAX_ITEMS	64
+
+typedef struct
+{
+	LSMessage *message;
+	ResponseWorkerPool::SerializeFunction serialize;
+} Job;
+
+typedef struct
+{
+	LSMessage *message;
+	std::string payload;
+} Completion;
+
+static std::mutex jobsMutex;
+static std::condition_variable jobsCondition;
+static std::deque<Job> jobs;
+static bool stopping = false;
+static std::vector<std::thread> workers;
+
+static gboolean deliverCompletion(gpointer userData)
+{
+	Completion *completion = static_cast<Completion*>(userData);
+
+	LSUtils::postToClient(completion->message, completion->payload);
+	LSMessageUnref(completion->message);
+	delete completion;
+
+	return FALSE;
+}
+
+static void runWorker()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobsMutex);
+			jobsCondition.wait(lock, [] { return stopping || !jobs.empty(); });
+			if (stopping)
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		Completion *completion = new Completion;
+		completion->message = job.message;
+		completion->payload = job.serialize();
+
+		// g_idle_add is safe to call from any thread and wakes up the main loop
+		g_idle_add_full(G_PRIORITY_DEFAULT, deliverCompletion, completion, NULL);
+	}
+}
+
+void ResponseWorkerPool::start(unsigned int count)
+{
+	if (!workers.empty() || 0 == count)
+		return;
+
+	stopping = false;
+	for (unsigned int i = 0; i < count; i++)
+		workers.push_back(std::thread(runWorker));
+
+	BT_INFO(MSGID_RESPONSE_WORKER_POOL, 0, "Started %u response serialization workers", count);
+}
+
+void ResponseWorkerPool::stop()
+{
+	if (workers.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		stopping = true;
+	}
+	jobsCondition.notify_all();
+
+	for (auto &worker : workers)
+		worker.join();
+	workers.clear();
+
+	// Nobody is going to answer these anymore
+	for (auto &job : jobs)
+		LSMessageUnref(job.message);
+	jobs.clear();
+}
+
+void ResponseWorkerPool::respond(LSMessage *message, size_t itemCount, SerializeFunction serialize)
+{
+	if (!message)
+		return;
+
+	if (workers.empty() || itemCount < INLINE_SERIALIZE_MAX_ITEMS)
+	{
+		LSUtils::postToClient(message, serialize());
+		return;
+	}
+
+	LSMessageRef(message);
+
+	Job job;
+	job.message = message;
+	job.serialize = std::move(serialize);
+	{
+		std::lock_guard<std::mutex> lock(jobsMutex);
+		jobs.push_back(std::move(job));
+	}
+	jobsCondition.notify_one();
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef RESPONSEWORKERPOOL_H
+#define RESPONSEWORKERPOOL_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include <luna-service2/lunaservice.h>
+
+/*
+ * Worker threads that serialize large luna responses off the main loop.
+ *
+ * The serialize function runs on a worker and must only use data it owns,
+ * i.e. a snapshot captured by value; it must not touch service state. The
+ * payload it returns is posted back to the main loop and sent there, so a
+ * directory listing with thousands of entries no longer holds up HID or
+ * AVRCP pass-through notifications while it is being built.
+ *
+ * Small responses, and all of them while the pool is not started, are
+ * serialized inline where the thread hop would cost more than it saves.
+ */
+namespace ResponseWorkerPool
+{
+
+typedef std::function<std::string()> SerializeFunction;
+
+void start(unsigned int workers);
+void stop();
+
+void respond(LSMessage *message, size_t itemCount, SerializeFunction serialize);
+
+} // namespace ResponseWorkerPool
+
+#endif // RESPONSEWORKERPOOL_H
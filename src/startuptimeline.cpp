@@ -0,0 +1,157 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include <cstring>
+#include <vector>
+
+#include <glib.h>
+
+#include "startuptimeline.h"
+#include "logging.h"
+
+// Bounds the timeline if the service sees many adapters before finishing
+#define MAX_STARTUP_EVENTS		128
+
+typedef struct
+{
+	const char *event;
+	std::string detail;
+	int64_t startUs;
+	int64_t durationUs;
+} StartupEvent;
+
+static int64_t startTime = 0;
+static int64_t finishTime = 0;
+static std::vector<StartupEvent> startupEvents;
+static std::vector<const char*> expectedEvents;
+
+static bool takeExpectedEvent(const char *event)
+{
+	for (auto expected = expectedEvents.begin(); expected != expectedEvents.end(); ++expected)
+	{
+		if (0 == strcmp(*expected, event))
+		{
+			expectedEvents.erase(expected);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void addEvent(const char *event, const std::string &detail, int64_t eventStart, int64_t now)
+{
+	if (0 == startTime || startupEvents.size() >= MAX_STARTUP_EVENTS)
+		return;
+
+	bool late = finishTime != 0;
+	if (late && !takeExpectedEvent(event))
+		return;
+
+	StartupEvent startupEvent;
+	startupEvent.event = event;
+	startupEvent.detail = detail;
+	startupEvent.startUs = eventStart - startTime;
+	startupEvent.durationUs = now - eventStart;
+	startupEvents.push_back(startupEvent);
+
+	// The summary has been logged already
+	if (late)
+		BT_INFO(MSGID_PROFILE_STARTUP, 0, "+%lld us %s%s%s took %lld us, after startup finished",
+				(long long) startupEvent.startUs, event, detail.empty() ? "" : " ", detail.c_str(),
+				(long long) startupEvent.durationUs);
+}
+
+void StartupTimeline::start()
+{
+	if (startTime)
+		return;
+
+	startTime = g_get_monotonic_time();
+	startupEvents.reserve(32);
+}
+
+void StartupTimeline::finish()
+{
+	if (0 == startTime || finishTime)
+		return;
+
+	finishTime = g_get_monotonic_time();
+	logSummary();
+}
+
+bool StartupTimeline::isFinished()
+{
+	return finishTime != 0;
+}
+
+void StartupTimeline::expect(const char *event)
+{
+	if (0 == startTime)
+		return;
+
+	expectedEvents.push_back(event);
+}
+
+void StartupTimeline::mark(const char *event, const std::string &detail)
+{
+	int64_t now = g_get_monotonic_time();
+	addEvent(event, detail, now, now);
+}
+
+void StartupTimeline::record(const char *event, int64_t eventStart, const std::string &detail)
+{
+	addEvent(event, detail, eventStart, g_get_monotonic_time());
+}
+
+pbnjson::JValue StartupTimeline::getTimeline()
+{
+	pbnjson::JValue eventsObj = pbnjson::Array();
+	for (auto &startupEvent : startupEvents)
+	{
+		pbnjson::JValue eventObj = pbnjson::Object();
+		eventObj.put("event", startupEvent.event);
+		if (!startupEvent.detail.empty())
+			eventObj.put("detail", startupEvent.detail);
+		eventObj.put("startUs", (int64_t) startupEvent.startUs);
+		eventObj.put("durationUs", (int64_t) startupEvent.durationUs);
+		eventsObj.append(eventObj);
+	}
+
+	pbnjson::JValue timelineObj = pbnjson::Object();
+	timelineObj.put("finished", isFinished());
+	if (isFinished())
+		timelineObj.put("totalUs", (int64_t) (finishTime - startTime));
+	timelineObj.put("events", eventsObj);
+
+	return timelineObj;
+}
+
+void StartupTimeline::logSummary()
+{
+	for (auto &startupEvent : startupEvents)
+	{
+		BT_INFO(MSGID_PROFILE_STARTUP, 0, "+%lld us %s%s%s took %lld us",
+				(long long) startupEvent.startUs, startupEvent.event,
+				startupEvent.detail.empty() ? "" : " ", startupEvent.detail.c_str(),
+				(long long) startupEvent.durationUs);
+	}
+
+	if (isFinished())
+		BT_INFO(MSGID_PROFILE_STARTUP, 0, "Startup finished after %lld us, %zu steps recorded",
+				(long long) (finishTime - startTime), startupEvents.size());
+}
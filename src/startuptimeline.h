@@ -0,0 +1,54 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+#ifndef STARTUPTIMELINE_H
+#define STARTUPTIMELINE_H
+
+#include <cstdint>
+#include <string>
+
+#include <pbnjson.hpp>
+
+/*
+ * Monotonic timeline of the service startup, from main() until the default
+ * adapter has its profiles bound. Each entry records when a step started
+ * relative to start() and how long it took (0 for plain marks).
+ *
+ * The timeline is closed by finish(), which logs a summary; steps recorded
+ * afterwards are ignored so the timeline stays a picture of the boot, except
+ * for milestones announced with expect() that are known to come later.
+ */
+namespace StartupTimeline
+{
+
+void start();
+void finish();
+bool isFinished();
+// Lets the next step named event land even after finish(), once
+void expect(const char *event);
+
+// Point in time without a duration, event must outlive the timeline
+void mark(const char *event, const std::string &detail = std::string());
+// Step that started at startTime (g_get_monotonic_time) and ends now
+void record(const char *event, int64_t startTime, const std::string &detail = std::string());
+
+pbnjson::JValue getTimeline();
+void logSummary();
+
+} // namespace StartupTimeline
+
+#endif // STARTUPTIMELINE_H
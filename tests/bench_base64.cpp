@@ -0,0 +1,212 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/*
+ * Base64 codec against g_base64_encode/g_base64_decode, which SPP used
+ * before.
+ *
+ * The output of both is first compared for every size up to a few blocks
+ * of the vector paths and for inputs the lenient decoder has to handle
+ * (characters outside the alphabet, missing padding, embedded NUL); any
+ * difference makes the run fail. Then both encode and decode payloads of
+ * the sizes SPP sees, up to the 5 KiB readData buffer and a large write,
+ * and MB/s is reported. The codec works on a reused buffer as in the
+ * service, glib allocates the result every time.
+ *
+ * Usage: bench_base64 [megabytes per size]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+#include "base64codec.h"
+
+static std::vector<uint8_t> makeData(size_t size)
+{
+	std::vector<uint8_t> data(size);
+	uint32_t state = 2463534242u;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		data[i] = (uint8_t) state;
+	}
+
+	return data;
+}
+
+static bool checkDecode(const std::string &encoded)
+{
+	gsize glibSize = 0;
+	guchar *glibData = g_base64_decode(encoded.c_str(), &glibSize);
+
+	std::vector<uint8_t> decoded;
+	Base64::decode(encoded, decoded);
+
+	bool same = decoded.size() == glibSize && (0 == glibSize || 0 == memcmp(decoded.data(), glibData, glibSize));
+	if (!same)
+		printf("MISMATCH decoding \"%s\": %zu bytes, glib %zu bytes\n", encoded.c_str(), decoded.size(), (size_t) glibSize);
+
+	g_free(glibData);
+
+	return same;
+}
+
+static int compare()
+{
+	int mismatches = 0;
+
+	// Every tail length around the 48 byte NEON and 12 byte SSSE3 blocks
+	for (size_t size = 0; size <= 200; size++)
+	{
+		std::vector<uint8_t> data = makeData(size);
+
+		gchar *glibEncoded = g_base64_encode(data.data(), data.size());
+		std::string encoded;
+		Base64::encode(data.data(), data.size(), encoded);
+
+		if (encoded != glibEncoded)
+		{
+			printf("MISMATCH encoding %zu bytes:\n  glib:  %s\n  codec: %s\n", size, glibEncoded, encoded.c_str());
+			mismatches++;
+		}
+
+		if (!checkDecode(glibEncoded))
+			mismatches++;
+
+		g_free(glibEncoded);
+	}
+
+	const std::string lenientInputs[] = {
+		"",
+		"QQ",
+		"QUI",
+		"QUJD\nREVG\n",
+		"QU JD RE VG",
+		"QUJD!!!!REVG",
+		"QUJDREVG====",
+		"QQ==QUI=",
+		"=QUJD",
+		"!!!!",
+		std::string("QUJD\0REVG", 9),
+	};
+
+	for (auto &input : lenientInputs)
+	{
+		if (!checkDecode(input))
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+static double toMegabytesPerSecond(size_t bytes, std::chrono::steady_clock::duration elapsed)
+{
+	double seconds = std::chrono::duration<double>(elapsed).count();
+	return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0;
+}
+
+static void measure(size_t size, size_t megabytes)
+{
+	std::vector<uint8_t> data = makeData(size);
+	size_t iterations = std::max<size_t>(1, megabytes * 1024 * 1024 / size);
+	size_t check = 0;
+
+	gchar *glibEncoded = g_base64_encode(data.data(), data.size());
+	std::string encoded = glibEncoded;
+	g_free(glibEncoded);
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++)
+	{
+		gchar *result = g_base64_encode(data.data(), data.size());
+		check += result[0];
+		g_free(result);
+	}
+	double glibEncode = toMegabytesPerSecond(size * iterations, std::chrono::steady_clock::now() - start);
+
+	std::string encodeBuffer;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++)
+	{
+		Base64::encode(data.data(), data.size(), encodeBuffer);
+		check += encodeBuffer[0];
+	}
+	double codecEncode = toMegabytesPerSecond(size * iterations, std::chrono::steady_clock::now() - start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++)
+	{
+		gsize resultSize = 0;
+		guchar *result = g_base64_decode(encoded.c_str(), &resultSize);
+		check += result[0];
+		g_free(result);
+	}
+	double glibDecode = toMegabytesPerSecond(size * iterations, std::chrono::steady_clock::now() - start);
+
+	std::vector<uint8_t> decodeBuffer;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++)
+	{
+		Base64::decode(encoded, decodeBuffer);
+		check += decodeBuffer[0];
+	}
+	double codecDecode = toMegabytesPerSecond(size * iterations, std::chrono::steady_clock::now() - start);
+
+	printf("%8zu %14.1f %14.1f %8.1fx %14.1f %14.1f %8.1fx\n", size, glibEncode, codecEncode,
+		   glibEncode > 0 ? codecEncode / glibEncode : 0.0, glibDecode, codecDecode,
+		   glibDecode > 0 ? codecDecode / glibDecode : 0.0);
+
+	// Keeps the loops from being optimized away
+	if (1 == check)
+		printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 64;
+	if (0 == megabytes)
+		megabytes = 64;
+
+	int mismatches = compare();
+	if (mismatches)
+	{
+		printf("%d results differ from glib\n", mismatches);
+		return 1;
+	}
+
+	printf("All results match glib\n\n");
+	printf("%8s %14s %14s %9s %14s %14s %9s\n", "bytes", "glib enc MB/s", "codec enc MB/s", "speedup",
+		   "glib dec MB/s", "codec dec MB/s", "speedup");
+
+	// Typical SPP chunks, the readData buffer and a large writeData
+	const size_t sizes[] = { 20, 64, 256, 1024, 5 * 1024, 64 * 1024 };
+	for (size_t size : sizes)
+		measure(size, megabytes);
+
+	return 0;
+}
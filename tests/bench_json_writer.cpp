@@ -0,0 +1,366 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/*
+ * JsonWriter against building a pbnjson object and serializing it with
+ * LSUtils::generatePayload.
+ *
+ * Every notification written with JsonWriter in the service is rebuilt here
+ * both ways with the same keys in the same order. The payloads are first
+ * compared byte for byte, together with strings that need escaping and
+ * integer edge cases; any difference is printed and makes the run fail.
+ * Then each message is written repeatedly and the time and allocations per
+ * message are reported for both.
+ *
+ * Usage: bench_json_writer [iterations]
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <pbnjson.hpp>
+
+#include "jsonwriter.h"
+#include "ls2utils.h"
+
+static uint64_t allocationCount = 0;
+static bool countAllocations = false;
+
+void *operator new(size_t size)
+{
+	if (countAllocations)
+		allocationCount++;
+
+	void *pointer = malloc(size ? size : 1);
+	if (!pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+	free(pointer);
+}
+
+typedef struct
+{
+	const char *name;
+	std::function<void(JsonWriter &writer)> write;
+	std::function<pbnjson::JValue()> build;
+} Message;
+
+static const std::string adapterAddress = "00:11:22:33:44:55";
+static const std::string deviceAddress = "66:77:88:99:aa:bb";
+
+// A full readData notification carries the base64 of a 5 KiB data buffer
+static std::string makeBase64Data()
+{
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string data;
+	for (size_t i = 0; i < 6828; i++)
+		data += alphabet[(i * 7) % 64];
+	data += "==";
+
+	return data;
+}
+
+static std::vector<Message> makeNotifications()
+{
+	static const std::string base64Data = makeBase64Data();
+	static const std::vector<uint8_t> meshData = { 0x82, 0x04, 0x01, 0x00, 0xff, 0x10, 0x7f, 0x80 };
+	static const std::vector<uint8_t> characteristicValue = { 0x00, 0x5a, 0x01, 0xff, 0x20, 0x03 };
+
+	std::vector<Message> messages;
+
+	// ChannelManager::postToReadDataSubscriber
+	messages.push_back({ "spp readData", [](JsonWriter &writer) {
+		writer.beginObject();
+		writer.put("returnValue", true);
+		writer.put("adapterAddress", adapterAddress);
+		writer.put("subscribed", true);
+		writer.put("channelId", "001");
+		writer.put("data", base64Data);
+		writer.endObject();
+	}, []() {
+		pbnjson::JValue object = pbnjson::Object();
+		object.put("returnValue", true);
+		object.put("adapterAddress", adapterAddress);
+		object.put("subscribed", true);
+		object.put("channelId", std::string("001"));
+		object.put("data", base64Data);
+		return object;
+	} });
+
+	// BluetoothAvrcpProfileService::mediaPlayStatusReceived
+	messages.push_back({ "avrcp playStatus", [](JsonWriter &writer) {
+		writer.beginObject();
+		writer.put("returnValue", true);
+		writer.put("subscribed", true);
+		writer.put("address", deviceAddress);
+		writer.put("adapterAddress", adapterAddress);
+		writer.beginObject("playbackStatus");
+		writer.put("duration", (int32_t) 245000);
+		writer.put("position", (int32_t) 61234);
+		writer.put("status", "playing");
+		writer.endObject();
+		writer.endObject();
+	}, []() {
+		pbnjson::JValue object = pbnjson::Object();
+		object.put("returnValue", true);
+		object.put("subscribed", true);
+		object.put("address", deviceAddress);
+		object.put("adapterAddress", adapterAddress);
+		pbnjson::JValue playbackStatusObj = pbnjson::Object();
+		playbackStatusObj.put("duration", (int32_t) 245000);
+		playbackStatusObj.put("position", (int32_t) 61234);
+		playbackStatusObj.put("status", std::string("playing"));
+		object.put("playbackStatus", playbackStatusObj);
+		return object;
+	} });
+
+	// BluetoothMeshProfileService::modelDataReceived
+	messages.push_back({ "mesh receive", [](JsonWriter &writer) {
+		writer.beginObject();
+		writer.put("srcAddress", (int32_t) 0x0102);
+		writer.put("destAddress", (int32_t) 0xc001);
+		writer.beginArray("data");
+		for (auto byte : meshData)
+			writer.append((int32_t) byte);
+		writer.endArray();
+		writer.put("subscribed", true);
+		writer.put("returnValue", true);
+		writer.put("adapterAddress", adapterAddress);
+		writer.endObject();
+	}, []() {
+		pbnjson::JValue object = pbnjson::Object();
+		object.put("srcAddress", (int32_t) 0x0102);
+		object.put("destAddress", (int32_t) 0xc001);
+		pbnjson::JValue dataArray = pbnjson::Array();
+		for (auto byte : meshData)
+			dataArray.append((int32_t) byte);
+		object.put("data", dataArray);
+		object.put("subscribed", true);
+		object.put("returnValue", true);
+		object.put("adapterAddress", adapterAddress);
+		return object;
+	} });
+
+	// BluetoothGattProfileService::writeCharacteristicChanged
+	messages.push_back({ "gatt changed", [](JsonWriter &writer) {
+		writer.beginObject();
+		writer.put("returnValue", true);
+		writer.put("subscribed", true);
+		writer.put("adapterAddress", adapterAddress);
+		writer.put("address", deviceAddress);
+		writer.beginObject("changed");
+		writer.put("characteristic", "00002a37-0000-1000-8000-00805f9b34fb");
+		writer.beginObject("value");
+		writer.beginArray("bytes");
+		for (auto byte : characteristicValue)
+			writer.append((int32_t) byte);
+		writer.endArray();
+		writer.endObject();
+		writer.endObject();
+		writer.endObject();
+	}, []() {
+		pbnjson::JValue object = pbnjson::Object();
+		object.put("returnValue", true);
+		object.put("subscribed", true);
+		object.put("adapterAddress", adapterAddress);
+		object.put("address", deviceAddress);
+		pbnjson::JValue characteristicObj = pbnjson::Object();
+		characteristicObj.put("characteristic", std::string("00002a37-0000-1000-8000-00805f9b34fb"));
+		pbnjson::JValue valueObj = pbnjson::Object();
+		pbnjson::JValue bytesArray = pbnjson::Array();
+		for (auto byte : characteristicValue)
+			bytesArray.append((int32_t) byte);
+		valueObj.put("bytes", bytesArray);
+		characteristicObj.put("value", valueObj);
+		object.put("changed", characteristicObj);
+		return object;
+	} });
+
+	return messages;
+}
+
+static std::vector<Message> makeEdgeCases()
+{
+	std::vector<Message> messages;
+
+	const std::string strings[] = {
+		"",
+		"quote \" backslash \\ slash /",
+		"\b\f\n\r\t",
+		std::string("\x00\x01\x1f\x7f", 4),
+		"UTF-8 \xc3\xa4\xe2\x82\xac\xf0\x9f\x8e\xb5",
+		"</script>",
+	};
+
+	for (auto &value : strings)
+	{
+		messages.push_back({ "string", [value](JsonWriter &writer) {
+			writer.beginObject();
+			writer.put("value", value);
+			writer.endObject();
+		}, [value]() {
+			pbnjson::JValue object = pbnjson::Object();
+			object.put("value", value);
+			return object;
+		} });
+	}
+
+	const int64_t integers[] = {
+		0, -1, 255,
+		std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(),
+		std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(),
+	};
+
+	for (auto value : integers)
+	{
+		messages.push_back({ "integer", [value](JsonWriter &writer) {
+			writer.beginObject();
+			writer.put("value", value);
+			writer.beginArray("values");
+			writer.append(value);
+			writer.append(value);
+			writer.endArray();
+			writer.endObject();
+		}, [value]() {
+			pbnjson::JValue object = pbnjson::Object();
+			object.put("value", value);
+			pbnjson::JValue valuesArray = pbnjson::Array();
+			valuesArray.append(value);
+			valuesArray.append(value);
+			object.put("values", valuesArray);
+			return object;
+		} });
+	}
+
+	return messages;
+}
+
+static int compare(const std::vector<Message> &messages)
+{
+	int mismatches = 0;
+	JsonWriter writer;
+
+	for (auto &message : messages)
+	{
+		writer.reset();
+		message.write(writer);
+
+		std::string expected;
+		LSUtils::generatePayload(message.build(), expected);
+
+		if (writer.getPayload() == expected)
+			continue;
+
+		mismatches++;
+		printf("MISMATCH %s\n  pbnjson:    %s\n  JsonWriter: %s\n", message.name, expected.c_str(),
+			   writer.getPayload().c_str());
+	}
+
+	return mismatches;
+}
+
+static void measure(const Message &message, size_t iterations)
+{
+	JsonWriter writer;
+	size_t bytes = 0;
+
+	countAllocations = true;
+	allocationCount = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++)
+	{
+		std::string payload;
+		LSUtils::generatePayload(message.build(), payload);
+		bytes += payload.size();
+	}
+	auto end = std::chrono::steady_clock::now();
+	countAllocations = false;
+
+	double pbnjsonNs = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	double pbnjsonAllocations = (double) allocationCount / iterations;
+
+	// The writer is reused across messages as it is in the service
+	countAllocations = true;
+	allocationCount = 0;
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < iterations; i++)
+	{
+		writer.reset();
+		message.write(writer);
+		bytes += writer.getPayload().size();
+	}
+	end = std::chrono::steady_clock::now();
+	countAllocations = false;
+
+	double writerNs = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	double writerAllocations = (double) allocationCount / iterations;
+
+	printf("%-18s %8zu %12.0f %14.2f %12.0f %14.2f %8.1fx\n", message.name, writer.getPayload().size(),
+		   pbnjsonNs, pbnjsonAllocations, writerNs, writerAllocations, writerNs > 0 ? pbnjsonNs / writerNs : 0.0);
+
+	// Keeps the loops from being optimized away
+	if (0 == bytes)
+		printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	size_t iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+	if (0 == iterations)
+		iterations = 100000;
+
+	std::vector<Message> notifications = makeNotifications();
+
+	int mismatches = compare(notifications) + compare(makeEdgeCases());
+	if (mismatches)
+	{
+		printf("%d payloads differ from pbnjson\n", mismatches);
+		return 1;
+	}
+
+	printf("All payloads match pbnjson byte for byte\n\n");
+	printf("%-18s %8s %12s %14s %12s %14s %9s\n", "message", "bytes", "pbnjson ns", "pbnjson allocs",
+		   "writer ns", "writer allocs", "speedup");
+
+	for (auto &message : notifications)
+		measure(message, iterations);
+
+	return 0;
+}
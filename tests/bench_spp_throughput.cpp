@@ -0,0 +1,677 @@
+// Copyright (c) 2024 LG Electronics, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+
+/*
+ * SPP receive throughput of the luna (JSON/base64) path against the binary
+ * socket path, measured on the service itself.
+ *
+ * The benchmark is built from the service sources and runs the real
+ * BluetoothManagerService on the bus without a SIL. Its
+ * BluetoothSppProfileService gets a ChannelManager for a loopback adapter,
+ * and a loopback SPP profile stands in for the SIL's: it reports channel
+ * state on the main loop and hands chunks to dataReceived from its own
+ * thread, as the stack does. Everything from there on is the service code,
+ * the event queue, ChannelManager and the readData response for the luna
+ * path, BluetoothBinarySocket for the other one.
+ *
+ * The client is a second bus connection with its own main loop thread,
+ * subscribed to readData, or a thread reading the binary socket. A channel
+ * is created on behalf of an application id, which makes the service pick
+ * the binary socket for com.lge.watchmanager. As the stack can not be
+ * reached through the adapter checks of the luna API, connecting a channel
+ * and subscribing go through a /bench category with the same calls into
+ * ChannelManager the SPP methods make.
+ *
+ * Latency of every chunk is taken on the client side, from the SIL handing
+ * it over to the client holding its last byte (decoded for luna). The SIL
+ * keeps at most a receive window of data in flight, like RFCOMM credits do.
+ * C++ allocations are counted on the SIL and main loop threads.
+ *
+ * Run on the target with the Bluetooth service stopped and a hub that lets
+ * this binary take com.webos.service.bluetooth2 and call on behalf of
+ * applications, such as a development image. SPP has to be an enabled
+ * service class.
+ *
+ * Usage: bench_spp_throughput [megabytes per run]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <luna-service2/lunaservice.h>
+#include <pbnjson.hpp>
+
+#include "base64codec.h"
+#include "bluetoothbinarysocket.h"
+#include "bluetoothmanagerservice.h"
+#include "bluetoothsppprofileservice.h"
+#include "channelmanager.h"
+#include "clientwatch.h"
+#include "config.h"
+#include "eventqueue.h"
+#include "logging.h"
+#include "ls2utils.h"
+#include "responseworkerpool.h"
+
+#define SERVICE_NAME			"com.webos.service.bluetooth2"
+#define LOOPBACK_ADAPTER		"00:00:00:00:be:00"
+#define LOOPBACK_DEVICE			"00:00:00:00:be:01"
+#define LOOPBACK_UUID			"00001101-0000-1000-8000-00805f9b34fb"
+#define LUNA_CLIENT_APP_ID		"com.webos.app.sppbench"
+// isCallerUsingBinarySocket hands this application's channels to a socket
+#define BINARY_SOCKET_APP_ID	"com.lge.watchmanager"
+#define RECEIVE_WINDOW			(64 * 1024)
+// A run ends early when the client sees nothing for this long
+#define CLIENT_IDLE_TIMEOUT_MS	5000
+
+PmLogContext logContext;
+
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<bool> measuring(false);
+static thread_local bool countAllocations = false;
+
+void *operator new(size_t size)
+{
+	if (countAllocations && measuring.load(std::memory_order_relaxed))
+		allocationCount++;
+
+	void *pointer = malloc(size ? size : 1);
+	if (!pointer)
+		throw std::bad_alloc();
+
+	return pointer;
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+	free(pointer);
+}
+
+static int64_t nowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+typedef struct
+{
+	size_t chunkSize;
+	size_t chunks;
+	// Set by the SIL right before it hands chunk i over
+	std::unique_ptr<std::atomic<int64_t>[]> handedOverTime;
+	std::atomic<uint64_t> receivedBytes;
+	std::vector<int64_t> latencies;
+	size_t completedChunks;
+	int64_t lastReceivedTime;
+	std::mutex mutex;
+	std::condition_variable progress;
+} Run;
+
+// Client side, called for every payload received
+static void receivedPayload(Run &run, size_t size)
+{
+	std::lock_guard<std::mutex> lock(run.mutex);
+
+	uint64_t received = run.receivedBytes.load() + size;
+	int64_t now = nowUs();
+
+	for (; run.completedChunks < run.chunks && (run.completedChunks + 1) * run.chunkSize <= received; run.completedChunks++)
+		run.latencies.push_back(now - run.handedOverTime[run.completedChunks].load());
+
+	run.lastReceivedTime = now;
+	run.receivedBytes.store(received);
+	run.progress.notify_all();
+}
+
+/*
+ * Stands in for the SIL's BluetoothSppProfile: one channel to a loopback
+ * device, reported to the service through the observer calls the stack
+ * makes.
+ */
+class LoopbackSppProfile
+{
+public:
+	LoopbackSppProfile(BluetoothSppProfileService *observer) :
+		mObserver(observer),
+		mNextChannelId(1),
+		mChannelId(BLUETOOTH_SPP_CHANNEL_ID_INVALID)
+	{
+	}
+
+	// On the main loop, like the stack's channel state callbacks
+	void connectChannel()
+	{
+		mChannelId = mNextChannelId++;
+		mObserver->channelStateChanged(LOOPBACK_ADAPTER, LOOPBACK_DEVICE, LOOPBACK_UUID, mChannelId, true);
+	}
+
+	void disconnectChannel()
+	{
+		if (BLUETOOTH_SPP_CHANNEL_ID_INVALID == mChannelId)
+			return;
+
+		mObserver->channelStateChanged(LOOPBACK_ADAPTER, LOOPBACK_DEVICE, LOOPBACK_UUID, mChannelId, false);
+		mChannelId = BLUETOOTH_SPP_CHANNEL_ID_INVALID;
+	}
+
+	BluetoothSppChannelId getChannelId() const { return mChannelId; }
+
+	// The stack's reader thread
+	void receive(Run &run)
+	{
+		countAllocations = true;
+
+		std::vector<uint8_t> chunk(run.chunkSize);
+		for (size_t i = 0; i < chunk.size(); i++)
+			chunk[i] = (uint8_t) i;
+
+		uint64_t sentBytes = 0;
+		for (size_t i = 0; i < run.chunks; i++)
+		{
+			{
+				std::unique_lock<std::mutex> lock(run.mutex);
+				bool open = run.progress.wait_for(lock, std::chrono::milliseconds(CLIENT_IDLE_TIMEOUT_MS), [&run, sentBytes]() {
+					return sentBytes + run.chunkSize - run.receivedBytes.load() <= RECEIVE_WINDOW;
+				});
+				if (!open)
+					return;
+			}
+
+			chunk[0] = (uint8_t) i;
+			run.handedOverTime[i].store(nowUs());
+			mObserver->dataReceived(mChannelId, LOOPBACK_ADAPTER, chunk.data(), chunk.size());
+			sentBytes += run.chunkSize;
+		}
+	}
+
+private:
+	BluetoothSppProfileService *mObserver;
+	BluetoothSppChannelId mNextChannelId;
+	BluetoothSppChannelId mChannelId;
+};
+
+typedef struct
+{
+	ChannelManager *channelManager;
+	LoopbackSppProfile *profile;
+} Bench;
+
+static void respond(LSMessage *message, pbnjson::JValue responseObj)
+{
+	LSUtils::postToClient(message, responseObj);
+}
+
+// createChannel followed by the stack reporting the channel as connected
+static bool benchConnect(LSHandle *handle, LSMessage *message, void *context)
+{
+	Bench *bench = static_cast<Bench*>(context);
+
+	// The channel belongs to the application asking for it
+	bench->channelManager->addCreateChannelSubscripton(LOOPBACK_UUID, NULL, message);
+	bench->profile->connectChannel();
+	bench->channelManager->deleteCreateChannelSubscription(LOOPBACK_UUID);
+
+	pbnjson::JValue responseObj = pbnjson::Object();
+	responseObj.put("returnValue", true);
+	responseObj.put("channelId", bench->channelManager->getUserChannelId(bench->profile->getChannelId()));
+	respond(message, responseObj);
+
+	return true;
+}
+
+// What readData does for a subscription once the request is validated
+static bool benchReadData(LSHandle *handle, LSMessage *message, void *context)
+{
+	Bench *bench = static_cast<Bench*>(context);
+	std::string channelId = bench->channelManager->getUserChannelId(bench->profile->getChannelId());
+
+	LSUtils::ClientWatch *watch = new LSUtils::ClientWatch(handle, message, NULL);
+	std::string appName = bench->channelManager->getMessageOwner(message);
+	ChannelManager::ReadDataSubscriptionId readDataId = bench->channelManager->addReadDataSubscription(channelId, 0, watch, appName);
+	watch->setCallback(std::bind(&ChannelManager::readDataClientDropped, bench->channelManager, readDataId));
+
+	pbnjson::JValue responseObj = pbnjson::Object();
+	responseObj.put("returnValue", true);
+	responseObj.put("subscribed", true);
+	responseObj.put("channelId", channelId);
+	respond(message, responseObj);
+
+	return true;
+}
+
+static bool benchDisconnect(LSHandle *handle, LSMessage *message, void *context)
+{
+	Bench *bench = static_cast<Bench*>(context);
+	bench->profile->disconnectChannel();
+
+	pbnjson::JValue responseObj = pbnjson::Object();
+	responseObj.put("returnValue", true);
+	respond(message, responseObj);
+
+	return true;
+}
+
+static LSMethod benchMethods[] = {
+	{ "connect", benchConnect, LUNA_METHOD_FLAGS_NONE },
+	{ "readData", benchReadData, LUNA_METHOD_FLAGS_NONE },
+	{ "disconnect", benchDisconnect, LUNA_METHOD_FLAGS_NONE },
+	{ NULL, NULL, LUNA_METHOD_FLAGS_NONE },
+};
+
+/*
+ * The client's own bus connection. Calls are made on its main loop thread,
+ * a handle is only used from the thread dispatching it.
+ */
+class LunaClient
+{
+public:
+	LunaClient() : mHandle(NULL), mToken(LSMESSAGE_TOKEN_INVALID), mRun(NULL)
+	{
+		mContext = g_main_context_new();
+		mLoop = g_main_loop_new(mContext, FALSE);
+
+		LSError error;
+		LSErrorInit(&error);
+		if (!LSRegister(NULL, &mHandle, &error) || !LSGmainContextAttach(mHandle, mContext, &error))
+		{
+			fprintf(stderr, "Failed to set up the client bus connection: %s\n", error.message);
+			LSErrorFree(&error);
+			exit(1);
+		}
+
+		mThread = std::thread([this]() { g_main_loop_run(mLoop); });
+	}
+
+	~LunaClient()
+	{
+		invoke([this]() {
+			LSError error;
+			LSErrorInit(&error);
+			if (!LSUnregister(mHandle, &error))
+				LSErrorFree(&error);
+			g_main_loop_quit(mLoop);
+		});
+		mThread.join();
+
+		g_main_loop_unref(mLoop);
+		g_main_context_unref(mContext);
+	}
+
+	pbnjson::JValue call(const char *method, const char *appId)
+	{
+		std::mutex mutex;
+		std::condition_variable replied;
+		std::string payload;
+		bool done = false;
+
+		std::function<void(LSMessage*)> onReply = [&](LSMessage *message) {
+			std::lock_guard<std::mutex> lock(mutex);
+			payload = message ? LSMessageGetPayload(message) : "";
+			done = true;
+			replied.notify_all();
+		};
+
+		invoke([this, method, appId, &onReply]() {
+			std::string uri = std::string("luna://" SERVICE_NAME "/bench/") + method;
+			LSError error;
+			LSErrorInit(&error);
+			if (!LSCallFromApplicationOneReply(mHandle, uri.c_str(), "{}", appId, &LunaClient::handleReply, &onReply, NULL, &error))
+			{
+				fprintf(stderr, "Failed to call %s: %s\n", uri.c_str(), error.message);
+				LSErrorFree(&error);
+				onReply(NULL);
+			}
+		});
+
+		std::unique_lock<std::mutex> lock(mutex);
+		replied.wait(lock, [&done]() { return done; });
+
+		pbnjson::JValue replyObj;
+		if (!LSUtils::parsePayload(payload, replyObj) || !replyObj["returnValue"].asBool())
+		{
+			fprintf(stderr, "/bench/%s failed: %s\n", method, payload.c_str());
+			exit(1);
+		}
+
+		return replyObj;
+	}
+
+	// Returns once the subscription is in place
+	void subscribe(Run &run)
+	{
+		mRun = &run;
+
+		std::mutex mutex;
+		std::condition_variable subscribed;
+		bool done = false;
+
+		invoke([this, &mutex, &subscribed, &done]() {
+			LSError error;
+			LSErrorInit(&error);
+			if (!LSCallFromApplication(mHandle, "luna://" SERVICE_NAME "/bench/readData", "{\"subscribe\":true}",
+					LUNA_CLIENT_APP_ID, &LunaClient::handleData, this, &mToken, &error))
+			{
+				fprintf(stderr, "Failed to subscribe to readData: %s\n", error.message);
+				LSErrorFree(&error);
+				exit(1);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			subscribed.notify_all();
+		});
+
+		std::unique_lock<std::mutex> lock(mutex);
+		subscribed.wait(lock, [&done]() { return done; });
+	}
+
+	void unsubscribe()
+	{
+		invoke([this]() {
+			LSError error;
+			LSErrorInit(&error);
+			if (!LSCallCancel(mHandle, mToken, &error))
+				LSErrorFree(&error);
+			mToken = LSMESSAGE_TOKEN_INVALID;
+			mRun = NULL;
+		});
+	}
+
+private:
+	GMainContext *mContext;
+	GMainLoop *mLoop;
+	std::thread mThread;
+	LSHandle *mHandle;
+	LSMessageToken mToken;
+	Run *mRun;
+	std::vector<uint8_t> mPayload;
+
+	void invoke(std::function<void()> function)
+	{
+		g_main_context_invoke_full(mContext, G_PRIORITY_DEFAULT, [](gpointer data) -> gboolean {
+			std::function<void()> *function = static_cast<std::function<void()>*>(data);
+			(*function)();
+			delete function;
+			return FALSE;
+		}, new std::function<void()>(function), NULL);
+	}
+
+	static bool handleReply(LSHandle *handle, LSMessage *message, void *context)
+	{
+		(*static_cast<std::function<void(LSMessage*)>*>(context))(message);
+		return true;
+	}
+
+	static bool handleData(LSHandle *handle, LSMessage *message, void *context)
+	{
+		LunaClient *client = static_cast<LunaClient*>(context);
+		if (!client->mRun)
+			return true;
+
+		// The client only looks at the data member
+		const char *payload = LSMessageGetPayload(message);
+		const char *dataStart = strstr(payload, "\"data\":\"");
+		if (!dataStart)
+			return true;
+
+		dataStart += 8;
+		const char *dataEnd = strchr(dataStart, '"');
+		if (!dataEnd)
+			return true;
+
+		client->mPayload.resize(Base64::maxDecodedLength(dataEnd - dataStart));
+		size_t size = Base64::decode(dataStart, dataEnd - dataStart, client->mPayload.data());
+		receivedPayload(*client->mRun, size);
+
+		return true;
+	}
+};
+
+static int connectBinarySocket(const std::string &channelId)
+{
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	snprintf(address.sun_path, sizeof(address.sun_path), "%s/%s%s", BINARY_SOCKET_DIRECTORY,
+			 BINARY_SOCKET_FILE_NAME_PREFIX, channelId.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr*) &address, sizeof(address)) < 0)
+	{
+		perror(address.sun_path);
+		exit(1);
+	}
+
+	return fd;
+}
+
+static void readBinarySocket(int fd, Run &run)
+{
+	std::vector<uint8_t> payload(DATA_BUFFER_SIZE + RECEIVE_WINDOW);
+	uint64_t total = (uint64_t) run.chunkSize * run.chunks;
+	struct pollfd pollFd = { fd, POLLIN, 0 };
+
+	while (run.receivedBytes.load() < total && poll(&pollFd, 1, CLIENT_IDLE_TIMEOUT_MS) > 0)
+	{
+		ssize_t got = read(fd, payload.data(), payload.size());
+		if (got <= 0)
+			break;
+
+		receivedPayload(run, got);
+	}
+}
+
+static void waitForRun(Run &run)
+{
+	uint64_t total = (uint64_t) run.chunkSize * run.chunks;
+
+	std::unique_lock<std::mutex> lock(run.mutex);
+	while (run.receivedBytes.load() < total)
+	{
+		if (std::cv_status::timeout == run.progress.wait_for(lock, std::chrono::milliseconds(CLIENT_IDLE_TIMEOUT_MS)))
+			break;
+	}
+}
+
+static int64_t percentile(std::vector<int64_t> &values, unsigned int percent)
+{
+	if (values.empty())
+		return 0;
+
+	size_t index = (values.size() * percent + 99) / 100;
+	index = index ? index - 1 : 0;
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+
+	return values[index];
+}
+
+static void runPath(LunaClient &client, LoopbackSppProfile &profile, bool binarySocket, size_t chunkSize, size_t megabytes)
+{
+	Run run;
+	run.chunkSize = chunkSize;
+	run.chunks = megabytes * 1024 * 1024 / chunkSize;
+	run.handedOverTime.reset(new std::atomic<int64_t>[run.chunks]);
+	run.receivedBytes.store(0);
+	run.latencies.reserve(run.chunks);
+	run.completedChunks = 0;
+	run.lastReceivedTime = 0;
+
+	pbnjson::JValue connectObj = client.call("connect", binarySocket ? BINARY_SOCKET_APP_ID : LUNA_CLIENT_APP_ID);
+	std::string channelId = connectObj["channelId"].asString();
+
+	int fd = -1;
+	if (binarySocket)
+	{
+		fd = connectBinarySocket(channelId);
+		// Lets the main loop accept before data arrives, otherwise the first
+		// chunks are buffered by BluetoothBinarySocket until it does
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	else
+	{
+		client.subscribe(run);
+	}
+
+	allocationCount.store(0);
+	measuring.store(true);
+
+	int64_t startTime = nowUs();
+	std::thread reader;
+	if (binarySocket)
+		reader = std::thread(readBinarySocket, fd, std::ref(run));
+	std::thread sil(&LoopbackSppProfile::receive, &profile, std::ref(run));
+
+	sil.join();
+	if (binarySocket)
+		reader.join();
+	else
+		waitForRun(run);
+
+	measuring.store(false);
+	uint64_t allocations = allocationCount.load();
+
+	if (binarySocket)
+		close(fd);
+	else
+		client.unsubscribe();
+	client.call("disconnect", NULL);
+
+	std::lock_guard<std::mutex> lock(run.mutex);
+	uint64_t total = (uint64_t) run.chunkSize * run.chunks;
+	double megaBytes = run.receivedBytes.load() / (1024.0 * 1024.0);
+	double seconds = (run.lastReceivedTime - startTime) / 1000000.0;
+
+	printf("%-13s %6zu %10.1f %9lld %9lld %9lld %14.1f", binarySocket ? "binarySocket" : "luna", chunkSize,
+		   seconds > 0 ? megaBytes / seconds : 0.0,
+		   (long long) percentile(run.latencies, 50), (long long) percentile(run.latencies, 99),
+		   (long long) (run.latencies.empty() ? 0 : *std::max_element(run.latencies.begin(), run.latencies.end())),
+		   megaBytes > 0 ? allocations / megaBytes : 0.0);
+	if (run.receivedBytes.load() < total)
+		printf("  lost %llu bytes", (unsigned long long) (total - run.receivedBytes.load()));
+	printf("\n");
+}
+
+static BluetoothSppProfileService *findSppService(BluetoothManagerService &manager)
+{
+	for (auto profile : manager.getProfiles())
+	{
+		BluetoothSppProfileService *sppService = dynamic_cast<BluetoothSppProfileService*>(profile);
+		if (sppService)
+			return sppService;
+	}
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 16;
+	if (0 == megabytes)
+		megabytes = 16;
+
+	if (PmLogGetContext("webos-bluetooth-service", &logContext) != kPmLogErr_None)
+		fprintf(stderr, "Failed to set up the log context\n");
+
+	// No SIL is loaded, the loopback profile is the only stack there is
+	setenv("WEBOS_BLUETOOTH_SIL", "none", 1);
+
+	GMainLoop *mainLoop = g_main_loop_new(NULL, FALSE);
+	LSUtils::buildConstantErrorResponses();
+	ResponseWorkerPool::start(WEBOS_BLUETOOTH_RESPONSE_WORKERS);
+	EventQueue::start();
+
+	try
+	{
+		BluetoothManagerService manager;
+		manager.attachToLoop(mainLoop);
+
+		BluetoothSppProfileService *sppService = findSppService(manager);
+		if (!sppService)
+		{
+			fprintf(stderr, "SPP is not an enabled service class\n");
+			return 1;
+		}
+
+		// No adapter to bind to, this only sets up the channel manager
+		sppService->initialize(LOOPBACK_ADAPTER);
+
+		LoopbackSppProfile profile(sppService);
+		Bench bench = { sppService->findChannelImpl(LOOPBACK_ADAPTER), &profile };
+		manager.registerCategory("/bench", benchMethods, NULL, NULL);
+		manager.setCategoryData("/bench", &bench);
+
+		std::thread driver([&profile, megabytes, mainLoop]() {
+			LunaClient client;
+			const size_t chunkSizes[] = { 64, 256, 1024, 4096 };
+
+			printf("%-13s %6s %10s %9s %9s %9s %14s\n", "path", "chunk", "MB/s", "p50 us", "p99 us", "max us", "allocations/MB");
+
+			for (size_t chunkSize : chunkSizes)
+			{
+				runPath(client, profile, false, chunkSize, megabytes);
+				runPath(client, profile, true, chunkSize, megabytes);
+			}
+
+			g_main_loop_quit(mainLoop);
+		});
+
+		countAllocations = true;
+		g_main_loop_run(mainLoop);
+		countAllocations = false;
+
+		driver.join();
+	}
+	catch (LS::Error &error)
+	{
+		fprintf(stderr, "Failed to take %s: %s\n", SERVICE_NAME, error.what());
+		return 1;
+	}
+
+	EventQueue::stop();
+	ResponseWorkerPool::stop();
+	g_main_loop_unref(mainLoop);
+
+	return 0;
+}